@@ -26,6 +26,7 @@
 #include <glib/gi18n.h>
 #include <glib-object.h>
 #include <math.h>
+#include <string.h>
 #include <colord-session/cd-session.h>
 
 #define GNOME_DESKTOP_USE_UNSTABLE_API
@@ -53,6 +54,15 @@ struct _CcColorCalibratePrivate
   GtkWindow       *window;
   GtkWidget       *sample_widget;
   guint            gamma_size;
+  guint           *gamma_plan_lo;       /* per ramp entry: CLUT indices */
+  guint           *gamma_plan_hi;
+  gdouble         *gamma_plan_mix;      /* ...and how far between them */
+  guint            gamma_plan_len;      /* CLUT length of the plan */
+  CdColorRGB      *gamma_clut;          /* last CLUT we got */
+  guint            gamma_clut_len;
+  guint16         *gamma_ramp;          /* red, green then blue */
+  guint16         *gamma_ramp_tmp;
+  GnomeRRCrtc     *gamma_crtc;          /* where gamma_ramp was sent */
   CdProfileQuality quality;
   guint            target_whitepoint;   /* in Kelvin */
   gdouble          target_gamma;
@@ -192,6 +202,15 @@ cc_color_calibrate_calib_setup_screen (CcColorCalibrate *calibrate,
     }
 
   /* create a lookup table */
+  g_clear_pointer (&priv->gamma_plan_lo, g_free);
+  g_clear_pointer (&priv->gamma_plan_hi, g_free);
+  g_clear_pointer (&priv->gamma_plan_mix, g_free);
+  g_clear_pointer (&priv->gamma_clut, g_free);
+  g_clear_pointer (&priv->gamma_ramp, g_free);
+  g_clear_pointer (&priv->gamma_ramp_tmp, g_free);
+  priv->gamma_plan_len = 0;
+  priv->gamma_clut_len = 0;
+  priv->gamma_crtc = NULL;
   priv->gamma_size = _gnome_rr_output_get_gamma_size (priv->output);
   if (priv->gamma_size == 0)
     {
@@ -205,6 +224,42 @@ out:
   return ret;
 }
 
+/* Works out which two CLUT entries each gamma ramp entry is mixed from,
+ * which only depends on the sizes of the CLUT and of the ramp. */
+static void
+cc_color_calibrate_ensure_gamma_plan (CcColorCalibrate *calibrate,
+                                      guint clut_len)
+{
+  CcColorCalibratePrivate *priv = calibrate->priv;
+  gdouble mix;
+  guint i;
+
+  if (priv->gamma_plan_len == clut_len)
+    return;
+
+  if (priv->gamma_plan_lo == NULL)
+    {
+      priv->gamma_plan_lo = g_new (guint, priv->gamma_size);
+      priv->gamma_plan_hi = g_new (guint, priv->gamma_size);
+      priv->gamma_plan_mix = g_new (gdouble, priv->gamma_size);
+      priv->gamma_ramp = g_new0 (guint16, priv->gamma_size * 3);
+      priv->gamma_ramp_tmp = g_new (guint16, priv->gamma_size * 3);
+    }
+  for (i = 0; i < priv->gamma_size; i++)
+    {
+      if (priv->gamma_size > 1)
+        mix = (gdouble) (clut_len - 1) /
+              (gdouble) (priv->gamma_size - 1) *
+              (gdouble) i;
+      else
+        mix = 0.0;
+      priv->gamma_plan_lo[i] = (guint) floor (mix);
+      priv->gamma_plan_hi[i] = (guint) ceil (mix);
+      priv->gamma_plan_mix[i] = mix - floor (mix);
+    }
+  priv->gamma_plan_len = clut_len;
+}
+
 /**
  * cc_color_calibrate_calib_set_output_gamma:
  *
@@ -216,75 +271,86 @@ out:
  *
  *  - We only have 100ms to process the request before the next update
  *    could be scheduled.
+ *
+ * The helper sends the same CLUT many times during a calibration, so the
+ * ramp is only sent to the card when it actually changed.
  **/
 static gboolean
 cc_color_calibrate_calib_set_output_gamma (CcColorCalibrate *calibrate,
-                                           GPtrArray *array,
+                                           const CdColorRGB *clut,
+                                           gsize clut_len,
                                            GError **error)
 {
   CcColorCalibratePrivate *priv = calibrate->priv;
-  CdColorRGB *p1;
-  CdColorRGB *p2;
-  CdColorRGB result;
-  gboolean ret = TRUE;
-  gdouble mix;
+  const guint *lo;
+  const guint *hi;
+  const gdouble *mix;
   GnomeRRCrtc *crtc;
-  guint16 *blue = NULL;
-  guint16 *green = NULL;
-  guint16 *red = NULL;
+  guint16 *blue;
+  guint16 *green;
+  guint16 *red;
+  guint16 *tmp;
   guint i;
 
   /* no length? */
-  if (array->len == 0)
+  if (clut_len == 0)
     {
-      ret = FALSE;
       g_set_error_literal (error,
                            CD_SESSION_ERROR,
                            CD_SESSION_ERROR_INTERNAL,
                            "no data in the CLUT array");
-      goto out;
+      return FALSE;
     }
 
-  /* convert to a type X understands of the right size */
-  red = g_new (guint16, priv->gamma_size);
-  green = g_new (guint16, priv->gamma_size);
-  blue = g_new (guint16, priv->gamma_size);
-  cd_color_rgb_set (&result, 1.0, 1.0, 1.0);
-  for (i = 0; i < priv->gamma_size; i++)
-    {
-      mix = (gdouble) (array->len - 1) /
-            (gdouble) (priv->gamma_size - 1) *
-            (gdouble) i;
-      p1 = g_ptr_array_index (array, (guint) floor (mix));
-      p2 = g_ptr_array_index (array, (guint) ceil (mix));
-      cd_color_rgb_interpolate (p1,
-                                p2,
-                                mix - (gint) mix,
-                                &result);
-      red[i] = result.R * 0xffff;
-      green[i] = result.G * 0xffff;
-      blue[i] = result.B * 0xffff;
-    }
-
-  /* send to LUT */
   crtc = gnome_rr_output_get_crtc (priv->output);
   if (crtc == NULL)
     {
-      ret = FALSE;
       g_set_error (error,
                    CD_SESSION_ERROR,
                    CD_SESSION_ERROR_INTERNAL,
                    "failed to get ctrc for %s",
                    gnome_rr_output_get_name (priv->output));
-      goto out;
+      return FALSE;
     }
+
+  /* same as before */
+  if (crtc == priv->gamma_crtc &&
+      clut_len == priv->gamma_clut_len &&
+      memcmp (clut, priv->gamma_clut, clut_len * sizeof (CdColorRGB)) == 0)
+    return TRUE;
+  g_free (priv->gamma_clut);
+  priv->gamma_clut = g_memdup (clut, clut_len * sizeof (CdColorRGB));
+  priv->gamma_clut_len = clut_len;
+
+  /* convert to a type X understands of the right size */
+  cc_color_calibrate_ensure_gamma_plan (calibrate, clut_len);
+  lo = priv->gamma_plan_lo;
+  hi = priv->gamma_plan_hi;
+  mix = priv->gamma_plan_mix;
+  red = priv->gamma_ramp_tmp;
+  green = red + priv->gamma_size;
+  blue = green + priv->gamma_size;
+  for (i = 0; i < priv->gamma_size; i++)
+    {
+      red[i] = (clut[lo[i]].R + (clut[hi[i]].R - clut[lo[i]].R) * mix[i]) * 0xffff;
+      green[i] = (clut[lo[i]].G + (clut[hi[i]].G - clut[lo[i]].G) * mix[i]) * 0xffff;
+      blue[i] = (clut[lo[i]].B + (clut[hi[i]].B - clut[lo[i]].B) * mix[i]) * 0xffff;
+    }
+
+  /* the CLUT changed, but not enough to change what the card gets */
+  if (crtc == priv->gamma_crtc &&
+      memcmp (priv->gamma_ramp_tmp, priv->gamma_ramp,
+              priv->gamma_size * 3 * sizeof (guint16)) == 0)
+    return TRUE;
+  tmp = priv->gamma_ramp;
+  priv->gamma_ramp = priv->gamma_ramp_tmp;
+  priv->gamma_ramp_tmp = tmp;
+
+  /* send to LUT */
   gnome_rr_crtc_set_gamma (crtc, priv->gamma_size,
                            red, green, blue);
-out:
-  g_free (red);
-  g_free (green);
-  g_free (blue);
-  return ret;
+  priv->gamma_crtc = crtc;
+  return TRUE;
 }
 
 static void
@@ -496,7 +562,7 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
 {
   CcColorCalibratePrivate *priv = calibrate->priv;
   CdColorRGB color;
-  CdColorRGB *color_tmp;
+  const CdColorRGB *clut;
   CdSessionInteraction code;
   const gchar *image = NULL;
   const gchar *message;
@@ -504,11 +570,11 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
   const gchar *str = NULL;
   gboolean ret;
   GError *error = NULL;
-  GPtrArray *array = NULL;
+  gsize clut_len;
   GtkImage *img;
   GtkLabel *label;
-  GVariantIter *iter;
   GVariant *dict = NULL;
+  GVariant *value = NULL;
 
   if (g_strcmp0 (signal_name, "Finished") == 0)
     {
@@ -569,22 +635,14 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
     }
   if (g_strcmp0 (signal_name, "UpdateGamma") == 0)
     {
+      /* (ddd) has the same layout as CdColorRGB */
       g_variant_get (parameters,
-                     "(a(ddd))",
-                     &iter);
-      array = g_ptr_array_new_with_free_func (g_free);
-      while (g_variant_iter_loop (iter, "(ddd)",
-                                  &color.R,
-                                  &color.G,
-                                  &color.B))
-        {
-          color_tmp = cd_color_rgb_new ();
-          cd_color_rgb_copy (&color, color_tmp);
-          g_ptr_array_add (array, color_tmp);
-        }
-      g_variant_iter_free (iter);
+                     "(@a(ddd))",
+                     &value);
+      clut = g_variant_get_fixed_array (value, &clut_len, sizeof (CdColorRGB));
       ret = cc_color_calibrate_calib_set_output_gamma (calibrate,
-                                                       array,
+                                                       clut,
+                                                       clut_len,
                                                        &error);
       if (!ret)
         {
@@ -599,6 +657,8 @@ cc_color_calibrate_signal_cb (GDBusProxy *proxy,
 out:
   if (dict != NULL)
     g_variant_unref (dict);
+  if (value != NULL)
+    g_variant_unref (value);
 }
 
 static void
@@ -1045,6 +1105,12 @@ cc_color_calibrate_finalize (GObject *object)
   g_clear_object (&priv->sensor);
   g_clear_object (&priv->x11_screen);
   g_free (priv->title);
+  g_free (priv->gamma_plan_lo);
+  g_free (priv->gamma_plan_hi);
+  g_free (priv->gamma_plan_mix);
+  g_free (priv->gamma_clut);
+  g_free (priv->gamma_ramp);
+  g_free (priv->gamma_ramp_tmp);
   g_main_loop_unref (priv->loop);
 
   G_OBJECT_CLASS (cc_color_calibrate_parent_class)->finalize (object);
@@ -181,6 +181,22 @@ cc_color_device_set_expanded (CcColorDevice *color_device,
   cc_color_device_refresh (color_device);
 }
 
+static void
+cc_color_device_set_enabled_cb (GObject *object,
+                                GAsyncResult *res,
+                                gpointer user_data)
+{
+  gboolean enable = GPOINTER_TO_INT (user_data);
+  GError *error = NULL;
+
+  if (!cd_device_set_enabled_finish (CD_DEVICE (object), res, &error))
+    {
+      g_warning ("failed to %s to the device: %s",
+                 enable ? "enable" : "disable", error->message);
+      g_error_free (error);
+    }
+}
+
 static void
 cc_color_device_notify_enable_device_cb (GtkSwitch *sw,
                                          GParamSpec *pspec,
@@ -189,19 +205,12 @@ cc_color_device_notify_enable_device_cb (GtkSwitch *sw,
   CcColorDevice *color_device = CC_COLOR_DEVICE (user_data);
   CcColorDevicePrivate *priv = color_device->priv;
   gboolean enable;
-  gboolean ret;
-  GError *error = NULL;
 
   enable = gtk_switch_get_active (sw);
   g_debug ("Set %s to %i", cd_device_get_id (priv->device), enable);
-  ret = cd_device_set_enabled_sync (priv->device,
-                                    enable, NULL, &error);
-  if (!ret)
-    {
-      g_warning ("failed to %s to the device: %s",
-                 enable ? "enable" : "disable", error->message);
-      g_error_free (error);
-    }
+  cd_device_set_enabled (priv->device, enable, NULL,
+                         cc_color_device_set_enabled_cb,
+                         GINT_TO_POINTER (enable));
 
   /* if expanded, close */
   cc_color_device_set_expanded (color_device, FALSE);
@@ -64,6 +64,20 @@ struct _CcColorPanelPrivate
   GtkSizeGroup  *list_box_size;
   gboolean       is_live_cd;
   gboolean       model_is_changing;
+  GHashTable    *devices_pending;
+  guint          device_connects;
+  gboolean       devices_listed;
+  gboolean       devices_settled;
+  GHashTable    *profile_cache;
+  GQueue         profile_queue;
+  guint          profile_connects;
+  GHashTable    *catalogue;
+  GHashTable    *catalogue_index;
+  gboolean       catalogue_loaded;
+  CdDevice      *assign_device;
+  GHashTable    *assign_exclude;
+  gchar         *assign_search;
+  guint          sensors_generation;
 };
 
 enum {
@@ -106,6 +120,9 @@ enum {
 /* max number of devices and profiles to cause auto-expand at startup */
 #define GCM_PREFS_MAX_DEVICES_PROFILES_EXPANDED         5
 
+/* max number of profiles we get the properties of at the same time */
+#define GCM_PREFS_MAX_PROFILE_CONNECTS                  8
+
 static void gcm_prefs_refresh_toolbar_buttons (CcColorPanel *panel);
 
 static void
@@ -179,33 +196,46 @@ gcm_prefs_combobox_add_profile (CcColorPanel *prefs,
   g_string_free (string, TRUE);
 }
 
+/* async colord calls hold a reference on the panel, and bail out in
+ * their callback when it has been disposed in the meantime */
+static gboolean
+gcm_prefs_is_disposed (CcColorPanel *prefs)
+{
+  return prefs->priv->cancellable == NULL;
+}
+
+static void
+gcm_prefs_install_system_wide_cb (GObject *object,
+                                  GAsyncResult *res,
+                                  gpointer user_data)
+{
+  GError *error = NULL;
+
+  if (!cd_profile_install_system_wide_finish (CD_PROFILE (object), res, &error))
+    {
+      g_warning ("failed to set profile system-wide: %s",
+           error->message);
+      g_error_free (error);
+    }
+}
+
 static void
 gcm_prefs_default_cb (GtkWidget *widget, CcColorPanel *prefs)
 {
   CdProfile *profile;
-  gboolean ret;
-  GError *error = NULL;
   CcColorPanelPrivate *priv = prefs->priv;
 
   /* TODO: check if the profile is already systemwide */
   profile = cd_device_get_default_profile (priv->current_device);
   if (profile == NULL)
-    goto out;
+    return;
 
   /* install somewhere out of $HOME */
-  ret = cd_profile_install_system_wide_sync (profile,
-                                             priv->cancellable,
-                                             &error);
-  if (!ret)
-    {
-      g_warning ("failed to set profile system-wide: %s",
-           error->message);
-      g_error_free (error);
-      goto out;
-    }
-out:
-  if (profile != NULL)
-    g_object_unref (profile);
+  cd_profile_install_system_wide (profile,
+                                  priv->cancellable,
+                                  gcm_prefs_install_system_wide_cb,
+                                  NULL);
+  g_object_unref (profile);
 }
 
 static GFile *
@@ -738,38 +768,473 @@ gcm_prefs_combo_sort_func_cb (GtkTreeModel *model,
   return retval;
 }
 
+typedef void (*GcmPrefsProfileFunc) (CcColorPanel *prefs,
+                                     CdProfile *profile,
+                                     gpointer user_data);
+
+typedef struct {
+  CcColorPanel        *prefs;
+  CdProfile           *profile;
+  GcmPrefsProfileFunc  func;
+  gpointer             user_data;
+  GDestroyNotify       destroy;
+} GcmPrefsProfileRequest;
+
+static void
+gcm_prefs_profile_request_free (GcmPrefsProfileRequest *request)
+{
+  if (request->destroy != NULL)
+    request->destroy (request->user_data);
+  g_object_unref (request->profile);
+  g_object_unref (request->prefs);
+  g_free (request);
+}
+
+static void gcm_prefs_profile_queue_run (CcColorPanel *prefs);
+
+static void
+gcm_prefs_profile_connect_cb (GObject *object,
+                              GAsyncResult *res,
+                              gpointer user_data)
+{
+  GcmPrefsProfileRequest *request = user_data;
+  CcColorPanel *prefs = request->prefs;
+  CdProfile *profile = CD_PROFILE (object);
+  GError *error = NULL;
+
+  if (!cd_profile_connect_finish (profile, res, &error))
+    {
+      if (!gcm_prefs_is_disposed (prefs))
+        g_warning ("failed to get profile: %s", error->message);
+      g_error_free (error);
+    }
+  else if (!gcm_prefs_is_disposed (prefs))
+    {
+      g_hash_table_insert (prefs->priv->profile_cache,
+                           g_strdup (cd_profile_get_object_path (profile)),
+                           g_object_ref (profile));
+      request->func (prefs, profile, request->user_data);
+    }
+
+  if (!gcm_prefs_is_disposed (prefs))
+    {
+      prefs->priv->profile_connects--;
+      gcm_prefs_profile_queue_run (prefs);
+    }
+  gcm_prefs_profile_request_free (request);
+}
+
+static void
+gcm_prefs_profile_queue_run (CcColorPanel *prefs)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsProfileRequest *request;
+  CdProfile *cached;
+
+  while (priv->profile_connects < GCM_PREFS_MAX_PROFILE_CONNECTS &&
+         (request = g_queue_pop_head (&priv->profile_queue)) != NULL)
+    {
+      /* another request may have got it in the meantime */
+      cached = g_hash_table_lookup (priv->profile_cache,
+                                    cd_profile_get_object_path (request->profile));
+      if (cached != NULL)
+        {
+          request->func (prefs, cached, request->user_data);
+          gcm_prefs_profile_request_free (request);
+          continue;
+        }
+
+      priv->profile_connects++;
+      cd_profile_connect (request->profile,
+                          priv->cancellable,
+                          gcm_prefs_profile_connect_cb,
+                          request);
+    }
+}
+
+/* Calls @func with a profile which has its properties, using the shared
+ * cache when possible. Getting the properties of many profiles at the same
+ * time doesn't make colord any faster, so at most
+ * GCM_PREFS_MAX_PROFILE_CONNECTS requests are in flight at any time. */
+static void
+gcm_prefs_get_connected_profile (CcColorPanel *prefs,
+                                 CdProfile *profile,
+                                 GcmPrefsProfileFunc func,
+                                 gpointer user_data,
+                                 GDestroyNotify destroy)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsProfileRequest *request;
+  CdProfile *cached;
+
+  cached = g_hash_table_lookup (priv->profile_cache,
+                                cd_profile_get_object_path (profile));
+  if (cached == NULL && cd_profile_get_connected (profile))
+    {
+      cached = profile;
+      g_hash_table_insert (priv->profile_cache,
+                           g_strdup (cd_profile_get_object_path (profile)),
+                           g_object_ref (profile));
+    }
+  if (cached != NULL)
+    {
+      func (prefs, cached, user_data);
+      if (destroy != NULL)
+        destroy (user_data);
+      return;
+    }
+
+  request = g_new0 (GcmPrefsProfileRequest, 1);
+  request->prefs = g_object_ref (prefs);
+  request->profile = g_object_ref (profile);
+  request->func = func;
+  request->user_data = user_data;
+  request->destroy = destroy;
+  g_queue_push_tail (&priv->profile_queue, request);
+
+  gcm_prefs_profile_queue_run (prefs);
+}
+
+/* Every profile colord knows about, indexed by colorspace and kind, which
+ * is what decides whether a profile can be used for a device at all.
+ * This is kept up to date from the CdClient signals so that opening the
+ * assign dialog, or searching in it, doesn't need to ask colord again. */
+typedef struct {
+  CdProfile     *profile;
+  guint          key;
+  gchar         *search;
+} GcmPrefsCatalogueEntry;
+
+static void
+gcm_prefs_catalogue_entry_free (GcmPrefsCatalogueEntry *entry)
+{
+  g_object_unref (entry->profile);
+  g_free (entry->search);
+  g_free (entry);
+}
+
+static guint
+gcm_prefs_catalogue_key (CdColorspace colorspace, CdProfileKind kind)
+{
+  return ((guint) colorspace << 16) | (guint) kind;
+}
+
+static guint
+gcm_prefs_catalogue_key_for_device (CdDevice *device)
+{
+  CdProfileKind kind;
+
+  /* displays can also use the standard spaces, which are display
+   * device profiles themselves */
+  kind = cd_device_kind_to_profile_kind (cd_device_get_kind (device));
+  return gcm_prefs_catalogue_key (cd_device_get_colorspace (device), kind);
+}
+
+/* the title, vendor, model and filename of the profile */
+static gchar *
+gcm_prefs_catalogue_search_key (CdProfile *profile)
+{
+  const gchar *items[4];
+  gchar *basename = NULL;
+  gchar *tmp;
+  GString *str;
+  guint i;
+
+  if (cd_profile_get_filename (profile) != NULL)
+    basename = g_path_get_basename (cd_profile_get_filename (profile));
+  items[0] = cd_profile_get_title (profile);
+  items[1] = cd_profile_get_metadata_item (profile,
+                                           CD_PROFILE_METADATA_EDID_VENDOR);
+  items[2] = cd_profile_get_metadata_item (profile,
+                                           CD_PROFILE_METADATA_EDID_MODEL);
+  items[3] = basename;
+
+  str = g_string_new (NULL);
+  for (i = 0; i < G_N_ELEMENTS (items); i++)
+    {
+      if (items[i] == NULL)
+        continue;
+      tmp = g_utf8_casefold (items[i], -1);
+      g_string_append (str, tmp);
+      g_string_append_c (str, '\n');
+      g_free (tmp);
+    }
+  g_free (basename);
+  return g_string_free (str, FALSE);
+}
+
 static gboolean
-gcm_prefs_profile_exists_in_array (GPtrArray *array, CdProfile *profile)
+gcm_prefs_assign_entry_matches (CcColorPanel *prefs,
+                                GcmPrefsCatalogueEntry *entry)
 {
-  CdProfile *profile_tmp;
+  CcColorPanelPrivate *priv = prefs->priv;
+
+  /* don't add any of the already added profiles */
+  if (g_hash_table_contains (priv->assign_exclude,
+                             cd_profile_get_object_path (entry->profile)))
+    return FALSE;
+
+  /* only add correct types */
+  if (!gcm_prefs_is_profile_suitable_for_device (entry->profile,
+                                                 priv->assign_device))
+    return FALSE;
+
+#if CD_CHECK_VERSION(0,1,13)
+  /* ignore profiles from other user accounts */
+  if (!cd_profile_has_access (entry->profile))
+    return FALSE;
+#endif
+
+  /* only what the user is looking for */
+  if (priv->assign_search != NULL &&
+      g_strstr_len (entry->search, -1, priv->assign_search) == NULL)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gcm_prefs_assign_remove_profile (CcColorPanel *prefs,
+                                 const gchar *object_path)
+{
+  GtkListStore *list_store;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  CdProfile *profile;
+  gboolean found;
+  gboolean valid;
+
+  list_store = GTK_LIST_STORE (gtk_builder_get_object (prefs->priv->builder,
+                                                       "liststore_assign"));
+  model = GTK_TREE_MODEL (list_store);
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  while (valid)
+    {
+      gtk_tree_model_get (model, &iter,
+                          GCM_PREFS_COMBO_COLUMN_PROFILE, &profile,
+                          -1);
+      found = g_strcmp0 (cd_profile_get_object_path (profile), object_path) == 0;
+      g_object_unref (profile);
+      if (found)
+        {
+          gtk_list_store_remove (list_store, &iter);
+          return;
+        }
+      valid = gtk_tree_model_iter_next (model, &iter);
+    }
+}
+
+static void
+gcm_prefs_catalogue_remove (CcColorPanel *prefs,
+                            const gchar *object_path)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsCatalogueEntry *entry;
+  GHashTable *bucket;
+
+  entry = g_hash_table_lookup (priv->catalogue, object_path);
+  if (entry == NULL)
+    return;
+
+  /* the dialog may be showing it */
+  if (priv->assign_device != NULL)
+    gcm_prefs_assign_remove_profile (prefs, object_path);
+
+  bucket = g_hash_table_lookup (priv->catalogue_index,
+                                GUINT_TO_POINTER (entry->key));
+  g_hash_table_remove (bucket, object_path);
+  g_hash_table_remove (priv->catalogue, object_path);
+}
+
+static void
+gcm_prefs_catalogue_add (CcColorPanel *prefs,
+                         CdProfile *profile,
+                         gpointer user_data)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsCatalogueEntry *entry;
+  GHashTable *bucket;
+  GtkTreeIter iter;
+  const gchar *object_path;
+
+  /* reindex when it changed */
+  object_path = cd_profile_get_object_path (profile);
+  gcm_prefs_catalogue_remove (prefs, object_path);
+
+  entry = g_new0 (GcmPrefsCatalogueEntry, 1);
+  entry->profile = g_object_ref (profile);
+  entry->key = gcm_prefs_catalogue_key (cd_profile_get_colorspace (profile),
+                                        cd_profile_get_kind (profile));
+  entry->search = gcm_prefs_catalogue_search_key (profile);
+  g_hash_table_insert (priv->catalogue, g_strdup (object_path), entry);
+
+  bucket = g_hash_table_lookup (priv->catalogue_index,
+                                GUINT_TO_POINTER (entry->key));
+  if (bucket == NULL)
+    {
+      bucket = g_hash_table_new (g_str_hash, g_str_equal);
+      g_hash_table_insert (priv->catalogue_index,
+                           GUINT_TO_POINTER (entry->key),
+                           bucket);
+    }
+  g_hash_table_insert (bucket,
+                       (gpointer) cd_profile_get_object_path (entry->profile),
+                       entry);
+
+  /* the dialog may want to show it */
+  if (priv->assign_device != NULL &&
+      entry->key == gcm_prefs_catalogue_key_for_device (priv->assign_device) &&
+      gcm_prefs_assign_entry_matches (prefs, entry))
+    gcm_prefs_combobox_add_profile (prefs, entry->profile, &iter);
+}
+
+static void
+gcm_prefs_catalogue_get_profiles_cb (GObject *object,
+                                     GAsyncResult *res,
+                                     gpointer user_data)
+{
+  CcColorPanel *prefs = CC_COLOR_PANEL (user_data);
+  GError *error = NULL;
+  GPtrArray *profiles;
   guint i;
 
-  for (i = 0; i < array->len; i++)
+  profiles = cd_client_get_profiles_finish (CD_CLIENT (object), res, &error);
+  if (profiles == NULL)
+    {
+      if (!gcm_prefs_is_disposed (prefs))
+        g_warning ("failed to get profiles: %s", error->message);
+      g_error_free (error);
+      goto out;
+    }
+  if (gcm_prefs_is_disposed (prefs))
+    goto out;
+
+  /* add to the catalogue as their properties come in */
+  for (i = 0; i < profiles->len; i++)
     {
-      profile_tmp = g_ptr_array_index (array, i);
-      if (cd_profile_equal (profile, profile_tmp))
-         return TRUE;
+      gcm_prefs_get_connected_profile (prefs,
+                                       g_ptr_array_index (profiles, i),
+                                       gcm_prefs_catalogue_add,
+                                       NULL, NULL);
     }
-  return FALSE;
+out:
+  if (profiles != NULL)
+    g_ptr_array_unref (profiles);
+  g_object_unref (prefs);
+}
+
+/* the catalogue is only needed by the assign dialog, so the profiles
+ * are not connected until it is first shown */
+static void
+gcm_prefs_catalogue_load (CcColorPanel *prefs)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+
+  if (priv->catalogue_loaded)
+    return;
+  priv->catalogue_loaded = TRUE;
+
+  cd_client_get_profiles (priv->client,
+                          priv->cancellable,
+                          gcm_prefs_catalogue_get_profiles_cb,
+                          g_object_ref (prefs));
+}
+
+static void
+gcm_prefs_client_profile_added_cb (CdClient *client,
+                                   CdProfile *profile,
+                                   CcColorPanel *prefs)
+{
+  if (gcm_prefs_is_disposed (prefs))
+    return;
+  if (!prefs->priv->catalogue_loaded)
+    return;
+  gcm_prefs_get_connected_profile (prefs, profile,
+                                   gcm_prefs_catalogue_add,
+                                   NULL, NULL);
+}
+
+static void
+gcm_prefs_client_profile_changed_cb (CdClient *client,
+                                     CdProfile *profile,
+                                     CcColorPanel *prefs)
+{
+  if (gcm_prefs_is_disposed (prefs))
+    return;
+  if (!g_hash_table_contains (prefs->priv->catalogue,
+                              cd_profile_get_object_path (profile)))
+    return;
+  gcm_prefs_get_connected_profile (prefs, profile,
+                                   gcm_prefs_catalogue_add,
+                                   NULL, NULL);
+}
+
+static void
+gcm_prefs_client_profile_removed_cb (CdClient *client,
+                                     CdProfile *profile,
+                                     CcColorPanel *prefs)
+{
+  if (gcm_prefs_is_disposed (prefs))
+    return;
+  gcm_prefs_catalogue_remove (prefs, cd_profile_get_object_path (profile));
+  g_hash_table_remove (prefs->priv->profile_cache,
+                       cd_profile_get_object_path (profile));
+}
+
+static void
+gcm_prefs_assign_refresh (CcColorPanel *prefs)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsCatalogueEntry *entry;
+  GHashTableIter hash_iter;
+  GtkTreeIter iter;
+  GHashTable *bucket;
+  GtkListStore *list_store;
+
+  list_store = GTK_LIST_STORE (gtk_builder_get_object (priv->builder,
+                                                       "liststore_assign"));
+  gtk_list_store_clear (list_store);
+
+  /* only the profiles of the right colorspace and kind can be suitable */
+  bucket = g_hash_table_lookup (priv->catalogue_index,
+                                GUINT_TO_POINTER (gcm_prefs_catalogue_key_for_device (priv->assign_device)));
+  if (bucket == NULL)
+    return;
+  g_hash_table_iter_init (&hash_iter, bucket);
+  while (g_hash_table_iter_next (&hash_iter, NULL, (gpointer *) &entry))
+    {
+      if (gcm_prefs_assign_entry_matches (prefs, entry))
+        gcm_prefs_combobox_add_profile (prefs, entry->profile, &iter);
+    }
+}
+
+static void
+gcm_prefs_assign_search_changed_cb (GtkSearchEntry *entry,
+                                    CcColorPanel *prefs)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  const gchar *text;
+
+  g_clear_pointer (&priv->assign_search, g_free);
+  text = gtk_entry_get_text (GTK_ENTRY (entry));
+  if (text[0] != '\0')
+    priv->assign_search = g_utf8_casefold (text, -1);
+
+  if (priv->assign_device != NULL)
+    gcm_prefs_assign_refresh (prefs);
 }
 
 static void
 gcm_prefs_add_profiles_suitable_for_devices (CcColorPanel *prefs,
                                              GPtrArray *profiles)
 {
-  CdProfile *profile_tmp;
-  gboolean ret;
-  GError *error = NULL;
-  GPtrArray *profile_array = NULL;
-  GtkTreeIter iter;
   GtkListStore *list_store;
   GtkWidget *widget;
-  guint i;
   CcColorPanelPrivate *priv = prefs->priv;
+  guint i;
 
   list_store = GTK_LIST_STORE(gtk_builder_get_object (prefs->priv->builder,
                                                       "liststore_assign"));
-  gtk_list_store_clear (list_store);
   gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (list_store),
                                         GCM_PREFS_COMBO_COLUMN_TEXT,
                                         GTK_SORT_ASCENDING);
@@ -782,61 +1247,27 @@ gcm_prefs_add_profiles_suitable_for_devices (CcColorPanel *prefs,
                                                "label_assign_warning"));
   gtk_widget_hide (widget);
 
-  /* get profiles */
-  profile_array = cd_client_get_profiles_sync (priv->client,
-                                               priv->cancellable,
-                                               &error);
-  if (profile_array == NULL)
+  /* the profiles the device already has */
+  g_hash_table_remove_all (priv->assign_exclude);
+  for (i = 0; profiles != NULL && i < profiles->len; i++)
     {
-      g_warning ("failed to get profiles: %s",
-           error->message);
-      g_error_free (error);
-      goto out;
+      g_hash_table_add (priv->assign_exclude,
+                        g_strdup (cd_profile_get_object_path (g_ptr_array_index (profiles, i))));
     }
 
-  /* add profiles of the right kind */
-  for (i = 0; i < profile_array->len; i++)
-    {
-      profile_tmp = g_ptr_array_index (profile_array, i);
-
-      /* get properties */
-      ret = cd_profile_connect_sync (profile_tmp,
-                                     priv->cancellable,
-                                     &error);
-      if (!ret)
-        {
-          g_warning ("failed to get profile: %s", error->message);
-          g_error_free (error);
-          goto out;
-        }
-
-      /* don't add any of the already added profiles */
-      if (profiles != NULL)
-        {
-          if (gcm_prefs_profile_exists_in_array (profiles, profile_tmp))
-            continue;
-        }
-
-      /* only add correct types */
-      ret = gcm_prefs_is_profile_suitable_for_device (profile_tmp,
-                                                      priv->current_device);
-      if (!ret)
-        continue;
-
-#if CD_CHECK_VERSION(0,1,13)
-      /* ignore profiles from other user accounts */
-      if (!cd_profile_has_access (profile_tmp))
-        continue;
-#endif
+  /* start with an empty search */
+  g_set_object (&priv->assign_device, priv->current_device);
+  g_clear_pointer (&priv->assign_search, g_free);
+  widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                               "entry_assign_search"));
+  g_signal_handlers_block_by_func (widget, gcm_prefs_assign_search_changed_cb, prefs);
+  gtk_entry_set_text (GTK_ENTRY (widget), "");
+  g_signal_handlers_unblock_by_func (widget, gcm_prefs_assign_search_changed_cb, prefs);
 
-      /* add */
-      gcm_prefs_combobox_add_profile (prefs,
-                                      profile_tmp,
-                                      &iter);
-    }
-out:
-  if (profile_array != NULL)
-    g_ptr_array_unref (profile_array);
+  /* add profiles of the right kind, the others follow as the
+   * catalogue is filled */
+  gcm_prefs_catalogue_load (prefs);
+  gcm_prefs_assign_refresh (prefs);
 }
 
 static void
@@ -1036,13 +1467,25 @@ gcm_prefs_profile_add_cb (GtkWidget *widget, CcColorPanel *prefs)
     g_ptr_array_unref (profiles);
 }
 
+static void
+gcm_prefs_device_remove_profile_cb (GObject *object,
+                                    GAsyncResult *res,
+                                    gpointer user_data)
+{
+  GError *error = NULL;
+
+  if (!cd_device_remove_profile_finish (CD_DEVICE (object), res, &error))
+    {
+      g_warning ("failed to remove profile: %s", error->message);
+      g_error_free (error);
+    }
+}
+
 static void
 gcm_prefs_profile_remove_cb (GtkWidget *widget, CcColorPanel *prefs)
 {
   CcColorPanelPrivate *priv = prefs->priv;
   CdProfile *profile;
-  gboolean ret = FALSE;
-  GError *error = NULL;
   GtkListBoxRow *row;
 
   /* get the selected profile */
@@ -1057,15 +1500,11 @@ gcm_prefs_profile_remove_cb (GtkWidget *widget, CcColorPanel *prefs)
     }
 
   /* just remove it, the list store will get ::changed */
-  ret = cd_device_remove_profile_sync (priv->current_device,
-                                       profile,
-                                       priv->cancellable,
-                                       &error);
-  if (!ret)
-    {
-      g_warning ("failed to remove profile: %s", error->message);
-      g_error_free (error);
-    }
+  cd_device_remove_profile (priv->current_device,
+                            profile,
+                            priv->cancellable,
+                            gcm_prefs_device_remove_profile_cb,
+                            NULL);
 }
 
 static void
@@ -1203,6 +1642,86 @@ gcm_prefs_button_assign_cancel_cb (GtkWidget *widget, CcColorPanel *prefs)
 {
   CcColorPanelPrivate *priv = prefs->priv;
   gtk_widget_hide (priv->dialog_assign);
+  g_clear_object (&priv->assign_device);
+}
+
+typedef struct {
+  CcColorPanel  *prefs;
+  CdDevice      *device;
+  CdProfile     *profile;
+} GcmPrefsAssignHelper;
+
+static void
+gcm_prefs_assign_helper_free (GcmPrefsAssignHelper *helper)
+{
+  g_object_unref (helper->prefs);
+  g_object_unref (helper->device);
+  g_object_unref (helper->profile);
+  g_free (helper);
+}
+
+static void
+gcm_prefs_assign_add_profile_cb (GObject *object,
+                                 GAsyncResult *res,
+                                 gpointer user_data)
+{
+  GcmPrefsAssignHelper *helper = user_data;
+  GError *error = NULL;
+
+  if (!cd_device_add_profile_finish (helper->device, res, &error))
+    {
+      if (!gcm_prefs_is_disposed (helper->prefs))
+        g_warning ("failed to add: %s", error->message);
+      g_error_free (error);
+      goto out;
+    }
+  if (gcm_prefs_is_disposed (helper->prefs))
+    goto out;
+
+  /* make it default */
+  cd_device_make_profile_default (helper->device,
+                                  helper->profile,
+                                  helper->prefs->priv->cancellable,
+                                  (GAsyncReadyCallback) gcm_prefs_make_profile_default_cb,
+                                  helper->prefs);
+out:
+  gcm_prefs_assign_helper_free (helper);
+}
+
+static void
+gcm_prefs_assign_add_profile (GcmPrefsAssignHelper *helper)
+{
+  /* just add it, the list store will get ::changed */
+  cd_device_add_profile (helper->device,
+                         CD_DEVICE_RELATION_HARD,
+                         helper->profile,
+                         helper->prefs->priv->cancellable,
+                         gcm_prefs_assign_add_profile_cb,
+                         helper);
+}
+
+static void
+gcm_prefs_assign_set_enabled_cb (GObject *object,
+                                 GAsyncResult *res,
+                                 gpointer user_data)
+{
+  GcmPrefsAssignHelper *helper = user_data;
+  GError *error = NULL;
+
+  if (!cd_device_set_enabled_finish (helper->device, res, &error))
+    {
+      if (!gcm_prefs_is_disposed (helper->prefs))
+        g_warning ("failed to enabled device: %s", error->message);
+      g_error_free (error);
+      gcm_prefs_assign_helper_free (helper);
+      return;
+    }
+  if (gcm_prefs_is_disposed (helper->prefs))
+    {
+      gcm_prefs_assign_helper_free (helper);
+      return;
+    }
+  gcm_prefs_assign_add_profile (helper);
 }
 
 static void
@@ -1211,68 +1730,47 @@ gcm_prefs_button_assign_ok_cb (GtkWidget *widget, CcColorPanel *prefs)
   GtkTreeIter iter;
   GtkTreeModel *model;
   CdProfile *profile = NULL;
-  gboolean ret = FALSE;
-  GError *error = NULL;
+  GcmPrefsAssignHelper *helper;
   GtkTreeSelection *selection;
   CcColorPanelPrivate *priv = prefs->priv;
 
   /* hide window */
   widget = GTK_WIDGET (priv->dialog_assign);
   gtk_widget_hide (widget);
+  g_clear_object (&priv->assign_device);
 
   /* get the selected profile */
   widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
                                                "treeview_assign"));
   selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (widget));
   if (!gtk_tree_selection_get_selected (selection, &model, &iter))
-    goto out;
+    return;
   gtk_tree_model_get (model, &iter,
                       GCM_PREFS_COMBO_COLUMN_PROFILE, &profile,
                       -1);
   if (profile == NULL)
     {
         g_warning ("failed to get the active profile");
-        goto out;
+        return;
     }
 
+  helper = g_new0 (GcmPrefsAssignHelper, 1);
+  helper->prefs = g_object_ref (prefs);
+  helper->device = g_object_ref (priv->current_device);
+  helper->profile = profile;
+
   /* if the device is disabled, enable the device so that we can
    * add color profiles to it */
   if (!cd_device_get_enabled (priv->current_device))
     {
-      ret = cd_device_set_enabled_sync (priv->current_device,
-                                        TRUE,
-                                        priv->cancellable,
-                                        &error);
-      if (!ret)
-        {
-          g_warning ("failed to enabled device: %s", error->message);
-          g_error_free (error);
-          goto out;
-        }
-    }
-
-  /* just add it, the list store will get ::changed */
-  ret = cd_device_add_profile_sync (priv->current_device,
-                                    CD_DEVICE_RELATION_HARD,
-                                    profile,
-                                    priv->cancellable,
-                                    &error);
-  if (!ret)
-    {
-      g_warning ("failed to add: %s", error->message);
-      g_error_free (error);
-      goto out;
+      cd_device_set_enabled (priv->current_device,
+                             TRUE,
+                             priv->cancellable,
+                             gcm_prefs_assign_set_enabled_cb,
+                             helper);
+      return;
     }
-
-  /* make it default */
-  cd_device_make_profile_default (priv->current_device,
-                                  profile,
-                                  priv->cancellable,
-                                  (GAsyncReadyCallback) gcm_prefs_make_profile_default_cb,
-                                  prefs);
-out:
-  if (profile != NULL)
-    g_object_unref (profile);
+  gcm_prefs_assign_add_profile (helper);
 }
 
 static gboolean
@@ -1479,13 +1977,41 @@ gcm_prefs_profiles_row_activated_cb (GtkTreeView *tree_view,
 }
 
 
+#if CD_CHECK_VERSION(0,1,12)
+static void
+gcm_prefs_import_profile_cb (GObject *object,
+                             GAsyncResult *res,
+                             gpointer user_data)
+{
+  CcColorPanel *prefs = CC_COLOR_PANEL (user_data);
+  CdProfile *profile;
+  GError *error = NULL;
+
+  profile = cd_client_import_profile_finish (CD_CLIENT (object), res, &error);
+  if (profile == NULL)
+    {
+      if (!gcm_prefs_is_disposed (prefs))
+        g_warning ("failed to get imported profile: %s", error->message);
+      g_error_free (error);
+      goto out;
+    }
+  if (gcm_prefs_is_disposed (prefs))
+    goto out;
+
+  /* add to list view */
+  gcm_prefs_profile_add_cb (NULL, prefs);
+out:
+  if (profile != NULL)
+    g_object_unref (profile);
+  g_object_unref (prefs);
+}
+#endif
+
 static void
 gcm_prefs_button_assign_import_cb (GtkWidget *widget,
                                    CcColorPanel *prefs)
 {
   GFile *file = NULL;
-  GError *error = NULL;
-  CdProfile *profile = NULL;
   CcColorPanelPrivate *priv = prefs->priv;
 
   file = gcm_prefs_file_chooser_get_icc_profile (prefs);
@@ -1498,69 +2024,116 @@ gcm_prefs_button_assign_import_cb (GtkWidget *widget,
     }
 
 #if CD_CHECK_VERSION(0,1,12)
-  profile = cd_client_import_profile_sync (priv->client,
-                                           file,
-                                           priv->cancellable,
-                                           &error);
-  if (profile == NULL)
-    {
-      g_warning ("failed to get imported profile: %s", error->message);
-      g_error_free (error);
-      goto out;
-    }
-#endif
-
+  cd_client_import_profile (priv->client,
+                            file,
+                            priv->cancellable,
+                            gcm_prefs_import_profile_cb,
+                            g_object_ref (prefs));
+#else
   /* add to list view */
   gcm_prefs_profile_add_cb (NULL, prefs);
+#endif
 out:
   if (file != NULL)
     g_object_unref (file);
-  if (profile != NULL)
-    g_object_unref (profile);
 }
 
+typedef struct {
+  CcColorPanel  *prefs;
+  GPtrArray     *sensors;
+  guint          pending;
+  guint          generation;
+} GcmPrefsSensorColdplug;
+
 static void
-gcm_prefs_sensor_coldplug (CcColorPanel *prefs)
+gcm_prefs_sensor_coldplug_finish (GcmPrefsSensorColdplug *coldplug)
 {
-  CcColorPanelPrivate *priv = prefs->priv;
-  CdSensor *sensor_tmp;
-  gboolean ret;
+  CcColorPanel *prefs = coldplug->prefs;
+
+  /* only the most recent coldplug gets to set the sensor list */
+  if (!gcm_prefs_is_disposed (prefs) &&
+      coldplug->generation == prefs->priv->sensors_generation)
+    {
+      g_clear_pointer (&prefs->priv->sensors, g_ptr_array_unref);
+      if (coldplug->sensors != NULL && coldplug->sensors->len > 0)
+        prefs->priv->sensors = g_ptr_array_ref (coldplug->sensors);
+      gcm_prefs_set_calibrate_button_sensitivity (prefs);
+    }
+
+  if (coldplug->sensors != NULL)
+    g_ptr_array_unref (coldplug->sensors);
+  g_object_unref (coldplug->prefs);
+  g_free (coldplug);
+}
+
+static void
+gcm_prefs_sensor_connect_cb (GObject *object,
+                             GAsyncResult *res,
+                             gpointer user_data)
+{
+  GcmPrefsSensorColdplug *coldplug = user_data;
   GError *error = NULL;
-  GPtrArray *sensors;
-  guint i;
 
-  /* unref old */
-  g_clear_pointer (&priv->sensors, g_ptr_array_unref);
+  if (!cd_sensor_connect_finish (CD_SENSOR (object), res, &error))
+    {
+      if (!gcm_prefs_is_disposed (coldplug->prefs))
+        g_warning ("%s", error->message);
+      g_error_free (error);
+    }
+  if (--coldplug->pending == 0)
+    gcm_prefs_sensor_coldplug_finish (coldplug);
+}
+
+static void
+gcm_prefs_get_sensors_cb (GObject *object,
+                          GAsyncResult *res,
+                          gpointer user_data)
+{
+  GcmPrefsSensorColdplug *coldplug = user_data;
+  CcColorPanel *prefs = coldplug->prefs;
+  GError *error = NULL;
+  guint i;
 
   /* no present */
-  sensors = cd_client_get_sensors_sync (priv->client, NULL, &error);
-  if (sensors == NULL)
+  coldplug->sensors = cd_client_get_sensors_finish (CD_CLIENT (object), res, &error);
+  if (coldplug->sensors == NULL)
     {
-      g_warning ("%s", error->message);
+      if (!gcm_prefs_is_disposed (prefs))
+        g_warning ("%s", error->message);
       g_error_free (error);
-      goto out;
+      gcm_prefs_sensor_coldplug_finish (coldplug);
+      return;
+    }
+  if (coldplug->sensors->len == 0 || gcm_prefs_is_disposed (prefs))
+    {
+      gcm_prefs_sensor_coldplug_finish (coldplug);
+      return;
     }
-  if (sensors->len == 0)
-    goto out;
-
-  /* save a copy of the sensor list */
-  priv->sensors = g_ptr_array_ref (sensors);
 
-  /* connect to each sensor */
-  for (i = 0; i < sensors->len; i++)
+  /* connect to all the sensors at the same time */
+  coldplug->pending = coldplug->sensors->len;
+  for (i = 0; i < coldplug->sensors->len; i++)
     {
-      sensor_tmp = g_ptr_array_index (sensors, i);
-      ret = cd_sensor_connect_sync (sensor_tmp, NULL, &error);
-      if (!ret)
-        {
-          g_warning ("%s", error->message);
-          g_error_free (error);
-          goto out;
-        }
+      cd_sensor_connect (g_ptr_array_index (coldplug->sensors, i),
+                         prefs->priv->cancellable,
+                         gcm_prefs_sensor_connect_cb,
+                         coldplug);
     }
-out:
-  if (sensors != NULL)
-    g_ptr_array_unref (sensors);
+}
+
+static void
+gcm_prefs_sensor_coldplug (CcColorPanel *prefs)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+  GcmPrefsSensorColdplug *coldplug;
+
+  coldplug = g_new0 (GcmPrefsSensorColdplug, 1);
+  coldplug->prefs = g_object_ref (prefs);
+  coldplug->generation = ++priv->sensors_generation;
+  cd_client_get_sensors (priv->client,
+                         priv->cancellable,
+                         gcm_prefs_get_sensors_cb,
+                         coldplug);
 }
 
 static void
@@ -1568,31 +2141,49 @@ gcm_prefs_client_sensor_changed_cb (CdClient *client,
                                     CdSensor *sensor,
                                     CcColorPanel *prefs)
 {
+  /* the calibrate button is updated when this completes */
   gcm_prefs_sensor_coldplug (prefs);
-  gcm_prefs_set_calibrate_button_sensitivity (prefs);
 }
 
+static gboolean gcm_prefs_find_profile_by_object_path (GPtrArray *profiles,
+                                                       const gchar *object_path);
+static gboolean gcm_prefs_find_widget_by_object_path (GList *list,
+                                                      const gchar *object_path_device,
+                                                      const gchar *object_path_profile);
+
 static void
-gcm_prefs_add_device_profile (CcColorPanel *prefs,
-                              CdDevice *device,
-                              CdProfile *profile,
-                              gboolean is_default)
+gcm_prefs_add_device_profile_connected (CcColorPanel *prefs,
+                                        CdProfile *profile,
+                                        gpointer user_data)
 {
   CcColorPanelPrivate *priv = prefs->priv;
-  gboolean ret;
-  GError *error = NULL;
+  CdDevice *device = CD_DEVICE (user_data);
+  GPtrArray *profiles = NULL;
+  GList *list = NULL;
   GtkWidget *widget;
+  gboolean is_default;
+  guint i;
 
-  /* get properties */
-  ret = cd_profile_connect_sync (profile,
-                                 priv->cancellable,
-                                 &error);
-  if (!ret)
+  /* the device may have gone, or changed, while we were waiting */
+  for (i = 0; i < priv->devices->len; i++)
     {
-      g_warning ("failed to get profile: %s", error->message);
-      g_error_free (error);
-      goto out;
+      if (g_ptr_array_index (priv->devices, i) == device)
+        break;
     }
+  if (i == priv->devices->len)
+    goto out;
+  profiles = cd_device_get_profiles (device);
+  if (profiles == NULL ||
+      !gcm_prefs_find_profile_by_object_path (profiles,
+                                              cd_profile_get_object_path (profile)))
+    goto out;
+  list = gtk_container_get_children (GTK_CONTAINER (priv->list_box));
+  if (gcm_prefs_find_widget_by_object_path (list,
+                                            cd_device_get_object_path (device),
+                                            cd_profile_get_object_path (profile)))
+    goto out;
+  is_default = g_strcmp0 (cd_profile_get_object_path (g_ptr_array_index (profiles, 0)),
+                          cd_profile_get_object_path (profile)) == 0;
 
   /* ignore profiles from other user accounts */
   if (!cd_profile_has_access (profile))
@@ -1616,8 +2207,24 @@ gcm_prefs_add_device_profile (CcColorPanel *prefs,
   gtk_widget_show (widget);
   gtk_container_add (GTK_CONTAINER (priv->list_box), widget);
   gtk_size_group_add_widget (priv->list_box_size, widget);
+  gtk_list_box_invalidate_sort (priv->list_box);
 out:
-  return;
+  g_list_free (list);
+  if (profiles != NULL)
+    g_ptr_array_unref (profiles);
+}
+
+static void
+gcm_prefs_add_device_profile (CcColorPanel *prefs,
+                              CdDevice *device,
+                              CdProfile *profile)
+{
+  /* get properties, then add to listbox */
+  gcm_prefs_get_connected_profile (prefs,
+                                   profile,
+                                   gcm_prefs_add_device_profile_connected,
+                                   g_object_ref (device),
+                                   g_object_unref);
 }
 
 static void
@@ -1634,7 +2241,7 @@ gcm_prefs_add_device_profiles (CcColorPanel *prefs, CdDevice *device)
   for (i = 0; i < profiles->len; i++)
     {
       profile_tmp = g_ptr_array_index (profiles, i);
-      gcm_prefs_add_device_profile (prefs, device, profile_tmp, i == 0);
+      gcm_prefs_add_device_profile (prefs, device, profile_tmp);
     }
 out:
   if (profiles != NULL)
@@ -1737,7 +2344,7 @@ gcm_prefs_device_changed_cb (CdDevice *device, CcColorPanel *prefs)
                                                   cd_device_get_object_path (device),
                                                   cd_profile_get_object_path (profile_tmp));
       if (!ret)
-        gcm_prefs_add_device_profile (prefs, device, profile_tmp, i == 0);
+        gcm_prefs_add_device_profile (prefs, device, profile_tmp);
     }
   g_list_free (list);
 
@@ -1783,23 +2390,42 @@ gcm_prefs_device_expanded_changed_cb (CcColorDevice *widget,
   gtk_list_box_invalidate_filter (priv->list_box);
 }
 
+static void gcm_prefs_update_device_list_extra_entry (CcColorPanel *prefs);
+
 static void
-gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
+gcm_prefs_device_connect_cb (GObject *object,
+                             GAsyncResult *res,
+                             gpointer user_data)
 {
+  CcColorPanel *prefs = CC_COLOR_PANEL (user_data);
   CcColorPanelPrivate *priv = prefs->priv;
-  gboolean ret;
+  CdDevice *device = CD_DEVICE (object);
   GError *error = NULL;
   GtkWidget *widget;
 
-  /* get device properties */
-  ret = cd_device_connect_sync (device, priv->cancellable, &error);
-  if (!ret)
+  /* the panel has gone */
+  if (gcm_prefs_is_disposed (prefs))
+    {
+      cd_device_connect_finish (device, res, NULL);
+      g_object_unref (prefs);
+      return;
+    }
+  priv->device_connects--;
+
+  if (!cd_device_connect_finish (device, res, &error))
     {
       g_warning ("failed to connect to the device: %s", error->message);
+      g_hash_table_remove (priv->devices_pending,
+                           cd_device_get_object_path (device));
       g_error_free (error);
       goto out;
     }
 
+  /* the device was removed in the meantime */
+  if (!g_hash_table_contains (priv->devices_pending,
+                              cd_device_get_object_path (device)))
+    goto out;
+
   /* add device */
   widget = cc_color_device_new (device);
   g_signal_connect (widget, "expanded-changed",
@@ -1817,7 +2443,29 @@ gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
                     G_CALLBACK (gcm_prefs_device_changed_cb), prefs);
   gtk_list_box_invalidate_sort (priv->list_box);
 out:
-  return;
+  /* ensure we're not showing the 'No devices detected' entry */
+  gcm_prefs_update_device_list_extra_entry (prefs);
+  g_object_unref (prefs);
+}
+
+static void
+gcm_prefs_add_device (CcColorPanel *prefs, CdDevice *device)
+{
+  CcColorPanelPrivate *priv = prefs->priv;
+
+  /* already added, or being added */
+  if (g_hash_table_contains (priv->devices_pending,
+                             cd_device_get_object_path (device)))
+    return;
+  g_hash_table_add (priv->devices_pending,
+                    g_strdup (cd_device_get_object_path (device)));
+  priv->device_connects++;
+
+  /* get device properties, then add the device */
+  cd_device_connect (device,
+                     priv->cancellable,
+                     gcm_prefs_device_connect_cb,
+                     g_object_ref (prefs));
 }
 
 static void
@@ -1842,6 +2490,8 @@ gcm_prefs_remove_device (CcColorPanel *prefs, CdDevice *device)
         }
     }
   g_list_free (list);
+  g_hash_table_remove (priv->devices_pending,
+                       cd_device_get_object_path (device));
   g_signal_handlers_disconnect_by_func (device,
                                         G_CALLBACK (gcm_prefs_device_changed_cb),
                                         prefs);
@@ -1856,6 +2506,11 @@ gcm_prefs_update_device_list_extra_entry (CcColorPanel *prefs)
   GtkWidget *widget;
   guint number_of_devices;
 
+  /* wait for the devices being connected, so that neither the
+   * 'No devices detected' entry nor a lone device flash up */
+  if (!priv->devices_listed || priv->device_connects > 0)
+    return;
+
   /* any devices to show? */
   device_widgets = gtk_container_get_children (GTK_CONTAINER (priv->list_box));
   number_of_devices = g_list_length (device_widgets);
@@ -1867,8 +2522,9 @@ gcm_prefs_update_device_list_extra_entry (CcColorPanel *prefs)
   gtk_widget_set_visible (widget, number_of_devices > 0);
 
   /* if we have only one device expand it by default */
-  if (number_of_devices == 1)
+  if (!priv->devices_settled && number_of_devices == 1)
     cc_color_device_set_expanded (CC_COLOR_DEVICE (device_widgets->data), TRUE);
+  priv->devices_settled = TRUE;
   g_list_free (device_widgets);
 }
 
@@ -1912,22 +2568,30 @@ gcm_prefs_get_devices_cb (GObject *object,
   devices = cd_client_get_devices_finish (client, res, &error);
   if (devices == NULL)
     {
+      /* the panel has gone */
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_error_free (error);
+          return;
+        }
       g_warning ("failed to add connected devices: %s",
                  error->message);
       g_error_free (error);
-      goto out;
     }
-  for (i = 0; i < devices->len; i++)
+  else
     {
-      device = g_ptr_array_index (devices, i);
-      gcm_prefs_add_device (prefs, device);
+      for (i = 0; i < devices->len; i++)
+        {
+          device = g_ptr_array_index (devices, i);
+          gcm_prefs_add_device (prefs, device);
+        }
+      g_ptr_array_unref (devices);
     }
 
-  /* ensure we show the 'No devices detected' entry if empty */
+  /* ensure we show the 'No devices detected' entry if empty, this is
+   * otherwise done when the last device is connected */
+  prefs->priv->devices_listed = TRUE;
   gcm_prefs_update_device_list_extra_entry (prefs);
-out:
-  if (devices != NULL)
-    g_ptr_array_unref (devices);
 }
 
 static void
@@ -2037,7 +2701,6 @@ gcm_prefs_connect_cb (GObject *object,
   /* set calibrate button sensitivity */
   gcm_prefs_sensor_coldplug (prefs);
 
-
   /* get devices */
   cd_client_get_devices (priv->client,
                          priv->cancellable,
@@ -2118,6 +2781,7 @@ static void
 cc_color_panel_dispose (GObject *object)
 {
   CcColorPanelPrivate *priv = CC_COLOR_PANEL (object)->priv;
+  GcmPrefsProfileRequest *request;
   CdDevice *device;
   guint i;
 
@@ -2150,6 +2814,18 @@ cc_color_panel_dispose (GObject *object)
 
   if (priv->cancellable != NULL)
     g_cancellable_cancel (priv->cancellable);
+
+  /* drop the profiles still waiting for their properties */
+  while ((request = g_queue_pop_head (&priv->profile_queue)) != NULL)
+    gcm_prefs_profile_request_free (request);
+  g_clear_pointer (&priv->profile_cache, g_hash_table_unref);
+  g_clear_pointer (&priv->catalogue_index, g_hash_table_unref);
+  g_clear_pointer (&priv->catalogue, g_hash_table_unref);
+  g_clear_pointer (&priv->assign_exclude, g_hash_table_unref);
+  g_clear_pointer (&priv->assign_search, g_free);
+  g_clear_object (&priv->assign_device);
+  g_clear_pointer (&priv->devices_pending, g_hash_table_unref);
+
   g_clear_object (&priv->settings);
   g_clear_object (&priv->settings_colord);
   g_clear_object (&priv->cancellable);
@@ -2273,6 +2949,19 @@ cc_color_panel_init (CcColorPanel *prefs)
 
   priv->cancellable = g_cancellable_new ();
   priv->devices = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
+  priv->devices_pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
+  priv->profile_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_object_unref);
+  g_queue_init (&priv->profile_queue);
+  priv->catalogue = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free,
+                                           (GDestroyNotify) gcm_prefs_catalogue_entry_free);
+  priv->catalogue_index = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                 NULL,
+                                                 (GDestroyNotify) g_hash_table_unref);
+  priv->assign_exclude = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, NULL);
 
   /* can do native display calibration using colord-session */
   priv->calibrate = cc_color_calibrate_new ();
@@ -2371,6 +3060,10 @@ cc_color_panel_init (CcColorPanel *prefs)
                                                "button_assign_import"));
   g_signal_connect (widget, "clicked",
                     G_CALLBACK (gcm_prefs_button_assign_import_cb), prefs);
+  widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                               "entry_assign_search"));
+  g_signal_connect (widget, "search-changed",
+                    G_CALLBACK (gcm_prefs_assign_search_changed_cb), prefs);
 
   /* setup the calibration helper */
   widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
@@ -2502,6 +3195,12 @@ cc_color_panel_init (CcColorPanel *prefs)
                            G_CALLBACK (gcm_prefs_device_added_cb), prefs, 0);
   g_signal_connect_object (priv->client, "device-removed",
                            G_CALLBACK (gcm_prefs_device_removed_cb), prefs, 0);
+  g_signal_connect_object (priv->client, "profile-added",
+                           G_CALLBACK (gcm_prefs_client_profile_added_cb), prefs, 0);
+  g_signal_connect_object (priv->client, "profile-changed",
+                           G_CALLBACK (gcm_prefs_client_profile_changed_cb), prefs, 0);
+  g_signal_connect_object (priv->client, "profile-removed",
+                           G_CALLBACK (gcm_prefs_client_profile_removed_cb), prefs, 0);
 
   /* use a listbox for the main UI */
   priv->list_box = GTK_LIST_BOX (gtk_list_box_new ());
@@ -21,10 +21,12 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <locale.h>
 
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 
 #include <fontconfig/fontconfig.h>
@@ -87,58 +89,216 @@ cc_common_language_get_iter_for_language (GtkTreeModel *model,
   return iter_for_language (model, lang, iter, FALSE);
 }
 
-gboolean
-cc_common_language_has_font (const gchar *locale)
+/* Languages covered by at least one installed font. Listing every font
+ * once and checking the language against the union of their coverage is
+ * much cheaper than one FcFontList() per locale, and the result is kept
+ * on disk until the fontconfig caches change. */
+static GHashTable *font_languages = NULL;
+
+static gchar *
+get_font_languages_cache_path (void)
 {
-        const FcCharSet *charset;
-        FcPattern       *pattern;
-        FcObjectSet     *object_set;
-        FcFontSet       *font_set;
-        gchar           *language_code;
-        gboolean         is_displayable;
-
-        is_displayable = FALSE;
-        pattern = NULL;
-        object_set = NULL;
-        font_set = NULL;
+        return g_build_filename (g_get_user_cache_dir (),
+                                 "gnome-control-center",
+                                 "font-languages",
+                                 NULL);
+}
 
-        if (!gnome_parse_locale (locale, &language_code, NULL, NULL, NULL))
-                return FALSE;
+static gint64
+get_fontconfig_cache_timestamp (void)
+{
+        FcStrList *dirs;
+        FcChar8   *dir;
+        gint64     timestamp;
 
-        charset = FcLangGetCharSet ((FcChar8 *) language_code);
-        if (!charset) {
-                /* fontconfig does not know about this language */
-                is_displayable = TRUE;
+        timestamp = 0;
+
+        dirs = FcConfigGetCacheDirs (NULL);
+        if (dirs == NULL)
+                return 0;
+
+        while ((dir = FcStrListNext (dirs)) != NULL) {
+                GStatBuf buf;
+
+                if (g_stat ((const gchar *) dir, &buf) == 0)
+                        timestamp = MAX (timestamp, (gint64) buf.st_mtime);
         }
-        else {
-                /* see if any fonts support rendering it */
-                pattern = FcPatternBuild (NULL, FC_LANG, FcTypeString, language_code, NULL);
+        FcStrListDone (dirs);
+
+        return timestamp;
+}
+
+static void
+add_font_language (GHashTable  *languages,
+                   const gchar *lang)
+{
+        const gchar *territory;
+
+        /* Fonts covering a territory variant also display the language */
+        territory = strchr (lang, '-');
+        if (territory != NULL)
+                g_hash_table_add (languages, g_strndup (lang, territory - lang));
+        else
+                g_hash_table_add (languages, g_strdup (lang));
+}
+
+static gboolean
+load_font_languages_cache (GHashTable *languages,
+                           gint64      timestamp)
+{
+        GKeyFile  *keyfile;
+        gchar     *path;
+        gchar    **langs;
+        gboolean   ret;
+        guint      i;
+
+        ret = FALSE;
+        langs = NULL;
+
+        keyfile = g_key_file_new ();
+        path = get_font_languages_cache_path ();
+
+        if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, NULL))
+                goto out;
+
+        if (g_key_file_get_int64 (keyfile, "Fonts", "Timestamp", NULL) != timestamp)
+                goto out;
+
+        langs = g_key_file_get_string_list (keyfile, "Fonts", "Languages", NULL, NULL);
+        if (langs == NULL)
+                goto out;
+
+        for (i = 0; langs[i] != NULL; i++)
+                g_hash_table_add (languages, g_strdup (langs[i]));
 
-                if (pattern == NULL)
-                        goto done;
+        ret = TRUE;
 
-                object_set = FcObjectSetCreate ();
+ out:
+        g_strfreev (langs);
+        g_free (path);
+        g_key_file_unref (keyfile);
 
-                if (object_set == NULL)
-                        goto done;
+        return ret;
+}
 
-                font_set = FcFontList (NULL, pattern, object_set);
+static void
+save_font_languages_cache (GHashTable *languages,
+                           gint64      timestamp)
+{
+        GKeyFile *keyfile;
+        GError   *error = NULL;
+        gchar    *path;
+        gchar    *dir;
+        gchar    *data;
+        gchar   **langs;
+        gsize     length;
+
+        keyfile = g_key_file_new ();
+        path = get_font_languages_cache_path ();
+
+        langs = (gchar **) g_hash_table_get_keys_as_array (languages, &length);
+        g_key_file_set_int64 (keyfile, "Fonts", "Timestamp", timestamp);
+        g_key_file_set_string_list (keyfile, "Fonts", "Languages",
+                                    (const gchar * const *) langs, length);
+        g_free (langs);
+
+        dir = g_path_get_dirname (path);
+        g_mkdir_with_parents (dir, 0755);
+
+        data = g_key_file_to_data (keyfile, &length, NULL);
+        if (!g_file_set_contents (path, data, length, &error)) {
+                g_debug ("Could not save font language cache: %s", error->message);
+                g_error_free (error);
+        }
 
-                if (font_set == NULL)
-                        goto done;
+        g_free (data);
+        g_free (dir);
+        g_free (path);
+        g_key_file_unref (keyfile);
+}
 
-                is_displayable = (font_set->nfont > 0);
+static void
+scan_font_languages (GHashTable *languages)
+{
+        FcPattern   *pattern;
+        FcObjectSet *object_set;
+        FcFontSet   *font_set;
+        FcLangSet   *all_langs;
+        FcStrSet    *langs;
+        FcStrList   *list;
+        FcChar8     *lang;
+        gint         i;
+
+        pattern = FcPatternCreate ();
+        object_set = FcObjectSetBuild (FC_LANG, NULL);
+        font_set = FcFontList (NULL, pattern, object_set);
+        all_langs = FcLangSetCreate ();
+
+        for (i = 0; font_set != NULL && i < font_set->nfont; i++) {
+                FcLangSet *font_langs;
+                FcLangSet *merged;
+
+                if (FcPatternGetLangSet (font_set->fonts[i], FC_LANG, 0, &font_langs) != FcResultMatch)
+                        continue;
+
+                merged = FcLangSetUnion (all_langs, font_langs);
+                FcLangSetDestroy (all_langs);
+                all_langs = merged;
         }
 
- done:
+        langs = FcLangSetGetLangs (all_langs);
+        list = FcStrListCreate (langs);
+        while ((lang = FcStrListNext (list)) != NULL)
+                add_font_language (languages, (const gchar *) lang);
+        FcStrListDone (list);
+        FcStrSetDestroy (langs);
+
+        FcLangSetDestroy (all_langs);
         if (font_set != NULL)
                 FcFontSetDestroy (font_set);
+        FcObjectSetDestroy (object_set);
+        FcPatternDestroy (pattern);
+}
+
+static GHashTable *
+get_font_languages (void)
+{
+        gint64 timestamp;
+
+        if (font_languages != NULL)
+                return font_languages;
+
+        font_languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
-        if (object_set != NULL)
-                FcObjectSetDestroy (object_set);
+        /* Without a fontconfig cache to compare with, the disk cache could
+         * never be invalidated, so it is not used at all */
+        timestamp = get_fontconfig_cache_timestamp ();
+        if (timestamp == 0) {
+                scan_font_languages (font_languages);
+        } else if (!load_font_languages_cache (font_languages, timestamp)) {
+                scan_font_languages (font_languages);
+                save_font_languages_cache (font_languages, timestamp);
+        }
+
+        return font_languages;
+}
+
+gboolean
+cc_common_language_has_font (const gchar *locale)
+{
+        gchar    *language_code;
+        gboolean  is_displayable;
 
-        if (pattern != NULL)
-                FcPatternDestroy (pattern);
+        if (!gnome_parse_locale (locale, &language_code, NULL, NULL, NULL))
+                return FALSE;
+
+        if (!FcLangGetCharSet ((FcChar8 *) language_code)) {
+                /* fontconfig does not know about this language */
+                is_displayable = TRUE;
+        } else {
+                /* see if any fonts support rendering it */
+                is_displayable = g_hash_table_contains (get_font_languages (), language_code);
+        }
 
         g_free (language_code);
 
@@ -22,6 +22,7 @@
 
 #include <gtk/gtk.h>
 #include "scrollarea.h"
+#include "cc-display-snap.h"
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-rr.h>
 #include <libgnome-desktop/gnome-rr-config.h>
@@ -77,13 +78,16 @@ struct _CcDisplayPanelPrivate
   GtkWidget *arrange_button;
   GtkWidget *res_combo;
   GtkWidget *freq_combo;
-  GHashTable *res_freqs;
+  GHashTable *mode_catalogues;
+  struct ModeCatalogue *clone_catalogue;
+  struct ModeCatalogue *mode_catalogue;
   GtkWidget *scaling_switch;
   GtkWidget *rotate_left_button;
   GtkWidget *upside_down_button;
   GtkWidget *rotate_right_button;
   GtkWidget *dialog;
   GtkWidget *config_grid;
+  GArray    *output_tiles;
 
   UpClient *up_client;
   gboolean lid_is_closed;
@@ -102,8 +106,50 @@ typedef struct
   int grab_y;
   int output_x;
   int output_y;
+  CcDisplaySnap *snap;
 } GrabInfo;
 
+/* A refresh rate offered for a resolution */
+typedef struct
+{
+  GnomeRRMode *mode;
+  gchar       *label;
+  gboolean     atsc_duplicate;    /* the next, lower, rate is its NTSC variant */
+} ModeRate;
+
+typedef struct
+{
+  GnomeRRMode *mode;              /* the first mode with this resolution */
+  gchar       *label;
+  gint         width;
+  gint         height;
+  gboolean     interlaced;
+  GArray      *rates;             /* ModeRate, highest to lowest */
+} ModeResolution;
+
+/* The modes of an output grouped by resolution, built once for as
+ * long as the screen doesn't change */
+typedef struct ModeCatalogue
+{
+  GnomeRRMode **modes;
+  GPtrArray    *resolutions;      /* ModeResolution, in the order of @modes */
+  GHashTable   *by_mode;          /* GnomeRRMode → ModeResolution */
+} ModeCatalogue;
+
+/* An output as laid out in the arrangement dialog, with its rendering
+ * kept around for as long as its size and decorations don't change */
+typedef struct
+{
+  GnomeRROutputInfo *output;
+  GdkRectangle       rect;              /* in canvas coordinates */
+  gint               width;
+  gint               height;
+  gint               num;
+  gboolean           active;
+  gboolean           has_top_bar;
+  cairo_surface_t   *surface;
+} OutputTile;
+
 static GHashTable *output_ids;
 
 gint
@@ -199,6 +245,39 @@ ensure_monitor_labels (CcDisplayPanel *self)
   g_list_free (windows);
 }
 
+static void
+mode_rate_clear (ModeRate *rate)
+{
+  g_free (rate->label);
+}
+
+static void
+mode_resolution_free (ModeResolution *resolution)
+{
+  g_array_unref (resolution->rates);
+  g_free (resolution->label);
+  g_free (resolution);
+}
+
+static void
+mode_catalogue_free (ModeCatalogue *catalogue)
+{
+  g_hash_table_destroy (catalogue->by_mode);
+  g_ptr_array_unref (catalogue->resolutions);
+  g_free (catalogue);
+}
+
+static void
+clear_mode_catalogues (CcDisplayPanel *panel)
+{
+  CcDisplayPanelPrivate *priv = panel->priv;
+
+  priv->mode_catalogue = NULL;
+  g_clear_pointer (&priv->clone_catalogue, mode_catalogue_free);
+  if (priv->mode_catalogues)
+    g_hash_table_remove_all (priv->mode_catalogues);
+}
+
 static void
 cc_display_panel_dispose (GObject *object)
 {
@@ -237,6 +316,9 @@ cc_display_panel_dispose (GObject *object)
       priv->screen_changed_handler_id = 0;
     }
 
+  clear_mode_catalogues (CC_DISPLAY_PANEL (object));
+  g_clear_pointer (&priv->mode_catalogues, g_hash_table_destroy);
+
   g_clear_object (&priv->screen);
   g_clear_object (&priv->up_client);
   g_clear_object (&priv->background);
@@ -247,6 +329,7 @@ cc_display_panel_dispose (GObject *object)
       gtk_widget_destroy (priv->dialog);
       priv->dialog = NULL;
     }
+  g_clear_pointer (&priv->output_tiles, g_array_unref);
 
   g_cancellable_cancel (priv->shell_cancellable);
   g_clear_object (&priv->shell_cancellable);
@@ -329,7 +412,11 @@ on_viewport_changed (FooScrollArea *scroll_area,
                             new_viewport->width,
                             new_viewport->height);
 
-  foo_scroll_area_invalidate (scroll_area);
+  /* The layout is scaled to the viewport size, scrolling is
+   * taken care of by the scroll area itself */
+  if (old_viewport->width != new_viewport->width ||
+      old_viewport->height != new_viewport->height)
+    foo_scroll_area_invalidate (scroll_area);
 }
 
 static void
@@ -498,6 +585,9 @@ on_screen_changed (CcDisplayPanel *panel)
   if (priv->dialog)
     gtk_dialog_response (GTK_DIALOG (priv->dialog), GTK_RESPONSE_NONE);
 
+  /* The modes belong to the screen */
+  clear_mode_catalogues (panel);
+
   gnome_rr_screen_refresh (priv->screen, NULL);
 
   current = gnome_rr_config_new_current (priv->screen, NULL);
@@ -812,339 +902,148 @@ compute_scale (CcDisplayPanel *self, FooScrollArea *area)
   return MIN ((double)available_w / total_w, (double)available_h / total_h);
 }
 
-typedef struct Edge
-{
-  GnomeRROutputInfo *output;
-  int x1, y1;
-  int x2, y2;
-} Edge;
-
-typedef struct Snap
-{
-  Edge *snapper;              /* Edge that should be snapped */
-  Edge *snappee;
-  int dy, dx;
-} Snap;
-
 static void
-add_edge (GnomeRROutputInfo *output, int x1, int y1, int x2, int y2, GArray *edges)
+output_tile_clear (OutputTile *tile)
 {
-  Edge e;
-
-  e.x1 = x1;
-  e.x2 = x2;
-  e.y1 = y1;
-  e.y2 = y2;
-  e.output = output;
-
-  g_array_append_val (edges, e);
+  g_clear_pointer (&tile->surface, cairo_surface_destroy);
 }
 
-static void
-list_edges_for_output (GnomeRROutputInfo *output, GArray *edges)
+static OutputTile *
+find_output_tile (GArray            *tiles,
+                  GnomeRROutputInfo *output)
 {
-  int x, y, w, h;
-
-  get_geometry (output, &x, &y, &w, &h);
-
-  /* Top, Bottom, Left, Right */
-  add_edge (output, x, y, x + w, y, edges);
-  add_edge (output, x, y + h, x + w, y + h, edges);
-  add_edge (output, x, y, x, y + h, edges);
-  add_edge (output, x + w, y, x + w, y + h, edges);
-}
+  guint i;
 
-static void
-list_edges (GnomeRRConfig *config, GArray *edges)
-{
-  int i;
-  GnomeRROutputInfo **outputs = gnome_rr_config_get_outputs (config);
+  if (tiles == NULL)
+    return NULL;
 
-  for (i = 0; outputs[i]; ++i)
+  for (i = 0; i < tiles->len; i++)
     {
-      if (gnome_rr_output_info_is_connected (outputs[i]))
-	{
-	  if (!gnome_rr_output_info_is_primary_tile (outputs[i]))
-	    continue;
-	  list_edges_for_output (outputs[i], edges);
-	}
-    }
-}
-
-static gboolean
-overlap (int s1, int e1, int s2, int e2)
-{
-  return (!(e1 < s2 || s1 >= e2));
-}
-
-static gboolean
-horizontal_overlap (Edge *snapper, Edge *snappee)
-{
-  if (snapper->y1 != snapper->y2 || snappee->y1 != snappee->y2)
-    return FALSE;
-
-  return overlap (snapper->x1, snapper->x2, snappee->x1, snappee->x2);
-}
-
-static gboolean
-vertical_overlap (Edge *snapper, Edge *snappee)
-{
-  if (snapper->x1 != snapper->x2 || snappee->x1 != snappee->x2)
-    return FALSE;
+      OutputTile *tile = &g_array_index (tiles, OutputTile, i);
 
-  return overlap (snapper->y1, snapper->y2, snappee->y1, snappee->y2);
-}
-
-static void
-add_snap (GArray *snaps, Snap snap)
-{
-  if (ABS (snap.dx) <= 200 || ABS (snap.dy) <= 200)
-    g_array_append_val (snaps, snap);
+      if (tile->output == output)
+        return tile;
+    }
+  return NULL;
 }
 
+/* Lays out the connected outputs in the viewport, reusing the rendering of
+ * those that only moved. If @damage is not %NULL, the area of the tiles that
+ * changed is added to it. */
 static void
-add_edge_snaps (Edge *snapper, Edge *snappee, GArray *snaps)
+update_output_tiles (CcDisplayPanel *self,
+                     FooScrollArea  *area,
+                     cairo_region_t *damage)
 {
-  Snap snap;
-
-  snap.snapper = snapper;
-  snap.snappee = snappee;
-
-  if (horizontal_overlap (snapper, snappee))
-    {
-      snap.dx = 0;
-      snap.dy = snappee->y1 - snapper->y1;
-
-      add_snap (snaps, snap);
-    }
-  else if (vertical_overlap (snapper, snappee))
-    {
-      snap.dy = 0;
-      snap.dx = snappee->x1 - snapper->x1;
-
-      add_snap (snaps, snap);
-    }
-
-  /* Corner snaps */
-  /* 1->1 */
-  snap.dx = snappee->x1 - snapper->x1;
-  snap.dy = snappee->y1 - snapper->y1;
-
-  add_snap (snaps, snap);
-
-  /* 1->2 */
-  snap.dx = snappee->x2 - snapper->x1;
-  snap.dy = snappee->y2 - snapper->y1;
-
-  add_snap (snaps, snap);
+  CcDisplayPanelPrivate *priv = self->priv;
+  GArray *old_tiles = priv->output_tiles;
+  GList *connected_outputs;
+  GList *list;
+  GdkRectangle viewport;
+  int total_w, total_h;
+  int available_w, available_h;
+  int n_monitors;
+  double scale;
+  gboolean clone;
 
-  /* 2->2 */
-  snap.dx = snappee->x2 - snapper->x2;
-  snap.dy = snappee->y2 - snapper->y2;
+  priv->output_tiles = g_array_new (FALSE, TRUE, sizeof (OutputTile));
+  g_array_set_clear_func (priv->output_tiles, (GDestroyNotify) output_tile_clear);
 
-  add_snap (snaps, snap);
+  connected_outputs = list_connected_outputs (self, &total_w, &total_h);
+  n_monitors = g_list_length (connected_outputs);
 
-  /* 2->1 */
-  snap.dx = snappee->x1 - snapper->x2;
-  snap.dy = snappee->y1 - snapper->y2;
+  foo_scroll_area_get_viewport (area, &viewport);
+  available_w = viewport.width - 2 * MARGIN - (n_monitors - 1) * SPACE;
+  available_h = viewport.height - 2 * MARGIN - (n_monitors - 1) * SPACE;
+  scale = MIN ((double)available_w / total_w, (double)available_h / total_h);
 
-  add_snap (snaps, snap);
-}
+  viewport.height -= 2 * MARGIN;
+  viewport.width -= 2 * MARGIN;
 
-static void
-list_snaps (GnomeRROutputInfo *output, GArray *edges, GArray *snaps)
-{
-  int i;
+  clone = gnome_rr_config_get_clone (priv->current_configuration);
 
-  for (i = 0; i < edges->len; ++i)
+  for (list = connected_outputs; list != NULL; list = list->next)
     {
-      Edge *output_edge = &(g_array_index (edges, Edge, i));
-
-      if (output_edge->output == output)
-        {
-          int j;
+      GnomeRROutputInfo *output = list->data;
+      OutputTile tile = { NULL, };
+      OutputTile *old_tile;
+      int output_x, output_y;
+      int w, h;
 
-          for (j = 0; j < edges->len; ++j)
-            {
-              Edge *edge = &(g_array_index (edges, Edge, j));
+      get_geometry (output, &output_x, &output_y, &w, &h);
 
-              if (edge->output != output)
-                add_edge_snaps (output_edge, edge, snaps);
-            }
+      tile.output = output;
+      tile.rect.x = output_x * scale + MARGIN + (viewport.width - total_w * scale) / 2.0;
+      tile.rect.y = output_y * scale + MARGIN + (viewport.height - total_h * scale) / 2.0;
+      tile.rect.width = w * scale + 0.5;
+      tile.rect.height = h * scale + 0.5;
+      tile.width = w * scale;
+      tile.height = h * scale;
+      tile.num = cc_display_panel_get_output_id (output);
+      tile.active = gnome_rr_output_info_is_active (output);
+      tile.has_top_bar = gnome_rr_output_info_get_primary (output) || clone;
+
+      old_tile = find_output_tile (old_tiles, output);
+      if (old_tile != NULL &&
+          old_tile->width == tile.width &&
+          old_tile->height == tile.height &&
+          old_tile->num == tile.num &&
+          old_tile->active == tile.active &&
+          old_tile->has_top_bar == tile.has_top_bar)
+        {
+          tile.surface = old_tile->surface;
+          old_tile->surface = NULL;
         }
-    }
-}
 
-#if 0
-static void
-print_edge (Edge *edge)
-{
-  g_debug ("(%d %d %d %d)", edge->x1, edge->y1, edge->x2, edge->y2);
-}
-#endif
-
-static gboolean
-corner_on_edge (int x, int y, Edge *e)
-{
-  if (x == e->x1 && x == e->x2 && y >= e->y1 && y <= e->y2)
-    return TRUE;
-
-  if (y == e->y1 && y == e->y2 && x >= e->x1 && x <= e->x2)
-    return TRUE;
-
-  return FALSE;
-}
-
-static gboolean
-edges_align (Edge *e1, Edge *e2)
-{
-  if (corner_on_edge (e1->x1, e1->y1, e2))
-    return TRUE;
-
-  if (corner_on_edge (e2->x1, e2->y1, e1))
-    return TRUE;
+      if (damage != NULL &&
+          (old_tile == NULL || tile.surface == NULL ||
+           !gdk_rectangle_equal (&old_tile->rect, &tile.rect)))
+        {
+          if (old_tile != NULL)
+            cairo_region_union_rectangle (damage, &old_tile->rect);
+          cairo_region_union_rectangle (damage, &tile.rect);
+        }
 
-  return FALSE;
-}
+      g_array_append_val (priv->output_tiles, tile);
 
-static gboolean
-output_is_aligned (GnomeRROutputInfo *output, GArray *edges)
-{
-  gboolean result = FALSE;
-  int i;
+      if (clone)
+        break;
+    }
 
-  for (i = 0; i < edges->len; ++i)
+  g_list_free (connected_outputs);
+  if (old_tiles != NULL)
     {
-      Edge *output_edge = &(g_array_index (edges, Edge, i));
+      guint i;
 
-      if (output_edge->output == output)
+      for (i = 0; damage != NULL && i < old_tiles->len; i++)
         {
-          int j;
-
-          for (j = 0; j < edges->len; ++j)
-            {
-              Edge *edge = &(g_array_index (edges, Edge, j));
+          OutputTile *old_tile = &g_array_index (old_tiles, OutputTile, i);
 
-              /* We are aligned if an output edge matches
-               * an edge of another output
-               */
-              if (edge->output != output_edge->output)
-                {
-                  if (edges_align (output_edge, edge))
-                    {
-                      result = TRUE;
-                      goto done;
-                    }
-                }
-            }
+          if (find_output_tile (priv->output_tiles, old_tile->output) == NULL)
+            cairo_region_union_rectangle (damage, &old_tile->rect);
         }
-    }
- done:
-
-  return result;
-}
-
-static void
-get_output_rect (GnomeRROutputInfo *output, GdkRectangle *rect)
-{
-  get_geometry (output, &rect->x, &rect->y, &rect->width, &rect->height);
-}
-
-static gboolean
-output_overlaps (GnomeRROutputInfo *output, GnomeRRConfig *config)
-{
-  int i;
-  GdkRectangle output_rect;
-  GnomeRROutputInfo **outputs;
-
-  g_assert (output != NULL);
-
-  get_output_rect (output, &output_rect);
-
-  outputs = gnome_rr_config_get_outputs (config);
-  for (i = 0; outputs[i]; ++i)
-    {
-      if (!gnome_rr_output_info_is_primary_tile (outputs[i]))
-	continue;
-      if (outputs[i] != output && gnome_rr_output_info_is_connected (outputs[i]))
-	{
-	  GdkRectangle other_rect;
 
-	  get_output_rect (outputs[i], &other_rect);
-	  if (gdk_rectangle_intersect (&output_rect, &other_rect, NULL))
-	    return TRUE;
-	}
+      g_array_unref (old_tiles);
     }
-
-  return FALSE;
 }
 
-static gboolean
-gnome_rr_config_is_aligned (GnomeRRConfig *config, GArray *edges)
+/* Only repaints the outputs that moved or changed since the last paint */
+static void
+invalidate_output_tiles (CcDisplayPanel *self,
+                         FooScrollArea  *area)
 {
-  int i;
-  gboolean result = TRUE;
-  GnomeRROutputInfo **outputs;
+  cairo_region_t *damage;
 
-  outputs = gnome_rr_config_get_outputs (config);
-  for (i = 0; outputs[i]; ++i)
+  if (self->priv->output_tiles == NULL)
     {
-      if (!gnome_rr_output_info_is_primary_tile (outputs[i]))
-	continue;
-      if (gnome_rr_output_info_is_connected (outputs[i]))
-	{
-	  if (!output_is_aligned (outputs[i], edges))
-	    return FALSE;
-
-	  if (output_overlaps (outputs[i], config))
-	    return FALSE;
-	}
+      foo_scroll_area_invalidate (area);
+      return;
     }
 
-  return result;
-}
-
-static gboolean
-is_corner_snap (const Snap *s)
-{
-  return s->dx != 0 && s->dy != 0;
-}
-
-static int
-compare_snaps (gconstpointer v1, gconstpointer v2)
-{
-  const Snap *s1 = v1;
-  const Snap *s2 = v2;
-  int sv1 = MAX (ABS (s1->dx), ABS (s1->dy));
-  int sv2 = MAX (ABS (s2->dx), ABS (s2->dy));
-  int d;
-
-  d = sv1 - sv2;
-
-  /* This snapping algorithm is good enough for rock'n'roll, but
-   * this is probably a better:
-   *
-   *    First do a horizontal/vertical snap, then
-   *    with the new coordinates from that snap,
-   *    do a corner snap.
-   *
-   * Right now, it's confusing that corner snapping
-   * depends on the distance in an axis that you can't actually see.
-   *
-   */
-  if (d == 0)
-    {
-      if (is_corner_snap (s1) && !is_corner_snap (s2))
-        return -1;
-      else if (is_corner_snap (s2) && !is_corner_snap (s1))
-        return 1;
-      else
-        return 0;
-    }
-  else
-    {
-      return d;
-    }
+  damage = cairo_region_create ();
+  update_output_tiles (self, area, damage);
+  foo_scroll_area_invalidate_region (area, damage);
+  cairo_region_destroy (damage);
 }
 
 /* Sets a mouse cursor for a widget's window.  As a hack, you can pass
@@ -1178,6 +1077,50 @@ grab_weak_ref_notify (gpointer  area,
   foo_scroll_area_end_grab (area, NULL);
 }
 
+static void
+grab_info_free (GrabInfo *info)
+{
+  g_clear_pointer (&info->snap, cc_display_snap_free);
+  g_free (info);
+}
+
+/* Snapping only considers the outputs that are shown, and sets up
+ * what it needs about the ones that stay put when the drag starts */
+static CcDisplaySnap *
+create_snap_for_output (CcDisplayPanel    *self,
+                        GnomeRROutputInfo *output)
+{
+  GnomeRROutputInfo **outputs;
+  CcDisplaySnap *snap = NULL;
+  GArray *rects;
+  int moving = -1;
+  int i;
+
+  rects = g_array_new (FALSE, FALSE, sizeof (GdkRectangle));
+  outputs = gnome_rr_config_get_outputs (self->priv->current_configuration);
+  for (i = 0; outputs[i]; ++i)
+    {
+      GdkRectangle rect;
+
+      if (!gnome_rr_output_info_is_connected (outputs[i]) ||
+          !gnome_rr_output_info_is_primary_tile (outputs[i]))
+        continue;
+
+      if (outputs[i] == output)
+        moving = rects->len;
+
+      get_geometry (outputs[i], &rect.x, &rect.y, &rect.width, &rect.height);
+      g_array_append_val (rects, rect);
+    }
+
+  if (moving >= 0)
+    snap = cc_display_snap_new ((GdkRectangle *) rects->data, rects->len, moving);
+
+  g_array_free (rects, TRUE);
+
+  return snap;
+}
+
 static GnomeRROutputInfo *
 find_output (GnomeRROutputInfo **outputs,
              const gchar        *name)
@@ -1302,10 +1245,12 @@ on_output_event (FooScrollArea *area,
 	  info->grab_y = event->y;
 	  info->output_x = output_x;
 	  info->output_y = output_y;
+	  info->snap = create_snap_for_output (self, output);
 
-	  g_object_set_data (G_OBJECT (output), "grab-info", info);
+	  g_object_set_data_full (G_OBJECT (output), "grab-info", info,
+				  (GDestroyNotify) grab_info_free);
 	}
-      foo_scroll_area_invalidate (area);
+      invalidate_output_tiles (self, area);
     }
   else
     {
@@ -1316,56 +1261,27 @@ on_output_event (FooScrollArea *area,
 	  int old_x, old_y;
 	  int width, height;
 	  int new_x, new_y;
-	  int i;
-	  GArray *edges, *snaps, *new_edges;
+	  GdkRectangle dragged;
+	  int dx, dy;
 
 	  gnome_rr_output_info_get_geometry (output, &old_x, &old_y, &width, &height);
 	  new_x = info->output_x + (event->x - info->grab_x) / scale;
 	  new_y = info->output_y + (event->y - info->grab_y) / scale;
 
 	  gnome_rr_output_info_set_geometry (output, new_x, new_y, width, height);
+	  get_geometry (output, &dragged.x, &dragged.y, &dragged.width, &dragged.height);
 
-	  edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-	  snaps = g_array_new (TRUE, TRUE, sizeof (Snap));
-	  new_edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-
-	  list_edges (self->priv->current_configuration, edges);
-	  list_snaps (output, edges, snaps);
-
-	  g_array_sort (snaps, compare_snaps);
-
-	  gnome_rr_output_info_set_geometry (output, old_x, old_y, width, height);
-
-	  for (i = 0; i < snaps->len; ++i)
-	    {
-	      Snap *snap = &(g_array_index (snaps, Snap, i));
-	      GArray *new_edges = g_array_new (TRUE, TRUE, sizeof (Edge));
-
-	      gnome_rr_output_info_set_geometry (output, new_x + snap->dx, new_y + snap->dy, width, height);
-
-	      g_array_set_size (new_edges, 0);
-	      list_edges (self->priv->current_configuration, new_edges);
-
-	      if (gnome_rr_config_is_aligned (self->priv->current_configuration, new_edges))
-		{
-		  g_array_free (new_edges, TRUE);
-		  break;
-		}
-	      else
-		{
-		  gnome_rr_output_info_set_geometry (output, info->output_x, info->output_y, width, height);
-		}
-	    }
-
-	  g_array_free (new_edges, TRUE);
-	  g_array_free (snaps, TRUE);
-	  g_array_free (edges, TRUE);
+	  if (info->snap == NULL)
+	    gnome_rr_output_info_set_geometry (output, old_x, old_y, width, height);
+	  else if (cc_display_snap_query (info->snap, &dragged, &dx, &dy))
+	    gnome_rr_output_info_set_geometry (output, new_x + dx, new_y + dy, width, height);
+	  else
+	    gnome_rr_output_info_set_geometry (output, info->output_x, info->output_y, width, height);
 
 	  if (event->type == FOO_BUTTON_RELEASE)
 	    {
 	      foo_scroll_area_end_grab (area, event);
 
-	      g_free (g_object_get_data (G_OBJECT (output), "grab-info"));
 	      g_object_set_data (G_OBJECT (output), "grab-info", NULL);
 	      g_object_weak_unref (data, grab_weak_ref_notify, area);
               update_apply_button (self);
@@ -1375,7 +1291,7 @@ on_output_event (FooScrollArea *area,
 #endif
             }
 
-          foo_scroll_area_invalidate (area);
+          invalidate_output_tiles (self, area);
         }
     }
 }
@@ -1408,62 +1324,55 @@ paint_background (FooScrollArea *area,
   cairo_fill (cr);
 }
 
+static void
+paint_output_tile (CcDisplayPanel *self,
+                   FooScrollArea  *area,
+                   cairo_t        *cr,
+                   OutputTile     *tile)
+{
+  if (tile->width <= 0 || tile->height <= 0)
+    return;
+
+  if (tile->surface == NULL)
+    {
+      cairo_t *tile_cr;
+
+      tile->surface = gdk_window_create_similar_surface (gtk_widget_get_window (GTK_WIDGET (area)),
+                                                         CAIRO_CONTENT_COLOR_ALPHA,
+                                                         tile->width, tile->height);
+      tile_cr = cairo_create (tile->surface);
+      paint_output (self, tile_cr, self->priv->current_configuration,
+                    tile->output, tile->num,
+                    tile->width, tile->height);
+      cairo_destroy (tile_cr);
+    }
+
+  cairo_set_source_surface (cr, tile->surface, tile->rect.x, tile->rect.y);
+  cairo_paint (cr);
+}
+
 static void
 on_area_paint (FooScrollArea  *area,
                cairo_t        *cr,
                gpointer        data)
 {
   CcDisplayPanel *self = data;
-  GList *connected_outputs = NULL;
-  GList *list;
+  guint i;
 
   paint_background (area, cr);
 
   if (!self->priv->current_configuration)
     return;
 
-  connected_outputs = list_connected_outputs (self, NULL, NULL);
+  update_output_tiles (self, area, NULL);
 
-  for (list = connected_outputs; list != NULL; list = list->next)
+  for (i = 0; i < self->priv->output_tiles->len; i++)
     {
-      int w, h;
-      double scale = compute_scale (self, area);
-      gint x, y;
-      int output_x, output_y;
-      int total_w, total_h;
-      GList *connected_outputs;
-      GnomeRROutputInfo *output = list->data;
-      GdkRectangle viewport;
-
-      cairo_save (cr);
-
-      connected_outputs = list_connected_outputs (self, &total_w, &total_h);
-      g_list_free (connected_outputs);
+      OutputTile *tile = &g_array_index (self->priv->output_tiles, OutputTile, i);
 
-      foo_scroll_area_get_viewport (area, &viewport);
-      get_geometry (output, &output_x, &output_y, &w, &h);
-
-      viewport.height -= 2 * MARGIN;
-      viewport.width -= 2 * MARGIN;
-
-      x = output_x * scale + MARGIN + (viewport.width - total_w * scale) / 2.0;
-      y = output_y * scale + MARGIN + (viewport.height - total_h * scale) / 2.0;
-
-
-      cairo_set_source_rgba (cr, 0, 0, 0, 0);
-      cairo_rectangle (cr, x, y, w * scale + 0.5, h * scale + 0.5);
-      foo_scroll_area_add_input_from_fill (area, cr, on_output_event, output);
-      cairo_fill (cr);
-
-      cairo_translate (cr, x, y);
-      paint_output (self, cr, self->priv->current_configuration, output,
-                    cc_display_panel_get_output_id (output),
-                    w * scale, h * scale);
-
-      cairo_restore (cr);
-
-      if (gnome_rr_config_get_clone (self->priv->current_configuration))
-        break;
+      foo_scroll_area_add_input_from_rect (area, &tile->rect,
+                                           on_output_event, tile->output);
+      paint_output_tile (self, area, cr, tile);
     }
 }
 
@@ -1613,6 +1522,7 @@ show_arrange_displays_dialog (GtkButton      *button,
 
   gtk_widget_destroy (priv->dialog);
   priv->dialog = NULL;
+  g_clear_pointer (&priv->output_tiles, g_array_unref);
 }
 
 static const gchar *
@@ -1731,8 +1641,8 @@ is_atsc_duplicate_freq (GnomeRRMode *mode,
 static int
 sort_frequencies (gconstpointer a, gconstpointer b)
 {
-  GnomeRRMode *mode_a = (GnomeRRMode *) a;
-  GnomeRRMode *mode_b = (GnomeRRMode *) b;
+  GnomeRRMode *mode_a = ((ModeRate *) a)->mode;
+  GnomeRRMode *mode_b = ((ModeRate *) b)->mode;
 
   /* Highest to lowest */
   if (gnome_rr_mode_get_freq_f (mode_a) > gnome_rr_mode_get_freq_f (mode_b))
@@ -1743,32 +1653,11 @@ sort_frequencies (gconstpointer a, gconstpointer b)
 }
 
 static void
-setup_frequency_combo_box (CcDisplayPanel *panel,
-                           GnomeRRMode    *resolution_mode)
+mode_resolution_setup_rates (ModeResolution *resolution)
 {
-  CcDisplayPanelPrivate *priv = panel->priv;
-  GnomeRROutput *current_output;
-  GnomeRRMode *current_mode;
-  GtkTreeModel *model;
-  GtkTreeIter iter;
-  gchar *res;
-  GSList *l, *frequencies;
   guint i;
-  gboolean prev_dup;
 
-  current_output = gnome_rr_screen_get_output_by_name (priv->screen,
-                                                       gnome_rr_output_info_get_name (priv->current_output));
-  current_mode = gnome_rr_output_get_current_mode (current_output);
-
-  model = gtk_combo_box_get_model (GTK_COMBO_BOX (priv->freq_combo));
-  gtk_list_store_clear (GTK_LIST_STORE (model));
-
-  i = 0;
-  res = make_resolution_string (resolution_mode);
-  frequencies = g_slist_copy (g_hash_table_lookup (priv->res_freqs, res));
-  g_free (res);
-  frequencies = g_slist_sort (frequencies, sort_frequencies);
-  prev_dup = FALSE;
+  g_array_sort (resolution->rates, sort_frequencies);
 
   /* Look for 59.94Hz, and if it exists, remove the 60Hz option
    * in favour of this NTSC/ATSC frequency.
@@ -1777,137 +1666,216 @@ setup_frequency_combo_box (CcDisplayPanel *panel,
    * https://en.wikipedia.org/wiki/NTSC#Lines_and_refresh_rate
    *
    * We also want to handle this for ~30Hz and ~120Hz */
-  for (l = frequencies; l != NULL; l = l->next)
+  for (i = 0; i < resolution->rates->len; i++)
     {
-      GnomeRRMode *mode = l->data;
-      GnomeRRMode *next_mode;
-      gchar *freq;
-      gboolean dup;
+      ModeRate *rate = &g_array_index (resolution->rates, ModeRate, i);
+      GnomeRRMode *next_mode = NULL;
 
-      if (l->next != NULL)
-        next_mode = l->next->data;
-      else
-        next_mode = NULL;
+      if (i + 1 < resolution->rates->len)
+        next_mode = g_array_index (resolution->rates, ModeRate, i + 1).mode;
 
-      dup = is_atsc_duplicate_freq (mode, next_mode);
-      if (dup && mode != current_mode)
-        {
-          prev_dup = TRUE;
-          continue;
-        }
+      rate->atsc_duplicate = is_atsc_duplicate_freq (rate->mode, next_mode);
 
-      if (prev_dup)
+      if (i > 0 && g_array_index (resolution->rates, ModeRate, i - 1).atsc_duplicate)
         {
           /* translators: example string is "60 Hz (NTSC)"
            * NTSC is https://en.wikipedia.org/wiki/NTSC */
-          freq = g_strdup_printf (_("%d Hz (NTSC)"),
-                                  (int) (roundf (gnome_rr_mode_get_freq_f (mode))));
+          rate->label = g_strdup_printf (_("%d Hz (NTSC)"),
+                                         (int) (roundf (gnome_rr_mode_get_freq_f (rate->mode))));
         }
       else
         {
           /* translators: example string is "60 Hz" */
-          freq = g_strdup_printf (_("%d Hz"), gnome_rr_mode_get_freq (mode));
+          rate->label = g_strdup_printf (_("%d Hz"), gnome_rr_mode_get_freq (rate->mode));
         }
+    }
+}
 
-      gtk_list_store_insert_with_values (GTK_LIST_STORE (model), &iter,
-                                         -1, 0, freq, 1, mode, -1);
-      g_free (freq);
-
-      if (mode == current_mode)
-        gtk_combo_box_set_active_iter (GTK_COMBO_BOX (priv->freq_combo), &iter);
+static ModeCatalogue *
+mode_catalogue_new (GnomeRRMode **modes)
+{
+  ModeCatalogue *catalogue;
+  GHashTable *by_label;
+  guint i;
 
-      prev_dup = dup;
-      i++;
-    }
+  catalogue = g_new0 (ModeCatalogue, 1);
+  catalogue->modes = modes;
+  catalogue->resolutions = g_ptr_array_new_with_free_func ((GDestroyNotify) mode_resolution_free);
+  catalogue->by_mode = g_hash_table_new (NULL, NULL);
 
-  g_slist_free (frequencies);
+  by_label = g_hash_table_new (g_str_hash, g_str_equal);
 
-  if (i < 2)
+  for (i = 0; modes[i] != NULL; i++)
     {
-      gtk_widget_hide (priv->freq_combo);
-      return;
+      ModeResolution *resolution;
+      ModeRate rate = { NULL, };
+      gchar *label;
+
+      label = make_resolution_string (modes[i]);
+      resolution = g_hash_table_lookup (by_label, label);
+
+      if (resolution == NULL)
+        {
+          resolution = g_new0 (ModeResolution, 1);
+          resolution->mode = modes[i];
+          resolution->label = label;
+          resolution->width = gnome_rr_mode_get_width (modes[i]);
+          resolution->height = gnome_rr_mode_get_height (modes[i]);
+          resolution->interlaced = gnome_rr_mode_get_is_interlaced (modes[i]);
+          resolution->rates = g_array_new (FALSE, TRUE, sizeof (ModeRate));
+          g_array_set_clear_func (resolution->rates, (GDestroyNotify) mode_rate_clear);
+
+          g_ptr_array_add (catalogue->resolutions, resolution);
+          g_hash_table_insert (by_label, resolution->label, resolution);
+        }
+      else
+        {
+          g_free (label);
+        }
+
+      rate.mode = modes[i];
+      g_array_append_val (resolution->rates, rate);
+      g_hash_table_insert (catalogue->by_mode, modes[i], resolution);
     }
 
-  gtk_widget_show (priv->freq_combo);
-  if (gtk_combo_box_get_active (GTK_COMBO_BOX (priv->freq_combo)) == -1)
-    gtk_combo_box_set_active (GTK_COMBO_BOX (priv->freq_combo), 0);
+  g_hash_table_destroy (by_label);
+
+  for (i = 0; i < catalogue->resolutions->len; i++)
+    mode_resolution_setup_rates (g_ptr_array_index (catalogue->resolutions, i));
+
+  return catalogue;
 }
 
-static void
-free_mode_list (gpointer key,
-                gpointer value,
-                gpointer data)
+static ModeCatalogue *
+get_mode_catalogue (CcDisplayPanel *panel,
+                    GnomeRROutput  *output,
+                    gboolean        clone)
 {
-  g_slist_free (value);
+  CcDisplayPanelPrivate *priv = panel->priv;
+  ModeCatalogue *catalogue;
+  GnomeRRMode **modes;
+
+  if (clone)
+    {
+      modes = gnome_rr_screen_list_clone_modes (priv->screen);
+      if (priv->clone_catalogue == NULL || priv->clone_catalogue->modes != modes)
+        {
+          g_clear_pointer (&priv->clone_catalogue, mode_catalogue_free);
+          priv->clone_catalogue = mode_catalogue_new (modes);
+        }
+      return priv->clone_catalogue;
+    }
+
+  if (priv->mode_catalogues == NULL)
+    priv->mode_catalogues = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                   (GDestroyNotify) mode_catalogue_free);
+
+  modes = gnome_rr_output_list_modes (output);
+  catalogue = g_hash_table_lookup (priv->mode_catalogues,
+                                   gnome_rr_output_get_name (output));
+  if (catalogue == NULL || catalogue->modes != modes)
+    {
+      catalogue = mode_catalogue_new (modes);
+      g_hash_table_replace (priv->mode_catalogues,
+                            g_strdup (gnome_rr_output_get_name (output)),
+                            catalogue);
+    }
+
+  return catalogue;
 }
 
 static void
-clear_res_freqs (CcDisplayPanel *panel)
+setup_frequency_combo_box (CcDisplayPanel *panel,
+                           GnomeRRMode    *resolution_mode)
 {
   CcDisplayPanelPrivate *priv = panel->priv;
-  if (priv->res_freqs)
+  GnomeRROutput *current_output;
+  GnomeRRMode *current_mode;
+  ModeResolution *resolution = NULL;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  guint i, n_rates;
+
+  current_output = gnome_rr_screen_get_output_by_name (priv->screen,
+                                                       gnome_rr_output_info_get_name (priv->current_output));
+  current_mode = gnome_rr_output_get_current_mode (current_output);
+
+  model = gtk_combo_box_get_model (GTK_COMBO_BOX (priv->freq_combo));
+  gtk_list_store_clear (GTK_LIST_STORE (model));
+
+  if (priv->mode_catalogue != NULL && resolution_mode != NULL)
+    resolution = g_hash_table_lookup (priv->mode_catalogue->by_mode, resolution_mode);
+
+  n_rates = 0;
+  for (i = 0; resolution != NULL && i < resolution->rates->len; i++)
+    {
+      ModeRate *rate = &g_array_index (resolution->rates, ModeRate, i);
+
+      if (rate->atsc_duplicate && rate->mode != current_mode)
+        continue;
+
+      gtk_list_store_insert_with_values (GTK_LIST_STORE (model), &iter,
+                                         -1, 0, rate->label, 1, rate->mode, -1);
+
+      if (rate->mode == current_mode)
+        gtk_combo_box_set_active_iter (GTK_COMBO_BOX (priv->freq_combo), &iter);
+
+      n_rates++;
+    }
+
+  if (n_rates < 2)
     {
-      g_hash_table_foreach (priv->res_freqs, free_mode_list, NULL);
-      g_hash_table_destroy (priv->res_freqs);
-      priv->res_freqs = NULL;
+      gtk_widget_hide (priv->freq_combo);
+      return;
     }
+
+  gtk_widget_show (priv->freq_combo);
+  if (gtk_combo_box_get_active (GTK_COMBO_BOX (priv->freq_combo)) == -1)
+    gtk_combo_box_set_active (GTK_COMBO_BOX (priv->freq_combo), 0);
 }
 
 static void
 setup_resolution_combo_box (CcDisplayPanel  *panel,
-                            GnomeRRMode    **modes,
+                            ModeCatalogue   *catalogue,
                             GnomeRRMode     *current_mode)
 {
   CcDisplayPanelPrivate *priv = panel->priv;
   GtkTreeModel *res_model;
-  gint i;
+  gint output_width, output_height;
+  guint i;
 
-  clear_res_freqs (panel);
-  priv->res_freqs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->mode_catalogue = catalogue;
 
   res_model = gtk_combo_box_get_model (GTK_COMBO_BOX (priv->res_combo));
   gtk_list_store_clear (GTK_LIST_STORE (res_model));
 
-  for (i = 0; modes[i] != NULL; i++)
-    {
-      GSList *l;
-      gchar *res;
-      gint output_width, output_height, mode_width, mode_height;
-
-      if (!current_mode)
-        current_mode = modes[i];
+  if (!current_mode)
+    current_mode = catalogue->modes[0];
 
-      mode_width = gnome_rr_mode_get_width (modes[i]);
-      mode_height = gnome_rr_mode_get_height (modes[i]);
+  output_width = gnome_rr_output_info_get_preferred_width (priv->current_output);
+  output_height = gnome_rr_output_info_get_preferred_height (priv->current_output);
 
-      output_width = gnome_rr_output_info_get_preferred_width (priv->current_output);
-      output_height = gnome_rr_output_info_get_preferred_height (priv->current_output);
+  for (i = 0; i < catalogue->resolutions->len; i++)
+    {
+      ModeResolution *resolution = g_ptr_array_index (catalogue->resolutions, i);
+      GtkTreeIter iter;
 
-      if (!should_show_resolution (output_width, output_height, mode_width,
-                                   mode_height))
+      if (!should_show_resolution (output_width, output_height,
+                                   resolution->width, resolution->height))
         continue;
 
-      res = make_resolution_string (modes[i]);
+      gtk_list_store_insert_with_values (GTK_LIST_STORE (res_model), &iter,
+                                         -1, 0, resolution->label, 1, resolution->mode, -1);
 
-      if ((l = g_hash_table_lookup (priv->res_freqs, res)) == NULL)
+      /* select the current mode in the combo box */
+      if (current_mode != NULL
+          && resolution->width == gnome_rr_mode_get_width (current_mode)
+          && resolution->height == gnome_rr_mode_get_height (current_mode)
+          && resolution->interlaced == gnome_rr_mode_get_is_interlaced (current_mode))
         {
-          GtkTreeIter iter;
-
-          gtk_list_store_insert_with_values (GTK_LIST_STORE (res_model), &iter,
-                                             -1, 0, res, 1, modes[i], -1);
-
-          /* select the current mode in the combo box */
-          if (gnome_rr_mode_get_width (modes[i]) == gnome_rr_mode_get_width (current_mode)
-              && gnome_rr_mode_get_height (modes[i]) == gnome_rr_mode_get_height (current_mode)
-              && gnome_rr_mode_get_is_interlaced (modes[i]) == gnome_rr_mode_get_is_interlaced (current_mode))
-            {
-              gtk_combo_box_set_active_iter (GTK_COMBO_BOX (priv->res_combo),
-                                             &iter);
-            }
+          gtk_combo_box_set_active_iter (GTK_COMBO_BOX (priv->res_combo),
+                                         &iter);
         }
-
-      l = g_slist_append (l, modes[i]);
-      g_hash_table_replace (priv->res_freqs, res, l);
     }
 
   /* ensure a resolution is selected by default */
@@ -1924,7 +1892,7 @@ setup_listbox_row_activated (GtkListBox     *list_box,
                              CcDisplayPanel *panel)
 {
   CcDisplayPanelPrivate *priv = panel->priv;
-  GnomeRRMode **modes;
+  ModeCatalogue *catalogue;
   gint index;
   GnomeRROutput *output;
 
@@ -1941,7 +1909,7 @@ setup_listbox_row_activated (GtkListBox     *list_box,
 
   if (index == DISPLAY_MODE_MIRROR)
     {
-      modes = gnome_rr_screen_list_clone_modes (priv->screen);
+      catalogue = get_mode_catalogue (panel, output, TRUE);
       gnome_rr_config_set_clone (priv->current_configuration, TRUE);
     }
   else
@@ -1950,10 +1918,10 @@ setup_listbox_row_activated (GtkListBox     *list_box,
                                         (index == DISPLAY_MODE_PRIMARY));
       gnome_rr_config_set_clone (priv->current_configuration, FALSE);
 
-      modes = gnome_rr_output_list_modes (output);
+      catalogue = get_mode_catalogue (panel, output, FALSE);
     }
 
-  setup_resolution_combo_box (panel, modes,
+  setup_resolution_combo_box (panel, catalogue,
                               gnome_rr_output_get_current_mode (output));
   update_apply_button (panel);
 }
@@ -2475,10 +2443,8 @@ show_setup_dialog (CcDisplayPanel *panel)
     }
   else
     {
-      GnomeRRMode **modes;
-
-      modes = gnome_rr_output_list_modes (output);
-      setup_resolution_combo_box (panel, modes,
+      setup_resolution_combo_box (panel,
+                                  get_mode_catalogue (panel, output, FALSE),
                                   gnome_rr_output_get_current_mode (output));
     }
 
@@ -2598,7 +2564,7 @@ show_setup_dialog (CcDisplayPanel *panel)
   priv->rotate_right_button = NULL;
   priv->res_combo = NULL;
   priv->freq_combo = NULL;
-  clear_res_freqs (panel);
+  priv->mode_catalogue = NULL;
   gtk_widget_destroy (priv->dialog);
   priv->dialog = NULL;
 }
@@ -0,0 +1,754 @@
+/*
+ * Copyright (C) 2007, 2008  Red Hat, Inc.
+ * Copyright (C) 2013 Intel, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdlib.h>
+
+#include "cc-display-snap.h"
+
+/* Snapping and alignment checks for the arrangement dialog.
+ *
+ * An output is "aligned" when its top-left, top-right or bottom-left
+ * corner lies on the border of another output, or when one of those
+ * corners of another output lies on its border.  A layout is aligned
+ * when every output is aligned and no two outputs overlap.
+ *
+ * The layout checks use an x sweep over the rectangles for overlaps
+ * and sorted border lists for the corner lookups, so checking a whole
+ * layout is O(n log n).  While dragging, the state of the outputs
+ * that stay put is computed once and every snap candidate is then
+ * checked against it in linear time.
+ */
+
+#define SNAP_DISTANCE 200
+
+typedef struct
+{
+  int x1, y1;
+  int x2, y2;
+} Edge;
+
+typedef struct
+{
+  int dx, dy;
+  guint order;
+} Snap;
+
+typedef struct
+{
+  int pos;        /* x of a vertical border, y of a horizontal one */
+  int start, end;
+  guint owner;
+} Border;
+
+typedef struct
+{
+  Border *vertical;
+  guint n_vertical;
+  Border *horizontal;
+  guint n_horizontal;
+} BorderIndex;
+
+typedef struct
+{
+  int x;
+  gboolean insert;
+  guint owner;
+} SweepEvent;
+
+static gboolean
+rect_is_empty (const GdkRectangle *r)
+{
+  return r->width <= 0 || r->height <= 0;
+}
+
+static gboolean
+rects_overlap (const GdkRectangle *a, const GdkRectangle *b)
+{
+  if (rect_is_empty (a) || rect_is_empty (b))
+    return FALSE;
+
+  return a->x < b->x + b->width && b->x < a->x + a->width &&
+         a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+static gboolean
+point_on_border (int x, int y, const GdkRectangle *r)
+{
+  if ((x == r->x || x == r->x + r->width) &&
+      y >= r->y && y <= r->y + r->height)
+    return TRUE;
+
+  if ((y == r->y || y == r->y + r->height) &&
+      x >= r->x && x <= r->x + r->width)
+    return TRUE;
+
+  return FALSE;
+}
+
+static gboolean
+corners_on_border (const GdkRectangle *a, const GdkRectangle *b)
+{
+  /* The bottom-right corner is never the start of an edge */
+  return point_on_border (a->x, a->y, b) ||
+         point_on_border (a->x + a->width, a->y, b) ||
+         point_on_border (a->x, a->y + a->height, b);
+}
+
+static gboolean
+rects_align (const GdkRectangle *a, const GdkRectangle *b)
+{
+  return corners_on_border (a, b) || corners_on_border (b, a);
+}
+
+static int
+compare_borders (const void *v1, const void *v2)
+{
+  const Border *b1 = v1;
+  const Border *b2 = v2;
+
+  if (b1->pos != b2->pos)
+    return b1->pos < b2->pos ? -1 : 1;
+  if (b1->start != b2->start)
+    return b1->start < b2->start ? -1 : 1;
+  if (b1->owner != b2->owner)
+    return b1->owner < b2->owner ? -1 : 1;
+  return 0;
+}
+
+static void
+border_index_init (BorderIndex        *index,
+                   const GdkRectangle *rects,
+                   guint               n_rects,
+                   guint               skip)
+{
+  guint i;
+
+  index->vertical = g_new (Border, 2 * n_rects);
+  index->horizontal = g_new (Border, 2 * n_rects);
+  index->n_vertical = 0;
+  index->n_horizontal = 0;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      const GdkRectangle *r = &rects[i];
+      Border *b;
+
+      if (i == skip)
+        continue;
+
+      b = &index->vertical[index->n_vertical++];
+      b->pos = r->x;
+      b->start = r->y;
+      b->end = r->y + r->height;
+      b->owner = i;
+
+      b = &index->vertical[index->n_vertical++];
+      b->pos = r->x + r->width;
+      b->start = r->y;
+      b->end = r->y + r->height;
+      b->owner = i;
+
+      b = &index->horizontal[index->n_horizontal++];
+      b->pos = r->y;
+      b->start = r->x;
+      b->end = r->x + r->width;
+      b->owner = i;
+
+      b = &index->horizontal[index->n_horizontal++];
+      b->pos = r->y + r->height;
+      b->start = r->x;
+      b->end = r->x + r->width;
+      b->owner = i;
+    }
+
+  qsort (index->vertical, index->n_vertical, sizeof (Border), compare_borders);
+  qsort (index->horizontal, index->n_horizontal, sizeof (Border), compare_borders);
+}
+
+static void
+border_index_clear (BorderIndex *index)
+{
+  g_free (index->vertical);
+  g_free (index->horizontal);
+}
+
+static guint
+border_lower_bound (const Border *borders,
+                    guint         n_borders,
+                    int           pos)
+{
+  guint lo = 0, hi = n_borders;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (borders[mid].pos < pos)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/* Marks @owner and every other rectangle with (@x, @y) on its border
+ * as aligned.
+ */
+static void
+mark_point (const BorderIndex *index,
+            int                x,
+            int                y,
+            guint              owner,
+            gboolean          *aligned)
+{
+  guint i;
+
+  for (i = border_lower_bound (index->vertical, index->n_vertical, x);
+       i < index->n_vertical &&
+       index->vertical[i].pos == x &&
+       index->vertical[i].start <= y;
+       i++)
+    {
+      const Border *b = &index->vertical[i];
+
+      if (b->owner != owner && y <= b->end)
+        aligned[owner] = aligned[b->owner] = TRUE;
+    }
+
+  for (i = border_lower_bound (index->horizontal, index->n_horizontal, y);
+       i < index->n_horizontal &&
+       index->horizontal[i].pos == y &&
+       index->horizontal[i].start <= x;
+       i++)
+    {
+      const Border *b = &index->horizontal[i];
+
+      if (b->owner != owner && x <= b->end)
+        aligned[owner] = aligned[b->owner] = TRUE;
+    }
+}
+
+/* Fills @aligned for every rectangle but @skip */
+static void
+compute_alignment (const GdkRectangle *rects,
+                   guint               n_rects,
+                   guint               skip,
+                   gboolean           *aligned)
+{
+  BorderIndex index;
+  guint i;
+
+  border_index_init (&index, rects, n_rects, skip);
+
+  for (i = 0; i < n_rects; i++)
+    aligned[i] = FALSE;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      const GdkRectangle *r = &rects[i];
+
+      if (i == skip)
+        continue;
+
+      mark_point (&index, r->x, r->y, i, aligned);
+      mark_point (&index, r->x + r->width, r->y, i, aligned);
+      mark_point (&index, r->x, r->y + r->height, i, aligned);
+    }
+
+  border_index_clear (&index);
+}
+
+static int
+compare_sweep_events (const void *v1, const void *v2)
+{
+  const SweepEvent *e1 = v1;
+  const SweepEvent *e2 = v2;
+
+  if (e1->x != e2->x)
+    return e1->x < e2->x ? -1 : 1;
+  /* Rectangles that only touch do not overlap, so leave before entering */
+  if (e1->insert != e2->insert)
+    return e1->insert ? 1 : -1;
+  if (e1->owner != e2->owner)
+    return e1->owner < e2->owner ? -1 : 1;
+  return 0;
+}
+
+static gint
+compare_active (gconstpointer a,
+                gconstpointer b,
+                gpointer      user_data)
+{
+  const GdkRectangle *r1 = a;
+  const GdkRectangle *r2 = b;
+
+  if (r1->y != r2->y)
+    return r1->y < r2->y ? -1 : 1;
+  if (r1 != r2)
+    return r1 < r2 ? -1 : 1;
+  return 0;
+}
+
+/* Sweeps a vertical line over the rectangles, keeping the ones it
+ * crosses ordered by y.  As long as nothing overlapped so far those are
+ * disjoint on the y axis, so a newcomer only needs to be checked
+ * against its neighbours.
+ */
+static gboolean
+has_overlaps (const GdkRectangle *rects,
+              guint               n_rects,
+              guint               skip)
+{
+  SweepEvent *events;
+  GSequenceIter **iters;
+  GSequence *active;
+  guint n_events = 0;
+  guint i;
+  gboolean ret = FALSE;
+
+  events = g_new (SweepEvent, 2 * n_rects);
+  iters = g_new0 (GSequenceIter *, n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if (i == skip || rect_is_empty (&rects[i]))
+        continue;
+
+      events[n_events].x = rects[i].x;
+      events[n_events].insert = TRUE;
+      events[n_events].owner = i;
+      n_events++;
+
+      events[n_events].x = rects[i].x + rects[i].width;
+      events[n_events].insert = FALSE;
+      events[n_events].owner = i;
+      n_events++;
+    }
+
+  qsort (events, n_events, sizeof (SweepEvent), compare_sweep_events);
+
+  active = g_sequence_new (NULL);
+
+  for (i = 0; i < n_events; i++)
+    {
+      const SweepEvent *e = &events[i];
+      const GdkRectangle *r = &rects[e->owner];
+      GSequenceIter *iter;
+
+      if (!e->insert)
+        {
+          g_sequence_remove (iters[e->owner]);
+          iters[e->owner] = NULL;
+          continue;
+        }
+
+      iter = g_sequence_insert_sorted (active, (gpointer) r, compare_active, NULL);
+      iters[e->owner] = iter;
+
+      if (!g_sequence_iter_is_begin (iter))
+        {
+          const GdkRectangle *prev = g_sequence_get (g_sequence_iter_prev (iter));
+
+          if (prev->y + prev->height > r->y)
+            {
+              ret = TRUE;
+              break;
+            }
+        }
+
+      iter = g_sequence_iter_next (iter);
+      if (!g_sequence_iter_is_end (iter))
+        {
+          const GdkRectangle *next = g_sequence_get (iter);
+
+          if (r->y + r->height > next->y)
+            {
+              ret = TRUE;
+              break;
+            }
+        }
+    }
+
+  g_sequence_free (active);
+  g_free (iters);
+  g_free (events);
+
+  return ret;
+}
+
+/**
+ * cc_display_snap_layout_is_aligned:
+ * @rects: the output rectangles
+ * @n_rects: the number of rectangles in @rects
+ *
+ * Returns: %TRUE if no two rectangles overlap and every rectangle is
+ *   aligned with at least one other
+ */
+gboolean
+cc_display_snap_layout_is_aligned (const GdkRectangle *rects,
+                                   guint               n_rects)
+{
+  gboolean *aligned;
+  gboolean ret = TRUE;
+  guint i;
+
+  if (has_overlaps (rects, n_rects, G_MAXUINT))
+    return FALSE;
+
+  aligned = g_new (gboolean, n_rects);
+  compute_alignment (rects, n_rects, G_MAXUINT, aligned);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if (!aligned[i])
+        {
+          ret = FALSE;
+          break;
+        }
+    }
+
+  g_free (aligned);
+
+  return ret;
+}
+
+static void
+rect_get_edges (const GdkRectangle *r, Edge *edges)
+{
+  int x = r->x, y = r->y, w = r->width, h = r->height;
+
+  /* Top, Bottom, Left, Right */
+  edges[0].x1 = x;     edges[0].y1 = y;     edges[0].x2 = x + w; edges[0].y2 = y;
+  edges[1].x1 = x;     edges[1].y1 = y + h; edges[1].x2 = x + w; edges[1].y2 = y + h;
+  edges[2].x1 = x;     edges[2].y1 = y;     edges[2].x2 = x;     edges[2].y2 = y + h;
+  edges[3].x1 = x + w; edges[3].y1 = y;     edges[3].x2 = x + w; edges[3].y2 = y + h;
+}
+
+static gboolean
+overlap (int s1, int e1, int s2, int e2)
+{
+  return (!(e1 < s2 || s1 >= e2));
+}
+
+static gboolean
+horizontal_overlap (const Edge *snapper, const Edge *snappee)
+{
+  if (snapper->y1 != snapper->y2 || snappee->y1 != snappee->y2)
+    return FALSE;
+
+  return overlap (snapper->x1, snapper->x2, snappee->x1, snappee->x2);
+}
+
+static gboolean
+vertical_overlap (const Edge *snapper, const Edge *snappee)
+{
+  if (snapper->x1 != snapper->x2 || snappee->x1 != snappee->x2)
+    return FALSE;
+
+  return overlap (snapper->y1, snapper->y2, snappee->y1, snappee->y2);
+}
+
+static void
+add_snap (GArray *snaps, int dx, int dy)
+{
+  Snap snap;
+
+  if (ABS (dx) > SNAP_DISTANCE && ABS (dy) > SNAP_DISTANCE)
+    return;
+
+  snap.dx = dx;
+  snap.dy = dy;
+  snap.order = snaps->len;
+  g_array_append_val (snaps, snap);
+}
+
+static void
+add_edge_snaps (const Edge *snapper, const Edge *snappee, GArray *snaps)
+{
+  if (horizontal_overlap (snapper, snappee))
+    add_snap (snaps, 0, snappee->y1 - snapper->y1);
+  else if (vertical_overlap (snapper, snappee))
+    add_snap (snaps, snappee->x1 - snapper->x1, 0);
+
+  /* Corner snaps */
+  /* 1->1 */
+  add_snap (snaps, snappee->x1 - snapper->x1, snappee->y1 - snapper->y1);
+  /* 1->2 */
+  add_snap (snaps, snappee->x2 - snapper->x1, snappee->y2 - snapper->y1);
+  /* 2->2 */
+  add_snap (snaps, snappee->x2 - snapper->x2, snappee->y2 - snapper->y2);
+  /* 2->1 */
+  add_snap (snaps, snappee->x1 - snapper->x2, snappee->y1 - snapper->y2);
+}
+
+static gboolean
+is_corner_snap (const Snap *s)
+{
+  return s->dx != 0 && s->dy != 0;
+}
+
+static int
+compare_snap_offsets (const void *v1, const void *v2)
+{
+  const Snap *s1 = v1;
+  const Snap *s2 = v2;
+
+  if (s1->dx != s2->dx)
+    return s1->dx < s2->dx ? -1 : 1;
+  if (s1->dy != s2->dy)
+    return s1->dy < s2->dy ? -1 : 1;
+  if (s1->order != s2->order)
+    return s1->order < s2->order ? -1 : 1;
+  return 0;
+}
+
+static int
+compare_snaps (const void *v1, const void *v2)
+{
+  const Snap *s1 = v1;
+  const Snap *s2 = v2;
+  int sv1 = MAX (ABS (s1->dx), ABS (s1->dy));
+  int sv2 = MAX (ABS (s2->dx), ABS (s2->dy));
+
+  if (sv1 != sv2)
+    return sv1 < sv2 ? -1 : 1;
+
+  /* Prefer corner snaps, then the order in which they were found */
+  if (is_corner_snap (s1) != is_corner_snap (s2))
+    return is_corner_snap (s1) ? -1 : 1;
+
+  if (s1->order != s2->order)
+    return s1->order < s2->order ? -1 : 1;
+  return 0;
+}
+
+static GArray *
+list_snaps (const GdkRectangle *rects,
+            guint               n_rects,
+            guint               moving)
+{
+  GArray *snaps;
+  Edge moving_edges[4];
+  Edge edges[4];
+  guint i, j, k, n;
+
+  snaps = g_array_new (FALSE, FALSE, sizeof (Snap));
+  rect_get_edges (&rects[moving], moving_edges);
+
+  for (i = 0; i < 4; i++)
+    {
+      for (j = 0; j < n_rects; j++)
+        {
+          if (j == moving)
+            continue;
+
+          rect_get_edges (&rects[j], edges);
+          for (k = 0; k < 4; k++)
+            add_edge_snaps (&moving_edges[i], &edges[k], snaps);
+        }
+    }
+
+  if (snaps->len == 0)
+    return snaps;
+
+  /* The same offset is usually found through several pairs of edges,
+   * only keep the first one.
+   */
+  qsort (snaps->data, snaps->len, sizeof (Snap), compare_snap_offsets);
+  for (i = 1, n = 1; i < snaps->len; i++)
+    {
+      Snap *s = &g_array_index (snaps, Snap, i);
+      Snap *last = &g_array_index (snaps, Snap, n - 1);
+
+      if (s->dx != last->dx || s->dy != last->dy)
+        g_array_index (snaps, Snap, n++) = *s;
+    }
+  g_array_set_size (snaps, n);
+
+  qsort (snaps->data, snaps->len, sizeof (Snap), compare_snaps);
+
+  return snaps;
+}
+
+struct _CcDisplaySnap
+{
+  GdkRectangle *rects;
+  guint n_rects;
+  guint moving;
+  gboolean overlapping;   /* whether the outputs that stay put overlap */
+  guint *unaligned;       /* the ones not aligned among themselves */
+  guint n_unaligned;
+};
+
+/**
+ * cc_display_snap_new:
+ * @rects: the output rectangles
+ * @n_rects: the number of rectangles in @rects
+ * @moving: the index of the rectangle about to be dragged
+ *
+ * Computes what snapping needs to know about the rectangles that stay
+ * put, to be done once when a drag starts.
+ *
+ * Returns: a new #CcDisplaySnap, free it with cc_display_snap_free()
+ */
+CcDisplaySnap *
+cc_display_snap_new (const GdkRectangle *rects,
+                     guint               n_rects,
+                     guint               moving)
+{
+  CcDisplaySnap *snap;
+  gboolean *aligned;
+  guint i;
+
+  g_return_val_if_fail (moving < n_rects, NULL);
+
+  snap = g_new0 (CcDisplaySnap, 1);
+  snap->rects = g_memdup (rects, n_rects * sizeof (GdkRectangle));
+  snap->n_rects = n_rects;
+  snap->moving = moving;
+
+  /* Nothing the dragged output does can fix the others overlapping */
+  snap->overlapping = has_overlaps (rects, n_rects, moving);
+  if (snap->overlapping)
+    return snap;
+
+  /* Outputs that are not aligned among themselves have to be aligned
+   * with the dragged one.
+   */
+  aligned = g_new (gboolean, n_rects);
+  snap->unaligned = g_new (guint, n_rects);
+  compute_alignment (rects, n_rects, moving, aligned);
+  for (i = 0; i < n_rects; i++)
+    {
+      if (i != moving && !aligned[i])
+        snap->unaligned[snap->n_unaligned++] = i;
+    }
+  g_free (aligned);
+
+  return snap;
+}
+
+void
+cc_display_snap_free (CcDisplaySnap *snap)
+{
+  g_free (snap->unaligned);
+  g_free (snap->rects);
+  g_free (snap);
+}
+
+/**
+ * cc_display_snap_query:
+ * @snap: a #CcDisplaySnap
+ * @dragged: the dragged rectangle at its pointer position
+ * @dx: (out): return location for the horizontal offset
+ * @dy: (out): return location for the vertical offset
+ *
+ * Looks for the closest offset that snaps @dragged to one of the
+ * other rectangles and leaves an aligned layout.
+ *
+ * Returns: %TRUE if such an offset was found
+ */
+gboolean
+cc_display_snap_query (CcDisplaySnap      *snap,
+                       const GdkRectangle *dragged,
+                       gint               *dx,
+                       gint               *dy)
+{
+  const GdkRectangle *rects = snap->rects;
+  guint n_rects = snap->n_rects;
+  guint moving = snap->moving;
+  GArray *snaps;
+  gboolean ret = FALSE;
+  guint i, j;
+
+  if (snap->overlapping)
+    return FALSE;
+
+  snap->rects[moving] = *dragged;
+  snaps = list_snaps (rects, n_rects, moving);
+
+  for (i = 0; i < snaps->len && !ret; i++)
+    {
+      const Snap *s = &g_array_index (snaps, Snap, i);
+      GdkRectangle r = *dragged;
+      gboolean valid = TRUE;
+      gboolean touches = FALSE;
+
+      r.x += s->dx;
+      r.y += s->dy;
+
+      for (j = 0; j < snap->n_unaligned && valid; j++)
+        valid = rects_align (&r, &rects[snap->unaligned[j]]);
+
+      for (j = 0; j < n_rects && valid; j++)
+        {
+          if (j == moving)
+            continue;
+
+          if (rects_overlap (&r, &rects[j]))
+            valid = FALSE;
+          else if (!touches)
+            touches = rects_align (&r, &rects[j]);
+        }
+
+      if (valid && touches)
+        {
+          *dx = s->dx;
+          *dy = s->dy;
+          ret = TRUE;
+        }
+    }
+
+  g_array_free (snaps, TRUE);
+
+  return ret;
+}
+
+/**
+ * cc_display_snap_find:
+ * @rects: the output rectangles, with the dragged one at its pointer position
+ * @n_rects: the number of rectangles in @rects
+ * @moving: the index of the dragged rectangle
+ * @dx: (out): return location for the horizontal offset
+ * @dy: (out): return location for the vertical offset
+ *
+ * A one-off cc_display_snap_query(), use a #CcDisplaySnap instead when
+ * the same rectangle is snapped at several positions.
+ *
+ * Returns: %TRUE if such an offset was found
+ */
+gboolean
+cc_display_snap_find (const GdkRectangle *rects,
+                      guint               n_rects,
+                      guint               moving,
+                      gint               *dx,
+                      gint               *dy)
+{
+  CcDisplaySnap *snap;
+  gboolean ret;
+
+  g_return_val_if_fail (moving < n_rects, FALSE);
+
+  snap = cc_display_snap_new (rects, n_rects, moving);
+  ret = cc_display_snap_query (snap, &rects[moving], dx, dy);
+  cc_display_snap_free (snap);
+
+  return ret;
+}
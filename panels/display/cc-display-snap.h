@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2007, 2008  Red Hat, Inc.
+ * Copyright (C) 2013 Intel, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_DISPLAY_SNAP_H
+#define _CC_DISPLAY_SNAP_H
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _CcDisplaySnap CcDisplaySnap;
+
+gboolean       cc_display_snap_layout_is_aligned (const GdkRectangle *rects,
+                                                  guint               n_rects);
+
+CcDisplaySnap *cc_display_snap_new               (const GdkRectangle *rects,
+                                                  guint               n_rects,
+                                                  guint               moving);
+void           cc_display_snap_free              (CcDisplaySnap      *snap);
+gboolean       cc_display_snap_query             (CcDisplaySnap      *snap,
+                                                  const GdkRectangle *dragged,
+                                                  gint               *dx,
+                                                  gint               *dy);
+
+gboolean       cc_display_snap_find              (const GdkRectangle *rects,
+                                                  guint               n_rects,
+                                                  guint               moving,
+                                                  gint               *dx,
+                                                  gint               *dy);
+
+G_END_DECLS
+
+#endif /* _CC_DISPLAY_SNAP_H */
@@ -35,6 +35,7 @@ struct InputPath
   cairo_fill_rule_t           fill_rule;
   double                      line_width;
   cairo_path_t               *path;           /* In canvas coordinates */
+  GdkRectangle                rect;           /* ...or this, if path is NULL */
 
   FooScrollAreaEventFunc      func;
   gpointer                    data;
@@ -173,6 +174,7 @@ foo_scroll_area_finalize (GObject *object)
   g_object_unref (scroll_area->priv->vadj);
 
   g_ptr_array_free (scroll_area->priv->input_regions, TRUE);
+  cairo_region_destroy (scroll_area->priv->update_region);
 
   g_free (scroll_area->priv);
 
@@ -286,6 +288,27 @@ foo_scroll_area_class_init (FooScrollAreaClass *class)
                   G_TYPE_POINTER);
 }
 
+static void
+input_path_free_list (InputPath *paths)
+{
+  if (!paths)
+    return;
+
+  input_path_free_list (paths->next);
+  if (paths->path)
+    cairo_path_destroy (paths->path);
+  g_free (paths);
+}
+
+static void
+input_region_free (InputRegion *region)
+{
+  input_path_free_list (region->paths);
+  cairo_region_destroy (region->region);
+
+  g_free (region);
+}
+
 static GtkAdjustment *
 new_adjustment (void)
 {
@@ -312,7 +335,7 @@ foo_scroll_area_init (FooScrollArea *scroll_area)
   scroll_area->priv->min_width = 0;
   scroll_area->priv->min_height = 0;
   scroll_area->priv->auto_scroll_info = NULL;
-  scroll_area->priv->input_regions = g_ptr_array_new ();
+  scroll_area->priv->input_regions = g_ptr_array_new_with_free_func ((GDestroyNotify) input_region_free);
   scroll_area->priv->surface = NULL;
   scroll_area->priv->update_region = cairo_region_create ();
 }
@@ -322,26 +345,6 @@ typedef struct
   double x1, y1, x2, y2;
 } Box;
 
-static void
-input_path_free_list (InputPath *paths)
-{
-  if (!paths)
-    return;
-
-  input_path_free_list (paths->next);
-  cairo_path_destroy (paths->path);
-  g_free (paths);
-}
-
-static void
-input_region_free (InputRegion *region)
-{
-  input_path_free_list (region->paths);
-  cairo_region_destroy (region->region);
-
-  g_free (region);
-}
-
 static void
 get_viewport (FooScrollArea *scroll_area,
               GdkRectangle  *viewport)
@@ -389,10 +392,7 @@ clear_exposed_input_region (FooScrollArea  *area,
       cairo_region_intersect (region->region, viewport);
 
       if (cairo_region_is_empty (region->region))
-        {
-          input_region_free (region);
-          g_ptr_array_remove_index_fast (area->priv->input_regions, i--);
-        }
+        g_ptr_array_remove_index_fast (area->priv->input_regions, i--);
     }
 
   cairo_region_destroy (viewport);
@@ -436,7 +436,7 @@ foo_scroll_area_draw (GtkWidget *widget,
 {
   FooScrollArea *scroll_area = FOO_SCROLL_AREA (widget);
   cairo_region_t *region;
-  GtkAllocation widget_allocation;
+  GdkRectangle viewport;
 
   /* Note that this function can be called at a time
    * where the adj->value is different from x_offset.
@@ -448,33 +448,53 @@ foo_scroll_area_draw (GtkWidget *widget,
    * priv->{x,y}_offset.
    */
 
-  /* Setup input areas */
-  clear_exposed_input_region (scroll_area, scroll_area->priv->update_region);
+  if (scroll_area->priv->surface == NULL)
+    return FALSE;
 
-  scroll_area->priv->current_input = g_new0 (InputRegion, 1);
-  scroll_area->priv->current_input->region = cairo_region_copy (scroll_area->priv->update_region);
-  scroll_area->priv->current_input->paths = NULL;
-  g_ptr_array_add (scroll_area->priv->input_regions,
-                   scroll_area->priv->current_input);
+  /* Only what was invalidated since the last draw gets painted
+   * again, the rest of the backing surface is still up to date.
+   */
+  get_viewport (scroll_area, &viewport);
 
   region = scroll_area->priv->update_region;
   scroll_area->priv->update_region = cairo_region_create ();
+  cairo_region_intersect_rectangle (region, &viewport);
+
+  if (!cairo_region_is_empty (region))
+    {
+      cairo_t *surface_cr;
 
-  initialize_background (widget, cr);
+      /* Setup input areas */
+      clear_exposed_input_region (scroll_area, region);
 
-  g_signal_emit (widget, signals[PAINT], 0, cr);
+      scroll_area->priv->current_input = g_new0 (InputRegion, 1);
+      scroll_area->priv->current_input->region = cairo_region_copy (region);
+      scroll_area->priv->current_input->paths = NULL;
+      g_ptr_array_add (scroll_area->priv->input_regions,
+                       scroll_area->priv->current_input);
 
-  scroll_area->priv->current_input = NULL;
+      surface_cr = cairo_create (scroll_area->priv->surface);
+      cairo_translate (surface_cr,
+                       -scroll_area->priv->x_offset,
+                       -scroll_area->priv->y_offset);
+      gdk_cairo_region (surface_cr, region);
+      cairo_clip (surface_cr);
 
-  gtk_widget_get_allocation (widget, &widget_allocation);
+      initialize_background (widget, surface_cr);
 
-  /* Finally draw the backing surface */
-  cairo_set_source_surface (cr, scroll_area->priv->surface,
-                            widget_allocation.x, widget_allocation.y);
-  cairo_fill (cr);
+      g_signal_emit (widget, signals[PAINT], 0, surface_cr);
+
+      scroll_area->priv->current_input = NULL;
+
+      cairo_destroy (surface_cr);
+    }
 
   cairo_region_destroy (region);
 
+  /* Finally draw the backing surface */
+  cairo_set_source_surface (cr, scroll_area->priv->surface, 0, 0);
+  cairo_paint (cr);
+
   return TRUE;
 }
 
@@ -573,7 +593,6 @@ foo_scroll_area_realize (GtkWidget *widget)
   GtkAllocation widget_allocation;
   GdkWindow *window;
   gint attributes_mask;
-  cairo_t *cr;
 
   gtk_widget_get_allocation (widget, &widget_allocation);
   gtk_widget_set_realized (widget, TRUE);
@@ -603,12 +622,15 @@ foo_scroll_area_realize (GtkWidget *widget)
   area->priv->input_window = gdk_window_new (window,
                                              &attributes, attributes_mask);
 
-  cr = gdk_cairo_create (gtk_widget_get_window (widget));
-  area->priv->surface = cairo_surface_create_similar (cairo_get_target (cr),
-                                                      CAIRO_CONTENT_COLOR,
-                                                      widget_allocation.width,
-                                                      widget_allocation.height);
-  cairo_destroy (cr);
+  area->priv->surface = gdk_window_create_similar_surface (window,
+                                                           CAIRO_CONTENT_COLOR,
+                                                           widget_allocation.width,
+                                                           widget_allocation.height);
+
+  /* Nothing has been painted into the new surface yet */
+  widget_allocation.x = area->priv->x_offset;
+  widget_allocation.y = area->priv->y_offset;
+  cairo_region_union_rectangle (area->priv->update_region, &widget_allocation);
 
   gdk_window_set_user_data (area->priv->input_window, area);
 }
@@ -625,6 +647,9 @@ foo_scroll_area_unrealize (GtkWidget *widget)
       area->priv->input_window = NULL;
     }
 
+  g_clear_pointer (&area->priv->surface, cairo_surface_destroy);
+  g_ptr_array_set_size (area->priv->input_regions, 0);
+
   GTK_WIDGET_CLASS (parent_class)->unrealize (widget);
 }
 
@@ -637,12 +662,10 @@ create_new_surface (GtkWidget *widget,
   cairo_t *cr;
 
   gtk_widget_get_allocation (widget, &widget_allocation);
-  cr = gdk_cairo_create (gtk_widget_get_window (widget));
-  new = cairo_surface_create_similar (cairo_get_target (cr),
-                                      CAIRO_CONTENT_COLOR,
-                                      widget_allocation.width,
-                                      widget_allocation.height);
-  cairo_destroy (cr);
+  new = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                           CAIRO_CONTENT_COLOR,
+                                           widget_allocation.width,
+                                           widget_allocation.height);
 
   /* Unfortunately we don't know in which direction we were resized,
    * so we just assume we were dragged from the south-east corner.
@@ -752,6 +775,15 @@ emit_input (FooScrollArea *scroll_area,
   func (scroll_area, &event, data);
 }
 
+static gboolean
+rect_contains (const GdkRectangle *rect, int x, int y)
+{
+  return (x >= rect->x                &&
+          y >= rect->y                &&
+          x  < rect->x + rect->width  &&
+          y  < rect->y + rect->height);
+}
+
 static void
 process_event (FooScrollArea           *scroll_area,
                FooScrollAreaEventType   input_type,
@@ -792,17 +824,24 @@ process_event (FooScrollArea           *scroll_area,
               cairo_t *cr;
               gboolean inside;
 
-              cr = gdk_cairo_create (gtk_widget_get_window (widget));
-              cairo_set_fill_rule (cr, path->fill_rule);
-              cairo_set_line_width (cr, path->line_width);
-              cairo_append_path (cr, path->path);
-
-              if (path->is_stroke)
-                inside = cairo_in_stroke (cr, x, y);
+              if (path->path == NULL)
+                {
+                  inside = rect_contains (&path->rect, x, y);
+                }
               else
-                inside = cairo_in_fill (cr, x, y);
+                {
+                  cr = gdk_cairo_create (gtk_widget_get_window (widget));
+                  cairo_set_fill_rule (cr, path->fill_rule);
+                  cairo_set_line_width (cr, path->line_width);
+                  cairo_append_path (cr, path->path);
 
-              cairo_destroy (cr);
+                  if (path->is_stroke)
+                    inside = cairo_in_stroke (cr, x, y);
+                  else
+                    inside = cairo_in_fill (cr, x, y);
+
+                  cairo_destroy (cr);
+                }
 
               if (inside)
                 {
@@ -1199,6 +1238,28 @@ foo_scroll_area_add_input_from_stroke (FooScrollArea           *scroll_area,
   make_path (scroll_area, cr, TRUE, func, data);
 }
 
+/* Cheaper than a path for the common case, as hit-testing it doesn't
+ * need a cairo context */
+void
+foo_scroll_area_add_input_from_rect (FooScrollArea           *scroll_area,
+                                     const GdkRectangle      *rect,
+                                     FooScrollAreaEventFunc   func,
+                                     gpointer                 data)
+{
+  InputPath *path;
+
+  g_return_if_fail (FOO_IS_SCROLL_AREA (scroll_area));
+  g_return_if_fail (rect != NULL);
+  g_return_if_fail (scroll_area->priv->current_input);
+
+  path = g_new0 (InputPath, 1);
+  path->rect = *rect;
+  path->func = func;
+  path->data = data;
+  path->next = scroll_area->priv->current_input->paths;
+  scroll_area->priv->current_input->paths = path;
+}
+
 void
 foo_scroll_area_invalidate (FooScrollArea *scroll_area)
 {
@@ -1331,15 +1392,6 @@ foo_scroll_area_set_viewport_pos (FooScrollArea  *scroll_area,
   g_object_thaw_notify (G_OBJECT (scroll_area->priv->vadj));
 }
 
-static gboolean
-rect_contains (const GdkRectangle *rect, int x, int y)
-{
-  return (x >= rect->x                &&
-          y >= rect->y                &&
-          x  < rect->x + rect->width  &&
-          y  < rect->y + rect->height);
-}
-
 static void
 stop_scrolling (FooScrollArea *area)
 {
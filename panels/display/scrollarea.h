@@ -104,6 +104,10 @@ void          foo_scroll_area_add_input_from_fill (FooScrollArea *scroll_area,
                                                    cairo_t         *cr,
                                                    FooScrollAreaEventFunc func,
                                                    gpointer       data);
+void          foo_scroll_area_add_input_from_rect (FooScrollArea      *scroll_area,
+                                                   const GdkRectangle *rect,
+                                                   FooScrollAreaEventFunc func,
+                                                   gpointer            data);
 void          foo_scroll_area_invalidate_region (FooScrollArea  *area,
                                                  cairo_region_t *region);
 void          foo_scroll_area_invalidate (FooScrollArea *scroll_area);
@@ -0,0 +1,452 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * Copyright (C) 2007, 2008  Red Hat, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <glib.h>
+#include <locale.h>
+#include <string.h>
+#include "cc-display-snap.h"
+
+#define N_OUTPUTS 32
+#define N_LAYOUTS 200
+#define N_DRAGS 50
+
+/* The snapping code the panel used before cc-display-snap.c, kept as a
+ * reference for the expected results.
+ */
+
+typedef struct
+{
+  guint owner;
+  int x1, y1;
+  int x2, y2;
+} Edge;
+
+typedef struct
+{
+  int dy, dx;
+} Snap;
+
+static void
+add_edge (guint owner, int x1, int y1, int x2, int y2, GArray *edges)
+{
+  Edge e;
+
+  e.x1 = x1;
+  e.x2 = x2;
+  e.y1 = y1;
+  e.y2 = y2;
+  e.owner = owner;
+
+  g_array_append_val (edges, e);
+}
+
+static void
+list_edges (const GdkRectangle *rects, guint n_rects, GArray *edges)
+{
+  guint i;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      int x = rects[i].x, y = rects[i].y, w = rects[i].width, h = rects[i].height;
+
+      /* Top, Bottom, Left, Right */
+      add_edge (i, x, y, x + w, y, edges);
+      add_edge (i, x, y + h, x + w, y + h, edges);
+      add_edge (i, x, y, x, y + h, edges);
+      add_edge (i, x + w, y, x + w, y + h, edges);
+    }
+}
+
+static gboolean
+overlap (int s1, int e1, int s2, int e2)
+{
+  return (!(e1 < s2 || s1 >= e2));
+}
+
+static gboolean
+horizontal_overlap (Edge *snapper, Edge *snappee)
+{
+  if (snapper->y1 != snapper->y2 || snappee->y1 != snappee->y2)
+    return FALSE;
+
+  return overlap (snapper->x1, snapper->x2, snappee->x1, snappee->x2);
+}
+
+static gboolean
+vertical_overlap (Edge *snapper, Edge *snappee)
+{
+  if (snapper->x1 != snapper->x2 || snappee->x1 != snappee->x2)
+    return FALSE;
+
+  return overlap (snapper->y1, snapper->y2, snappee->y1, snappee->y2);
+}
+
+static void
+add_snap (GArray *snaps, int dx, int dy)
+{
+  Snap snap;
+
+  snap.dx = dx;
+  snap.dy = dy;
+
+  if (ABS (snap.dx) <= 200 || ABS (snap.dy) <= 200)
+    g_array_append_val (snaps, snap);
+}
+
+static void
+add_edge_snaps (Edge *snapper, Edge *snappee, GArray *snaps)
+{
+  if (horizontal_overlap (snapper, snappee))
+    add_snap (snaps, 0, snappee->y1 - snapper->y1);
+  else if (vertical_overlap (snapper, snappee))
+    add_snap (snaps, snappee->x1 - snapper->x1, 0);
+
+  add_snap (snaps, snappee->x1 - snapper->x1, snappee->y1 - snapper->y1);
+  add_snap (snaps, snappee->x2 - snapper->x1, snappee->y2 - snapper->y1);
+  add_snap (snaps, snappee->x2 - snapper->x2, snappee->y2 - snapper->y2);
+  add_snap (snaps, snappee->x1 - snapper->x2, snappee->y1 - snapper->y2);
+}
+
+static void
+list_snaps (guint moving, GArray *edges, GArray *snaps)
+{
+  guint i, j;
+
+  for (i = 0; i < edges->len; ++i)
+    {
+      Edge *output_edge = &(g_array_index (edges, Edge, i));
+
+      if (output_edge->owner != moving)
+        continue;
+
+      for (j = 0; j < edges->len; ++j)
+        {
+          Edge *edge = &(g_array_index (edges, Edge, j));
+
+          if (edge->owner != moving)
+            add_edge_snaps (output_edge, edge, snaps);
+        }
+    }
+}
+
+static gboolean
+corner_on_edge (int x, int y, Edge *e)
+{
+  if (x == e->x1 && x == e->x2 && y >= e->y1 && y <= e->y2)
+    return TRUE;
+
+  if (y == e->y1 && y == e->y2 && x >= e->x1 && x <= e->x2)
+    return TRUE;
+
+  return FALSE;
+}
+
+static gboolean
+edges_align (Edge *e1, Edge *e2)
+{
+  return corner_on_edge (e1->x1, e1->y1, e2) || corner_on_edge (e2->x1, e2->y1, e1);
+}
+
+static gboolean
+output_is_aligned (guint output, GArray *edges)
+{
+  guint i, j;
+
+  for (i = 0; i < edges->len; ++i)
+    {
+      Edge *output_edge = &(g_array_index (edges, Edge, i));
+
+      if (output_edge->owner != output)
+        continue;
+
+      for (j = 0; j < edges->len; ++j)
+        {
+          Edge *edge = &(g_array_index (edges, Edge, j));
+
+          if (edge->owner != output && edges_align (output_edge, edge))
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static gboolean
+reference_is_aligned (const GdkRectangle *rects, guint n_rects)
+{
+  GArray *edges;
+  gboolean result = TRUE;
+  guint i, j;
+
+  edges = g_array_new (FALSE, FALSE, sizeof (Edge));
+  list_edges (rects, n_rects, edges);
+
+  for (i = 0; i < n_rects && result; i++)
+    {
+      if (!output_is_aligned (i, edges))
+        result = FALSE;
+
+      for (j = 0; j < n_rects && result; j++)
+        {
+          if (j != i && gdk_rectangle_intersect (&rects[i], &rects[j], NULL))
+            result = FALSE;
+        }
+    }
+
+  g_array_free (edges, TRUE);
+
+  return result;
+}
+
+static int
+compare_snaps (gconstpointer v1, gconstpointer v2)
+{
+  const Snap *s1 = v1;
+  const Snap *s2 = v2;
+  int sv1 = MAX (ABS (s1->dx), ABS (s1->dy));
+  int sv2 = MAX (ABS (s2->dx), ABS (s2->dy));
+  gboolean c1 = s1->dx != 0 && s1->dy != 0;
+  gboolean c2 = s2->dx != 0 && s2->dy != 0;
+
+  if (sv1 != sv2)
+    return sv1 - sv2;
+  if (c1 && !c2)
+    return -1;
+  if (c2 && !c1)
+    return 1;
+  return 0;
+}
+
+static gboolean
+reference_find (const GdkRectangle *rects,
+                guint               n_rects,
+                guint               moving,
+                gint               *dx,
+                gint               *dy)
+{
+  GArray *edges, *snaps;
+  GdkRectangle *moved;
+  gboolean ret = FALSE;
+  guint i;
+
+  edges = g_array_new (FALSE, FALSE, sizeof (Edge));
+  snaps = g_array_new (FALSE, FALSE, sizeof (Snap));
+  moved = g_memdup (rects, n_rects * sizeof (GdkRectangle));
+
+  list_edges (rects, n_rects, edges);
+  list_snaps (moving, edges, snaps);
+  g_array_sort (snaps, compare_snaps);
+
+  for (i = 0; i < snaps->len && !ret; i++)
+    {
+      Snap *snap = &g_array_index (snaps, Snap, i);
+
+      moved[moving].x = rects[moving].x + snap->dx;
+      moved[moving].y = rects[moving].y + snap->dy;
+
+      if (reference_is_aligned (moved, n_rects))
+        {
+          *dx = snap->dx;
+          *dy = snap->dy;
+          ret = TRUE;
+        }
+    }
+
+  g_free (moved);
+  g_array_free (snaps, TRUE);
+  g_array_free (edges, TRUE);
+
+  return ret;
+}
+
+/* Lays out @n_rects outputs of common sizes in rows, like a wall of
+ * monitors, then moves some of them away to break the layout.
+ */
+static void
+make_layout (GdkRectangle *rects, guint n_rects, gboolean scramble)
+{
+  static const int sizes[][2] = {
+    { 1920, 1080 }, { 1080, 1920 }, { 2560, 1440 }, { 1280, 1024 }, { 1024, 768 },
+  };
+  int x = 0, y = 0, row_height = 0;
+  guint per_row, i;
+
+  per_row = g_test_rand_int_range (2, 9);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      guint s = g_test_rand_int_range (0, G_N_ELEMENTS (sizes));
+
+      if (i > 0 && i % per_row == 0)
+        {
+          x = 0;
+          y += row_height;
+          row_height = 0;
+        }
+
+      rects[i].x = x;
+      rects[i].y = y;
+      rects[i].width = sizes[s][0];
+      rects[i].height = sizes[s][1];
+
+      x += rects[i].width;
+      row_height = MAX (row_height, rects[i].height);
+
+      if (scramble && g_test_rand_bit ())
+        {
+          rects[i].x += g_test_rand_int_range (-300, 300);
+          rects[i].y += g_test_rand_int_range (-300, 300);
+        }
+    }
+}
+
+static void
+test_snap_simple (void)
+{
+  GdkRectangle rects[2] = {
+    { 0, 0, 1920, 1080 },
+    { 1950, 40, 1280, 1024 },
+  };
+  gint dx, dy;
+
+  g_assert (!cc_display_snap_layout_is_aligned (rects, 2));
+  g_assert (!cc_display_snap_layout_is_aligned (rects, 1));
+
+  g_assert (cc_display_snap_find (rects, 2, 1, &dx, &dy));
+  g_assert_cmpint (dx, ==, -30);
+  g_assert_cmpint (dy, ==, 16);
+
+  rects[1].x += dx;
+  rects[1].y += dy;
+  g_assert (cc_display_snap_layout_is_aligned (rects, 2));
+
+  /* Overlapping outputs are never aligned */
+  rects[1].x -= 1;
+  g_assert (!cc_display_snap_layout_is_aligned (rects, 2));
+
+  /* Too far away to snap */
+  rects[1].x = 5000;
+  rects[1].y = 5000;
+  g_assert (!cc_display_snap_find (rects, 2, 1, &dx, &dy));
+}
+
+static void
+test_snap_random (void)
+{
+  GdkRectangle rects[N_OUTPUTS];
+  guint i, j;
+
+  for (i = 0; i < N_LAYOUTS; i++)
+    {
+      guint n_rects = g_test_rand_int_range (2, N_OUTPUTS + 1);
+      guint moving = g_test_rand_int_range (0, n_rects);
+      CcDisplaySnap *snap;
+
+      make_layout (rects, n_rects, i % 2);
+      g_assert_cmpint (cc_display_snap_layout_is_aligned (rects, n_rects), ==,
+                       reference_is_aligned (rects, n_rects));
+
+      /* The same drag, at several positions */
+      snap = cc_display_snap_new (rects, n_rects, moving);
+
+      for (j = 0; j < 5; j++)
+        {
+          GdkRectangle dragged[N_OUTPUTS];
+          gint dx = 0, dy = 0, ref_dx = 0, ref_dy = 0;
+          gboolean found, ref_found;
+
+          memcpy (dragged, rects, n_rects * sizeof (GdkRectangle));
+          dragged[moving].x += g_test_rand_int_range (-400, 400);
+          dragged[moving].y += g_test_rand_int_range (-400, 400);
+
+          found = cc_display_snap_query (snap, &dragged[moving], &dx, &dy);
+          ref_found = reference_find (dragged, n_rects, moving, &ref_dx, &ref_dy);
+
+          g_assert_cmpint (found, ==, ref_found);
+          if (found)
+            {
+              g_assert_cmpint (dx, ==, ref_dx);
+              g_assert_cmpint (dy, ==, ref_dy);
+            }
+
+          found = cc_display_snap_find (dragged, n_rects, moving, &dx, &dy);
+          g_assert_cmpint (found, ==, ref_found);
+        }
+
+      cc_display_snap_free (snap);
+    }
+}
+
+static void
+test_snap_perf (void)
+{
+  GdkRectangle rects[N_OUTPUTS];
+  CcDisplaySnap *snap;
+  GTimer *timer;
+  gdouble elapsed, ref_elapsed;
+  gint dx, dy;
+  guint i;
+
+  /* A broken layout, so that most candidates get rejected */
+  make_layout (rects, N_OUTPUTS, TRUE);
+
+  timer = g_timer_new ();
+
+  /* As in the panel, where the snap is set up when the drag starts */
+  snap = cc_display_snap_new (rects, N_OUTPUTS, 0);
+  for (i = 0; i < N_DRAGS; i++)
+    {
+      rects[0].x = 100 + i;
+      rects[0].y = -50 - i;
+      cc_display_snap_query (snap, &rects[0], &dx, &dy);
+    }
+  cc_display_snap_free (snap);
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < N_DRAGS; i++)
+    {
+      rects[0].x = 100 + i;
+      rects[0].y = -50 - i;
+      reference_find (rects, N_OUTPUTS, 0, &dx, &dy);
+    }
+  ref_elapsed = g_timer_elapsed (timer, NULL);
+
+  g_timer_destroy (timer);
+
+  g_test_minimized_result (elapsed / N_DRAGS,
+                           "snapping with %d outputs: %.6f seconds per drag "
+                           "(%.6f before)", N_OUTPUTS,
+                           elapsed / N_DRAGS, ref_elapsed / N_DRAGS);
+}
+
+int main (int argc, char **argv)
+{
+  setlocale (LC_ALL, "");
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/display/snap/simple", test_snap_simple);
+  g_test_add_func ("/display/snap/random", test_snap_random);
+  if (g_test_perf ())
+    g_test_add_func ("/display/snap/perf", test_snap_perf);
+
+  return g_test_run ();
+}
@@ -0,0 +1,672 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <glibtop/mem.h>
+#include <glibtop/sysinfo.h>
+
+#include "cc-info-inventory.h"
+
+#define SYSFS_CPU_DIR  "/sys/devices/system/cpu"
+#define SYSFS_NODE_DIR "/sys/devices/system/node"
+#define SYSFS_EDAC_DIR "/sys/devices/system/edac/mc"
+#define SYSFS_PCI_DIR  "/sys/bus/pci/devices"
+
+static void
+cpu_clear (CcInfoCpu *cpu)
+{
+  g_free (cpu->model);
+}
+
+static void
+cache_clear (CcInfoCache *cache)
+{
+  g_free (cache->type);
+  g_free (cache->shared_cpus);
+}
+
+static void
+numa_node_clear (CcInfoNumaNode *node)
+{
+  g_free (node->cpus);
+}
+
+static void
+dimm_clear (CcInfoDimm *dimm)
+{
+  g_free (dimm->label);
+  g_free (dimm->type);
+}
+
+static void
+pci_device_clear (CcInfoPciDevice *device)
+{
+  g_free (device->address);
+  g_free (device->driver);
+}
+
+static GArray *
+inventory_array_new (guint          element_size,
+                     GDestroyNotify clear_func)
+{
+  GArray *array;
+
+  array = g_array_new (FALSE, TRUE, element_size);
+  g_array_set_clear_func (array, clear_func);
+
+  return array;
+}
+
+static CcInfoInventory *
+cc_info_inventory_new (void)
+{
+  CcInfoInventory *inventory;
+
+  inventory = g_new0 (CcInfoInventory, 1);
+  inventory->cpus = inventory_array_new (sizeof (CcInfoCpu), (GDestroyNotify) cpu_clear);
+  inventory->caches = inventory_array_new (sizeof (CcInfoCache), (GDestroyNotify) cache_clear);
+  inventory->numa_nodes = inventory_array_new (sizeof (CcInfoNumaNode), (GDestroyNotify) numa_node_clear);
+  inventory->dimms = inventory_array_new (sizeof (CcInfoDimm), (GDestroyNotify) dimm_clear);
+  inventory->pci_devices = inventory_array_new (sizeof (CcInfoPciDevice), (GDestroyNotify) pci_device_clear);
+
+  return inventory;
+}
+
+void
+cc_info_inventory_free (CcInfoInventory *inventory)
+{
+  g_array_unref (inventory->cpus);
+  g_array_unref (inventory->caches);
+  g_array_unref (inventory->numa_nodes);
+  g_array_unref (inventory->dimms);
+  g_array_unref (inventory->pci_devices);
+  g_free (inventory);
+}
+
+static char *
+read_sysfs_string (const char *dir,
+                   const char *name)
+{
+  char *path;
+  char *contents = NULL;
+
+  path = g_build_filename (dir, name, NULL);
+  if (g_file_get_contents (path, &contents, NULL, NULL))
+    g_strstrip (contents);
+  g_free (path);
+
+  return contents;
+}
+
+static gboolean
+read_sysfs_uint64 (const char *dir,
+                   const char *name,
+                   guint64    *value)
+{
+  char *str, *end;
+  gboolean ret;
+
+  str = read_sysfs_string (dir, name);
+  if (str == NULL)
+    return FALSE;
+
+  *value = g_ascii_strtoull (str, &end, 0);
+  ret = (end != str);
+  g_free (str);
+
+  return ret;
+}
+
+static gint
+read_sysfs_id (const char *dir,
+               const char *name)
+{
+  char *str, *end;
+  gint64 id;
+
+  str = read_sysfs_string (dir, name);
+  if (str == NULL)
+    return -1;
+
+  id = g_ascii_strtoll (str, &end, 10);
+  if (end == str || id < 0 || id > G_MAXINT)
+    id = -1;
+  g_free (str);
+
+  return id;
+}
+
+/* Sizes such as "32K" in the cache directories */
+static guint64
+parse_size (const char *str)
+{
+  guint64 size;
+  char *end;
+
+  size = g_ascii_strtoull (str, &end, 10);
+  switch (*end)
+    {
+    case 'K':
+      return size * 1024;
+    case 'M':
+      return size * 1024 * 1024;
+    case 'G':
+      return size * 1024 * 1024 * 1024;
+    default:
+      return size;
+    }
+}
+
+/* Puts "dimm2" before "dimm10", for names sharing a prefix */
+static int
+compare_names (gconstpointer a,
+               gconstpointer b)
+{
+  const char *name_a = *(const char **) a;
+  const char *name_b = *(const char **) b;
+  gsize len_a = strlen (name_a);
+  gsize len_b = strlen (name_b);
+
+  if (len_a != len_b)
+    return len_a < len_b ? -1 : 1;
+
+  return strcmp (name_a, name_b);
+}
+
+static GPtrArray *
+list_dir (const char *path,
+          const char *prefix)
+{
+  GPtrArray *names;
+  const char *name;
+  GDir *dir;
+
+  names = g_ptr_array_new_with_free_func (g_free);
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return names;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      if (prefix == NULL || g_str_has_prefix (name, prefix))
+        g_ptr_array_add (names, g_strdup (name));
+    }
+  g_dir_close (dir);
+
+  g_ptr_array_sort (names, compare_names);
+
+  return names;
+}
+
+static void
+collect_cpu_caches (CcInfoInventory *inventory,
+                    const char      *cpu_dir,
+                    GHashTable      *seen)
+{
+  GPtrArray *indexes;
+  char *cache_dir;
+  guint i;
+
+  cache_dir = g_build_filename (cpu_dir, "cache", NULL);
+  indexes = list_dir (cache_dir, "index");
+
+  for (i = 0; i < indexes->len; i++)
+    {
+      CcInfoCache cache;
+      char *index_dir;
+      char *size;
+      char *key;
+      guint64 level;
+
+      index_dir = g_build_filename (cache_dir, g_ptr_array_index (indexes, i), NULL);
+
+      if (!read_sysfs_uint64 (index_dir, "level", &level))
+        goto next;
+
+      cache.level = level;
+      cache.type = read_sysfs_string (index_dir, "type");
+      cache.shared_cpus = read_sysfs_string (index_dir, "shared_cpu_list");
+      size = read_sysfs_string (index_dir, "size");
+      cache.size = size ? parse_size (size) : 0;
+      g_free (size);
+
+      /* A shared cache shows up under each of the processors using it */
+      key = g_strdup_printf ("%u/%s/%s", cache.level,
+                             cache.type ? cache.type : "",
+                             cache.shared_cpus ? cache.shared_cpus : "");
+      if (g_hash_table_contains (seen, key))
+        {
+          g_free (key);
+          cache_clear (&cache);
+          goto next;
+        }
+      g_hash_table_add (seen, key);
+      g_array_append_val (inventory->caches, cache);
+
+next:
+      g_free (index_dir);
+    }
+
+  g_ptr_array_unref (indexes);
+  g_free (cache_dir);
+}
+
+static void
+collect_cpus (CcInfoInventory *inventory)
+{
+  GHashTable *seen;
+  guint i;
+
+  seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; i < inventory->cpus->len; i++)
+    {
+      CcInfoCpu *cpu = &g_array_index (inventory->cpus, CcInfoCpu, i);
+      char *cpu_dir, *dir;
+
+      cpu_dir = g_strdup_printf (SYSFS_CPU_DIR "/cpu%u", cpu->index);
+
+      dir = g_build_filename (cpu_dir, "topology", NULL);
+      cpu->package_id = read_sysfs_id (dir, "physical_package_id");
+      cpu->core_id = read_sysfs_id (dir, "core_id");
+      g_free (dir);
+
+      dir = g_build_filename (cpu_dir, "cpufreq", NULL);
+      read_sysfs_uint64 (dir, "scaling_cur_freq", &cpu->cur_freq_khz);
+      read_sysfs_uint64 (dir, "cpuinfo_max_freq", &cpu->max_freq_khz);
+      g_free (dir);
+
+      collect_cpu_caches (inventory, cpu_dir, seen);
+
+      g_free (cpu_dir);
+    }
+
+  g_hash_table_destroy (seen);
+}
+
+static void
+collect_numa_nodes (CcInfoInventory *inventory)
+{
+  GPtrArray *names;
+  guint i;
+
+  names = list_dir (SYSFS_NODE_DIR, "node");
+
+  for (i = 0; i < names->len; i++)
+    {
+      const char *name = g_ptr_array_index (names, i);
+      CcInfoNumaNode node;
+      char *node_dir;
+      char *meminfo;
+
+      if (!g_ascii_isdigit (name[strlen ("node")]))
+        continue;
+
+      node_dir = g_build_filename (SYSFS_NODE_DIR, name, NULL);
+
+      node.id = strtoul (name + strlen ("node"), NULL, 10);
+      node.cpus = read_sysfs_string (node_dir, "cpulist");
+      node.memory = 0;
+
+      /* "Node 0 MemTotal:       16314196 kB" */
+      meminfo = read_sysfs_string (node_dir, "meminfo");
+      if (meminfo != NULL)
+        {
+          const char *total;
+
+          total = strstr (meminfo, "MemTotal:");
+          if (total != NULL)
+            node.memory = g_ascii_strtoull (total + strlen ("MemTotal:"), NULL, 10) * 1024;
+          g_free (meminfo);
+        }
+
+      g_array_append_val (inventory->numa_nodes, node);
+      g_free (node_dir);
+    }
+
+  g_ptr_array_unref (names);
+}
+
+/* The DIMMs are only visible through EDAC, the DMI tables
+ * being readable by root only */
+static void
+collect_dimms (CcInfoInventory *inventory)
+{
+  GPtrArray *controllers;
+  guint i, j;
+
+  controllers = list_dir (SYSFS_EDAC_DIR, "mc");
+
+  for (i = 0; i < controllers->len; i++)
+    {
+      GPtrArray *names;
+      char *mc_dir;
+
+      mc_dir = g_build_filename (SYSFS_EDAC_DIR, g_ptr_array_index (controllers, i), NULL);
+      names = list_dir (mc_dir, NULL);
+
+      for (j = 0; j < names->len; j++)
+        {
+          const char *name = g_ptr_array_index (names, j);
+          CcInfoDimm dimm;
+          char *dimm_dir;
+          guint64 size_mb;
+
+          if (!g_str_has_prefix (name, "dimm") &&
+              !g_str_has_prefix (name, "rank"))
+            continue;
+
+          dimm_dir = g_build_filename (mc_dir, name, NULL);
+
+          if (read_sysfs_uint64 (dimm_dir, "size", &size_mb) && size_mb > 0)
+            {
+              dimm.size = size_mb * 1024 * 1024;
+              dimm.label = read_sysfs_string (dimm_dir, "dimm_label");
+              dimm.type = read_sysfs_string (dimm_dir, "dimm_mem_type");
+              g_array_append_val (inventory->dimms, dimm);
+            }
+
+          g_free (dimm_dir);
+        }
+
+      g_ptr_array_unref (names);
+      g_free (mc_dir);
+    }
+
+  g_ptr_array_unref (controllers);
+}
+
+static void
+collect_pci_devices (CcInfoInventory *inventory)
+{
+  GPtrArray *addresses;
+  guint i;
+
+  addresses = list_dir (SYSFS_PCI_DIR, NULL);
+
+  for (i = 0; i < addresses->len; i++)
+    {
+      CcInfoPciDevice device;
+      char *device_dir;
+      char *driver_link;
+      char *driver;
+      guint64 value;
+
+      device.address = g_strdup (g_ptr_array_index (addresses, i));
+      device_dir = g_build_filename (SYSFS_PCI_DIR, device.address, NULL);
+
+      device.vendor_id = read_sysfs_uint64 (device_dir, "vendor", &value) ? value : 0;
+      device.device_id = read_sysfs_uint64 (device_dir, "device", &value) ? value : 0;
+      device.class_id = read_sysfs_uint64 (device_dir, "class", &value) ? value : 0;
+
+      device.driver = NULL;
+      driver_link = g_build_filename (device_dir, "driver", NULL);
+      driver = g_file_read_link (driver_link, NULL);
+      if (driver != NULL)
+        {
+          device.driver = g_path_get_basename (driver);
+          g_free (driver);
+        }
+      g_free (driver_link);
+
+      g_array_append_val (inventory->pci_devices, device);
+      g_free (device_dir);
+    }
+
+  g_ptr_array_unref (addresses);
+}
+
+static void
+collect_thread (GTask        *task,
+                gpointer      source_object,
+                gpointer      task_data,
+                GCancellable *cancellable)
+{
+  CcInfoInventory *inventory = task_data;
+
+  collect_cpus (inventory);
+  collect_numa_nodes (inventory);
+  collect_dimms (inventory);
+  collect_pci_devices (inventory);
+
+  g_task_return_pointer (task, inventory, (GDestroyNotify) cc_info_inventory_free);
+}
+
+void
+cc_info_inventory_collect_async (GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  const glibtop_sysinfo *info;
+  CcInfoInventory *inventory;
+  glibtop_mem mem;
+  GTask *task;
+  guint i;
+
+  inventory = cc_info_inventory_new ();
+
+  /* libgtop isn't thread-safe, so its part is read here,
+   * and only sysfs is walked in the thread */
+  glibtop_get_mem (&mem);
+  inventory->memory_total = mem.total;
+
+  info = glibtop_get_sysinfo ();
+  for (i = 0; i < info->ncpu; i++)
+    {
+      const char * const keys[] = { "model name", "cpu", "Processor" };
+      const char *processor;
+      CcInfoCpu cpu = { 0, };
+      guint j;
+
+      processor = g_hash_table_lookup (info->cpuinfo[i].values, "processor");
+      cpu.index = processor ? strtoul (processor, NULL, 10) : i;
+      for (j = 0; cpu.model == NULL && j < G_N_ELEMENTS (keys); j++)
+        cpu.model = g_strdup (g_hash_table_lookup (info->cpuinfo[i].values, keys[j]));
+      cpu.package_id = -1;
+      cpu.core_id = -1;
+
+      g_array_append_val (inventory->cpus, cpu);
+    }
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_info_inventory_collect_async);
+  /* Handed over to the task's result by the thread */
+  g_task_set_task_data (task, inventory, NULL);
+  g_task_run_in_thread (task, collect_thread);
+  g_object_unref (task);
+}
+
+CcInfoInventory *
+cc_info_inventory_collect_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+json_append_string (GString    *json,
+                    const char *str)
+{
+  const char *p;
+
+  if (str == NULL)
+    {
+      g_string_append (json, "null");
+      return;
+    }
+
+  g_string_append_c (json, '"');
+  for (p = str; *p != '\0'; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (json, "\\\"");
+          break;
+        case '\\':
+          g_string_append (json, "\\\\");
+          break;
+        case '\n':
+          g_string_append (json, "\\n");
+          break;
+        case '\t':
+          g_string_append (json, "\\t");
+          break;
+        default:
+          if ((guchar) *p < 0x20)
+            g_string_append_printf (json, "\\u%04x", (guchar) *p);
+          else
+            g_string_append_c (json, *p);
+        }
+    }
+  g_string_append_c (json, '"');
+}
+
+static void
+json_append_id (GString *json,
+                gint     id)
+{
+  if (id < 0)
+    g_string_append (json, "null");
+  else
+    g_string_append_printf (json, "%d", id);
+}
+
+static void
+json_append_frequency (GString *json,
+                       guint64  khz)
+{
+  if (khz == 0)
+    g_string_append (json, "null");
+  else
+    g_string_append_printf (json, "%" G_GUINT64_FORMAT, khz);
+}
+
+/* Starts the n-th element of an array, one per line */
+static void
+json_next_element (GString *json,
+                   guint    n)
+{
+  g_string_append (json, n == 0 ? "\n    " : ",\n    ");
+}
+
+static void
+json_end_array (GString *json,
+                guint    len)
+{
+  g_string_append (json, len == 0 ? "]" : "\n  ]");
+}
+
+char *
+cc_info_inventory_to_json (CcInfoInventory *inventory)
+{
+  GString *json;
+  guint i;
+
+  json = g_string_new ("{\n");
+
+  g_string_append_printf (json, "  \"memory\": %" G_GUINT64_FORMAT ",\n",
+                          inventory->memory_total);
+
+  g_string_append (json, "  \"cpus\": [");
+  for (i = 0; i < inventory->cpus->len; i++)
+    {
+      CcInfoCpu *cpu = &g_array_index (inventory->cpus, CcInfoCpu, i);
+
+      json_next_element (json, i);
+      g_string_append_printf (json, "{\"index\": %u, \"model\": ", cpu->index);
+      json_append_string (json, cpu->model);
+      g_string_append (json, ", \"package\": ");
+      json_append_id (json, cpu->package_id);
+      g_string_append (json, ", \"core\": ");
+      json_append_id (json, cpu->core_id);
+      g_string_append (json, ", \"frequency_khz\": ");
+      json_append_frequency (json, cpu->cur_freq_khz);
+      g_string_append (json, ", \"max_frequency_khz\": ");
+      json_append_frequency (json, cpu->max_freq_khz);
+      g_string_append_c (json, '}');
+    }
+  json_end_array (json, inventory->cpus->len);
+
+  g_string_append (json, ",\n  \"caches\": [");
+  for (i = 0; i < inventory->caches->len; i++)
+    {
+      CcInfoCache *cache = &g_array_index (inventory->caches, CcInfoCache, i);
+
+      json_next_element (json, i);
+      g_string_append_printf (json, "{\"level\": %u, \"type\": ", cache->level);
+      json_append_string (json, cache->type);
+      g_string_append_printf (json, ", \"size\": %" G_GUINT64_FORMAT ", \"shared_cpus\": ",
+                              cache->size);
+      json_append_string (json, cache->shared_cpus);
+      g_string_append_c (json, '}');
+    }
+  json_end_array (json, inventory->caches->len);
+
+  g_string_append (json, ",\n  \"numa_nodes\": [");
+  for (i = 0; i < inventory->numa_nodes->len; i++)
+    {
+      CcInfoNumaNode *node = &g_array_index (inventory->numa_nodes, CcInfoNumaNode, i);
+
+      json_next_element (json, i);
+      g_string_append_printf (json, "{\"id\": %u, \"cpus\": ", node->id);
+      json_append_string (json, node->cpus);
+      g_string_append_printf (json, ", \"memory\": %" G_GUINT64_FORMAT "}", node->memory);
+    }
+  json_end_array (json, inventory->numa_nodes->len);
+
+  g_string_append (json, ",\n  \"dimms\": [");
+  for (i = 0; i < inventory->dimms->len; i++)
+    {
+      CcInfoDimm *dimm = &g_array_index (inventory->dimms, CcInfoDimm, i);
+
+      json_next_element (json, i);
+      g_string_append (json, "{\"label\": ");
+      json_append_string (json, dimm->label);
+      g_string_append (json, ", \"type\": ");
+      json_append_string (json, dimm->type);
+      g_string_append_printf (json, ", \"size\": %" G_GUINT64_FORMAT "}", dimm->size);
+    }
+  json_end_array (json, inventory->dimms->len);
+
+  g_string_append (json, ",\n  \"pci_devices\": [");
+  for (i = 0; i < inventory->pci_devices->len; i++)
+    {
+      CcInfoPciDevice *device = &g_array_index (inventory->pci_devices, CcInfoPciDevice, i);
+
+      json_next_element (json, i);
+      g_string_append (json, "{\"address\": ");
+      json_append_string (json, device->address);
+      g_string_append_printf (json,
+                              ", \"vendor\": \"%04x\", \"device\": \"%04x\", \"class\": \"%06x\", \"driver\": ",
+                              device->vendor_id, device->device_id, device->class_id);
+      json_append_string (json, device->driver);
+      g_string_append_c (json, '}');
+    }
+  json_end_array (json, inventory->pci_devices->len);
+
+  g_string_append (json, "\n}\n");
+
+  return g_string_free (json, FALSE);
+}
@@ -0,0 +1,91 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_INFO_INVENTORY_H
+#define _CC_INFO_INVENTORY_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* A logical processor. The IDs are -1 and the frequencies 0
+ * when the kernel doesn't export them */
+typedef struct
+{
+  guint    index;
+  char    *model;
+  gint     package_id;
+  gint     core_id;
+  guint64  cur_freq_khz;
+  guint64  max_freq_khz;
+} CcInfoCpu;
+
+typedef struct
+{
+  guint    level;
+  char    *type;
+  guint64  size;
+  char    *shared_cpus;
+} CcInfoCache;
+
+typedef struct
+{
+  guint    id;
+  char    *cpus;
+  guint64  memory;
+} CcInfoNumaNode;
+
+typedef struct
+{
+  char    *label;
+  char    *type;
+  guint64  size;
+} CcInfoDimm;
+
+typedef struct
+{
+  char    *address;
+  guint    vendor_id;
+  guint    device_id;
+  guint    class_id;
+  char    *driver;
+} CcInfoPciDevice;
+
+typedef struct
+{
+  guint64  memory_total;
+  GArray  *cpus;
+  GArray  *caches;
+  GArray  *numa_nodes;
+  GArray  *dimms;
+  GArray  *pci_devices;
+} CcInfoInventory;
+
+void             cc_info_inventory_collect_async  (GCancellable        *cancellable,
+                                                   GAsyncReadyCallback  callback,
+                                                   gpointer             user_data);
+
+CcInfoInventory *cc_info_inventory_collect_finish (GAsyncResult        *result,
+                                                   GError             **error);
+
+char            *cc_info_inventory_to_json        (CcInfoInventory     *inventory);
+
+void             cc_info_inventory_free           (CcInfoInventory     *inventory);
+
+G_END_DECLS
+
+#endif /* _CC_INFO_INVENTORY_H */
@@ -22,6 +22,7 @@
 
 #include "cc-info-panel.h"
 #include "cc-info-resources.h"
+#include "cc-info-inventory.h"
 #include "info-cleanup.h"
 
 #include <glib.h>
@@ -58,15 +59,35 @@
 
 #define WID(w) (GtkWidget *) gtk_builder_get_object (self->priv->builder, w)
 
+/* How long a single mount may take to report its size */
+#define DISK_QUERY_TIMEOUT 3 /* seconds */
+/* How long the disk figures are reused when the panel is reopened */
+#define DISK_CACHE_TIMEOUT 30 /* seconds */
+
+#define INVENTORY_RESPONSE_COPY 1
+
+enum {
+  INVENTORY_NAME_COLUMN,
+  INVENTORY_VALUE_COLUMN,
+  INVENTORY_N_COLUMNS
+};
+
 CC_PANEL_REGISTER (CcInfoPanel, cc_info_panel)
 
 #define INFO_PANEL_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), CC_TYPE_INFO_PANEL, CcInfoPanelPrivate))
 
-typedef struct {
-  /* Will be one or 2 GPU name strings, or "Unknown" */
-  char *hardware_string;
-} GraphicsData;
+/* The graphics and virtualization probes, which can outlive
+ * the panel if a service or the GL helper is slow to answer */
+typedef struct
+{
+  gint          ref_count;
+  CcInfoPanel  *self;
+  GCancellable *cancellable;
+  guint         graphics_pending;
+  char         *renderer;
+  char         *discrete_renderer;
+} HardwareQuery;
 
 typedef struct 
 {
@@ -78,6 +99,35 @@ typedef struct
   const char *extra_type_filter;
 } DefaultAppData;
 
+typedef struct
+{
+  char    *mount_path;
+  char    *filesystem_id;
+  guint64  size;
+  guint64  used;
+  guint64  free;
+} DiskUsage;
+
+/* The size queries of all the primary mounts, which can outlive
+ * the panel if a mount doesn't answer */
+typedef struct
+{
+  gint          ref_count;
+  CcInfoPanel  *self;
+  GCancellable *cancellable;
+  guint         pending;
+  GArray       *disks;
+} DiskQuery;
+
+typedef struct
+{
+  DiskQuery *query;
+  GFile     *file;
+  char      *filesystem_id;
+  guint      timeout_id;
+  gboolean   done;
+} DiskProbe;
+
 struct _CcInfoPanelPrivate
 {
   GtkBuilder    *builder;
@@ -86,20 +136,32 @@ struct _CcInfoPanelPrivate
   char          *gnome_distributor;
   char          *gnome_date;
 
-  GCancellable  *cancellable;
-
   /* Free space */
-  GList         *primary_mounts;
-  guint64        total_bytes;
+  DiskQuery     *disk_query;
 
   /* Media */
   GSettings     *media_settings;
   GtkWidget     *other_application_combo;
 
-  GraphicsData  *graphics_data;
+  /* Graphics and virtualization */
+  HardwareQuery *hardware_query;
+
+  /* Hardware details */
+  GtkWidget     *inventory_dialog;
+  GtkTreeStore  *inventory_store;
+  GCancellable  *inventory_cancellable;
+  CcInfoInventory *inventory;
 };
 
-static void get_primary_disc_info_start (CcInfoPanel *self);
+/* Deduplicated disk usage, shared by all the instances of the panel */
+static GArray *disk_cache = NULL;
+static gint64 disk_cache_time = 0;
+
+/* The hardware doesn't change during a session, so the probes
+ * only run the first time the panel is opened */
+static char *graphics_cache = NULL;
+static char *virt_cache = NULL;
+static gboolean virt_cache_valid = FALSE;
 
 typedef struct
 {
@@ -216,110 +278,206 @@ load_gnome_version (char **version,
 };
 
 static void
-graphics_data_free (GraphicsData *gdata)
+hardware_query_unref (HardwareQuery *query)
 {
-  g_free (gdata->hardware_string);
-  g_slice_free (GraphicsData, gdata);
+  if (--query->ref_count > 0)
+    return;
+
+  g_object_unref (query->cancellable);
+  g_free (query->renderer);
+  g_free (query->discrete_renderer);
+  g_free (query);
+}
+
+static void
+graphics_query_done (HardwareQuery *query)
+{
+  if (g_cancellable_is_cancelled (query->cancellable))
+    return;
+
+  g_free (graphics_cache);
+  if (query->renderer == NULL && query->discrete_renderer == NULL)
+    graphics_cache = g_strdup (_("Unknown"));
+  else if (query->discrete_renderer == NULL)
+    graphics_cache = g_strdup (query->renderer);
+  else
+    graphics_cache = g_strdup_printf ("%s / %s",
+                                      query->renderer ? query->renderer : _("Unknown"),
+                                      query->discrete_renderer);
+
+  if (query->self != NULL)
+    {
+      CcInfoPanel *self = query->self;
+      gtk_label_set_markup (GTK_LABEL (WID ("graphics_label")), graphics_cache);
+    }
+}
+
+/* Called once for the integrated GPU and once for the discrete one,
+ * whether or not a renderer was found */
+static void
+graphics_probe_finish (HardwareQuery *query)
+{
+  if (--query->graphics_pending == 0)
+    graphics_query_done (query);
 }
 
 static char *
-get_renderer_from_session (void)
+renderer_helper_finish (GSubprocess  *subprocess,
+                        GAsyncResult *res,
+                        gboolean      discrete_gpu)
 {
-  GDBusProxy *session_proxy;
-  GVariant *renderer_variant;
-  char *renderer;
+  char *renderer = NULL;
+  char *ret = NULL;
   GError *error = NULL;
 
-  session_proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-                                                 G_DBUS_PROXY_FLAGS_NONE,
-                                                 NULL,
-                                                 "org.gnome.SessionManager",
-                                                 "/org/gnome/SessionManager",
-                                                 "org.gnome.SessionManager",
-                                                 NULL, &error);
-  if (error != NULL)
+  if (!g_subprocess_communicate_utf8_finish (subprocess, res, &renderer, NULL, &error))
     {
-      g_warning ("Unable to connect to create a proxy for org.gnome.SessionManager: %s",
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_debug ("Failed to get %s GPU: %s",
+                 discrete_gpu ? "discrete" : "integrated",
                  error->message);
       g_error_free (error);
-      return NULL;
+      goto out;
     }
 
-  renderer_variant = g_dbus_proxy_get_cached_property (session_proxy, "Renderer");
-  g_object_unref (session_proxy);
+  if (!g_subprocess_get_successful (subprocess))
+    goto out;
 
-  if (!renderer_variant)
-    {
-      g_warning ("Unable to retrieve org.gnome.SessionManager.Renderer property");
-      return NULL;
-    }
+  if (renderer == NULL || *renderer == '\0')
+    goto out;
+
+  ret = info_cleanup (renderer);
 
-  renderer = info_cleanup (g_variant_get_string (renderer_variant, NULL));
-  g_variant_unref (renderer_variant);
+out:
+  g_free (renderer);
+  return ret;
+}
 
-  return renderer;
+static void
+renderer_helper_done (GSubprocess   *subprocess,
+                      GAsyncResult  *res,
+                      HardwareQuery *query)
+{
+  query->renderer = renderer_helper_finish (subprocess, res, FALSE);
+  graphics_probe_finish (query);
+  hardware_query_unref (query);
 }
 
-static char *
-get_renderer_from_helper (gboolean discrete_gpu)
+static void
+discrete_renderer_helper_done (GSubprocess   *subprocess,
+                               GAsyncResult  *res,
+                               HardwareQuery *query)
 {
-  int status;
-  char *argv[] = { GNOME_SESSION_DIR "/gnome-session-check-accelerated", NULL };
-  char **envp = NULL;
-  char *renderer = NULL;
-  char *ret = NULL;
+  query->discrete_renderer = renderer_helper_finish (subprocess, res, TRUE);
+  graphics_probe_finish (query);
+  hardware_query_unref (query);
+}
+
+static void
+get_renderer_from_helper (HardwareQuery *query,
+                          gboolean       discrete_gpu)
+{
+  GSubprocessLauncher *launcher;
+  GSubprocess *subprocess;
   GError *error = NULL;
 
-  if (discrete_gpu)
+  if (g_cancellable_is_cancelled (query->cancellable))
     {
-      envp = g_get_environ ();
-      envp = g_environ_setenv (envp, "DRI_PRIME", "1", TRUE);
+      graphics_probe_finish (query);
+      return;
     }
 
-  if (!g_spawn_sync (NULL, (char **) argv, envp, 0, NULL, NULL, &renderer, NULL, &status, &error))
+  launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_STDOUT_PIPE);
+  if (discrete_gpu)
+    g_subprocess_launcher_setenv (launcher, "DRI_PRIME", "1", TRUE);
+
+  subprocess = g_subprocess_launcher_spawn (launcher, &error,
+                                            GNOME_SESSION_DIR "/gnome-session-check-accelerated",
+                                            NULL);
+  g_object_unref (launcher);
+
+  if (subprocess == NULL)
     {
       g_debug ("Failed to get %s GPU: %s",
                discrete_gpu ? "discrete" : "integrated",
                error->message);
       g_error_free (error);
-      goto out;
+      graphics_probe_finish (query);
+      return;
     }
 
-  if (!g_spawn_check_exit_status (status, NULL))
-    goto out;
+  query->ref_count++;
+  g_subprocess_communicate_utf8_async (subprocess, NULL, query->cancellable,
+                                       discrete_gpu ?
+                                       (GAsyncReadyCallback) discrete_renderer_helper_done :
+                                       (GAsyncReadyCallback) renderer_helper_done,
+                                       query);
+  g_object_unref (subprocess);
+}
 
-  if (renderer == NULL || *renderer == '\0')
-    goto out;
+static void
+session_proxy_ready (GObject       *source,
+                     GAsyncResult  *res,
+                     HardwareQuery *query)
+{
+  GDBusProxy *session_proxy;
+  GVariant *renderer_variant = NULL;
+  GError *error = NULL;
 
-  ret = info_cleanup (renderer);
+  session_proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+  if (session_proxy == NULL)
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_error_free (error);
+          graphics_probe_finish (query);
+          goto out;
+        }
+      g_warning ("Unable to connect to create a proxy for org.gnome.SessionManager: %s",
+                 error->message);
+      g_error_free (error);
+    }
+  else
+    {
+      renderer_variant = g_dbus_proxy_get_cached_property (session_proxy, "Renderer");
+      g_object_unref (session_proxy);
+      if (!renderer_variant)
+        g_warning ("Unable to retrieve org.gnome.SessionManager.Renderer property");
+    }
+
+  if (renderer_variant)
+    {
+      query->renderer = info_cleanup (g_variant_get_string (renderer_variant, NULL));
+      g_variant_unref (renderer_variant);
+      graphics_probe_finish (query);
+    }
+  else
+    {
+      get_renderer_from_helper (query, FALSE);
+    }
 
 out:
-  g_free (renderer);
-  g_strfreev (envp);
-  return ret;
+  hardware_query_unref (query);
 }
 
-static gboolean
-has_dual_gpu (void)
+static void
+switcheroo_proxy_ready (GObject       *source,
+                        GAsyncResult  *res,
+                        HardwareQuery *query)
 {
   GDBusProxy *switcheroo_proxy;
   GVariant *dualgpu_variant;
-  gboolean ret;
+  gboolean dual_gpu = FALSE;
   GError *error = NULL;
 
-  switcheroo_proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SYSTEM,
-                                                    G_DBUS_PROXY_FLAGS_NONE,
-                                                    NULL,
-                                                    "net.hadess.SwitcherooControl",
-                                                    "/net/hadess/SwitcherooControl",
-                                                    "net.hadess.SwitcherooControl",
-                                                    NULL, &error);
+  switcheroo_proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
   if (switcheroo_proxy == NULL)
     {
-      g_debug ("Unable to connect to create a proxy for net.hadess.SwitcherooControl: %s",
-               error->message);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_debug ("Unable to connect to create a proxy for net.hadess.SwitcherooControl: %s",
+                 error->message);
       g_error_free (error);
-      return FALSE;
+      goto out;
     }
 
   dualgpu_variant = g_dbus_proxy_get_cached_property (switcheroo_proxy, "HasDualGpu");
@@ -328,55 +486,64 @@ has_dual_gpu (void)
   if (!dualgpu_variant)
     {
       g_debug ("Unable to retrieve net.hadess.SwitcherooControl.HasDualGpu property, the daemon is likely not running");
-      return FALSE;
+      goto out;
     }
 
-  ret = g_variant_get_boolean (dualgpu_variant);
+  dual_gpu = g_variant_get_boolean (dualgpu_variant);
   g_variant_unref (dualgpu_variant);
 
-  if (ret)
+  if (dual_gpu)
     g_debug ("Dual-GPU machine detected");
 
-  return ret;
+out:
+  if (dual_gpu)
+    get_renderer_from_helper (query, TRUE);
+  else
+    graphics_probe_finish (query);
+
+  hardware_query_unref (query);
 }
 
-static GraphicsData *
-get_graphics_data (void)
+static void
+get_graphics_data (HardwareQuery *query)
 {
-  GraphicsData *result;
   GdkDisplay *display;
 
-  result = g_slice_new0 (GraphicsData);
-
   display = gdk_display_get_default ();
 
 #if defined(GDK_WINDOWING_X11) || defined(GDK_WINDOWING_WAYLAND)
   if (GDK_IS_X11_DISPLAY (display) ||
       GDK_IS_WAYLAND_DISPLAY (display))
     {
-      char *discrete_renderer = NULL;
-      char *renderer;
-
-      renderer = get_renderer_from_session ();
-      if (!renderer)
-        renderer = get_renderer_from_helper (FALSE);
-      if (has_dual_gpu ())
-        discrete_renderer = get_renderer_from_helper (TRUE);
-      if (!discrete_renderer)
-        result->hardware_string = g_strdup (renderer);
-      else
-        result->hardware_string = g_strdup_printf ("%s / %s",
-                                                   renderer,
-                                                   discrete_renderer);
-      g_free (renderer);
-      g_free (discrete_renderer);
+      /* The session renderer (or the GL helper as a fallback)
+       * and the dual-GPU check run at the same time */
+      query->graphics_pending = 2;
+      query->ref_count += 2;
+
+      g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                                G_DBUS_PROXY_FLAGS_NONE,
+                                NULL,
+                                "org.gnome.SessionManager",
+                                "/org/gnome/SessionManager",
+                                "org.gnome.SessionManager",
+                                query->cancellable,
+                                (GAsyncReadyCallback) session_proxy_ready,
+                                query);
+      g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
+                                G_DBUS_PROXY_FLAGS_NONE,
+                                NULL,
+                                "net.hadess.SwitcherooControl",
+                                "/net/hadess/SwitcherooControl",
+                                "net.hadess.SwitcherooControl",
+                                query->cancellable,
+                                (GAsyncReadyCallback) switcheroo_proxy_ready,
+                                query);
+      return;
     }
 #endif
 
-  if (!result->hardware_string)
-    result->hardware_string = g_strdup (_("Unknown"));
-
-  return result;
+  query->graphics_pending = 1;
+  graphics_probe_finish (query);
 }
 
 static void
@@ -384,9 +551,30 @@ cc_info_panel_dispose (GObject *object)
 {
   CcInfoPanelPrivate *priv = CC_INFO_PANEL (object)->priv;
 
+  if (priv->disk_query)
+    {
+      priv->disk_query->self = NULL;
+      g_cancellable_cancel (priv->disk_query->cancellable);
+      priv->disk_query = NULL;
+    }
+
+  if (priv->hardware_query)
+    {
+      priv->hardware_query->self = NULL;
+      g_cancellable_cancel (priv->hardware_query->cancellable);
+      g_clear_pointer (&priv->hardware_query, hardware_query_unref);
+    }
+
+  if (priv->inventory_cancellable)
+    {
+      g_cancellable_cancel (priv->inventory_cancellable);
+      g_clear_object (&priv->inventory_cancellable);
+    }
+  g_clear_pointer (&priv->inventory, cc_info_inventory_free);
+
   g_clear_object (&priv->builder);
-  g_clear_pointer (&priv->graphics_data, graphics_data_free);
   g_clear_pointer (&priv->extra_options_dialog, gtk_widget_destroy);
+  g_clear_pointer (&priv->inventory_dialog, gtk_widget_destroy);
 
   G_OBJECT_CLASS (cc_info_panel_parent_class)->dispose (object);
 }
@@ -396,11 +584,6 @@ cc_info_panel_finalize (GObject *object)
 {
   CcInfoPanelPrivate *priv = CC_INFO_PANEL (object)->priv;
 
-  if (priv->cancellable)
-    {
-      g_cancellable_cancel (priv->cancellable);
-      g_clear_object (&priv->cancellable);
-    }
   g_free (priv->gnome_version);
   g_free (priv->gnome_date);
   g_free (priv->gnome_distributor);
@@ -527,67 +710,306 @@ get_os_type (void)
   return result;
 }
 
+static void
+disk_usage_clear (DiskUsage *disk)
+{
+  g_free (disk->mount_path);
+  g_free (disk->filesystem_id);
+}
+
+static int
+disk_usage_compare (gconstpointer a,
+                    gconstpointer b)
+{
+  const DiskUsage *disk_a = a;
+  const DiskUsage *disk_b = b;
+  gsize len_a, len_b;
+
+  /* Shortest paths first, so that they win over bind mounts */
+  len_a = strlen (disk_a->mount_path);
+  len_b = strlen (disk_b->mount_path);
+  if (len_a != len_b)
+    return len_a < len_b ? -1 : 1;
+
+  return g_strcmp0 (disk_a->mount_path, disk_b->mount_path);
+}
+
+static GArray *
+disk_usage_array_new (void)
+{
+  GArray *disks;
+
+  disks = g_array_new (FALSE, TRUE, sizeof (DiskUsage));
+  g_array_set_clear_func (disks, (GDestroyNotify) disk_usage_clear);
+
+  return disks;
+}
+
+static void
+disk_query_unref (DiskQuery *query)
+{
+  if (--query->ref_count > 0)
+    return;
+
+  g_object_unref (query->cancellable);
+  g_array_unref (query->disks);
+  g_free (query);
+}
+
+static void
+update_disk_label (CcInfoPanel *self,
+                   GArray      *disks)
+{
+  GtkWidget *widget;
+  GString *tooltip;
+  guint64 total_bytes = 0;
+  char *size;
+  guint i;
+
+  tooltip = g_string_new (NULL);
+
+  for (i = 0; i < disks->len; i++)
+    {
+      DiskUsage *disk = &g_array_index (disks, DiskUsage, i);
+      char *disk_size, *disk_used, *disk_free;
+
+      total_bytes += disk->size;
+
+      disk_size = g_format_size (disk->size);
+      disk_used = g_format_size (disk->used);
+      disk_free = g_format_size (disk->free);
+      if (tooltip->len > 0)
+        g_string_append_c (tooltip, '\n');
+      /* translators: This is a mount point, followed by its used space,
+       * its free space and its size, for example:
+       * "/home: 75.2 GB used, 20.1 GB free of 100.0 GB" */
+      g_string_append_printf (tooltip, _("%s: %s used, %s free of %s"),
+                              disk->mount_path, disk_used, disk_free, disk_size);
+      g_free (disk_size);
+      g_free (disk_used);
+      g_free (disk_free);
+    }
+
+  size = g_format_size (total_bytes);
+  widget = WID ("disk_label");
+  gtk_label_set_text (GTK_LABEL (widget), size);
+  gtk_widget_set_tooltip_text (widget, tooltip->len > 0 ? tooltip->str : NULL);
+  g_free (size);
+
+  g_string_free (tooltip, TRUE);
+}
+
+static void
+disk_query_done (DiskQuery *query)
+{
+  GHashTable *seen;
+  GArray *disks;
+  guint i;
+
+  if (g_cancellable_is_cancelled (query->cancellable))
+    return;
+
+  /* Mounts of the same filesystem, such as bind mounts, are only
+   * counted once, under their shortest path */
+  g_array_sort (query->disks, disk_usage_compare);
+
+  disks = disk_usage_array_new ();
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i < query->disks->len; i++)
+    {
+      DiskUsage *disk = &g_array_index (query->disks, DiskUsage, i);
+
+      if (disk->filesystem_id != NULL)
+        {
+          if (g_hash_table_contains (seen, disk->filesystem_id))
+            continue;
+          g_hash_table_add (seen, disk->filesystem_id);
+        }
+
+      g_array_append_val (disks, *disk);
+      disk->mount_path = NULL;
+      disk->filesystem_id = NULL;
+    }
+
+  g_hash_table_destroy (seen);
+
+  g_clear_pointer (&disk_cache, g_array_unref);
+  disk_cache = disks;
+  disk_cache_time = g_get_monotonic_time ();
+
+  if (query->self != NULL)
+    {
+      update_disk_label (query->self, disk_cache);
+      query->self->priv->disk_query = NULL;
+    }
+}
+
+/* Called once per probe, either with the size of the mount,
+ * or without when it failed or took too long */
+static void
+disk_probe_finish (DiskProbe *probe,
+                   GFileInfo *info)
+{
+  DiskQuery *query = probe->query;
+
+  probe->done = TRUE;
+
+  if (probe->timeout_id != 0)
+    {
+      g_source_remove (probe->timeout_id);
+      probe->timeout_id = 0;
+    }
+
+  if (info != NULL)
+    {
+      DiskUsage disk;
+
+      disk.mount_path = g_file_get_path (probe->file);
+      disk.filesystem_id = g_strdup (probe->filesystem_id);
+      disk.size = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+      disk.free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+      if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_USED))
+        disk.used = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_USED);
+      else
+        disk.used = disk.size - MIN (disk.free, disk.size);
+
+      g_array_append_val (query->disks, disk);
+    }
+
+  if (--query->pending == 0)
+    disk_query_done (query);
+}
+
+static void
+disk_probe_free (DiskProbe *probe)
+{
+  disk_query_unref (probe->query);
+  g_object_unref (probe->file);
+  g_free (probe->filesystem_id);
+  g_free (probe);
+}
+
+static gboolean
+disk_probe_timeout (gpointer user_data)
+{
+  DiskProbe *probe = user_data;
+  char *path;
+
+  path = g_file_get_path (probe->file);
+  g_warning ("Timed out getting the size of '%s'", path);
+  g_free (path);
+
+  probe->timeout_id = 0;
+  disk_probe_finish (probe, NULL);
+
+  /* The probe itself is freed once its query returns */
+  return G_SOURCE_REMOVE;
+}
+
 static void
 query_done (GFile        *file,
             GAsyncResult *res,
-            CcInfoPanel  *self)
+            DiskProbe    *probe)
 {
   GFileInfo *info;
   GError *error = NULL;
 
-  self->priv->cancellable = NULL;
   info = g_file_query_filesystem_info_finish (file, res, &error);
+
+  if (!probe->done)
+    {
+      if (info == NULL && !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          char *path;
+          path = g_file_get_path (file);
+          g_warning ("Failed to get filesystem free space for '%s': %s", path, error->message);
+          g_free (path);
+        }
+
+      disk_probe_finish (probe, info);
+    }
+
+  g_clear_object (&info);
+  g_clear_error (&error);
+  disk_probe_free (probe);
+}
+
+static void
+query_id_done (GFile        *file,
+               GAsyncResult *res,
+               DiskProbe    *probe)
+{
+  GFileInfo *info;
+
+  info = g_file_query_info_finish (file, res, NULL);
   if (info != NULL)
     {
-      self->priv->total_bytes += g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+      probe->filesystem_id = g_strdup (g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILESYSTEM));
       g_object_unref (info);
     }
-  else
+
+  if (probe->done)
     {
-      char *path;
-      path = g_file_get_path (file);
-      g_warning ("Failed to get filesystem free space for '%s': %s", path, error->message);
-      g_free (path);
-      g_error_free (error);
+      disk_probe_free (probe);
+      return;
     }
 
-  /* And onto the next element */
-  get_primary_disc_info_start (self);
+  g_file_query_filesystem_info_async (file,
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_SIZE ","
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_FREE ","
+                                      G_FILE_ATTRIBUTE_FILESYSTEM_USED,
+                                      G_PRIORITY_DEFAULT,
+                                      probe->query->cancellable,
+                                      (GAsyncReadyCallback) query_done,
+                                      probe);
 }
 
 static void
-get_primary_disc_info_start (CcInfoPanel *self)
+get_primary_disc_info_start (CcInfoPanel *self,
+                             GList       *mounts)
 {
-  GUnixMountEntry *mount;
-  GFile *file;
+  DiskQuery *query;
+  GList *l;
 
-  if (self->priv->primary_mounts == NULL)
+  if (mounts == NULL)
     {
-      char *size;
-      GtkWidget *widget;
-
-      size = g_format_size (self->priv->total_bytes);
-      widget = WID ("disk_label");
-      gtk_label_set_text (GTK_LABEL (widget), size);
-      g_free (size);
-
+      GArray *disks = disk_usage_array_new ();
+      update_disk_label (self, disks);
+      g_array_unref (disks);
       return;
     }
 
-  mount = self->priv->primary_mounts->data;
-  self->priv->primary_mounts = g_list_remove (self->priv->primary_mounts, mount);
-  file = g_file_new_for_path (g_unix_mount_get_mount_path (mount));
-  g_unix_mount_free (mount);
+  query = g_new0 (DiskQuery, 1);
+  query->ref_count = 1;
+  query->self = self;
+  query->cancellable = g_cancellable_new ();
+  query->disks = disk_usage_array_new ();
+  self->priv->disk_query = query;
 
-  self->priv->cancellable = g_cancellable_new ();
+  /* All the mounts are queried at once, so that a mount that doesn't
+   * answer only delays the figure by DISK_QUERY_TIMEOUT */
+  for (l = mounts; l != NULL; l = l->next)
+    {
+      DiskProbe *probe;
+
+      probe = g_new0 (DiskProbe, 1);
+      probe->query = query;
+      query->ref_count++;
+      query->pending++;
+      probe->file = g_file_new_for_path (l->data);
+      probe->timeout_id = g_timeout_add_seconds (DISK_QUERY_TIMEOUT, disk_probe_timeout, probe);
+
+      g_file_query_info_async (probe->file,
+                               G_FILE_ATTRIBUTE_ID_FILESYSTEM,
+                               G_FILE_QUERY_INFO_NONE,
+                               G_PRIORITY_DEFAULT,
+                               query->cancellable,
+                               (GAsyncReadyCallback) query_id_done,
+                               probe);
+    }
 
-  g_file_query_filesystem_info_async (file,
-                                      G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,
-                                      0,
-                                      self->priv->cancellable,
-                                      (GAsyncReadyCallback) query_done,
-                                      self);
-  g_object_unref (file);
+  disk_query_unref (query);
 }
 
 static void
@@ -595,6 +1017,14 @@ get_primary_disc_info (CcInfoPanel *self)
 {
   GList        *points;
   GList        *p;
+  GList        *mounts = NULL;
+
+  if (disk_cache != NULL &&
+      g_get_monotonic_time () - disk_cache_time < DISK_CACHE_TIMEOUT * G_USEC_PER_SEC)
+    {
+      update_disk_label (self, disk_cache);
+      return;
+    }
 
   points = g_unix_mount_points_get (NULL);
 
@@ -609,20 +1039,18 @@ get_primary_disc_info (CcInfoPanel *self)
 
       mount_path = g_unix_mount_get_mount_path (mount);
 
-      if (gsd_should_ignore_unix_mount (mount) ||
-          gsd_is_removable_mount (mount) ||
-          g_str_has_prefix (mount_path, "/media/") ||
-          g_str_has_prefix (mount_path, g_get_home_dir ()))
-        {
-          g_unix_mount_free (mount);
-          continue;
-        }
+      if (!gsd_should_ignore_unix_mount (mount) &&
+          !gsd_is_removable_mount (mount) &&
+          !g_str_has_prefix (mount_path, "/media/") &&
+          !g_str_has_prefix (mount_path, g_get_home_dir ()))
+        mounts = g_list_prepend (mounts, g_strdup (mount_path));
 
-      self->priv->primary_mounts = g_list_prepend (self->priv->primary_mounts, mount);
+      g_unix_mount_free (mount);
     }
   g_list_free (points);
 
-  get_primary_disc_info_start (self);
+  get_primary_disc_info_start (self, mounts);
+  g_list_free_full (mounts, g_free);
 }
 
 static char *
@@ -782,56 +1210,117 @@ set_virtualization_label (CcInfoPanel  *self,
 }
 
 static void
-info_panel_setup_virt (CcInfoPanel  *self)
+virt_property_done (GDBusConnection *connection,
+                    GAsyncResult    *res,
+                    HardwareQuery   *query)
 {
   GError *error = NULL;
-  GDBusProxy *systemd_proxy;
   GVariant *variant;
   GVariant *inner;
-  char *str;
-
-  str = NULL;
+  char *str = NULL;
 
-  systemd_proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SYSTEM,
-                                                 G_DBUS_PROXY_FLAGS_NONE,
-                                                 NULL,
-                                                 "org.freedesktop.systemd1",
-                                                 "/org/freedesktop/systemd1",
-                                                 "org.freedesktop.systemd1",
-                                                 NULL,
-                                                 &error);
-
-  if (systemd_proxy == NULL)
+  variant = g_dbus_connection_call_finish (connection, res, &error);
+  if (variant == NULL)
     {
-      g_debug ("systemd not available, bailing: %s", error->message);
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_error_free (error);
+          goto out;
+        }
+      g_debug ("Failed to get property '%s': %s", "Virtualization", error->message);
       g_error_free (error);
-      goto bail;
+    }
+  else
+    {
+      g_variant_get (variant, "(v)", &inner);
+      str = g_variant_dup_string (inner, NULL);
+      g_variant_unref (inner);
+      g_variant_unref (variant);
     }
 
-  variant = g_dbus_proxy_call_sync (systemd_proxy,
-                                    "org.freedesktop.DBus.Properties.Get",
-                                    g_variant_new ("(ss)", "org.freedesktop.systemd1.Manager", "Virtualization"),
-                                    G_DBUS_CALL_FLAGS_NONE,
-                                    -1,
-                                    NULL,
-                                    &error);
-  if (variant == NULL)
+  g_free (virt_cache);
+  virt_cache = str;
+  virt_cache_valid = TRUE;
+
+  if (query->self != NULL)
+    set_virtualization_label (query->self, virt_cache);
+
+out:
+  hardware_query_unref (query);
+}
+
+static void
+system_bus_ready (GObject       *source,
+                  GAsyncResult  *res,
+                  HardwareQuery *query)
+{
+  GError *error = NULL;
+  GDBusConnection *connection;
+
+  connection = g_bus_get_finish (res, &error);
+  if (connection == NULL)
     {
-      g_debug ("Failed to get property '%s': %s", "Virtualization", error->message);
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_debug ("systemd not available, bailing: %s", error->message);
+          virt_cache_valid = TRUE;
+          if (query->self != NULL)
+            set_virtualization_label (query->self, NULL);
+        }
       g_error_free (error);
-      g_object_unref (systemd_proxy);
-      goto bail;
+      hardware_query_unref (query);
+      return;
     }
 
-  g_variant_get (variant, "(v)", &inner);
-  str = g_variant_dup_string (inner, NULL);
-  g_variant_unref (variant);
+  g_dbus_connection_call (connection,
+                          "org.freedesktop.systemd1",
+                          "/org/freedesktop/systemd1",
+                          "org.freedesktop.DBus.Properties",
+                          "Get",
+                          g_variant_new ("(ss)", "org.freedesktop.systemd1.Manager", "Virtualization"),
+                          G_VARIANT_TYPE ("(v)"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          query->cancellable,
+                          (GAsyncReadyCallback) virt_property_done,
+                          query);
+  g_object_unref (connection);
+}
+
+static void
+info_panel_setup_hardware (CcInfoPanel  *self)
+{
+  HardwareQuery *query;
+
+  if (graphics_cache != NULL)
+    gtk_label_set_markup (GTK_LABEL (WID ("graphics_label")), graphics_cache);
+  if (virt_cache_valid)
+    set_virtualization_label (self, virt_cache);
 
-  g_object_unref (systemd_proxy);
+  if (graphics_cache != NULL && virt_cache_valid)
+    return;
 
-bail:
-  set_virtualization_label (self, str);
-  g_free (str);
+  query = g_new0 (HardwareQuery, 1);
+  query->ref_count = 1;
+  query->self = self;
+  query->cancellable = g_cancellable_new ();
+  self->priv->hardware_query = query;
+
+  /* The labels are filled in as the answers come back, so that
+   * a slow service or GL helper doesn't hold up the panel */
+  if (graphics_cache == NULL)
+    {
+      gtk_label_set_text (GTK_LABEL (WID ("graphics_label")), "");
+      get_graphics_data (query);
+    }
+
+  if (!virt_cache_valid)
+    {
+      gtk_label_set_text (GTK_LABEL (WID ("virt_type_label")), "");
+      query->ref_count++;
+      g_bus_get (G_BUS_TYPE_SYSTEM, query->cancellable,
+                 (GAsyncReadyCallback) system_bus_ready, query);
+    }
 }
 
 static void
@@ -1515,9 +2004,6 @@ info_panel_setup_overview (CcInfoPanel  *self)
 
   get_primary_disc_info (self);
 
-  widget = WID ("graphics_label");
-  gtk_label_set_markup (GTK_LABEL (widget), self->priv->graphics_data->hardware_string);
-
   widget = WID ("info_vbox");
   gtk_container_add (GTK_CONTAINER (self), widget);
 }
@@ -1561,6 +2047,253 @@ on_updates_button_clicked (GtkWidget   *widget,
   g_strfreev (argv);
 }
 
+static GtkTreeIter
+inventory_add_section (GtkTreeStore *store,
+                       const char   *name)
+{
+  GtkTreeIter iter;
+
+  gtk_tree_store_insert_with_values (store, &iter, NULL, -1,
+                                     INVENTORY_NAME_COLUMN, name,
+                                     -1);
+  return iter;
+}
+
+static void
+inventory_add_row (GtkTreeStore *store,
+                   GtkTreeIter  *section,
+                   const char   *name,
+                   const char   *value)
+{
+  gtk_tree_store_insert_with_values (store, NULL, section, -1,
+                                     INVENTORY_NAME_COLUMN, name,
+                                     INVENTORY_VALUE_COLUMN, value,
+                                     -1);
+}
+
+static void
+inventory_fill_store (GtkTreeStore    *store,
+                      CcInfoInventory *inventory)
+{
+  GtkTreeIter section;
+  char *name, *value, *size;
+  guint i;
+
+  gtk_tree_store_clear (store);
+
+  section = inventory_add_section (store, _("Processors"));
+  for (i = 0; i < inventory->cpus->len; i++)
+    {
+      CcInfoCpu *cpu = &g_array_index (inventory->cpus, CcInfoCpu, i);
+      const char *model;
+      gboolean has_topology, has_freq;
+
+      model = cpu->model ? cpu->model : _("Unknown");
+      has_topology = cpu->package_id >= 0 && cpu->core_id >= 0;
+      has_freq = cpu->cur_freq_khz > 0;
+
+      if (has_topology && has_freq)
+        /* translators: A processor model, the physical processor and core
+         * it belongs to, and its current frequency, for example:
+         * "Intel(R) Core(TM) i7-8550U CPU @ 1.80GHz, package 0, core 3, 2.10 GHz" */
+        value = g_strdup_printf (_("%s, package %d, core %d, %.2f GHz"),
+                                 model, cpu->package_id, cpu->core_id,
+                                 cpu->cur_freq_khz / 1000000.0);
+      else if (has_topology)
+        /* translators: A processor model, and the physical processor and
+         * core it belongs to, for example:
+         * "Intel(R) Core(TM) i7-8550U CPU @ 1.80GHz, package 0, core 3" */
+        value = g_strdup_printf (_("%s, package %d, core %d"),
+                                 model, cpu->package_id, cpu->core_id);
+      else if (has_freq)
+        /* translators: A processor model and its current frequency, for example:
+         * "Intel(R) Core(TM) i7-8550U CPU @ 1.80GHz, 2.10 GHz" */
+        value = g_strdup_printf (_("%s, %.2f GHz"),
+                                 model, cpu->cur_freq_khz / 1000000.0);
+      else
+        value = g_strdup (model);
+
+      name = g_strdup_printf (_("CPU %u"), cpu->index);
+      inventory_add_row (store, &section, name, value);
+      g_free (name);
+      g_free (value);
+    }
+
+  section = inventory_add_section (store, _("Caches"));
+  for (i = 0; i < inventory->caches->len; i++)
+    {
+      CcInfoCache *cache = &g_array_index (inventory->caches, CcInfoCache, i);
+
+      /* translators: A processor cache, for example "L1 Data" */
+      name = g_strdup_printf (_("L%u %s"), cache->level, cache->type ? cache->type : "");
+      size = g_format_size_full (cache->size, G_FORMAT_SIZE_IEC_UNITS);
+      /* translators: The size of a processor cache, and the processors sharing it */
+      value = g_strdup_printf (_("%s, CPUs %s"), size, cache->shared_cpus ? cache->shared_cpus : "");
+      inventory_add_row (store, &section, name, value);
+      g_free (name);
+      g_free (size);
+      g_free (value);
+    }
+
+  if (inventory->numa_nodes->len > 0)
+    {
+      section = inventory_add_section (store, _("NUMA Nodes"));
+      for (i = 0; i < inventory->numa_nodes->len; i++)
+        {
+          CcInfoNumaNode *node = &g_array_index (inventory->numa_nodes, CcInfoNumaNode, i);
+
+          name = g_strdup_printf (_("Node %u"), node->id);
+          size = g_format_size_full (node->memory, G_FORMAT_SIZE_IEC_UNITS);
+          /* translators: The processors and the memory of a NUMA node */
+          value = g_strdup_printf (_("CPUs %s, %s"), node->cpus ? node->cpus : "", size);
+          inventory_add_row (store, &section, name, value);
+          g_free (name);
+          g_free (size);
+          g_free (value);
+        }
+    }
+
+  section = inventory_add_section (store, _("Memory"));
+  size = g_format_size_full (inventory->memory_total, G_FORMAT_SIZE_IEC_UNITS);
+  inventory_add_row (store, &section, _("Total"), size);
+  g_free (size);
+  for (i = 0; i < inventory->dimms->len; i++)
+    {
+      CcInfoDimm *dimm = &g_array_index (inventory->dimms, CcInfoDimm, i);
+
+      size = g_format_size_full (dimm->size, G_FORMAT_SIZE_IEC_UNITS);
+      if (dimm->type != NULL)
+        value = g_strdup_printf ("%s %s", size, dimm->type);
+      else
+        value = g_strdup (size);
+      inventory_add_row (store, &section, dimm->label ? dimm->label : _("Unknown"), value);
+      g_free (size);
+      g_free (value);
+    }
+
+  section = inventory_add_section (store, _("PCI Devices"));
+  for (i = 0; i < inventory->pci_devices->len; i++)
+    {
+      CcInfoPciDevice *device = &g_array_index (inventory->pci_devices, CcInfoPciDevice, i);
+
+      /* translators: The vendor and device IDs of a PCI device, its class, and its driver */
+      value = g_strdup_printf (_("%04x:%04x, class %06x, %s"),
+                               device->vendor_id, device->device_id, device->class_id,
+                               device->driver ? device->driver : _("no driver"));
+      inventory_add_row (store, &section, device->address, value);
+      g_free (value);
+    }
+}
+
+static void
+inventory_collected (GObject      *source,
+                     GAsyncResult *res,
+                     CcInfoPanel  *self)
+{
+  CcInfoInventory *inventory;
+  GError *error = NULL;
+
+  inventory = cc_info_inventory_collect_finish (res, &error);
+  if (inventory == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Failed to collect the hardware details: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  g_clear_object (&self->priv->inventory_cancellable);
+  g_clear_pointer (&self->priv->inventory, cc_info_inventory_free);
+  self->priv->inventory = inventory;
+
+  inventory_fill_store (self->priv->inventory_store, inventory);
+  gtk_tree_view_expand_all (GTK_TREE_VIEW (WID ("inventory_treeview")));
+  gtk_dialog_set_response_sensitive (GTK_DIALOG (self->priv->inventory_dialog),
+                                     INVENTORY_RESPONSE_COPY, TRUE);
+}
+
+static void
+on_inventory_dialog_response (GtkWidget   *dialog,
+                              int          response,
+                              CcInfoPanel *self)
+{
+  char *json;
+
+  if (response != INVENTORY_RESPONSE_COPY)
+    {
+      gtk_widget_hide (dialog);
+      return;
+    }
+
+  if (self->priv->inventory == NULL)
+    return;
+
+  json = cc_info_inventory_to_json (self->priv->inventory);
+  gtk_clipboard_set_text (gtk_widget_get_clipboard (dialog, GDK_SELECTION_CLIPBOARD),
+                          json, -1);
+  g_free (json);
+}
+
+static void
+on_inventory_button_clicked (GtkWidget   *button,
+                             CcInfoPanel *self)
+{
+  GtkWidget *dialog;
+
+  dialog = self->priv->inventory_dialog;
+  gtk_window_set_transient_for (GTK_WINDOW (dialog),
+                                GTK_WINDOW (gtk_widget_get_toplevel (GTK_WIDGET (self))));
+
+  /* The frequencies change, so the details are collected
+   * again every time the dialog is opened */
+  if (self->priv->inventory_cancellable == NULL)
+    {
+      gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog), INVENTORY_RESPONSE_COPY,
+                                         self->priv->inventory != NULL);
+      self->priv->inventory_cancellable = g_cancellable_new ();
+      cc_info_inventory_collect_async (self->priv->inventory_cancellable,
+                                       (GAsyncReadyCallback) inventory_collected,
+                                       self);
+    }
+
+  gtk_window_present (GTK_WINDOW (dialog));
+}
+
+static void
+info_panel_setup_inventory (CcInfoPanel *self)
+{
+  GtkTreeView *view;
+  GtkCellRenderer *renderer;
+
+  self->priv->inventory_dialog = WID ("inventory_dialog");
+  gtk_dialog_add_button (GTK_DIALOG (self->priv->inventory_dialog),
+                         _("_Copy as JSON"), INVENTORY_RESPONSE_COPY);
+  g_signal_connect (self->priv->inventory_dialog, "response",
+                    G_CALLBACK (on_inventory_dialog_response), self);
+  g_signal_connect (self->priv->inventory_dialog, "delete-event",
+                    G_CALLBACK (gtk_widget_hide_on_delete), NULL);
+
+  self->priv->inventory_store = gtk_tree_store_new (INVENTORY_N_COLUMNS,
+                                                    G_TYPE_STRING,
+                                                    G_TYPE_STRING);
+  view = GTK_TREE_VIEW (WID ("inventory_treeview"));
+  gtk_tree_view_set_model (view, GTK_TREE_MODEL (self->priv->inventory_store));
+  g_object_unref (self->priv->inventory_store);
+
+  renderer = gtk_cell_renderer_text_new ();
+  gtk_tree_view_insert_column_with_attributes (view, -1, NULL, renderer,
+                                               "text", INVENTORY_NAME_COLUMN,
+                                               NULL);
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+  gtk_tree_view_insert_column_with_attributes (view, -1, NULL, renderer,
+                                               "text", INVENTORY_VALUE_COLUMN,
+                                               NULL);
+
+  g_signal_connect (WID ("inventory_button"), "clicked",
+                    G_CALLBACK (on_inventory_button_clicked), self);
+}
+
 static void
 cc_info_panel_init (CcInfoPanel *self)
 {
@@ -1585,8 +2318,6 @@ cc_info_panel_init (CcInfoPanel *self)
 
   self->priv->extra_options_dialog = WID ("extra_options_dialog");
 
-  self->priv->graphics_data = get_graphics_data ();
-
   widget = WID ("updates_button");
   if (does_gnome_software_exist () || does_gpk_update_viewer_exist ())
     {
@@ -1601,5 +2332,6 @@ cc_info_panel_init (CcInfoPanel *self)
   info_panel_setup_overview (self);
   info_panel_setup_default_apps (self);
   info_panel_setup_media (self);
-  info_panel_setup_virt (self);
+  info_panel_setup_hardware (self);
+  info_panel_setup_inventory (self);
 }
@@ -21,121 +21,147 @@
 #include <config.h>
 
 #include <glib.h>
+#include <gio/gio.h>
 #include "info-cleanup.h"
 
+#define RULES_RESOURCE "/org/gnome/control-center/info/info-cleanup-rules.txt"
+
 typedef struct
 {
-  char *regex;
-  char *replacement;
-} ReplaceStrings;
-
-static char *
-prettify_info (const char *info)
+  GRegex *regex;
+  char   *replacement;
+} CleanupRule;
+
+static gboolean
+add_rule (GArray     *rules,
+          const char *pattern,
+          const char *replacement,
+          guint       compile_flags)
 {
-  char *pretty;
-  int   i;
-  static const ReplaceStrings rs[] = {
-    { "Mesa DRI ", ""},
-    { "Intel[(]R[)]", "Intel<sup>\302\256</sup>"},
-    { "Core[(]TM[)]", "Core<sup>\342\204\242</sup>"},
-    { "Atom[(]TM[)]", "Atom<sup>\342\204\242</sup>"},
-    { "Gallium .* on (AMD .*)", "\\1"},
-    { "(AMD .*) [(].*", "\\1"},
-    { "(AMD [A-Z])(.*)", "\\1\\L\\2\\E"},
-    { "AMD", "AMD<sup>\302\256</sup>"},
-    { "Graphics Controller", "Graphics"},
-  };
-
-  if (*info == '\0')
-    return NULL;
-
-  pretty = g_markup_escape_text (info, -1);
-  pretty = g_strchug (g_strchomp (pretty));
+  CleanupRule rule;
+  GError *error = NULL;
 
-  for (i = 0; i < G_N_ELEMENTS (rs); i++)
+  rule.regex = g_regex_new (pattern, compile_flags | G_REGEX_OPTIMIZE, 0, &error);
+  if (rule.regex == NULL)
     {
-      GError *error;
-      GRegex *re;
-      char   *new;
-
-      error = NULL;
-
-      re = g_regex_new (rs[i].regex, 0, 0, &error);
-      if (re == NULL)
-        {
-          g_warning ("Error building regex: %s", error->message);
-          g_error_free (error);
-          continue;
-        }
-
-      new = g_regex_replace (re,
-                             pretty,
-                             -1,
-                             0,
-                             rs[i].replacement,
-                             0,
-                             &error);
-
-      g_regex_unref (re);
-
-      if (error != NULL)
-        {
-          g_warning ("Error replacing %s: %s", rs[i].regex, error->message);
-          g_error_free (error);
-          continue;
-        }
+      g_warning ("Error building regex: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
 
-      g_free (pretty);
-      pretty = new;
+  if (!g_regex_check_replacement (replacement, NULL, &error))
+    {
+      g_warning ("Error in the replacement for %s: %s", pattern, error->message);
+      g_error_free (error);
+      g_regex_unref (rule.regex);
+      return FALSE;
     }
 
-  return pretty;
+  rule.replacement = g_strdup (replacement);
+  g_array_append_val (rules, rule);
+
+  return TRUE;
 }
 
-static char *
-remove_duplicate_whitespace (const char *old)
+/* The rules are compiled the first time a string is cleaned up,
+ * and kept until the process exits */
+static GArray *
+load_rules (void)
 {
-  char   *new;
-  GRegex *re;
-  GError *error;
+  GArray *rules;
+  GBytes *bytes;
+  GError *error = NULL;
+  char **lines;
+  guint i;
 
-  if (old == NULL)
-    return NULL;
+  rules = g_array_new (FALSE, FALSE, sizeof (CleanupRule));
 
-  error = NULL;
-  re = g_regex_new ("[ \t\n\r]+", G_REGEX_MULTILINE, 0, &error);
-  if (re == NULL)
+  bytes = g_resources_lookup_data (RULES_RESOURCE, G_RESOURCE_LOOKUP_FLAGS_NONE, &error);
+  if (bytes == NULL)
     {
-      g_warning ("Error building regex: %s", error->message);
+      g_warning ("Failed to load the cleanup rules: %s", error->message);
       g_error_free (error);
-      return g_strdup (old);
+      goto out;
     }
-  new = g_regex_replace (re,
-                         old,
-                         -1,
-                         0,
-                         " ",
-                         0,
-                         &error);
-  g_regex_unref (re);
-  if (new == NULL)
+
+  /* Resource data is always nul-terminated */
+  lines = g_strsplit (g_bytes_get_data (bytes, NULL), "\n", -1);
+  g_bytes_unref (bytes);
+
+  for (i = 0; lines[i] != NULL; i++)
     {
-      g_warning ("Error replacing string: %s", error->message);
-      g_error_free (error);
-      return g_strdup (old);
+      char **items;
+
+      if (*lines[i] == '#' || *lines[i] == '\0')
+        continue;
+
+      items = g_strsplit (lines[i], "\t", 2);
+      if (items[1] == NULL)
+        g_warning ("Invalid cleanup rule on line %u: '%s'", i + 1, lines[i]);
+      else
+        add_rule (rules, items[0], items[1], 0);
+      g_strfreev (items);
     }
 
-  return new;
+  g_strfreev (lines);
+
+out:
+  /* Always run last, to tidy up after the other rules */
+  add_rule (rules, "[ \t\n\r]+", " ", G_REGEX_MULTILINE);
+
+  return rules;
+}
+
+static GArray *
+get_rules (void)
+{
+  static GArray *rules = NULL;
+
+  if (g_once_init_enter (&rules))
+    g_once_init_leave (&rules, load_rules ());
+
+  return rules;
 }
 
 char *
 info_cleanup (const char *input)
 {
-  char *pretty, *ret;
+  GArray *rules;
+  char   *pretty;
+  guint   i;
+
+  if (*input == '\0')
+    return NULL;
+
+  rules = get_rules ();
+
+  pretty = g_markup_escape_text (input, -1);
+  pretty = g_strchug (g_strchomp (pretty));
 
-  pretty = prettify_info (input);
-  ret = remove_duplicate_whitespace (pretty);
-  g_free (pretty);
+  for (i = 0; i < rules->len; i++)
+    {
+      CleanupRule *rule = &g_array_index (rules, CleanupRule, i);
+      GError *error = NULL;
+      char   *new;
 
-  return ret;
+      new = g_regex_replace (rule->regex,
+                             pretty,
+                             -1,
+                             0,
+                             rule->replacement,
+                             0,
+                             &error);
+      if (new == NULL)
+        {
+          g_warning ("Error replacing %s: %s",
+                     g_regex_get_pattern (rule->regex), error->message);
+          g_error_free (error);
+          continue;
+        }
+
+      g_free (pretty);
+      pretty = new;
+    }
+
+  return pretty;
 }
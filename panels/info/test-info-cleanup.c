@@ -22,29 +22,48 @@
 
 #include <glib.h>
 #include <locale.h>
+#include <string.h>
 #include "info-cleanup.h"
+#include "cc-info-resources.h"
 
-static void
-test_info (void)
+/* Number of times the corpus is cleaned up in the benchmark */
+#define N_PASSES 2000
+
+static char **
+load_test_lines (void)
 {
 	char *contents;
-	char *result;
-	guint i;
 	char **lines;
 
 	if (g_file_get_contents (TEST_SRCDIR "/info-cleanup-test.txt", &contents, NULL, NULL) == FALSE) {
 		g_warning ("Failed to load '%s'", TEST_SRCDIR "/info-cleanup-test.txt");
 		g_test_fail ();
-		return;
+		return NULL;
 	}
 
 	lines = g_strsplit (contents, "\n", -1);
-	if (lines == NULL) {
+	g_free (contents);
+	if (lines == NULL || lines[0] == NULL) {
 		g_warning ("Test file is empty");
 		g_test_fail ();
-		return;
+		g_strfreev (lines);
+		return NULL;
 	}
 
+	return lines;
+}
+
+static void
+test_info (void)
+{
+	char *result;
+	guint i;
+	char **lines;
+
+	lines = load_test_lines ();
+	if (lines == NULL)
+		return;
+
 	for (i = 0; lines[i] != NULL; i++) {
 		char *utf8;
 		char **items;
@@ -72,7 +91,48 @@ test_info (void)
 	}
 
 	g_strfreev (lines);
-	g_free (contents);
+}
+
+static void
+test_info_perf (void)
+{
+	GPtrArray *corpus;
+	GTimer *timer;
+	gdouble elapsed;
+	char **lines;
+	guint i, j;
+
+	lines = load_test_lines ();
+	if (lines == NULL)
+		return;
+
+	/* The inputs of the test file are real processor and renderer names */
+	corpus = g_ptr_array_new_with_free_func (g_free);
+	for (i = 0; lines[i] != NULL; i++) {
+		if (*lines[i] == '#')
+			continue;
+		if (*lines[i] == '\0')
+			break;
+		g_ptr_array_add (corpus, g_strndup (lines[i], strcspn (lines[i], "\t")));
+	}
+	g_strfreev (lines);
+
+	/* Don't count building the rules */
+	g_free (info_cleanup ("warm up"));
+
+	timer = g_timer_new ();
+	for (i = 0; i < N_PASSES; i++) {
+		for (j = 0; j < corpus->len; j++)
+			g_free (info_cleanup (g_ptr_array_index (corpus, j)));
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_test_maximized_result (N_PASSES * corpus->len / elapsed,
+				 "cleaned up %.0f strings per second",
+				 N_PASSES * corpus->len / elapsed);
+
+	g_ptr_array_unref (corpus);
 }
 
 int main (int argc, char **argv)
@@ -82,7 +142,11 @@ int main (int argc, char **argv)
 
 	g_setenv ("G_DEBUG", "fatal_warnings", FALSE);
 
+	g_resources_register (cc_info_get_resource ());
+
 	g_test_add_func ("/info/info", test_info);
+	if (g_test_perf ())
+		g_test_add_func ("/info/perf", test_info_perf);
 
 	return g_test_run ();
 }
@@ -44,6 +44,11 @@ struct _CcKeyboardManager
   GHashTable         *kb_apps_sections;
   GHashTable         *kb_user_sections;
 
+  /* BindingKey → GPtrArray of items using that key */
+  GHashTable         *bindings_index;
+  /* CcKeyboardItem → its BindingKey, or NULL when disabled */
+  GHashTable         *indexed_items;
+
   GSettings          *binding_settings;
 
   gpointer            wm_changed_id;
@@ -61,6 +66,54 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0, };
 
+/*
+ * Key of the bindings index. Shortcuts with a keyval are matched on the
+ * keyval alone, and only keyval-less ones on their keycode, which is what
+ * is_shortcut_different() considers a match.
+ */
+typedef struct
+{
+  guint           keyval;
+  guint           keycode;
+  GdkModifierType mask;
+} BindingKey;
+
+static gboolean
+binding_key_init (BindingKey      *key,
+                  guint            keyval,
+                  GdkModifierType  mask,
+                  guint            keycode)
+{
+  if (keyval == 0 && keycode == 0)
+    return FALSE;
+
+  key->keyval = keyval;
+  key->keycode = keyval != 0 ? 0 : keycode;
+  key->mask = mask;
+
+  return TRUE;
+}
+
+static guint
+binding_key_hash (gconstpointer v)
+{
+  const BindingKey *key = v;
+
+  return (key->keyval * 31 + key->keycode) * 31 + key->mask;
+}
+
+static gboolean
+binding_key_equal (gconstpointer a,
+                   gconstpointer b)
+{
+  const BindingKey *key_a = a;
+  const BindingKey *key_b = b;
+
+  return key_a->keyval == key_b->keyval &&
+         key_a->keycode == key_b->keycode &&
+         key_a->mask == key_b->mask;
+}
+
 /*
  * Auxiliary methos
  */
@@ -148,26 +201,113 @@ compare_keys_for_uniqueness (CcKeyboardItem   *current_item,
   return TRUE;
 }
 
-static gboolean
-check_for_uniqueness (gpointer          key,
-                      GPtrArray        *keys_array,
-                      CcUniquenessData *data)
+static void
+unindex_item (CcKeyboardManager *self,
+              CcKeyboardItem    *item)
 {
-  guint i;
+  BindingKey *key;
+  GPtrArray *items;
+
+  key = g_hash_table_lookup (self->indexed_items, item);
+  if (!key)
+    return;
 
-  for (i = 0; i < keys_array->len; i++)
+  items = g_hash_table_lookup (self->bindings_index, key);
+  if (items)
     {
-      CcKeyboardItem *item;
+      g_ptr_array_remove_fast (items, item);
 
-      item = keys_array->pdata[i];
+      if (items->len == 0)
+        g_hash_table_remove (self->bindings_index, key);
+    }
 
-      if (compare_keys_for_uniqueness (item, data))
-        return TRUE;
+  g_hash_table_insert (self->indexed_items, item, NULL);
+}
+
+static void
+index_item (CcKeyboardManager *self,
+            CcKeyboardItem    *item)
+{
+  BindingKey key;
+  BindingKey *stored_key;
+  GPtrArray *items;
+
+  unindex_item (self, item);
+
+  /* Disabled shortcuts never collide */
+  if (!binding_key_init (&key, item->keyval, item->mask, item->keycode))
+    return;
+
+  items = g_hash_table_lookup (self->bindings_index, &key);
+  if (!items)
+    {
+      stored_key = g_memdup (&key, sizeof (BindingKey));
+      items = g_ptr_array_new ();
+      g_hash_table_insert (self->bindings_index, stored_key, items);
+    }
+  else
+    {
+      g_hash_table_lookup_extended (self->bindings_index, &key, (gpointer*) &stored_key, NULL);
     }
 
-  return FALSE;
+  g_ptr_array_add (items, item);
+  g_hash_table_insert (self->indexed_items, item, stored_key);
+}
+
+static void
+item_binding_changed_cb (CcKeyboardItem    *item,
+                         GParamSpec        *pspec,
+                         CcKeyboardManager *self)
+{
+  CcKeyboardItem *reverse_item;
+
+  index_item (self, item);
+
+  /* Setting a binding also rewrites the reverse binding */
+  reverse_item = cc_keyboard_item_get_reverse_item (item);
+  if (reverse_item && g_hash_table_contains (self->indexed_items, reverse_item))
+    index_item (self, reverse_item);
+}
+
+static void
+track_item (CcKeyboardManager *self,
+            CcKeyboardItem    *item)
+{
+  g_hash_table_insert (self->indexed_items, item, NULL);
+  index_item (self, item);
+
+  g_signal_connect (item,
+                    "notify::binding",
+                    G_CALLBACK (item_binding_changed_cb),
+                    self);
 }
 
+static void
+untrack_item (CcKeyboardManager *self,
+              CcKeyboardItem    *item)
+{
+  g_signal_handlers_disconnect_by_func (item, item_binding_changed_cb, self);
+
+  unindex_item (self, item);
+  g_hash_table_remove (self->indexed_items, item);
+}
+
+static void
+clear_bindings_index (CcKeyboardManager *self)
+{
+  GHashTableIter iter;
+  gpointer item;
+
+  if (!self->indexed_items)
+    return;
+
+  g_hash_table_iter_init (&iter, self->indexed_items);
+  while (g_hash_table_iter_next (&iter, &item, NULL))
+    g_signal_handlers_disconnect_by_func (item, item_binding_changed_cb, self);
+
+  g_hash_table_remove_all (self->indexed_items);
+  g_hash_table_remove_all (self->bindings_index);
+}
 
 static GHashTable*
 get_hash_for_group (CcKeyboardManager *self,
@@ -376,6 +516,7 @@ append_section (CcKeyboardManager  *self,
       item->group = group;
 
       g_ptr_array_add (keys_array, item);
+      track_item (self, item);
     }
 
   g_hash_table_destroy (reverse_items);
@@ -542,6 +683,8 @@ reload_sections (CcKeyboardManager *self)
   gtk_list_store_clear (GTK_LIST_STORE (self->sections_store));
   gtk_list_store_clear (GTK_LIST_STORE (shortcut_model));
 
+  clear_bindings_index (self);
+
   g_clear_pointer (&self->kb_system_sections, g_hash_table_destroy);
   self->kb_system_sections = g_hash_table_new_full (g_str_hash,
                                                     g_str_equal,
@@ -630,6 +773,10 @@ cc_keyboard_manager_finalize (GObject *object)
 {
   CcKeyboardManager *self = (CcKeyboardManager *)object;
 
+  clear_bindings_index (self);
+  g_clear_pointer (&self->indexed_items, g_hash_table_destroy);
+  g_clear_pointer (&self->bindings_index, g_hash_table_destroy);
+
   g_clear_pointer (&self->kb_system_sections, g_hash_table_destroy);
   g_clear_pointer (&self->kb_apps_sections, g_hash_table_destroy);
   g_clear_pointer (&self->kb_user_sections, g_hash_table_destroy);
@@ -716,6 +863,12 @@ cc_keyboard_manager_init (CcKeyboardManager *self)
   /* Bindings */
   self->binding_settings = g_settings_new (BINDINGS_SCHEMA);
 
+  self->bindings_index = g_hash_table_new_full (binding_key_hash,
+                                                binding_key_equal,
+                                                g_free,
+                                                (GDestroyNotify) g_ptr_array_unref);
+  self->indexed_items = g_hash_table_new (g_direct_hash, g_direct_equal);
+
   /* Setup the section models */
   self->sections_store = gtk_list_store_new (SECTION_N_COLUMNS,
                                              G_TYPE_STRING,
@@ -808,6 +961,7 @@ cc_keyboard_manager_add_custom_shortcut (CcKeyboardManager *self,
     }
 
   g_ptr_array_add (keys_array, item);
+  track_item (self, item);
 
   gtk_list_store_append (self->shortcuts_model, &iter);
   gtk_list_store_set (self->shortcuts_model, &iter, DETAIL_KEYENTRY_COLUMN, item, -1);
@@ -893,6 +1047,8 @@ cc_keyboard_manager_remove_custom_shortcut  (CcKeyboardManager *self,
 
   g_strfreev (settings_paths);
 
+  untrack_item (self, item);
+
   keys_array = g_hash_table_lookup (get_hash_for_group (self, BINDING_GROUP_USER), CUSTOM_SHORTCUTS_ID);
   g_ptr_array_remove (keys_array, item);
 
@@ -921,33 +1077,98 @@ cc_keyboard_manager_get_collision (CcKeyboardManager *self,
                                    gint               keycode)
 {
   CcUniquenessData data;
-  BindingGroupType i;
+  CcKeyboardItem *collision;
+  BindingKey key;
+  GPtrArray *items;
+  guint i;
 
   g_return_val_if_fail (CC_IS_KEYBOARD_MANAGER (self), NULL);
 
+  /* Any number of shortcuts can be disabled */
+  if (!binding_key_init (&key, keyval, mask, keycode))
+    return NULL;
+
+  items = g_hash_table_lookup (self->bindings_index, &key);
+  if (!items)
+    return NULL;
+
   data.orig_item = item;
   data.new_keyval = keyval;
   data.new_mask = mask;
   data.new_keycode = keycode;
-  data.conflict_item = NULL;
 
-  if (keyval == 0 && keycode == 0)
-    return NULL;
-
-  /* Any number of shortcuts can be disabled */
-  for (i = BINDING_GROUP_SYSTEM; i <= BINDING_GROUP_USER && !data.conflict_item; i++)
+  /* Candidates share the key, but still have to pass the usual checks
+   * for reverse and hidden items. Prefer system over app over user
+   * shortcuts, as the conflicting item reported to the user. */
+  collision = NULL;
+  for (i = 0; i < items->len; i++)
     {
-      GHashTable *table;
+      CcKeyboardItem *candidate = g_ptr_array_index (items, i);
+
+      if (collision && collision->group <= candidate->group)
+        continue;
+
+      data.conflict_item = NULL;
+      if (compare_keys_for_uniqueness (candidate, &data))
+        collision = data.conflict_item;
+    }
+
+  return collision;
+}
+
+/**
+ * cc_keyboard_manager_find_conflicts:
+ * @self: a #CcKeyboardManager
+ *
+ * Finds every set of system, application and custom shortcuts that
+ * share the same key combination.
+ *
+ * Returns: (transfer full)(element-type GPtrArray): a list of
+ * #GPtrArray, each holding the #CcKeyboardItem<!-- -->s of one conflict.
+ */
+GList*
+cc_keyboard_manager_find_conflicts (CcKeyboardManager *self)
+{
+  GHashTableIter iter;
+  GPtrArray *items;
+  GList *conflicts;
+
+  g_return_val_if_fail (CC_IS_KEYBOARD_MANAGER (self), NULL);
+
+  conflicts = NULL;
 
-      table = get_hash_for_group (self, i);
+  g_hash_table_iter_init (&iter, self->bindings_index);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer*) &items))
+    {
+      GPtrArray *conflict;
+      guint i;
 
-      if (!table)
+      if (items->len < 2)
         continue;
 
-      g_hash_table_find (table, (GHRFunc) check_for_uniqueness, &data);
+      conflict = g_ptr_array_new ();
+
+      for (i = 0; i < items->len; i++)
+        {
+          CcKeyboardItem *item = g_ptr_array_index (items, i);
+
+          /* Reversed shortcuts follow their main item */
+          if (cc_keyboard_item_get_reverse_item (item) && cc_keyboard_item_is_hidden (item))
+            continue;
+
+          g_ptr_array_add (conflict, item);
+        }
+
+      if (conflict->len < 2)
+        {
+          g_ptr_array_unref (conflict);
+          continue;
+        }
+
+      conflicts = g_list_prepend (conflicts, conflict);
     }
 
-  return data.conflict_item;
+  return conflicts;
 }
 
 /**
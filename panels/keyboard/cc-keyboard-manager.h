@@ -51,6 +51,8 @@ CcKeyboardItem*      cc_keyboard_manager_get_collision           (CcKeyboardMana
                                                                   GdkModifierType     mask,
                                                                   gint                keycode);
 
+GList*               cc_keyboard_manager_find_conflicts          (CcKeyboardManager  *self);
+
 void                 cc_keyboard_manager_disable_shortcut        (CcKeyboardManager  *self,
                                                                   CcKeyboardItem     *item);
 
@@ -37,6 +37,16 @@ typedef struct {
   CcKeyboardItem *item;
   gchar          *section_title;
   gchar          *section_id;
+
+  /* Normalized description and accelerator label, for searching.
+   * The keys of the accelerator are also split, so that short queries
+   * only match whole keys and not every "ctrl" */
+  gchar          *search_name;
+  gchar          *search_accel;
+  gchar         **search_accel_keys;
+
+  /* Shown when another shortcut uses the same keys */
+  GtkWidget      *conflict_icon;
 } RowData;
 
 struct _CcKeyboardPanel
@@ -49,11 +59,13 @@ struct _CcKeyboardPanel
   GtkWidget          *search_button;
   GtkWidget          *search_entry;
   guint               search_bar_handler_id;
+  gchar              *search_query;
 
   /* Shortcuts */
   GtkWidget          *listbox;
   GtkListBoxRow      *add_shortcut_row;
   GtkSizeGroup       *accelerator_sizegroup;
+  guint               update_conflicts_id;
 
   /* Custom shortcut dialog */
   GtkWidget          *shortcut_editor;
@@ -76,6 +88,26 @@ static const gchar* custom_css =
 "}";
 
 /* RowData functions */
+static void
+row_data_update_search_keys (RowData *data)
+{
+  gchar *accel;
+
+  g_free (data->search_name);
+  g_free (data->search_accel);
+  g_strfreev (data->search_accel_keys);
+
+  accel = convert_keysym_state_to_string (data->item->keyval,
+                                          data->item->mask,
+                                          data->item->keycode);
+
+  data->search_name = cc_util_normalize_casefold_and_unaccent (data->item->description);
+  data->search_accel = cc_util_normalize_casefold_and_unaccent (accel);
+  data->search_accel_keys = g_strsplit (data->search_accel, "+", -1);
+
+  g_free (accel);
+}
+
 static RowData *
 row_data_new (CcKeyboardItem *item,
               const gchar    *section_id,
@@ -88,6 +120,8 @@ row_data_new (CcKeyboardItem *item,
   data->section_id = g_strdup (section_id);
   data->section_title = g_strdup (section_title);
 
+  row_data_update_search_keys (data);
+
   return data;
 }
 
@@ -97,6 +131,9 @@ row_data_free (RowData *data)
   g_object_unref (data->item);
   g_free (data->section_id);
   g_free (data->section_title);
+  g_free (data->search_name);
+  g_free (data->search_accel);
+  g_strfreev (data->search_accel_keys);
   g_free (data);
 }
 
@@ -155,13 +192,25 @@ reset_shortcut_cb (GtkWidget      *reset_button,
   cc_keyboard_manager_reset_shortcut (self->manager, item);
 }
 
+static void
+item_search_keys_changed_cb (CcKeyboardItem *item,
+                             GParamSpec     *pspec,
+                             GtkListBoxRow  *row)
+{
+  row_data_update_search_keys (g_object_get_data (G_OBJECT (row), "data"));
+  gtk_list_box_row_changed (row);
+}
+
+static void queue_update_conflicts (CcKeyboardPanel *self);
+
 static void
 add_item (CcKeyboardPanel *self,
           CcKeyboardItem  *item,
           const gchar     *section_id,
           const gchar     *section_title)
 {
-  GtkWidget *row, *box, *label, *reset_button;
+  GtkWidget *row, *box, *label, *reset_button, *conflict_icon;
+  RowData *row_data;
 
   /* Horizontal box */
   box = g_object_new (GTK_TYPE_BOX,
@@ -188,6 +237,11 @@ add_item (CcKeyboardPanel *self,
 
   gtk_container_add (GTK_CONTAINER (box), label);
 
+  /* Conflict warning */
+  conflict_icon = gtk_image_new_from_icon_name ("dialog-warning-symbolic", GTK_ICON_SIZE_BUTTON);
+  gtk_widget_set_no_show_all (conflict_icon, TRUE);
+  gtk_container_add (GTK_CONTAINER (box), conflict_icon);
+
   /* Shortcut accelerator */
   label = gtk_label_new ("");
   gtk_label_set_xalign (GTK_LABEL (label), 0.0);
@@ -238,12 +292,29 @@ add_item (CcKeyboardPanel *self,
 
   gtk_widget_show_all (row);
 
+  row_data = row_data_new (item, section_id, section_title);
+  row_data->conflict_icon = conflict_icon;
   g_object_set_data_full (G_OBJECT (row),
                           "data",
-                          row_data_new (item, section_id, section_title),
+                          row_data,
                           (GDestroyNotify) row_data_free);
 
+  g_signal_connect_object (item,
+                           "notify::binding",
+                           G_CALLBACK (item_search_keys_changed_cb),
+                           row, 0);
+  g_signal_connect_object (item,
+                           "notify::description",
+                           G_CALLBACK (item_search_keys_changed_cb),
+                           row, 0);
+  g_signal_connect_object (item,
+                           "notify::binding",
+                           G_CALLBACK (queue_update_conflicts),
+                           self, G_CONNECT_SWAPPED);
+
   gtk_container_add (GTK_CONTAINER (self->listbox), row);
+
+  queue_update_conflicts (self);
 }
 
 static void
@@ -268,6 +339,8 @@ remove_item (CcKeyboardPanel *self,
     }
 
   g_list_free (children);
+
+  queue_update_conflicts (self);
 }
 
 static gint
@@ -380,10 +453,8 @@ filter_function (GtkListBoxRow *row,
 {
   CcKeyboardPanel *self = user_data;
   RowData *data;
-  gboolean retval;
-  gchar *search, *name;
 
-  if (gtk_entry_get_text_length (GTK_ENTRY (self->search_entry)) == 0)
+  if (!self->search_query || *self->search_query == '\0')
     return TRUE;
 
   /* When searching, the '+' row is always hidden */
@@ -391,15 +462,111 @@ filter_function (GtkListBoxRow *row,
     return FALSE;
 
   data = g_object_get_data (G_OBJECT (row), "data");
-  name = cc_util_normalize_casefold_and_unaccent (data->item->description);
-  search = cc_util_normalize_casefold_and_unaccent (gtk_entry_get_text (GTK_ENTRY (self->search_entry)));
 
-  retval = strstr (name, search) != NULL;
+  if (data->search_name && strstr (data->search_name, self->search_query) != NULL)
+    return TRUE;
 
-  g_free (search);
-  g_free (name);
+  /* Queries that look like an accelerator match anywhere in it,
+   * others only match one of its keys */
+  if (strchr (self->search_query, '+') != NULL)
+    return data->search_accel && strstr (data->search_accel, self->search_query) != NULL;
 
-  return retval;
+  return data->search_accel_keys && g_strv_contains ((const gchar * const *) data->search_accel_keys,
+                                                     self->search_query);
+}
+
+static void
+search_entry_changed_cb (CcKeyboardPanel *self)
+{
+  g_free (self->search_query);
+  self->search_query = cc_util_normalize_casefold_and_unaccent (gtk_entry_get_text (GTK_ENTRY (self->search_entry)));
+
+  gtk_list_box_invalidate_filter (GTK_LIST_BOX (self->listbox));
+}
+
+static gboolean
+update_conflicts (gpointer user_data)
+{
+  CcKeyboardPanel *self = user_data;
+  GHashTable *item_rows;
+  GList *children, *conflicts, *l;
+
+  self->update_conflicts_id = 0;
+
+  /* Clear the previous warnings */
+  item_rows = g_hash_table_new (NULL, NULL);
+  children = gtk_container_get_children (GTK_CONTAINER (self->listbox));
+
+  for (l = children; l != NULL; l = l->next)
+    {
+      RowData *data = g_object_get_data (l->data, "data");
+
+      if (!data)
+        continue;
+
+      gtk_widget_hide (data->conflict_icon);
+      g_hash_table_insert (item_rows, data->item, data);
+    }
+
+  g_list_free (children);
+
+  conflicts = cc_keyboard_manager_find_conflicts (self->manager);
+
+  for (l = conflicts; l != NULL; l = l->next)
+    {
+      GPtrArray *items = l->data;
+      guint i, j;
+
+      for (i = 0; i < items->len; i++)
+        {
+          CcKeyboardItem *item = g_ptr_array_index (items, i);
+          RowData *data;
+          GString *names;
+          gchar *tooltip;
+
+          data = g_hash_table_lookup (item_rows, item);
+          if (!data)
+            continue;
+
+          names = g_string_new (NULL);
+          for (j = 0; j < items->len; j++)
+            {
+              CcKeyboardItem *other = g_ptr_array_index (items, j);
+
+              if (other == item)
+                continue;
+
+              if (names->len > 0)
+                g_string_append (names, ", ");
+              g_string_append_printf (names, "“%s”", other->description);
+            }
+
+          /* TRANSLATORS: %s is a list of shortcut names, e.g. “Lock screen” */
+          tooltip = g_strdup_printf (_("This shortcut is also used by %s"), names->str);
+          gtk_widget_set_tooltip_text (data->conflict_icon, tooltip);
+          gtk_widget_show (data->conflict_icon);
+
+          g_string_free (names, TRUE);
+          g_free (tooltip);
+        }
+    }
+
+  g_list_free_full (conflicts, (GDestroyNotify) g_ptr_array_unref);
+  g_hash_table_destroy (item_rows);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Items are added and rebound in batches, look for conflicts once
+ * they are done */
+static void
+queue_update_conflicts (CcKeyboardPanel *self)
+{
+  if (self->update_conflicts_id != 0)
+    return;
+
+  self->update_conflicts_id = g_idle_add (update_conflicts, self);
+  g_source_set_name_by_id (self->update_conflicts_id, "[gnome-control-center] update_conflicts");
 }
 
 static void
@@ -449,6 +616,20 @@ cc_keyboard_panel_get_help_uri (CcPanel *panel)
   return "help:gnome-help/keyboard";
 }
 
+static void
+cc_keyboard_panel_dispose (GObject *object)
+{
+  CcKeyboardPanel *self = CC_KEYBOARD_PANEL (object);
+
+  if (self->update_conflicts_id != 0)
+    {
+      g_source_remove (self->update_conflicts_id);
+      self->update_conflicts_id = 0;
+    }
+
+  G_OBJECT_CLASS (cc_keyboard_panel_parent_class)->dispose (object);
+}
+
 static void
 cc_keyboard_panel_finalize (GObject *object)
 {
@@ -456,6 +637,7 @@ cc_keyboard_panel_finalize (GObject *object)
   GtkWidget *window;
 
   g_clear_pointer (&self->pictures_regex, g_regex_unref);
+  g_clear_pointer (&self->search_query, g_free);
   g_clear_object (&self->accelerator_sizegroup);
 
   cc_keyboard_option_clear_all ();
@@ -500,6 +682,7 @@ cc_keyboard_panel_class_init (CcKeyboardPanelClass *klass)
   panel_class->get_help_uri = cc_keyboard_panel_get_help_uri;
 
   object_class->set_property = cc_keyboard_panel_set_property;
+  object_class->dispose = cc_keyboard_panel_dispose;
   object_class->finalize = cc_keyboard_panel_finalize;
   object_class->constructed = cc_keyboard_panel_constructed;
 
@@ -514,6 +697,7 @@ cc_keyboard_panel_class_init (CcKeyboardPanelClass *klass)
   gtk_widget_class_bind_template_child (widget_class, CcKeyboardPanel, search_button);
   gtk_widget_class_bind_template_child (widget_class, CcKeyboardPanel, search_entry);
 
+  gtk_widget_class_bind_template_callback (widget_class, search_entry_changed_cb);
   gtk_widget_class_bind_template_callback (widget_class, shortcut_row_activated);
 }
 
@@ -93,6 +93,229 @@ switch_toggled (GObject    *object,
         ce_page_changed (page);
 }
 
+static gboolean
+parse_netmask (const char *str, guint32 *prefix)
+{
+        struct in_addr tmp_addr;
+        glong tmp_prefix;
+
+        errno = 0;
+
+        /* Is it a prefix? */
+        if (!strchr (str, '.')) {
+                tmp_prefix = strtol (str, NULL, 10);
+                if (!errno && tmp_prefix >= 0 && tmp_prefix <= 32) {
+                        *prefix = tmp_prefix;
+                        return TRUE;
+                }
+        }
+
+        /* Is it a netmask? */
+        if (inet_pton (AF_INET, str, &tmp_addr) > 0) {
+                *prefix = nm_utils_ip4_netmask_to_prefix (tmp_addr.s_addr);
+                return TRUE;
+        }
+
+        return FALSE;
+}
+
+typedef enum {
+        ROW_ADDRESS,
+        ROW_DNS,
+        ROW_ROUTE
+} RowKind;
+
+/* Parsed state of a row, refreshed whenever one of its entries changes so
+ * that validating the page does not need to reparse every row */
+typedef struct {
+        RowKind  kind;
+        gboolean empty;
+        gboolean valid;
+        guint32  prefix;
+        gint64   metric;
+} RowCache;
+
+static void
+set_entry_error (GtkWidget *entry, gboolean error)
+{
+        if (error)
+                widget_set_error (entry);
+        else
+                widget_unset_error (entry);
+}
+
+static void
+validate_address_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address, *network, *gateway;
+        const gchar *text_address;
+        const gchar *text_netmask;
+        const gchar *text_gateway = "";
+        gboolean address_ok = TRUE;
+        gboolean netmask_ok = TRUE;
+        gboolean gateway_ok = TRUE;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        network = g_object_get_data (G_OBJECT (row), "network");
+        gateway = g_object_get_data (G_OBJECT (row), "gateway");
+
+        text_address = gtk_entry_get_text (GTK_ENTRY (address));
+        text_netmask = gtk_entry_get_text (GTK_ENTRY (network));
+        if (gtk_widget_is_visible (gateway))
+                text_gateway = gtk_entry_get_text (GTK_ENTRY (gateway));
+
+        /* ignore empty rows */
+        cache->empty = !*text_address && !*text_netmask && !*text_gateway;
+        if (!cache->empty) {
+                address_ok = nm_utils_ipaddr_valid (AF_INET, text_address);
+                netmask_ok = parse_netmask (text_netmask, &cache->prefix);
+                gateway_ok = !*text_gateway || nm_utils_ipaddr_valid (AF_INET, text_gateway);
+        }
+        cache->valid = address_ok && netmask_ok && gateway_ok;
+
+        set_entry_error (address, !address_ok);
+        set_entry_error (network, !netmask_ok);
+        set_entry_error (gateway, !gateway_ok);
+}
+
+static void
+validate_dns_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address;
+        const gchar *text;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        text = gtk_entry_get_text (GTK_ENTRY (address));
+
+        cache->empty = !*text;
+        cache->valid = cache->empty || nm_utils_ipaddr_valid (AF_INET, text);
+
+        set_entry_error (address, !cache->valid);
+}
+
+static void
+validate_route_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address, *netmask, *gateway, *metric;
+        const gchar *text_address;
+        const gchar *text_netmask;
+        const gchar *text_gateway;
+        const gchar *text_metric;
+        gboolean address_ok = TRUE;
+        gboolean netmask_ok = TRUE;
+        gboolean gateway_ok = TRUE;
+        gboolean metric_ok = TRUE;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        netmask = g_object_get_data (G_OBJECT (row), "netmask");
+        gateway = g_object_get_data (G_OBJECT (row), "gateway");
+        metric = g_object_get_data (G_OBJECT (row), "metric");
+
+        text_address = gtk_entry_get_text (GTK_ENTRY (address));
+        text_netmask = gtk_entry_get_text (GTK_ENTRY (netmask));
+        text_gateway = gtk_entry_get_text (GTK_ENTRY (gateway));
+        text_metric = gtk_entry_get_text (GTK_ENTRY (metric));
+
+        /* ignore empty rows */
+        cache->empty = !*text_address && !*text_netmask && !*text_gateway && !*text_metric;
+        cache->metric = -1;
+        if (!cache->empty) {
+                address_ok = nm_utils_ipaddr_valid (AF_INET, text_address);
+                netmask_ok = parse_netmask (text_netmask, &cache->prefix);
+                gateway_ok = nm_utils_ipaddr_valid (AF_INET, text_gateway);
+                if (*text_metric) {
+                        errno = 0;
+                        cache->metric = g_ascii_strtoull (text_metric, NULL, 10);
+                        metric_ok = !errno && cache->metric >= 0 && cache->metric <= G_MAXUINT32;
+                }
+        }
+        cache->valid = address_ok && netmask_ok && gateway_ok && metric_ok;
+
+        set_entry_error (address, !address_ok);
+        set_entry_error (netmask, !netmask_ok);
+        set_entry_error (gateway, !gateway_ok);
+        set_entry_error (metric, !metric_ok);
+}
+
+static void
+validate_row (GtkWidget *row)
+{
+        RowCache *cache;
+
+        cache = g_object_get_data (G_OBJECT (row), "cache");
+        switch (cache->kind) {
+        case ROW_ADDRESS:
+                validate_address_row (row, cache);
+                break;
+        case ROW_DNS:
+                validate_dns_row (row, cache);
+                break;
+        case ROW_ROUTE:
+                validate_route_row (row, cache);
+                break;
+        default:
+                g_assert_not_reached ();
+        }
+}
+
+static GtkWidget *
+row_new (RowKind kind)
+{
+        GtkWidget *row;
+        RowCache *cache;
+
+        row = gtk_list_box_row_new ();
+        cache = g_new0 (RowCache, 1);
+        cache->kind = kind;
+        cache->empty = TRUE;
+        cache->valid = TRUE;
+        cache->metric = -1;
+        g_object_set_data_full (G_OBJECT (row), "cache", cache, g_free);
+
+        return row;
+}
+
+static void
+row_entry_changed (GtkEntry *entry, CEPageIP4 *page)
+{
+        validate_row (g_object_get_data (G_OBJECT (entry), "row"));
+        ce_page_changed (CE_PAGE (page));
+}
+
+static void
+connect_row_entry (CEPageIP4 *page, GtkWidget *row, GtkWidget *entry)
+{
+        g_object_set_data (G_OBJECT (entry), "row", row);
+        g_signal_connect (entry, "changed", G_CALLBACK (row_entry_changed), page);
+}
+
+static void
+remove_empty_rows (GtkWidget *list)
+{
+        GList *children, *l;
+
+        children = gtk_container_get_children (GTK_CONTAINER (list));
+        for (l = children; l; l = l->next) {
+                RowCache *cache;
+
+                cache = g_object_get_data (G_OBJECT (l->data), "cache");
+                if (cache != NULL && cache->empty)
+                        gtk_container_remove (GTK_CONTAINER (list), l->data);
+        }
+        g_list_free (children);
+}
+
+static gboolean
+list_is_empty (GtkWidget *list)
+{
+        GList *children;
+
+        children = gtk_container_get_children (GTK_CONTAINER (list));
+        g_list_free (children);
+
+        return children == NULL;
+}
+
 static void
 update_row_sensitivity (CEPageIP4 *page, GtkWidget *list)
 {
@@ -129,12 +352,16 @@ update_row_gateway_visibility (CEPageIP4 *page)
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
                 GtkWidget *label, *entry;
+                gboolean changed;
 
                 label = GTK_WIDGET (g_object_get_data (G_OBJECT (row), "gateway-label"));
                 entry = GTK_WIDGET (g_object_get_data (G_OBJECT (row), "gateway"));
 
+                changed = gtk_widget_get_visible (entry) != (rows == 0);
                 gtk_widget_set_visible (label, (rows == 0));
                 gtk_widget_set_visible (entry, (rows == 0));
+                if (changed)
+                        validate_row (row);
 
                 rows++;
         }
@@ -196,7 +423,7 @@ add_address_row (CEPageIP4   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_ADDRESS);
 
         row_grid = gtk_grid_new ();
         label = gtk_label_new (_("Address"));
@@ -204,9 +431,9 @@ add_address_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 1, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -217,9 +444,9 @@ add_address_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 2, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "network", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), network);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -232,9 +459,9 @@ add_address_row (CEPageIP4   *page,
         g_object_set_data (G_OBJECT (row), "gateway-label", label);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "gateway", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), gateway ? gateway : "");
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -263,18 +490,58 @@ add_address_row (CEPageIP4   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->address_list), row);
 
-        update_row_gateway_visibility (page);
-        update_row_sensitivity (page, page->address_list);
+        validate_row (row);
 }
 
 static void
 add_empty_address_row (CEPageIP4 *page)
 {
         add_address_row (page, "", "", "");
+        update_row_gateway_visibility (page);
+        update_row_sensitivity (page, page->address_list);
 }
 
 static void
-add_section_toolbar (CEPageIP4 *page, GtkWidget *section, GCallback add_cb)
+import_addresses (CEPageIP4 *page)
+{
+        gchar *text;
+        gchar **lines;
+        guint i;
+
+        text = text_block_dialog_run (page->address_list,
+                                      _("Import Addresses"),
+                                      _("Enter one address per line, as “address/prefix gateway” or “address netmask gateway”. "
+                                        "The gateway is only used for the first address."));
+        if (text == NULL)
+                return;
+
+        remove_empty_rows (page->address_list);
+
+        lines = g_strsplit (text, "\n", -1);
+        for (i = 0; lines[i] != NULL; i++) {
+                gchar *address, *network, *gateway;
+
+                if (!ce_page_parse_address_line (lines[i], &address, &network, &gateway, NULL))
+                        continue;
+
+                add_address_row (page, address, network ? network : "", gateway);
+                g_free (address);
+                g_free (network);
+                g_free (gateway);
+        }
+        g_strfreev (lines);
+        g_free (text);
+
+        if (list_is_empty (page->address_list))
+                add_address_row (page, "", "", "");
+
+        update_row_gateway_visibility (page);
+        update_row_sensitivity (page, page->address_list);
+        ce_page_changed (CE_PAGE (page));
+}
+
+static void
+add_section_toolbar (CEPageIP4 *page, GtkWidget *section, GCallback add_cb, GCallback import_cb)
 {
         GtkWidget *toolbar;
         GtkToolItem *item;
@@ -305,6 +572,17 @@ add_section_toolbar (CEPageIP4 *page, GtkWidget *section, GCallback add_cb)
         atk_object_set_name (gtk_widget_get_accessible (button), _("Add"));
         gtk_button_set_image (GTK_BUTTON (button), image);
         gtk_container_add (GTK_CONTAINER (box), button);
+
+        if (import_cb != NULL) {
+                button = gtk_button_new ();
+                g_signal_connect_swapped (button, "clicked", G_CALLBACK (import_cb), page);
+                image = gtk_image_new_from_icon_name ("edit-paste-symbolic", GTK_ICON_SIZE_MENU);
+                atk_object_set_name (gtk_widget_get_accessible (button), _("Import"));
+                gtk_widget_set_tooltip_text (button, _("Add several entries at once"));
+                gtk_button_set_image (GTK_BUTTON (button), image);
+                gtk_container_add (GTK_CONTAINER (box), button);
+        }
+
         gtk_toolbar_insert (GTK_TOOLBAR (toolbar), GTK_TOOL_ITEM (item), 1);
 }
 
@@ -326,7 +604,7 @@ add_address_section (CEPageIP4 *page)
         gtk_list_box_set_sort_func (GTK_LIST_BOX (list), (GtkListBoxSortFunc)sort_first_last, NULL, NULL);
         gtk_container_add (GTK_CONTAINER (frame), list);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_address_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_address_row), G_CALLBACK (import_addresses));
 
         for (i = 0; i < nm_setting_ip_config_get_num_addresses (page->setting); i++) {
                 NMIPAddress *addr;
@@ -346,9 +624,13 @@ add_address_section (CEPageIP4 *page)
                                  i == 0 ? nm_setting_ip_config_get_gateway (page->setting) : "");
         }
         if (nm_setting_ip_config_get_num_addresses (page->setting) == 0)
-                add_empty_address_row (page);
+                add_address_row (page, "", "", "");
 
         gtk_widget_show_all (widget);
+
+        /* rows are updated once for the whole batch */
+        update_row_gateway_visibility (page);
+        update_row_sensitivity (page, page->address_list);
 }
 
 static void
@@ -362,7 +644,7 @@ add_dns_row (CEPageIP4   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_DNS);
 
         row_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
         label = gtk_label_new (_("Server"));
@@ -370,9 +652,9 @@ add_dns_row (CEPageIP4   *page,
         gtk_box_pack_start (GTK_BOX (row_box), label, FALSE, FALSE, 0);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -397,13 +679,14 @@ add_dns_row (CEPageIP4   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->dns_list), row);
 
-        update_row_sensitivity (page, page->dns_list);
+        validate_row (row);
 }
 
 static void
 add_empty_dns_row (CEPageIP4 *page)
 {
         add_dns_row (page, "");
+        update_row_sensitivity (page, page->dns_list);
 }
 
 static void
@@ -427,7 +710,7 @@ add_dns_section (CEPageIP4 *page)
         gtk_switch_set_active (page->auto_dns, !nm_setting_ip_config_get_ignore_auto_dns (page->setting));
         g_signal_connect (page->auto_dns, "notify::active", G_CALLBACK (switch_toggled), page);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_dns_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_dns_row), NULL);
 
         for (i = 0; i < nm_setting_ip_config_get_num_dns (page->setting); i++) {
                 const char *address;
@@ -436,9 +719,11 @@ add_dns_section (CEPageIP4 *page)
                 add_dns_row (page, address);
         }
         if (nm_setting_ip_config_get_num_dns (page->setting) == 0)
-                add_empty_dns_row (page);
+                add_dns_row (page, "");
 
         gtk_widget_show_all (widget);
+
+        update_row_sensitivity (page, page->dns_list);
 }
 
 static void
@@ -455,7 +740,7 @@ add_route_row (CEPageIP4   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_ROUTE);
 
         row_grid = gtk_grid_new ();
         label = gtk_label_new (_("Address"));
@@ -463,9 +748,9 @@ add_route_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 1, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -476,9 +761,9 @@ add_route_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 2, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "netmask", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), netmask);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -489,9 +774,9 @@ add_route_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 3, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "gateway", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), gateway);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -503,13 +788,13 @@ add_route_row (CEPageIP4   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 4, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "metric", widget);
         if (metric >= 0) {
                 gchar *s = g_strdup_printf ("%d", metric);
                 gtk_entry_set_text (GTK_ENTRY (widget), s);
                 g_free (s);
         }
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -537,13 +822,66 @@ add_route_row (CEPageIP4   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->routes_list), row);
 
-        update_row_sensitivity (page, page->routes_list);
+        validate_row (row);
 }
 
 static void
 add_empty_route_row (CEPageIP4 *page)
 {
         add_route_row (page, "", "", "", -1);
+        update_row_sensitivity (page, page->routes_list);
+}
+
+static void
+import_routes (CEPageIP4 *page)
+{
+        gchar *text;
+        gchar **lines;
+        guint i;
+
+        text = text_block_dialog_run (page->routes_list,
+                                      _("Import Routes"),
+                                      _("Enter one route per line, as “address/prefix gateway metric”, "
+                                        "“address netmask gateway metric” or “address/prefix via gateway metric N”."));
+        if (text == NULL)
+                return;
+
+        remove_empty_rows (page->routes_list);
+
+        lines = g_strsplit (text, "\n", -1);
+        for (i = 0; lines[i] != NULL; i++) {
+                gchar *address, *netmask, *gateway, *metric;
+                gint64 value = -1;
+
+                if (!ce_page_parse_address_line (lines[i], &address, &netmask, &gateway, &metric))
+                        continue;
+
+                if (metric != NULL) {
+                        gchar *end;
+
+                        value = g_ascii_strtoll (metric, &end, 10);
+                        if (*end != '\0' || value < 0 || value > G_MAXINT)
+                                value = -1;
+                }
+
+                add_route_row (page,
+                               address,
+                               netmask ? netmask : "",
+                               gateway ? gateway : "",
+                               value);
+                g_free (address);
+                g_free (netmask);
+                g_free (gateway);
+                g_free (metric);
+        }
+        g_strfreev (lines);
+        g_free (text);
+
+        if (list_is_empty (page->routes_list))
+                add_route_row (page, "", "", "", -1);
+
+        update_row_sensitivity (page, page->routes_list);
+        ce_page_changed (CE_PAGE (page));
 }
 
 static void
@@ -567,7 +905,7 @@ add_routes_section (CEPageIP4 *page)
         gtk_switch_set_active (page->auto_routes, !nm_setting_ip_config_get_ignore_auto_routes (page->setting));
         g_signal_connect (page->auto_routes, "notify::active", G_CALLBACK (switch_toggled), page);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_route_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_route_row), G_CALLBACK (import_routes));
 
         for (i = 0; i < nm_setting_ip_config_get_num_routes (page->setting); i++) {
                 NMIPRoute *route;
@@ -588,9 +926,11 @@ add_routes_section (CEPageIP4 *page)
                                nm_ip_route_get_metric (route));
         }
         if (nm_setting_ip_config_get_num_routes (page->setting) == 0)
-                add_empty_route_row (page);
+                add_route_row (page, "", "", "", -1);
 
         gtk_widget_show_all (widget);
+
+        update_row_sensitivity (page, page->routes_list);
 }
 
 static void
@@ -659,32 +999,6 @@ connect_ip4_page (CEPageIP4 *page)
                 gtk_combo_box_set_active (page->method, method);
 }
 
-static gboolean
-parse_netmask (const char *str, guint32 *prefix)
-{
-        struct in_addr tmp_addr;
-        glong tmp_prefix;
-
-        errno = 0;
-
-        /* Is it a prefix? */
-        if (!strchr (str, '.')) {
-                tmp_prefix = strtol (str, NULL, 10);
-                if (!errno && tmp_prefix >= 0 && tmp_prefix <= 32) {
-                        *prefix = tmp_prefix;
-                        return TRUE;
-                }
-        }
-
-        /* Is it a netmask? */
-        if (inet_pton (AF_INET, str, &tmp_addr) > 0) {
-                *prefix = nm_utils_ip4_netmask_to_prefix (tmp_addr.s_addr);
-                return TRUE;
-        }
-
-        return FALSE;
-}
-
 static gboolean
 ui_to_setting (CEPageIP4 *page)
 {
@@ -724,63 +1038,32 @@ ui_to_setting (CEPageIP4 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
-                GtkEntry *gateway_entry;
+                GtkWidget *gateway_entry;
                 const gchar *text_address;
-                const gchar *text_netmask;
-                const gchar *text_gateway = "";
+                const gchar *text_gateway;
+                RowCache *cache;
                 NMIPAddress *addr;
-                guint32 prefix;
 
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
 
-                text_address = gtk_entry_get_text (entry);
-                text_netmask = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "network")));
-                gateway_entry = g_object_get_data (G_OBJECT (row), "gateway");
-                if (gtk_widget_is_visible (GTK_WIDGET (gateway_entry)))
-                        text_gateway = gtk_entry_get_text (gateway_entry);
-
-                if (!*text_address && !*text_netmask && !*text_gateway) {
-                        /* ignore empty rows */
-                        widget_unset_error (GTK_WIDGET (entry));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "network"));
-                        widget_unset_error (GTK_WIDGET (gateway_entry));
-                        continue;
-                }
-
-                if (!nm_utils_ipaddr_valid (AF_INET, text_address)) {
-                        widget_set_error (GTK_WIDGET (entry));
+                if (!cache->valid)
                         ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                }
-
-                if (!parse_netmask (text_netmask, &prefix)) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "network"));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "network"));
-                }
-
-                if (gtk_widget_is_visible (GTK_WIDGET (gateway_entry)) &&
-                    *text_gateway &&
-                    !nm_utils_ipaddr_valid (AF_INET, text_gateway)) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                        ret = FALSE;
-                } else {
-                         widget_unset_error (GTK_WIDGET (gateway_entry));
-                         if (gtk_widget_is_visible (GTK_WIDGET (gateway_entry)) && *text_gateway) {
-                                 g_assert (default_gateway == NULL);
-                                 default_gateway = text_gateway;
-                         }
-                }
-
                 if (!ret)
                         continue;
 
-                addr = nm_ip_address_new (AF_INET, text_address, prefix, NULL);
+                gateway_entry = g_object_get_data (G_OBJECT (row), "gateway");
+                if (gtk_widget_is_visible (gateway_entry)) {
+                        text_gateway = gtk_entry_get_text (GTK_ENTRY (gateway_entry));
+                        if (*text_gateway) {
+                                g_assert (default_gateway == NULL);
+                                default_gateway = text_gateway;
+                        }
+                }
+
+                text_address = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address")));
+                addr = nm_ip_address_new (AF_INET, text_address, cache->prefix, NULL);
                 if (addr)
                         g_ptr_array_add (addresses, addr);
         }
@@ -800,27 +1083,19 @@ ui_to_setting (CEPageIP4 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
-                const gchar *text;
+                RowCache *cache;
 
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
 
-                text = gtk_entry_get_text (entry);
-                if (!*text) {
-                        /* ignore empty rows */
-                        widget_unset_error (GTK_WIDGET (entry));
+                if (!cache->valid) {
+                        ret = FALSE;
                         continue;
                 }
 
-                if (text && !nm_utils_ipaddr_valid (AF_INET, text)) {
-                        widget_set_error (GTK_WIDGET (entry));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                        g_ptr_array_add (dns_servers, g_strdup (text));
-                }
+                g_ptr_array_add (dns_servers,
+                                 g_strdup (gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address")))));
         }
         g_list_free (children);
 
@@ -840,68 +1115,23 @@ ui_to_setting (CEPageIP4 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
                 const gchar *text_address;
-                const gchar *text_netmask;
                 const gchar *text_gateway;
-                const gchar *text_metric;
-                gint64 metric;
-                guint32 netmask;
+                RowCache *cache;
                 NMIPRoute *route;
 
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
 
-                text_address = gtk_entry_get_text (entry);
-                text_netmask = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "netmask")));
-                text_gateway = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway")));
-                text_metric = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "metric")));
-
-                if (!*text_address && !*text_netmask && !*text_gateway && !*text_metric) {
-                        /* ignore empty rows */
-                        continue;
-                }
-
-                if (text_address && !nm_utils_ipaddr_valid (AF_INET, text_address)) {
-                        widget_set_error (GTK_WIDGET (entry));
+                if (!cache->valid)
                         ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                }
-
-                if (!parse_netmask (text_netmask, &netmask)) {
-                        widget_set_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "netmask")));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "netmask")));
-                }
-
-                if (text_gateway && !nm_utils_ipaddr_valid (AF_INET, text_gateway)) {
-                        widget_set_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "gateway")));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "gateway")));
-                }
-
-                metric = -1;
-                if (*text_metric) {
-                        errno = 0;
-                        metric = g_ascii_strtoull (text_metric, NULL, 10);
-                        if (errno || metric < 0 || metric > G_MAXUINT32) {
-                                widget_set_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "metric")));
-                                ret = FALSE;
-                        } else {
-                                widget_unset_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "metric")));
-                        }
-                } else {
-                        widget_unset_error (GTK_WIDGET (g_object_get_data (G_OBJECT (row), "metric")));
-                }
-
                 if (!ret)
                         continue;
 
-                route = nm_ip_route_new (AF_INET, text_address, netmask, text_gateway, metric, NULL);
+                text_address = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address")));
+                text_gateway = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway")));
+                route = nm_ip_route_new (AF_INET, text_address, cache->prefix, text_gateway, cache->metric, NULL);
                 if (route)
                         g_ptr_array_add (routes, route);
         }
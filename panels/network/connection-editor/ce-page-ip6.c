@@ -95,6 +95,213 @@ switch_toggled (GObject    *object,
         ce_page_changed (page);
 }
 
+typedef enum {
+        ROW_ADDRESS,
+        ROW_DNS,
+        ROW_ROUTE
+} RowKind;
+
+/* Parsed state of a row, refreshed whenever one of its entries changes so
+ * that validating the page does not need to reparse every row */
+typedef struct {
+        RowKind  kind;
+        gboolean empty;
+        gboolean valid;
+        gboolean have_gateway;
+        guint32  prefix;
+        guint32  metric;
+} RowCache;
+
+static void
+set_entry_error (GtkWidget *entry, gboolean error)
+{
+        if (error)
+                widget_set_error (entry);
+        else
+                widget_unset_error (entry);
+}
+
+static gboolean
+parse_prefix (const gchar *str, guint32 *prefix)
+{
+        gchar *end;
+
+        *prefix = strtoul (str, &end, 10);
+        return end != NULL && *end == '\0' && *prefix > 0 && *prefix <= 128;
+}
+
+static void
+validate_address_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address, *prefix, *gateway;
+        const gchar *text_address;
+        const gchar *text_prefix;
+        const gchar *text_gateway;
+        gboolean address_ok = TRUE;
+        gboolean prefix_ok = TRUE;
+        gboolean gateway_ok = TRUE;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        prefix = g_object_get_data (G_OBJECT (row), "prefix");
+        gateway = g_object_get_data (G_OBJECT (row), "gateway");
+
+        text_address = gtk_entry_get_text (GTK_ENTRY (address));
+        text_prefix = gtk_entry_get_text (GTK_ENTRY (prefix));
+        text_gateway = gtk_entry_get_text (GTK_ENTRY (gateway));
+
+        /* ignore empty rows */
+        cache->empty = !*text_address && !*text_prefix && !*text_gateway;
+        if (!cache->empty) {
+                address_ok = nm_utils_ipaddr_valid (AF_INET6, text_address);
+                prefix_ok = parse_prefix (text_prefix, &cache->prefix);
+                gateway_ok = nm_utils_ipaddr_valid (AF_INET6, text_gateway);
+        }
+        cache->valid = address_ok && prefix_ok && gateway_ok;
+        cache->have_gateway = !cache->empty && gateway_ok;
+
+        set_entry_error (address, !address_ok);
+        set_entry_error (prefix, !prefix_ok);
+        set_entry_error (gateway, !gateway_ok);
+}
+
+static void
+validate_dns_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address;
+        const gchar *text;
+        struct in6_addr tmp_addr;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        text = gtk_entry_get_text (GTK_ENTRY (address));
+
+        cache->empty = !*text;
+        cache->valid = cache->empty || inet_pton (AF_INET6, text, &tmp_addr) > 0;
+
+        set_entry_error (address, !cache->valid);
+}
+
+static void
+validate_route_row (GtkWidget *row, RowCache *cache)
+{
+        GtkWidget *address, *prefix, *gateway, *metric;
+        const gchar *text_address;
+        const gchar *text_prefix;
+        const gchar *text_gateway;
+        const gchar *text_metric;
+        gboolean address_ok = TRUE;
+        gboolean prefix_ok = TRUE;
+        gboolean gateway_ok = TRUE;
+        gboolean metric_ok = TRUE;
+
+        address = g_object_get_data (G_OBJECT (row), "address");
+        prefix = g_object_get_data (G_OBJECT (row), "prefix");
+        gateway = g_object_get_data (G_OBJECT (row), "gateway");
+        metric = g_object_get_data (G_OBJECT (row), "metric");
+
+        text_address = gtk_entry_get_text (GTK_ENTRY (address));
+        text_prefix = gtk_entry_get_text (GTK_ENTRY (prefix));
+        text_gateway = gtk_entry_get_text (GTK_ENTRY (gateway));
+        text_metric = gtk_entry_get_text (GTK_ENTRY (metric));
+
+        /* ignore empty rows */
+        cache->empty = !*text_address && !*text_prefix && !*text_gateway && !*text_metric;
+        cache->metric = 0;
+        if (!cache->empty) {
+                address_ok = nm_utils_ipaddr_valid (AF_INET6, text_address);
+                prefix_ok = parse_prefix (text_prefix, &cache->prefix);
+                gateway_ok = nm_utils_ipaddr_valid (AF_INET6, text_gateway);
+                if (*text_metric) {
+                        errno = 0;
+                        cache->metric = strtoul (text_metric, NULL, 10);
+                        metric_ok = !errno;
+                }
+        }
+        cache->valid = address_ok && prefix_ok && gateway_ok && metric_ok;
+
+        set_entry_error (address, !address_ok);
+        set_entry_error (prefix, !prefix_ok);
+        set_entry_error (gateway, !gateway_ok);
+        set_entry_error (metric, !metric_ok);
+}
+
+static void
+validate_row (GtkWidget *row)
+{
+        RowCache *cache;
+
+        cache = g_object_get_data (G_OBJECT (row), "cache");
+        switch (cache->kind) {
+        case ROW_ADDRESS:
+                validate_address_row (row, cache);
+                break;
+        case ROW_DNS:
+                validate_dns_row (row, cache);
+                break;
+        case ROW_ROUTE:
+                validate_route_row (row, cache);
+                break;
+        default:
+                g_assert_not_reached ();
+        }
+}
+
+static GtkWidget *
+row_new (RowKind kind)
+{
+        GtkWidget *row;
+        RowCache *cache;
+
+        row = gtk_list_box_row_new ();
+        cache = g_new0 (RowCache, 1);
+        cache->kind = kind;
+        cache->empty = TRUE;
+        cache->valid = TRUE;
+        g_object_set_data_full (G_OBJECT (row), "cache", cache, g_free);
+
+        return row;
+}
+
+static void
+row_entry_changed (GtkEntry *entry, CEPageIP6 *page)
+{
+        validate_row (g_object_get_data (G_OBJECT (entry), "row"));
+        ce_page_changed (CE_PAGE (page));
+}
+
+static void
+connect_row_entry (CEPageIP6 *page, GtkWidget *row, GtkWidget *entry)
+{
+        g_object_set_data (G_OBJECT (entry), "row", row);
+        g_signal_connect (entry, "changed", G_CALLBACK (row_entry_changed), page);
+}
+
+static void
+remove_empty_rows (GtkWidget *list)
+{
+        GList *children, *l;
+
+        children = gtk_container_get_children (GTK_CONTAINER (list));
+        for (l = children; l; l = l->next) {
+                RowCache *cache;
+
+                cache = g_object_get_data (G_OBJECT (l->data), "cache");
+                if (cache != NULL && cache->empty)
+                        gtk_container_remove (GTK_CONTAINER (list), l->data);
+        }
+        g_list_free (children);
+}
+
+static gboolean
+list_is_empty (GtkWidget *list)
+{
+        GList *children;
+
+        children = gtk_container_get_children (GTK_CONTAINER (list));
+        g_list_free (children);
+
+        return children == NULL;
+}
+
 static void
 update_row_sensitivity (CEPageIP6 *page, GtkWidget *list)
 {
@@ -174,7 +381,7 @@ add_address_row (CEPageIP6   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_ADDRESS);
 
         row_grid = gtk_grid_new ();
         label = gtk_label_new (_("Address"));
@@ -182,9 +389,9 @@ add_address_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 1, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -195,9 +402,9 @@ add_address_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 2, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "prefix", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), network);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -208,9 +415,9 @@ add_address_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 3, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "gateway", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), gateway ? gateway : "");
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -236,17 +443,55 @@ add_address_row (CEPageIP6   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->address_list), row);
 
-        update_row_sensitivity (page, page->address_list);
+        validate_row (row);
 }
 
 static void
 add_empty_address_row (CEPageIP6 *page)
 {
         add_address_row (page, "", "", "");
+        update_row_sensitivity (page, page->address_list);
 }
 
 static void
-add_section_toolbar (CEPageIP6 *page, GtkWidget *section, GCallback add_cb)
+import_addresses (CEPageIP6 *page)
+{
+        gchar *text;
+        gchar **lines;
+        guint i;
+
+        text = text_block_dialog_run (page->address_list,
+                                      _("Import Addresses"),
+                                      _("Enter one address per line, as “address/prefix gateway”."));
+        if (text == NULL)
+                return;
+
+        remove_empty_rows (page->address_list);
+
+        lines = g_strsplit (text, "\n", -1);
+        for (i = 0; lines[i] != NULL; i++) {
+                gchar *address, *prefix, *gateway;
+
+                if (!ce_page_parse_address_line (lines[i], &address, &prefix, &gateway, NULL))
+                        continue;
+
+                add_address_row (page, address, prefix ? prefix : "", gateway);
+                g_free (address);
+                g_free (prefix);
+                g_free (gateway);
+        }
+        g_strfreev (lines);
+        g_free (text);
+
+        if (list_is_empty (page->address_list))
+                add_address_row (page, "", "", "");
+
+        update_row_sensitivity (page, page->address_list);
+        ce_page_changed (CE_PAGE (page));
+}
+
+static void
+add_section_toolbar (CEPageIP6 *page, GtkWidget *section, GCallback add_cb, GCallback import_cb)
 {
         GtkWidget *toolbar;
         GtkToolItem *item;
@@ -277,6 +522,17 @@ add_section_toolbar (CEPageIP6 *page, GtkWidget *section, GCallback add_cb)
         atk_object_set_name (gtk_widget_get_accessible (button), _("Add"));
         gtk_button_set_image (GTK_BUTTON (button), image);
         gtk_container_add (GTK_CONTAINER (box), button);
+
+        if (import_cb != NULL) {
+                button = gtk_button_new ();
+                g_signal_connect_swapped (button, "clicked", G_CALLBACK (import_cb), page);
+                image = gtk_image_new_from_icon_name ("edit-paste-symbolic", GTK_ICON_SIZE_MENU);
+                atk_object_set_name (gtk_widget_get_accessible (button), _("Import"));
+                gtk_widget_set_tooltip_text (button, _("Add several entries at once"));
+                gtk_button_set_image (GTK_BUTTON (button), image);
+                gtk_container_add (GTK_CONTAINER (box), button);
+        }
+
         gtk_toolbar_insert (GTK_TOOLBAR (toolbar), GTK_TOOL_ITEM (item), 1);
 }
 
@@ -298,7 +554,7 @@ add_address_section (CEPageIP6 *page)
         gtk_list_box_set_sort_func (GTK_LIST_BOX (list), (GtkListBoxSortFunc)sort_first_last, NULL, NULL);
         gtk_container_add (GTK_CONTAINER (frame), list);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_address_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_address_row), G_CALLBACK (import_addresses));
 
         for (i = 0; i < nm_setting_ip_config_get_num_addresses (page->setting); i++) {
                 NMIPAddress *addr;
@@ -311,9 +567,12 @@ add_address_section (CEPageIP6 *page)
                 g_free (netmask);
         }
         if (nm_setting_ip_config_get_num_addresses (page->setting) == 0)
-                add_empty_address_row (page);
+                add_address_row (page, "", "", "");
 
         gtk_widget_show_all (widget);
+
+        /* rows are updated once for the whole batch */
+        update_row_sensitivity (page, page->address_list);
 }
 
 static void
@@ -327,7 +586,7 @@ add_dns_row (CEPageIP6   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_DNS);
         gtk_widget_set_can_focus (row, FALSE);
 
         row_box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
@@ -336,9 +595,9 @@ add_dns_row (CEPageIP6   *page,
         gtk_box_pack_start (GTK_BOX (row_box), label, FALSE, FALSE, 0);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -363,13 +622,14 @@ add_dns_row (CEPageIP6   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->dns_list), row);
 
-        update_row_sensitivity (page, page->dns_list);
+        validate_row (row);
 }
 
 static void
 add_empty_dns_row (CEPageIP6 *page)
 {
         add_dns_row (page, "");
+        update_row_sensitivity (page, page->dns_list);
 }
 
 static void
@@ -393,7 +653,7 @@ add_dns_section (CEPageIP6 *page)
         gtk_switch_set_active (page->auto_dns, !nm_setting_ip_config_get_ignore_auto_dns (page->setting));
         g_signal_connect (page->auto_dns, "notify::active", G_CALLBACK (switch_toggled), page);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_dns_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_dns_row), NULL);
 
         for (i = 0; i < nm_setting_ip_config_get_num_dns (page->setting); i++) {
                 const char *address;
@@ -402,9 +662,11 @@ add_dns_section (CEPageIP6 *page)
                 add_dns_row (page, address);
         }
         if (nm_setting_ip_config_get_num_dns (page->setting) == 0)
-                add_empty_dns_row (page);
+                add_dns_row (page, "");
 
         gtk_widget_show_all (widget);
+
+        update_row_sensitivity (page, page->dns_list);
 }
 
 static void
@@ -421,7 +683,7 @@ add_route_row (CEPageIP6   *page,
         GtkWidget *delete_button;
         GtkWidget *image;
 
-        row = gtk_list_box_row_new ();
+        row = row_new (ROW_ROUTE);
 
         row_grid = gtk_grid_new ();
         label = gtk_label_new (_("Address"));
@@ -429,9 +691,9 @@ add_route_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 1, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "address", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), address);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -442,9 +704,9 @@ add_route_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 2, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "prefix", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), prefix ? prefix : "");
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -455,9 +717,9 @@ add_route_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 3, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "gateway", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), gateway);
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -469,9 +731,9 @@ add_route_row (CEPageIP6   *page,
         gtk_grid_attach (GTK_GRID (row_grid), label, 1, 4, 1, 1);
         widget = gtk_entry_new ();
         gtk_label_set_mnemonic_widget (GTK_LABEL (label), widget);
-        g_signal_connect_swapped (widget, "changed", G_CALLBACK (ce_page_changed), page);
         g_object_set_data (G_OBJECT (row), "metric", widget);
         gtk_entry_set_text (GTK_ENTRY (widget), metric ? metric : "");
+        connect_row_entry (page, row, widget);
         gtk_widget_set_margin_start (widget, 10);
         gtk_widget_set_margin_end (widget, 10);
         gtk_widget_set_hexpand (widget, TRUE);
@@ -499,13 +761,53 @@ add_route_row (CEPageIP6   *page,
         gtk_widget_show_all (row);
         gtk_container_add (GTK_CONTAINER (page->routes_list), row);
 
-        update_row_sensitivity (page, page->routes_list);
+        validate_row (row);
 }
 
 static void
 add_empty_route_row (CEPageIP6 *page)
 {
         add_route_row (page, "", NULL, "", NULL);
+        update_row_sensitivity (page, page->routes_list);
+}
+
+static void
+import_routes (CEPageIP6 *page)
+{
+        gchar *text;
+        gchar **lines;
+        guint i;
+
+        text = text_block_dialog_run (page->routes_list,
+                                      _("Import Routes"),
+                                      _("Enter one route per line, as “address/prefix gateway metric” "
+                                        "or “address/prefix via gateway metric N”."));
+        if (text == NULL)
+                return;
+
+        remove_empty_rows (page->routes_list);
+
+        lines = g_strsplit (text, "\n", -1);
+        for (i = 0; lines[i] != NULL; i++) {
+                gchar *address, *prefix, *gateway, *metric;
+
+                if (!ce_page_parse_address_line (lines[i], &address, &prefix, &gateway, &metric))
+                        continue;
+
+                add_route_row (page, address, prefix, gateway ? gateway : "", metric);
+                g_free (address);
+                g_free (prefix);
+                g_free (gateway);
+                g_free (metric);
+        }
+        g_strfreev (lines);
+        g_free (text);
+
+        if (list_is_empty (page->routes_list))
+                add_route_row (page, "", NULL, "", NULL);
+
+        update_row_sensitivity (page, page->routes_list);
+        ce_page_changed (CE_PAGE (page));
 }
 
 static void
@@ -529,7 +831,7 @@ add_routes_section (CEPageIP6 *page)
         gtk_switch_set_active (page->auto_routes, !nm_setting_ip_config_get_ignore_auto_routes (page->setting));
         g_signal_connect (page->auto_routes, "notify::active", G_CALLBACK (switch_toggled), page);
 
-        add_section_toolbar (page, widget, G_CALLBACK (add_empty_route_row));
+        add_section_toolbar (page, widget, G_CALLBACK (add_empty_route_row), G_CALLBACK (import_routes));
 
         for (i = 0; i < nm_setting_ip_config_get_num_routes (page->setting); i++) {
                 NMIPRoute *route;
@@ -546,9 +848,11 @@ add_routes_section (CEPageIP6 *page)
                 g_free (metric);
         }
         if (nm_setting_ip_config_get_num_routes (page->setting) == 0)
-                add_empty_route_row (page);
+                add_route_row (page, "", NULL, "", NULL);
 
         gtk_widget_show_all (widget);
+
+        update_row_sensitivity (page, page->routes_list);
 }
 
 static void
@@ -665,61 +969,25 @@ ui_to_setting (CEPageIP6 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
                 const gchar *text_address;
-                const gchar *text_prefix;
-                const gchar *text_gateway;
-                guint32 prefix;
-                gchar *end;
+                RowCache *cache;
                 NMIPAddress *addr;
-                gboolean have_gateway = FALSE;
-
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
-                        continue;
-
-                text_address = gtk_entry_get_text (entry);
-                text_prefix = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "prefix")));
-                text_gateway = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway")));
 
-                if (!*text_address && !*text_prefix && !*text_gateway) {
-                        /* ignore empty rows */
-                        widget_unset_error (GTK_WIDGET (entry));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "prefix"));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "gateway"));
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
-                }
-
-                if (!text_address || !nm_utils_ipaddr_valid (AF_INET6, text_address)) {
-                        widget_set_error (GTK_WIDGET (entry));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                }
 
-                prefix = strtoul (text_prefix, &end, 10);
-                if (!end || *end || prefix == 0 || prefix > 128) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "prefix"));
+                if (!cache->valid)
                         ret = FALSE;
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "prefix"));
-                }
-
-                if (text_gateway && !nm_utils_ipaddr_valid (AF_INET6, text_gateway)) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                        have_gateway = TRUE;
-                }
-
                 if (!ret)
                         continue;
 
-                addr = nm_ip_address_new (AF_INET6, text_address, prefix, NULL);
-                if (have_gateway)
+                text_address = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address")));
+                addr = nm_ip_address_new (AF_INET6, text_address, cache->prefix, NULL);
+                if (cache->have_gateway)
                         g_object_set (G_OBJECT (page->setting),
-                                      NM_SETTING_IP_CONFIG_GATEWAY, text_gateway,
+                                      NM_SETTING_IP_CONFIG_GATEWAY,
+                                      gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway"))),
                                       NULL);
                 nm_setting_ip_config_add_address (page->setting, addr);
         }
@@ -735,28 +1003,19 @@ ui_to_setting (CEPageIP6 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
-                const gchar *text;
-                struct in6_addr tmp_addr;
+                RowCache *cache;
 
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
 
-                text = gtk_entry_get_text (entry);
-                if (!*text) {
-                        /* ignore empty rows */
-                        widget_unset_error (GTK_WIDGET (entry));
+                if (!cache->valid) {
+                        ret = FALSE;
                         continue;
                 }
 
-                if (inet_pton (AF_INET6, text, &tmp_addr) <= 0) {
-                        widget_set_error (GTK_WIDGET (entry));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                        nm_setting_ip_config_add_dns (page->setting, text);
-                }
+                nm_setting_ip_config_add_dns (page->setting,
+                                              gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"))));
         }
         g_list_free (children);
 
@@ -770,73 +1029,23 @@ ui_to_setting (CEPageIP6 *page)
 
         for (l = children; l; l = l->next) {
                 GtkWidget *row = l->data;
-                GtkEntry *entry;
                 const gchar *text_address;
-                const gchar *text_prefix;
                 const gchar *text_gateway;
-                const gchar *text_metric;
-                guint32 prefix, metric;
-                gchar *end;
+                RowCache *cache;
                 NMIPRoute *route;
 
-                entry = GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address"));
-                if (!entry)
-                        continue;
-
-                text_address = gtk_entry_get_text (entry);
-                text_prefix = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "prefix")));
-                text_gateway = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway")));
-                text_metric = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "metric")));
-
-                if (!*text_address && !*text_prefix && !*text_gateway && !*text_metric) {
-                        /* ignore empty rows */
-                        widget_unset_error (GTK_WIDGET (entry));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "prefix"));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "metric"));
+                cache = g_object_get_data (G_OBJECT (row), "cache");
+                if (cache == NULL || cache->empty)
                         continue;
-                }
-
-                if (!nm_utils_ipaddr_valid (AF_INET6, text_address)) {
-                        widget_set_error (GTK_WIDGET (entry));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (GTK_WIDGET (entry));
-                }
 
-                prefix = strtoul (text_prefix, &end, 10);
-                if (!end || *end || prefix == 0 || prefix > 128) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "prefix"));
+                if (!cache->valid)
                         ret = FALSE;
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "prefix"));
-                }
-
-                if (!nm_utils_ipaddr_valid (AF_INET6, text_gateway)) {
-                        widget_set_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                        ret = FALSE;
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "gateway"));
-                }
-
-                metric = 0;
-                if (*text_metric) {
-                        errno = 0;
-                        metric = strtoul (text_metric, NULL, 10);
-                        if (errno) {
-                                widget_set_error (g_object_get_data (G_OBJECT (row), "metric"));
-                                ret = FALSE;
-                        } else {
-                                widget_unset_error (g_object_get_data (G_OBJECT (row), "metric"));
-                        }
-                } else {
-                        widget_unset_error (g_object_get_data (G_OBJECT (row), "metric"));
-                }
-
                 if (!ret)
                         continue;
 
-                route = nm_ip_route_new (AF_INET6, text_address, prefix, text_gateway, metric, NULL);
+                text_address = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "address")));
+                text_gateway = gtk_entry_get_text (GTK_ENTRY (g_object_get_data (G_OBJECT (row), "gateway")));
+                route = nm_ip_route_new (AF_INET6, text_address, cache->prefix, text_gateway, cache->metric, NULL);
                 nm_setting_ip_config_add_route (page->setting, route);
                 nm_ip_route_unref (route);
         }
@@ -539,3 +539,74 @@ ce_page_get_next_available_name (const GPtrArray *connections,
 
         return cname;
 }
+
+static void
+set_parsed_field (gchar **field, const gchar *value)
+{
+        if (field != NULL)
+                *field = g_strdup (value);
+}
+
+/* Splits one line of a pasted block of addresses or routes. The accepted
+ * forms are "ADDRESS/PREFIX [GATEWAY [METRIC]]", "ADDRESS NETMASK [GATEWAY
+ * [METRIC]]" and the iproute2 style "ADDRESS/PREFIX via GATEWAY metric N".
+ * The fields are returned as-is, they are validated by the page. */
+gboolean
+ce_page_parse_address_line (const gchar  *line,
+                            gchar       **address,
+                            gchar       **prefix,
+                            gchar       **gateway,
+                            gchar       **metric)
+{
+        const gchar *fields[4] = { NULL, NULL, NULL, NULL };
+        GPtrArray *words;
+        gchar **tokens;
+        gchar *slash;
+        guint i, n;
+
+        tokens = g_strsplit_set (line, " \t\r,;", -1);
+        words = g_ptr_array_new ();
+        for (i = 0; tokens[i] != NULL; i++) {
+                if (tokens[i][0] == '#')
+                        break;
+                if (tokens[i][0] != '\0')
+                        g_ptr_array_add (words, tokens[i]);
+        }
+
+        if (words->len == 0) {
+                g_ptr_array_free (words, TRUE);
+                g_strfreev (tokens);
+                return FALSE;
+        }
+
+        for (i = 0, n = 0; i < words->len; i++) {
+                gchar *word = g_ptr_array_index (words, i);
+
+                if ((g_str_equal (word, "via") || g_str_equal (word, "gw")) &&
+                    i + 1 < words->len) {
+                        fields[2] = g_ptr_array_index (words, ++i);
+                } else if (g_str_equal (word, "metric") && i + 1 < words->len) {
+                        fields[3] = g_ptr_array_index (words, ++i);
+                } else {
+                        while (n < G_N_ELEMENTS (fields) && fields[n] != NULL)
+                                n++;
+                        if (n == G_N_ELEMENTS (fields))
+                                continue;
+                        if (n == 0 && (slash = strchr (word, '/')) != NULL) {
+                                *slash = '\0';
+                                fields[1] = slash + 1;
+                        }
+                        fields[n] = word;
+                }
+        }
+
+        set_parsed_field (address, fields[0]);
+        set_parsed_field (prefix, fields[1]);
+        set_parsed_field (gateway, fields[2]);
+        set_parsed_field (metric, fields[3]);
+
+        g_ptr_array_free (words, TRUE);
+        g_strfreev (tokens);
+
+        return TRUE;
+}
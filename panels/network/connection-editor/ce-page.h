@@ -96,6 +96,11 @@ gint         ce_spin_output_with_default (GtkSpinButton *spin,
                                           gpointer       user_data);
 gboolean     ce_page_address_is_valid (const gchar *addr);
 gchar       *ce_page_trim_address (const gchar *addr);
+gboolean     ce_page_parse_address_line (const gchar  *line,
+                                         gchar       **address,
+                                         gchar       **prefix,
+                                         gchar       **gateway,
+                                         gchar       **metric);
 
 typedef enum {
         NAME_FORMAT_TYPE,
@@ -51,6 +51,11 @@ static guint signals[LAST_SIGNAL] = { 0 };
 G_DEFINE_TYPE (NetConnectionEditor, net_connection_editor, G_TYPE_OBJECT)
 
 static void page_changed (CEPage *page, gpointer user_data);
+static void validate (NetConnectionEditor *editor);
+
+/* Delay before re-validating after an edit, so that typing into an entry
+ * does not verify the whole connection on every keystroke */
+#define VALIDATE_TIMEOUT 150 /* ms */
 
 static void
 selection_changed (GtkTreeSelection *selection, NetConnectionEditor *editor)
@@ -141,6 +146,16 @@ added_connection_cb (GObject            *source_object,
 static void
 apply_edits (NetConnectionEditor *editor)
 {
+        GtkWidget *button;
+
+        /* make sure the latest edits made it into the connection */
+        if (editor->validate_id > 0) {
+                validate (editor);
+                button = GTK_WIDGET (gtk_builder_get_object (editor->builder, "details_apply_button"));
+                if (!gtk_widget_get_sensitive (button))
+                        return;
+        }
+
         update_connection (editor);
 
         eap_method_ca_cert_ignore_save (editor->connection);
@@ -211,6 +226,11 @@ net_connection_editor_finalize (GObject *object)
         for (l = editor->pages; l != NULL; l = l->next)
                 g_signal_handlers_disconnect_by_func (l->data, page_changed, editor);
 
+        if (editor->validate_id > 0) {
+                g_source_remove (editor->validate_id);
+                editor->validate_id = 0;
+        }
+
         if (editor->permission_id > 0 && editor->client)
                 g_signal_handler_disconnect (editor->client, editor->permission_id);
         g_clear_object (&editor->connection);
@@ -368,9 +388,16 @@ validate (NetConnectionEditor *editor)
         gboolean valid = FALSE;
         GSList *l;
 
+        if (editor->validate_id > 0) {
+                g_source_remove (editor->validate_id);
+                editor->validate_id = 0;
+        }
+
         if (!editor_is_initialized (editor))
                 goto done;
 
+        /* Every page is verified again, as some depend on the settings
+         * of others, e.g. the security page on the Wi-Fi mode */
         valid = TRUE;
         for (l = editor->pages; l; l = l->next) {
                 GError *error = NULL;
@@ -391,6 +418,17 @@ done:
         gtk_widget_set_sensitive (GTK_WIDGET (gtk_builder_get_object (editor->builder, "details_apply_button")), valid && editor->is_changed);
 }
 
+static gboolean
+validate_timeout_cb (gpointer user_data)
+{
+        NetConnectionEditor *editor = user_data;
+
+        editor->validate_id = 0;
+        validate (editor);
+
+        return G_SOURCE_REMOVE;
+}
+
 static void
 page_changed (CEPage *page, gpointer user_data)
 {
@@ -398,7 +436,10 @@ page_changed (CEPage *page, gpointer user_data)
 
         if (editor_is_initialized (editor))
                 editor->is_changed = TRUE;
-        validate (editor);
+        if (editor->validate_id > 0)
+                g_source_remove (editor->validate_id);
+        editor->validate_id = g_timeout_add (VALIDATE_TIMEOUT, validate_timeout_cb, editor);
+        g_source_set_name_by_id (editor->validate_id, "[gnome-control-center] validate_timeout_cb");
 }
 
 static gboolean
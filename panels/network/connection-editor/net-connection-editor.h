@@ -59,6 +59,8 @@ struct _NetConnectionEditor
         GSList *initializing_pages;
         GSList *pages;
 
+        guint                    validate_id;
+
         guint                    permission_id;
         NMClientPermissionResult can_modify;
 
@@ -19,6 +19,8 @@
 
 #include "config.h"
 
+#include <glib/gi18n.h>
+
 #include "ui-helpers.h"
 
 void
@@ -36,3 +38,57 @@ widget_unset_error (GtkWidget *widget)
 
 	gtk_style_context_remove_class (gtk_widget_get_style_context (widget), "error");
 }
+
+/* Asks for a block of text, one entry per line, and returns it or %NULL
+ * if the dialog was cancelled */
+gchar *
+text_block_dialog_run (GtkWidget   *widget,
+                       const gchar *title,
+                       const gchar *description)
+{
+	GtkWidget *toplevel;
+	GtkWidget *dialog;
+	GtkWidget *content;
+	GtkWidget *label;
+	GtkWidget *scrolled;
+	GtkWidget *view;
+	GtkTextBuffer *buffer;
+	GtkTextIter start, end;
+	gchar *text = NULL;
+
+	toplevel = gtk_widget_get_toplevel (widget);
+	dialog = gtk_dialog_new_with_buttons (title,
+	                                      GTK_IS_WINDOW (toplevel) ? GTK_WINDOW (toplevel) : NULL,
+	                                      GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT | GTK_DIALOG_USE_HEADER_BAR,
+	                                      _("_Cancel"), GTK_RESPONSE_CANCEL,
+	                                      _("_Import"), GTK_RESPONSE_ACCEPT,
+	                                      NULL);
+	gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_ACCEPT);
+	gtk_window_set_default_size (GTK_WINDOW (dialog), 480, 360);
+
+	content = gtk_dialog_get_content_area (GTK_DIALOG (dialog));
+	gtk_container_set_border_width (GTK_CONTAINER (content), 12);
+	gtk_box_set_spacing (GTK_BOX (content), 6);
+
+	label = gtk_label_new (description);
+	gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+	gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+	gtk_box_pack_start (GTK_BOX (content), label, FALSE, FALSE, 0);
+
+	scrolled = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled), GTK_SHADOW_IN);
+	view = gtk_text_view_new ();
+	gtk_text_view_set_monospace (GTK_TEXT_VIEW (view), TRUE);
+	gtk_container_add (GTK_CONTAINER (scrolled), view);
+	gtk_box_pack_start (GTK_BOX (content), scrolled, TRUE, TRUE, 0);
+	gtk_widget_show_all (content);
+
+	if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+		gtk_text_buffer_get_bounds (buffer, &start, &end);
+		text = gtk_text_buffer_get_text (buffer, &start, &end, FALSE);
+	}
+	gtk_widget_destroy (dialog);
+
+	return text;
+}
@@ -24,4 +24,8 @@
 void widget_set_error   (GtkWidget *widget);
 void widget_unset_error (GtkWidget *widget);
 
+gchar *text_block_dialog_run (GtkWidget   *widget,
+                              const gchar *title,
+                              const gchar *description);
+
 #endif  /* _UI_HELPERS_H_ */
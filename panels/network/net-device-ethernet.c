@@ -33,6 +33,7 @@
 #include "connection-editor/ce-page.h"
 
 #include "net-device-ethernet.h"
+#include "net-traffic-graph.h"
 
 G_DEFINE_TYPE (NetDeviceEthernet, net_device_ethernet, NET_TYPE_DEVICE_SIMPLE)
 
@@ -227,6 +228,8 @@ device_ethernet_refresh_ui (NetDeviceEthernet *device)
                 speed = net_device_simple_get_speed (NET_DEVICE_SIMPLE (device));
         panel_set_device_status (device->builder, "label_status", nm_device, speed);
 
+        panel_set_device_traffic_graph (device->traffic_graph, nm_device);
+
         populate_ui (device);
 }
 
@@ -621,6 +624,7 @@ static void
 net_device_ethernet_init (NetDeviceEthernet *device)
 {
         GError *error = NULL;
+        GtkWidget *widget;
 
         device->builder = gtk_builder_new ();
         gtk_builder_add_from_resource (device->builder,
@@ -634,5 +638,14 @@ net_device_ethernet_init (NetDeviceEthernet *device)
 
         device->connections = g_hash_table_new (NULL, NULL);
 
+        device->traffic_graph = net_traffic_graph_new ();
+        gtk_widget_set_margin_top (device->traffic_graph, 12);
+        gtk_widget_set_hexpand (device->traffic_graph, TRUE);
+        widget = GTK_WIDGET (gtk_builder_get_object (device->builder, "grid"));
+        gtk_grid_attach (GTK_GRID (widget), device->traffic_graph, 0, 3, 3, 1);
+        gtk_grid_attach (GTK_GRID (widget),
+                         panel_traffic_graph_latency_button_new (device->traffic_graph),
+                         0, 4, 3, 1);
+
         g_signal_connect (device, "notify::title", G_CALLBACK (device_title_changed), NULL);
 }
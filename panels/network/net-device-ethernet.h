@@ -50,6 +50,7 @@ struct _NetDeviceEthernet
         GtkWidget *details;
         GtkWidget *details_button;
         GtkWidget *add_profile_button;
+        GtkWidget *traffic_graph;
         gboolean   updating_device;
 
         GHashTable *connections;
@@ -30,12 +30,14 @@
 #include "panel-common.h"
 
 #include "net-device-simple.h"
+#include "net-traffic-graph.h"
 
 #define NET_DEVICE_SIMPLE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE_SIMPLE, NetDeviceSimplePrivate))
 
 struct _NetDeviceSimplePrivate
 {
         GtkBuilder *builder;
+        GtkWidget  *traffic_graph;
         gboolean    updating_device;
 };
 
@@ -127,6 +129,8 @@ nm_device_simple_refresh_ui (NetDeviceSimple *device_simple)
 
         /* set IP entries */
         panel_set_device_widgets (priv->builder, nm_device);
+
+        panel_set_device_traffic_graph (priv->traffic_graph, nm_device);
 }
 
 static void
@@ -257,6 +261,15 @@ net_device_simple_init (NetDeviceSimple *device_simple)
                                                      "button_options"));
         g_signal_connect (widget, "clicked",
                           G_CALLBACK (edit_connection), device_simple);
+
+        device_simple->priv->traffic_graph = net_traffic_graph_new ();
+        gtk_widget_set_margin_top (device_simple->priv->traffic_graph, 12);
+        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
+                                                     "vbox6"));
+        gtk_box_pack_start (GTK_BOX (widget), device_simple->priv->traffic_graph, FALSE, TRUE, 0);
+        gtk_box_pack_start (GTK_BOX (widget),
+                            panel_traffic_graph_latency_button_new (device_simple->priv->traffic_graph),
+                            FALSE, TRUE, 0);
 }
 
 char *
@@ -0,0 +1,712 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <glib/gi18n.h>
+#include <gio/gio.h>
+
+#include "net-traffic-graph.h"
+
+#define NET_TRAFFIC_GRAPH_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_TRAFFIC_GRAPH, NetTrafficGraphPrivate))
+
+/* one minute of history at the default rate */
+#define N_SAMPLES               60
+#define DEFAULT_INTERVAL        1000    /* ms */
+#define MIN_INTERVAL            100     /* ms */
+#define MIN_SCALE               1024.0  /* bytes per second */
+#define MIN_PACKET_SCALE        10.0    /* packets per second */
+#define MIN_RTT_SCALE           10.0    /* ms */
+#define GRAPH_HEIGHT            64
+#define RTT_PROBE_PORT          53
+
+typedef struct {
+        guint64 rx_bytes;
+        guint64 tx_bytes;
+        guint64 rx_packets;
+        guint64 tx_packets;
+} TrafficCounters;
+
+typedef struct {
+        gdouble rx_bytes;       /* per second */
+        gdouble tx_bytes;
+        gdouble rx_packets;
+        gdouble tx_packets;
+        gdouble rtt;            /* in ms, negative when unknown */
+} TrafficSample;
+
+struct _NetTrafficGraphPrivate
+{
+        gchar           *iface;
+        gchar           *gateway;
+        gboolean         probe_latency;
+        guint            interval;
+        guint            timeout_id;
+
+        /* ring buffer, head is the next slot to be written */
+        TrafficSample    samples[N_SAMPLES];
+        guint            head;
+        guint            n_samples;
+
+        TrafficCounters  last;
+        gint64           last_time;
+        gboolean         have_last;
+
+        GSocketClient   *socket_client;
+        GCancellable    *rtt_cancellable;
+        gint64           rtt_start;
+        gdouble          rtt;
+};
+
+enum {
+        PROP_0,
+        PROP_INTERFACE,
+        PROP_INTERVAL,
+        PROP_GATEWAY,
+        PROP_PROBE_LATENCY,
+        PROP_LAST
+};
+
+G_DEFINE_TYPE (NetTrafficGraph, net_traffic_graph, GTK_TYPE_DRAWING_AREA)
+
+static gboolean
+read_counter (const gchar *iface,
+              const gchar *name,
+              guint64     *value)
+{
+        gchar *path;
+        gchar *contents = NULL;
+        gboolean ret;
+
+        path = g_build_filename ("/sys/class/net", iface, "statistics", name, NULL);
+        ret = g_file_get_contents (path, &contents, NULL, NULL);
+        if (ret)
+                *value = g_ascii_strtoull (contents, NULL, 10);
+        g_free (contents);
+        g_free (path);
+
+        return ret;
+}
+
+static gboolean
+read_counters (const gchar     *iface,
+               TrafficCounters *counters)
+{
+        return read_counter (iface, "rx_bytes", &counters->rx_bytes) &&
+               read_counter (iface, "tx_bytes", &counters->tx_bytes) &&
+               read_counter (iface, "rx_packets", &counters->rx_packets) &&
+               read_counter (iface, "tx_packets", &counters->tx_packets);
+}
+
+static gdouble
+counter_rate (guint64 now,
+              guint64 before,
+              gdouble seconds)
+{
+        /* the counters are reset when the device goes away */
+        if (now < before)
+                return 0.0;
+        return (now - before) / seconds;
+}
+
+static gboolean
+is_probing (NetTrafficGraphPrivate *priv)
+{
+        return priv->probe_latency && priv->gateway != NULL;
+}
+
+static void
+cancel_rtt_probe (NetTrafficGraph *graph)
+{
+        NetTrafficGraphPrivate *priv = graph->priv;
+
+        if (priv->rtt_cancellable != NULL) {
+                g_cancellable_cancel (priv->rtt_cancellable);
+                g_clear_object (&priv->rtt_cancellable);
+        }
+}
+
+static void
+reset_samples (NetTrafficGraph *graph)
+{
+        NetTrafficGraphPrivate *priv = graph->priv;
+
+        priv->head = 0;
+        priv->n_samples = 0;
+        priv->have_last = FALSE;
+        priv->rtt = -1.0;
+
+        gtk_widget_queue_draw (GTK_WIDGET (graph));
+}
+
+static void
+rtt_probe_done (GObject      *source_object,
+                GAsyncResult *res,
+                gpointer      user_data)
+{
+        NetTrafficGraph *graph;
+        GSocketConnection *connection;
+        GError *error = NULL;
+        gint64 elapsed;
+
+        connection = g_socket_client_connect_finish (G_SOCKET_CLIENT (source_object),
+                                                     res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        graph = NET_TRAFFIC_GRAPH (user_data);
+        elapsed = g_get_monotonic_time () - graph->priv->rtt_start;
+
+        /* a refused connection still needed one round trip to the gateway */
+        if (connection != NULL ||
+            g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CONNECTION_REFUSED))
+                graph->priv->rtt = elapsed / 1000.0;
+        else
+                graph->priv->rtt = -1.0;
+
+        if (connection != NULL) {
+                g_io_stream_close (G_IO_STREAM (connection), NULL, NULL);
+                g_object_unref (connection);
+        }
+        g_clear_error (&error);
+        g_clear_object (&graph->priv->rtt_cancellable);
+}
+
+static void
+start_rtt_probe (NetTrafficGraph *graph)
+{
+        NetTrafficGraphPrivate *priv = graph->priv;
+        GSocketAddress *address;
+
+        /* the previous probe did not come back within one interval */
+        if (priv->rtt_cancellable != NULL) {
+                cancel_rtt_probe (graph);
+                priv->rtt = -1.0;
+        }
+
+        address = g_inet_socket_address_new_from_string (priv->gateway, RTT_PROBE_PORT);
+        if (address == NULL)
+                return;
+
+        if (priv->socket_client == NULL)
+                priv->socket_client = g_socket_client_new ();
+
+        priv->rtt_cancellable = g_cancellable_new ();
+        priv->rtt_start = g_get_monotonic_time ();
+        g_socket_client_connect_async (priv->socket_client,
+                                       G_SOCKET_CONNECTABLE (address),
+                                       priv->rtt_cancellable,
+                                       rtt_probe_done,
+                                       graph);
+        g_object_unref (address);
+}
+
+static gboolean
+sample_cb (gpointer user_data)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (user_data);
+        NetTrafficGraphPrivate *priv = graph->priv;
+        TrafficCounters counters;
+        TrafficSample *sample;
+        gdouble seconds;
+        gint64 now;
+
+        if (!read_counters (priv->iface, &counters)) {
+                priv->have_last = FALSE;
+                return G_SOURCE_CONTINUE;
+        }
+
+        now = g_get_monotonic_time ();
+        if (priv->have_last && now > priv->last_time) {
+                seconds = (gdouble) (now - priv->last_time) / G_USEC_PER_SEC;
+
+                sample = &priv->samples[priv->head];
+                sample->rx_bytes = counter_rate (counters.rx_bytes, priv->last.rx_bytes, seconds);
+                sample->tx_bytes = counter_rate (counters.tx_bytes, priv->last.tx_bytes, seconds);
+                sample->rx_packets = counter_rate (counters.rx_packets, priv->last.rx_packets, seconds);
+                sample->tx_packets = counter_rate (counters.tx_packets, priv->last.tx_packets, seconds);
+                sample->rtt = is_probing (priv) ? priv->rtt : -1.0;
+
+                priv->head = (priv->head + 1) % N_SAMPLES;
+                if (priv->n_samples < N_SAMPLES)
+                        priv->n_samples++;
+
+                gtk_widget_queue_draw (GTK_WIDGET (graph));
+        }
+
+        priv->last = counters;
+        priv->last_time = now;
+        priv->have_last = TRUE;
+
+        if (is_probing (priv))
+                start_rtt_probe (graph);
+
+        return G_SOURCE_CONTINUE;
+}
+
+static void
+stop_sampling (NetTrafficGraph *graph)
+{
+        NetTrafficGraphPrivate *priv = graph->priv;
+
+        if (priv->timeout_id != 0) {
+                g_source_remove (priv->timeout_id);
+                priv->timeout_id = 0;
+        }
+        cancel_rtt_probe (graph);
+
+        /* rates across a pause would be averaged over the hidden period */
+        priv->have_last = FALSE;
+}
+
+static void
+start_sampling (NetTrafficGraph *graph)
+{
+        NetTrafficGraphPrivate *priv = graph->priv;
+
+        stop_sampling (graph);
+
+        /* only sample while somebody can see the result */
+        if (priv->iface == NULL || !gtk_widget_get_mapped (GTK_WIDGET (graph)))
+                return;
+
+        sample_cb (graph);
+        priv->timeout_id = g_timeout_add (priv->interval, sample_cb, graph);
+        g_source_set_name_by_id (priv->timeout_id, "[gnome-control-center] sample_cb");
+}
+
+static gdouble
+get_series_max (NetTrafficGraphPrivate *priv,
+                glong                   offset,
+                gdouble                 min)
+{
+        gdouble max = min;
+        guint i;
+
+        for (i = 0; i < priv->n_samples; i++)
+                max = MAX (max, G_STRUCT_MEMBER (gdouble, &priv->samples[i], offset));
+
+        return max;
+}
+
+/* unknown values, which are negative, leave a gap in the line */
+static void
+draw_sparkline (cairo_t                *cr,
+                NetTrafficGraphPrivate *priv,
+                glong                   offset,
+                gdouble                 scale,
+                gint                    width,
+                gint                    height)
+{
+        gboolean pen_down = FALSE;
+        gdouble step;
+        gdouble value, x;
+        guint i, idx;
+
+        step = (gdouble) width / (N_SAMPLES - 1);
+        for (i = 0; i < priv->n_samples; i++) {
+                idx = (priv->head + N_SAMPLES - priv->n_samples + i) % N_SAMPLES;
+                value = G_STRUCT_MEMBER (gdouble, &priv->samples[idx], offset);
+                if (value < 0.0) {
+                        pen_down = FALSE;
+                        continue;
+                }
+
+                x = width - (priv->n_samples - 1 - i) * step;
+                if (pen_down)
+                        cairo_line_to (cr, x, height - value * scale);
+                else
+                        cairo_move_to (cr, x, height - value * scale);
+                pen_down = TRUE;
+        }
+}
+
+static gchar *
+get_summary_string (const TrafficSample *sample)
+{
+        gchar *rx, *tx, *summary;
+
+        rx = g_format_size ((guint64) sample->rx_bytes);
+        tx = g_format_size ((guint64) sample->tx_bytes);
+        if (sample->rtt >= 0.0) {
+                /* Translators: network throughput (received, sent) followed by the round trip time to the gateway */
+                summary = g_strdup_printf (_("↓ %s/s (%.0f pkt/s)  ↑ %s/s (%.0f pkt/s)  %.1f ms"),
+                                           rx, sample->rx_packets,
+                                           tx, sample->tx_packets,
+                                           sample->rtt);
+        } else {
+                /* Translators: network throughput (received, sent) */
+                summary = g_strdup_printf (_("↓ %s/s (%.0f pkt/s)  ↑ %s/s (%.0f pkt/s)"),
+                                           rx, sample->rx_packets,
+                                           tx, sample->tx_packets);
+        }
+        g_free (rx);
+        g_free (tx);
+
+        return summary;
+}
+
+static gboolean
+net_traffic_graph_draw (GtkWidget *widget,
+                        cairo_t   *cr)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (widget);
+        NetTrafficGraphPrivate *priv = graph->priv;
+        GtkStyleContext *context;
+        PangoLayout *layout;
+        GdkRGBA color;
+        const TrafficSample *latest;
+        static const gdouble packet_dash[] = { 4.0, 2.0 };
+        static const gdouble rtt_dash[] = { 1.0, 2.0 };
+        gdouble max_rate, max_packets;
+        gdouble scale;
+        gchar *summary;
+        gint width, height;
+
+        width = gtk_widget_get_allocated_width (widget);
+        height = gtk_widget_get_allocated_height (widget);
+
+        context = gtk_widget_get_style_context (widget);
+        gtk_render_background (context, cr, 0, 0, width, height);
+        gtk_render_frame (context, cr, 0, 0, width, height);
+
+        if (priv->n_samples == 0)
+                return FALSE;
+
+        max_rate = MAX (get_series_max (priv, G_STRUCT_OFFSET (TrafficSample, rx_bytes), MIN_SCALE),
+                        get_series_max (priv, G_STRUCT_OFFSET (TrafficSample, tx_bytes), MIN_SCALE));
+        /* leave some headroom above the highest peak */
+        scale = (height - 2) / (max_rate * 1.1);
+
+        gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
+        cairo_set_line_width (cr, 1.0);
+        cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
+
+        /* received data, filled */
+        draw_sparkline (cr, priv, G_STRUCT_OFFSET (TrafficSample, rx_bytes), scale, width, height);
+        cairo_set_source_rgba (cr, color.red, color.green, color.blue, color.alpha);
+        cairo_stroke_preserve (cr);
+        cairo_line_to (cr, width, height);
+        cairo_line_to (cr, width - (priv->n_samples - 1) * ((gdouble) width / (N_SAMPLES - 1)), height);
+        cairo_close_path (cr);
+        cairo_set_source_rgba (cr, color.red, color.green, color.blue, color.alpha * 0.2);
+        cairo_fill (cr);
+
+        /* sent data, outline only */
+        draw_sparkline (cr, priv, G_STRUCT_OFFSET (TrafficSample, tx_bytes), scale, width, height);
+        cairo_set_source_rgba (cr, color.red, color.green, color.blue, color.alpha * 0.6);
+        cairo_stroke (cr);
+
+        /* packet rates, dashed, on their own scale */
+        max_packets = MAX (get_series_max (priv, G_STRUCT_OFFSET (TrafficSample, rx_packets), MIN_PACKET_SCALE),
+                           get_series_max (priv, G_STRUCT_OFFSET (TrafficSample, tx_packets), MIN_PACKET_SCALE));
+        scale = (height - 2) / (max_packets * 1.1);
+        cairo_set_dash (cr, packet_dash, G_N_ELEMENTS (packet_dash), 0.0);
+        cairo_set_source_rgba (cr, color.red, color.green, color.blue, color.alpha * 0.4);
+        draw_sparkline (cr, priv, G_STRUCT_OFFSET (TrafficSample, rx_packets), scale, width, height);
+        draw_sparkline (cr, priv, G_STRUCT_OFFSET (TrafficSample, tx_packets), scale, width, height);
+        cairo_stroke (cr);
+
+        /* round trip time, dotted, on its own scale */
+        if (is_probing (priv)) {
+                scale = (height - 2) / (get_series_max (priv, G_STRUCT_OFFSET (TrafficSample, rtt), MIN_RTT_SCALE) * 1.1);
+                cairo_set_dash (cr, rtt_dash, G_N_ELEMENTS (rtt_dash), 0.0);
+                cairo_set_source_rgba (cr, color.red, color.green, color.blue, color.alpha);
+                draw_sparkline (cr, priv, G_STRUCT_OFFSET (TrafficSample, rtt), scale, width, height);
+                cairo_stroke (cr);
+        }
+        cairo_set_dash (cr, NULL, 0, 0.0);
+
+        latest = &priv->samples[(priv->head + N_SAMPLES - 1) % N_SAMPLES];
+        summary = get_summary_string (latest);
+        layout = gtk_widget_create_pango_layout (widget, summary);
+        gtk_render_layout (context, cr, 4, 2, layout);
+        g_object_unref (layout);
+        g_free (summary);
+
+        return FALSE;
+}
+
+static void
+net_traffic_graph_map (GtkWidget *widget)
+{
+        GTK_WIDGET_CLASS (net_traffic_graph_parent_class)->map (widget);
+        start_sampling (NET_TRAFFIC_GRAPH (widget));
+}
+
+static void
+net_traffic_graph_unmap (GtkWidget *widget)
+{
+        stop_sampling (NET_TRAFFIC_GRAPH (widget));
+        GTK_WIDGET_CLASS (net_traffic_graph_parent_class)->unmap (widget);
+}
+
+static void
+net_traffic_graph_set_property (GObject      *object,
+                                guint         prop_id,
+                                const GValue *value,
+                                GParamSpec   *pspec)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (object);
+
+        switch (prop_id) {
+        case PROP_INTERFACE:
+                net_traffic_graph_set_interface (graph, g_value_get_string (value));
+                break;
+        case PROP_INTERVAL:
+                net_traffic_graph_set_interval (graph, g_value_get_uint (value));
+                break;
+        case PROP_GATEWAY:
+                net_traffic_graph_set_gateway (graph, g_value_get_string (value));
+                break;
+        case PROP_PROBE_LATENCY:
+                net_traffic_graph_set_probe_latency (graph, g_value_get_boolean (value));
+                break;
+        default:
+                G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                break;
+        }
+}
+
+static void
+net_traffic_graph_get_property (GObject    *object,
+                                guint       prop_id,
+                                GValue     *value,
+                                GParamSpec *pspec)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (object);
+        NetTrafficGraphPrivate *priv = graph->priv;
+
+        switch (prop_id) {
+        case PROP_INTERFACE:
+                g_value_set_string (value, priv->iface);
+                break;
+        case PROP_INTERVAL:
+                g_value_set_uint (value, priv->interval);
+                break;
+        case PROP_GATEWAY:
+                g_value_set_string (value, priv->gateway);
+                break;
+        case PROP_PROBE_LATENCY:
+                g_value_set_boolean (value, priv->probe_latency);
+                break;
+        default:
+                G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                break;
+        }
+}
+
+static void
+net_traffic_graph_dispose (GObject *object)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (object);
+
+        stop_sampling (graph);
+        g_clear_object (&graph->priv->socket_client);
+
+        G_OBJECT_CLASS (net_traffic_graph_parent_class)->dispose (object);
+}
+
+static void
+net_traffic_graph_finalize (GObject *object)
+{
+        NetTrafficGraph *graph = NET_TRAFFIC_GRAPH (object);
+
+        g_free (graph->priv->iface);
+        g_free (graph->priv->gateway);
+
+        G_OBJECT_CLASS (net_traffic_graph_parent_class)->finalize (object);
+}
+
+static void
+net_traffic_graph_class_init (NetTrafficGraphClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+        GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+        GParamSpec *pspec;
+
+        object_class->get_property = net_traffic_graph_get_property;
+        object_class->set_property = net_traffic_graph_set_property;
+        object_class->dispose = net_traffic_graph_dispose;
+        object_class->finalize = net_traffic_graph_finalize;
+
+        widget_class->draw = net_traffic_graph_draw;
+        widget_class->map = net_traffic_graph_map;
+        widget_class->unmap = net_traffic_graph_unmap;
+
+        pspec = g_param_spec_string ("interface", NULL, NULL,
+                                     NULL,
+                                     G_PARAM_READWRITE);
+        g_object_class_install_property (object_class, PROP_INTERFACE, pspec);
+
+        pspec = g_param_spec_uint ("interval", NULL, NULL,
+                                   MIN_INTERVAL, G_MAXUINT, DEFAULT_INTERVAL,
+                                   G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+        g_object_class_install_property (object_class, PROP_INTERVAL, pspec);
+
+        pspec = g_param_spec_string ("gateway", NULL, NULL,
+                                     NULL,
+                                     G_PARAM_READWRITE);
+        g_object_class_install_property (object_class, PROP_GATEWAY, pspec);
+
+        pspec = g_param_spec_boolean ("probe-latency", NULL, NULL,
+                                      FALSE,
+                                      G_PARAM_READWRITE);
+        g_object_class_install_property (object_class, PROP_PROBE_LATENCY, pspec);
+
+        g_type_class_add_private (klass, sizeof (NetTrafficGraphPrivate));
+}
+
+static void
+net_traffic_graph_init (NetTrafficGraph *graph)
+{
+        graph->priv = NET_TRAFFIC_GRAPH_GET_PRIVATE (graph);
+        graph->priv->interval = DEFAULT_INTERVAL;
+        graph->priv->rtt = -1.0;
+
+        gtk_widget_set_size_request (GTK_WIDGET (graph), -1, GRAPH_HEIGHT);
+        gtk_style_context_add_class (gtk_widget_get_style_context (GTK_WIDGET (graph)),
+                                     GTK_STYLE_CLASS_VIEW);
+}
+
+GtkWidget *
+net_traffic_graph_new (void)
+{
+        return g_object_new (NET_TYPE_TRAFFIC_GRAPH, NULL);
+}
+
+void
+net_traffic_graph_set_interface (NetTrafficGraph *graph,
+                                 const gchar     *iface)
+{
+        NetTrafficGraphPrivate *priv;
+
+        g_return_if_fail (NET_IS_TRAFFIC_GRAPH (graph));
+
+        priv = graph->priv;
+        if (g_strcmp0 (priv->iface, iface) == 0)
+                return;
+
+        g_free (priv->iface);
+        priv->iface = g_strdup (iface);
+        reset_samples (graph);
+        start_sampling (graph);
+
+        g_object_notify (G_OBJECT (graph), "interface");
+}
+
+const gchar *
+net_traffic_graph_get_interface (NetTrafficGraph *graph)
+{
+        g_return_val_if_fail (NET_IS_TRAFFIC_GRAPH (graph), NULL);
+
+        return graph->priv->iface;
+}
+
+void
+net_traffic_graph_set_interval (NetTrafficGraph *graph,
+                                guint            interval)
+{
+        NetTrafficGraphPrivate *priv;
+
+        g_return_if_fail (NET_IS_TRAFFIC_GRAPH (graph));
+
+        priv = graph->priv;
+        interval = MAX (interval, MIN_INTERVAL);
+        if (priv->interval == interval)
+                return;
+
+        priv->interval = interval;
+        reset_samples (graph);
+        start_sampling (graph);
+
+        g_object_notify (G_OBJECT (graph), "interval");
+}
+
+guint
+net_traffic_graph_get_interval (NetTrafficGraph *graph)
+{
+        g_return_val_if_fail (NET_IS_TRAFFIC_GRAPH (graph), 0);
+
+        return graph->priv->interval;
+}
+
+/* The gateway is only contacted once latency probing is turned on, see
+ * net_traffic_graph_set_probe_latency() */
+void
+net_traffic_graph_set_gateway (NetTrafficGraph *graph,
+                               const gchar     *gateway)
+{
+        NetTrafficGraphPrivate *priv;
+
+        g_return_if_fail (NET_IS_TRAFFIC_GRAPH (graph));
+
+        priv = graph->priv;
+        if (g_strcmp0 (priv->gateway, gateway) == 0)
+                return;
+
+        cancel_rtt_probe (graph);
+        g_free (priv->gateway);
+        priv->gateway = g_strdup (gateway);
+        priv->rtt = -1.0;
+
+        g_object_notify (G_OBJECT (graph), "gateway");
+}
+
+const gchar *
+net_traffic_graph_get_gateway (NetTrafficGraph *graph)
+{
+        g_return_val_if_fail (NET_IS_TRAFFIC_GRAPH (graph), NULL);
+
+        return graph->priv->gateway;
+}
+
+/* When enabled, the round trip time to the gateway is sampled along with
+ * the counters by timing a TCP handshake against it. This sends traffic
+ * to the gateway every interval, so it is off unless the user asks */
+void
+net_traffic_graph_set_probe_latency (NetTrafficGraph *graph,
+                                     gboolean         probe_latency)
+{
+        NetTrafficGraphPrivate *priv;
+
+        g_return_if_fail (NET_IS_TRAFFIC_GRAPH (graph));
+
+        priv = graph->priv;
+        probe_latency = !!probe_latency;
+        if (priv->probe_latency == probe_latency)
+                return;
+
+        cancel_rtt_probe (graph);
+        priv->probe_latency = probe_latency;
+        priv->rtt = -1.0;
+        gtk_widget_queue_draw (GTK_WIDGET (graph));
+
+        g_object_notify (G_OBJECT (graph), "probe-latency");
+}
+
+gboolean
+net_traffic_graph_get_probe_latency (NetTrafficGraph *graph)
+{
+        g_return_val_if_fail (NET_IS_TRAFFIC_GRAPH (graph), FALSE);
+
+        return graph->priv->probe_latency;
+}
@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NET_TRAFFIC_GRAPH_H
+#define __NET_TRAFFIC_GRAPH_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define NET_TYPE_TRAFFIC_GRAPH          (net_traffic_graph_get_type ())
+#define NET_TRAFFIC_GRAPH(o)            (G_TYPE_CHECK_INSTANCE_CAST ((o), NET_TYPE_TRAFFIC_GRAPH, NetTrafficGraph))
+#define NET_TRAFFIC_GRAPH_CLASS(k)      (G_TYPE_CHECK_CLASS_CAST((k), NET_TYPE_TRAFFIC_GRAPH, NetTrafficGraphClass))
+#define NET_IS_TRAFFIC_GRAPH(o)         (G_TYPE_CHECK_INSTANCE_TYPE ((o), NET_TYPE_TRAFFIC_GRAPH))
+#define NET_IS_TRAFFIC_GRAPH_CLASS(k)   (G_TYPE_CHECK_CLASS_TYPE ((k), NET_TYPE_TRAFFIC_GRAPH))
+#define NET_TRAFFIC_GRAPH_GET_CLASS(o)  (G_TYPE_INSTANCE_GET_CLASS ((o), NET_TYPE_TRAFFIC_GRAPH, NetTrafficGraphClass))
+
+typedef struct _NetTrafficGraphPrivate   NetTrafficGraphPrivate;
+typedef struct _NetTrafficGraph          NetTrafficGraph;
+typedef struct _NetTrafficGraphClass     NetTrafficGraphClass;
+
+struct _NetTrafficGraph
+{
+        GtkDrawingArea           parent;
+        NetTrafficGraphPrivate  *priv;
+};
+
+struct _NetTrafficGraphClass
+{
+        GtkDrawingAreaClass      parent_class;
+};
+
+GType        net_traffic_graph_get_type         (void);
+GtkWidget   *net_traffic_graph_new              (void);
+
+void         net_traffic_graph_set_interface    (NetTrafficGraph *graph,
+                                                 const gchar     *iface);
+const gchar *net_traffic_graph_get_interface    (NetTrafficGraph *graph);
+void         net_traffic_graph_set_interval     (NetTrafficGraph *graph,
+                                                 guint            interval);
+guint        net_traffic_graph_get_interval     (NetTrafficGraph *graph);
+void         net_traffic_graph_set_gateway      (NetTrafficGraph *graph,
+                                                 const gchar     *gateway);
+const gchar *net_traffic_graph_get_gateway      (NetTrafficGraph *graph);
+void         net_traffic_graph_set_probe_latency (NetTrafficGraph *graph,
+                                                 gboolean         probe_latency);
+gboolean     net_traffic_graph_get_probe_latency (NetTrafficGraph *graph);
+
+G_END_DECLS
+
+#endif /* __NET_TRAFFIC_GRAPH_H */
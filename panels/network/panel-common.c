@@ -28,6 +28,7 @@
 #include <NetworkManager.h>
 
 #include "panel-common.h"
+#include "net-traffic-graph.h"
 
 /**
  * panel_device_to_icon_name:
@@ -658,3 +659,47 @@ panel_unset_device_widgets (GtkBuilder *builder)
         panel_set_device_widget_details (builder, "dns", NULL);
         panel_set_device_widget_details (builder, "route", NULL);
 }
+
+void
+panel_set_device_traffic_graph (GtkWidget *graph, NMDevice *device)
+{
+        NMIPConfig *ip4_config;
+        const gchar *gateway = NULL;
+
+        /* there is nothing to sample unless the device is up */
+        if (nm_device_get_state (device) != NM_DEVICE_STATE_ACTIVATED) {
+                net_traffic_graph_set_interface (NET_TRAFFIC_GRAPH (graph), NULL);
+                gtk_widget_hide (graph);
+                return;
+        }
+
+        ip4_config = nm_device_get_ip4_config (device);
+        if (ip4_config != NULL)
+                gateway = nm_ip_config_get_gateway (ip4_config);
+        if (gateway != NULL && *gateway == '\0')
+                gateway = NULL;
+
+        net_traffic_graph_set_gateway (NET_TRAFFIC_GRAPH (graph), gateway);
+        net_traffic_graph_set_interface (NET_TRAFFIC_GRAPH (graph),
+                                         nm_device_get_ip_iface (device));
+        gtk_widget_show (graph);
+}
+
+/* Measuring the latency sends a packet to the gateway every sample, so
+ * it is left for the user to turn on */
+GtkWidget *
+panel_traffic_graph_latency_button_new (GtkWidget *graph)
+{
+        GtkWidget *button;
+
+        button = gtk_check_button_new_with_mnemonic (_("Measure _latency to the gateway"));
+        gtk_widget_set_halign (button, GTK_ALIGN_START);
+        g_object_bind_property (button, "active",
+                                graph, "probe-latency",
+                                G_BINDING_DEFAULT);
+        g_object_bind_property (graph, "visible",
+                                button, "visible",
+                                G_BINDING_SYNC_CREATE);
+
+        return button;
+}
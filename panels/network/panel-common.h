@@ -46,6 +46,9 @@ gboolean         panel_set_device_widget_header                (GtkBuilder *buil
 void             panel_set_device_widgets                      (GtkBuilder *builder,
                                                                 NMDevice *device);
 void             panel_unset_device_widgets                    (GtkBuilder *builder);
+void             panel_set_device_traffic_graph                (GtkWidget *graph,
+                                                                NMDevice *device);
+GtkWidget       *panel_traffic_graph_latency_button_new        (GtkWidget *graph);
 gchar           *panel_get_ip4_address_as_string               (NMIPConfig *config, const gchar *what);
 gchar           *panel_get_ip4_dns_as_string                   (NMIPConfig *config);
 gchar           *panel_get_ip6_address_as_string               (NMIPConfig *config);
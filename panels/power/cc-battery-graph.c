@@ -0,0 +1,509 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <config.h>
+
+#include <math.h>
+#include <glib/gi18n.h>
+
+#include "cc-battery-graph.h"
+
+#define GRAPH_MARGIN 2
+#define GRID_LINES   4
+#define MAX_TIME_TICKS 6
+
+G_DEFINE_TYPE (CcBatteryGraph, cc_battery_graph, GTK_TYPE_DRAWING_AREA)
+
+#define BATTERY_GRAPH_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((o), CC_TYPE_BATTERY_GRAPH, CcBatteryGraphPrivate))
+
+struct _CcBatteryGraphPrivate
+{
+  GArray       *points;
+  char         *value_format;
+  gdouble       y_max;
+  gdouble       x_min;
+  gdouble       x_max;
+
+  /* The decimated line, only rebuilt when the data or the size change */
+  cairo_path_t *path;
+  gint          path_width;
+  gint          path_height;
+  gdouble       path_y_max;
+  gdouble       path_start;
+  gdouble       path_end;
+};
+
+static void
+clear_path (CcBatteryGraph *graph)
+{
+  g_clear_pointer (&graph->priv->path, cairo_path_destroy);
+}
+
+/* Rounds up to 1, 2 or 5 times a power of ten */
+static gdouble
+nice_ceiling (gdouble value)
+{
+  const gdouble steps[] = { 1.0, 2.0, 5.0, 10.0 };
+  gdouble magnitude;
+  guint i;
+
+  if (value <= 0.0)
+    return 1.0;
+
+  magnitude = pow (10.0, floor (log10 (value)));
+  for (i = 0; i < G_N_ELEMENTS (steps); i++)
+    {
+      if (value <= steps[i] * magnitude)
+        return steps[i] * magnitude;
+    }
+
+  return 10.0 * magnitude;
+}
+
+static gdouble
+get_y_max (CcBatteryGraph *graph)
+{
+  CcBatteryGraphPrivate *priv = graph->priv;
+  gdouble max = 0.0;
+  guint i;
+
+  if (priv->y_max > 0.0)
+    return priv->y_max;
+
+  for (i = 0; i < priv->points->len; i++)
+    max = MAX (max, g_array_index (priv->points, CcBatteryGraphPoint, i).y);
+
+  return nice_ceiling (max);
+}
+
+static gdouble
+value_to_y (gdouble value,
+            gdouble y_max,
+            gint    height)
+{
+  return height - GRAPH_MARGIN - CLAMP (value / y_max, 0.0, 1.0) * (height - 2 * GRAPH_MARGIN);
+}
+
+static void
+line_to (cairo_t *cr,
+         gdouble  x,
+         gdouble  y)
+{
+  if (cairo_has_current_point (cr))
+    cairo_line_to (cr, x, y);
+  else
+    cairo_move_to (cr, x, y);
+}
+
+static gboolean
+has_x_range (CcBatteryGraph *graph)
+{
+  return graph->priv->x_max > graph->priv->x_min;
+}
+
+/* The x axis spans the range set with cc_battery_graph_set_x_range(),
+ * or else from the first to the last sample */
+static void
+get_x_range (CcBatteryGraph *graph,
+             gdouble        *x_min,
+             gdouble        *x_span)
+{
+  CcBatteryGraphPrivate *priv = graph->priv;
+  CcBatteryGraphPoint *first, *last;
+
+  if (has_x_range (graph))
+    {
+      *x_min = priv->x_min;
+      *x_span = priv->x_max - priv->x_min;
+      return;
+    }
+
+  first = &g_array_index (priv->points, CcBatteryGraphPoint, 0);
+  last = &g_array_index (priv->points, CcBatteryGraphPoint, priv->points->len - 1);
+  *x_min = first->x;
+  *x_span = last->x - first->x;
+  if (*x_span <= 0.0)
+    *x_span = 1.0;
+}
+
+/* Samples falling in the same pixel column are reduced to the first,
+ * lowest, highest and last of them, in that order of occurrence, so
+ * that the line keeps its spikes whatever the number of samples */
+static void
+build_path (CcBatteryGraph *graph,
+            cairo_t        *cr,
+            gint            width,
+            gint            height)
+{
+  CcBatteryGraphPrivate *priv = graph->priv;
+  gdouble x_min, x_span, y_max;
+  gdouble col_first = 0, col_min = 0, col_max = 0, col_last = 0;
+  guint min_index = 0, max_index = 0;
+  gint first_column = -1;
+  gint column = -1;
+  guint i;
+
+  get_x_range (graph, &x_min, &x_span);
+  y_max = get_y_max (graph);
+
+  cairo_new_path (cr);
+
+  for (i = 0; i <= priv->points->len; i++)
+    {
+      CcBatteryGraphPoint *point = NULL;
+      gint point_column = -1;
+
+      if (i < priv->points->len)
+        {
+          point = &g_array_index (priv->points, CcBatteryGraphPoint, i);
+          if (point->x < x_min || point->x > x_min + x_span)
+            continue;
+          point_column = (gint) ((point->x - x_min) / x_span * (width - 2 * GRAPH_MARGIN - 1));
+        }
+
+      if (point != NULL && point_column == column)
+        {
+          if (point->y < col_min)
+            {
+              col_min = point->y;
+              min_index = i;
+            }
+          if (point->y > col_max)
+            {
+              col_max = point->y;
+              max_index = i;
+            }
+          col_last = point->y;
+          continue;
+        }
+
+      /* Flush the previous column */
+      if (column >= 0)
+        {
+          gdouble x = GRAPH_MARGIN + column + 0.5;
+
+          line_to (cr, x, value_to_y (col_first, y_max, height));
+          if (min_index < max_index)
+            {
+              line_to (cr, x, value_to_y (col_min, y_max, height));
+              line_to (cr, x, value_to_y (col_max, y_max, height));
+            }
+          else
+            {
+              line_to (cr, x, value_to_y (col_max, y_max, height));
+              line_to (cr, x, value_to_y (col_min, y_max, height));
+            }
+          line_to (cr, x, value_to_y (col_last, y_max, height));
+        }
+
+      if (point == NULL)
+        break;
+
+      if (first_column < 0)
+        first_column = point_column;
+      column = point_column;
+      col_first = col_min = col_max = col_last = point->y;
+      min_index = max_index = i;
+    }
+
+  priv->path = cairo_copy_path (cr);
+  priv->path_width = width;
+  priv->path_height = height;
+  priv->path_y_max = y_max;
+  priv->path_start = GRAPH_MARGIN + MAX (first_column, 0) + 0.5;
+  priv->path_end = GRAPH_MARGIN + MAX (column, 0) + 0.5;
+}
+
+/* Draws @text at (@x, @y), @xalign and @yalign being the point of the
+ * text that goes there, from 0.0 for the left or top to 1.0 */
+static void
+draw_text (GtkWidget  *widget,
+           cairo_t    *cr,
+           const char *text,
+           gdouble     x,
+           gdouble     y,
+           gdouble     xalign,
+           gdouble     yalign)
+{
+  PangoLayout *layout;
+  gint text_width, text_height;
+
+  layout = gtk_widget_create_pango_layout (widget, text);
+  pango_layout_get_pixel_size (layout, &text_width, &text_height);
+
+  cairo_move_to (cr,
+                 floor (x - xalign * text_width),
+                 floor (y - yalign * text_height));
+  pango_cairo_show_layout (cr, layout);
+  g_object_unref (layout);
+}
+
+static gint
+get_text_height (GtkWidget *widget)
+{
+  PangoLayout *layout;
+  gint text_height;
+
+  layout = gtk_widget_create_pango_layout (widget, "0");
+  pango_layout_get_pixel_size (layout, NULL, &text_height);
+  g_object_unref (layout);
+
+  return text_height;
+}
+
+/* Rounds to a duration that gives at most MAX_TIME_TICKS ticks */
+static gdouble
+get_time_step (gdouble span)
+{
+  const gdouble steps[] = { 15 * 60, 30 * 60, 60 * 60, 2 * 60 * 60,
+                            3 * 60 * 60, 6 * 60 * 60, 12 * 60 * 60 };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (steps); i++)
+    {
+      if (span / steps[i] <= MAX_TIME_TICKS)
+        return steps[i];
+    }
+
+  return 24 * 60 * 60;
+}
+
+/* Vertical grid lines on the full hours, or quarters, of the local
+ * time, labelled with that time below the plot */
+static void
+draw_time_axis (CcBatteryGraph *graph,
+                cairo_t        *cr,
+                GdkRGBA        *color,
+                gint            width,
+                gint            plot_height)
+{
+  GtkWidget *widget = GTK_WIDGET (graph);
+  CcBatteryGraphPrivate *priv = graph->priv;
+  GDateTime *now;
+  gdouble offset, step, tick, span;
+
+  span = priv->x_max - priv->x_min;
+  step = get_time_step (span);
+  cairo_set_line_width (cr, 1.0);
+
+  now = g_date_time_new_now_local ();
+  offset = g_date_time_get_utc_offset (now) / (gdouble) G_TIME_SPAN_SECOND;
+  g_date_time_unref (now);
+
+  for (tick = ceil ((priv->x_min + offset) / step) * step - offset;
+       tick <= priv->x_max;
+       tick += step)
+    {
+      GDateTime *time;
+      gdouble x;
+      char *label;
+
+      x = floor (GRAPH_MARGIN + (tick - priv->x_min) / span * (width - 2 * GRAPH_MARGIN - 1)) + 0.5;
+
+      cairo_set_source_rgba (cr, color->red, color->green, color->blue, 0.15);
+      cairo_move_to (cr, x, GRAPH_MARGIN);
+      cairo_line_to (cr, x, plot_height - GRAPH_MARGIN);
+      cairo_stroke (cr);
+
+      time = g_date_time_new_from_unix_local ((gint64) tick);
+      /* TRANSLATORS: the time of day under the battery history graphs,
+       * see the GLib documentation of g_date_time_format() */
+      label = g_date_time_format (time, _("%R"));
+      g_date_time_unref (time);
+
+      cairo_set_source_rgba (cr, color->red, color->green, color->blue, 0.6);
+      draw_text (widget, cr, label,
+                 CLAMP (x, GRAPH_MARGIN + 12, width - GRAPH_MARGIN - 12),
+                 plot_height, 0.5, 0.0);
+      g_free (label);
+    }
+}
+
+static gboolean
+cc_battery_graph_draw (GtkWidget *widget,
+                       cairo_t   *cr)
+{
+  CcBatteryGraph *graph = CC_BATTERY_GRAPH (widget);
+  CcBatteryGraphPrivate *priv = graph->priv;
+  GtkStyleContext *context;
+  GdkRGBA color;
+  gint width, height;
+  char *label;
+  gint i;
+
+  width = gtk_widget_get_allocated_width (widget);
+  height = gtk_widget_get_allocated_height (widget);
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
+
+  /* The time labels go below the plot */
+  if (has_x_range (graph))
+    {
+      height -= get_text_height (widget);
+      if (height <= 2 * GRAPH_MARGIN + 1 || width <= 2 * GRAPH_MARGIN + 1)
+        return FALSE;
+      draw_time_axis (graph, cr, &color, width, height);
+    }
+
+  /* Grid */
+  cairo_set_line_width (cr, 1.0);
+  cairo_set_source_rgba (cr, color.red, color.green, color.blue, 0.15);
+  for (i = 0; i <= GRID_LINES; i++)
+    {
+      gdouble y = floor (value_to_y (i, GRID_LINES, height)) + 0.5;
+
+      cairo_move_to (cr, GRAPH_MARGIN, y);
+      cairo_line_to (cr, width - GRAPH_MARGIN, y);
+    }
+  cairo_stroke (cr);
+
+  if (priv->points->len < 2)
+    {
+      cairo_set_source_rgba (cr, color.red, color.green, color.blue, 0.6);
+      draw_text (widget, cr, _("No data"), width / 2.0, height / 2.0, 0.5, 0.5);
+      return FALSE;
+    }
+
+  if (width <= 2 * GRAPH_MARGIN + 1)
+    return FALSE;
+
+  if (priv->path == NULL ||
+      priv->path_width != width ||
+      priv->path_height != height)
+    {
+      clear_path (graph);
+      build_path (graph, cr, width, height);
+    }
+
+  /* Area under the line */
+  cairo_new_path (cr);
+  cairo_append_path (cr, priv->path);
+  cairo_line_to (cr, priv->path_end, height - GRAPH_MARGIN);
+  cairo_line_to (cr, priv->path_start, height - GRAPH_MARGIN);
+  cairo_close_path (cr);
+  cairo_set_source_rgba (cr, color.red, color.green, color.blue, 0.15);
+  cairo_fill (cr);
+
+  cairo_append_path (cr, priv->path);
+  cairo_set_line_width (cr, 1.5);
+  cairo_set_line_join (cr, CAIRO_LINE_JOIN_ROUND);
+  cairo_set_source_rgba (cr, color.red, color.green, color.blue, 0.8);
+  cairo_stroke (cr);
+
+  /* Scale */
+  label = g_strdup_printf (priv->value_format, priv->path_y_max);
+  cairo_set_source_rgba (cr, color.red, color.green, color.blue, 0.6);
+  draw_text (widget, cr, label, GRAPH_MARGIN + 4, GRAPH_MARGIN, 0.0, 0.0);
+  g_free (label);
+
+  return FALSE;
+}
+
+static void
+cc_battery_graph_finalize (GObject *object)
+{
+  CcBatteryGraph *graph = CC_BATTERY_GRAPH (object);
+
+  clear_path (graph);
+  g_array_unref (graph->priv->points);
+  g_free (graph->priv->value_format);
+
+  G_OBJECT_CLASS (cc_battery_graph_parent_class)->finalize (object);
+}
+
+static void
+cc_battery_graph_class_init (CcBatteryGraphClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (CcBatteryGraphPrivate));
+
+  object_class->finalize = cc_battery_graph_finalize;
+  widget_class->draw = cc_battery_graph_draw;
+}
+
+static void
+cc_battery_graph_init (CcBatteryGraph *graph)
+{
+  graph->priv = BATTERY_GRAPH_PRIVATE (graph);
+  graph->priv->points = g_array_new (FALSE, FALSE, sizeof (CcBatteryGraphPoint));
+}
+
+/**
+ * cc_battery_graph_new:
+ * @value_format: a printf() format for the top of the scale
+ * @y_max: the top of the scale, or 0 to follow the data
+ */
+GtkWidget *
+cc_battery_graph_new (const char *value_format,
+                      gdouble     y_max)
+{
+  CcBatteryGraph *graph;
+
+  graph = g_object_new (CC_TYPE_BATTERY_GRAPH, NULL);
+  graph->priv->value_format = g_strdup (value_format);
+  graph->priv->y_max = y_max;
+
+  return GTK_WIDGET (graph);
+}
+
+/**
+ * cc_battery_graph_set_points:
+ * @points: (allow-none): #CcBatteryGraphPoint values, sorted by x
+ */
+void
+cc_battery_graph_set_points (CcBatteryGraph *graph,
+                             GArray         *points)
+{
+  CcBatteryGraphPrivate *priv = graph->priv;
+
+  g_array_unref (priv->points);
+  if (points != NULL)
+    priv->points = g_array_ref (points);
+  else
+    priv->points = g_array_new (FALSE, FALSE, sizeof (CcBatteryGraphPoint));
+
+  clear_path (graph);
+  gtk_widget_queue_draw (GTK_WIDGET (graph));
+}
+
+/**
+ * cc_battery_graph_set_x_range:
+ * @x_min: the time at the left of the graph, in seconds since the epoch
+ * @x_max: the time at the right, or @x_min to follow the data
+ *
+ * Fixes the time window shown, and labels it with the time of day.
+ */
+void
+cc_battery_graph_set_x_range (CcBatteryGraph *graph,
+                              gdouble         x_min,
+                              gdouble         x_max)
+{
+  CcBatteryGraphPrivate *priv = graph->priv;
+
+  if (priv->x_min == x_min && priv->x_max == x_max)
+    return;
+
+  priv->x_min = x_min;
+  priv->x_max = x_max;
+
+  clear_path (graph);
+  gtk_widget_queue_draw (GTK_WIDGET (graph));
+}
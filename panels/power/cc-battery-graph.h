@@ -0,0 +1,83 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*-
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef _CC_BATTERY_GRAPH_H
+#define _CC_BATTERY_GRAPH_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define CC_TYPE_BATTERY_GRAPH cc_battery_graph_get_type()
+
+#define CC_BATTERY_GRAPH(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+  CC_TYPE_BATTERY_GRAPH, CcBatteryGraph))
+
+#define CC_BATTERY_GRAPH_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+  CC_TYPE_BATTERY_GRAPH, CcBatteryGraphClass))
+
+#define CC_IS_BATTERY_GRAPH(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+  CC_TYPE_BATTERY_GRAPH))
+
+#define CC_IS_BATTERY_GRAPH_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+  CC_TYPE_BATTERY_GRAPH))
+
+#define CC_BATTERY_GRAPH_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+  CC_TYPE_BATTERY_GRAPH, CcBatteryGraphClass))
+
+typedef struct _CcBatteryGraph CcBatteryGraph;
+typedef struct _CcBatteryGraphClass CcBatteryGraphClass;
+typedef struct _CcBatteryGraphPrivate CcBatteryGraphPrivate;
+
+struct _CcBatteryGraph
+{
+  GtkDrawingArea parent;
+
+  CcBatteryGraphPrivate *priv;
+};
+
+struct _CcBatteryGraphClass
+{
+  GtkDrawingAreaClass parent_class;
+};
+
+typedef struct
+{
+  gdouble x;
+  gdouble y;
+} CcBatteryGraphPoint;
+
+GType      cc_battery_graph_get_type     (void) G_GNUC_CONST;
+
+GtkWidget *cc_battery_graph_new          (const char     *value_format,
+                                          gdouble         y_max);
+
+void       cc_battery_graph_set_points   (CcBatteryGraph *graph,
+                                          GArray         *points);
+
+void       cc_battery_graph_set_x_range  (CcBatteryGraph *graph,
+                                          gdouble         x_min,
+                                          gdouble         x_max);
+
+G_END_DECLS
+
+#endif /* _CC_BATTERY_GRAPH_H */
@@ -30,6 +30,7 @@
 #endif
 
 #include "shell/list-box-helper.h"
+#include "cc-battery-graph.h"
 #include "cc-power-panel.h"
 #include "cc-power-resources.h"
 
@@ -47,6 +48,19 @@
 
 #define WID(b, w) (GtkWidget *) gtk_builder_get_object (b, w)
 
+/* How often the battery and device rows are refreshed, at most */
+#define DEVICE_UPDATE_INTERVAL 250 /* ms */
+
+/* The battery history covers the last day; the graphs reduce the
+ * samples further to their width */
+#define HISTORY_TIMESPAN   (24 * 60 * 60) /* s */
+#define HISTORY_RESOLUTION 500
+#define HISTORY_REFRESH_INTERVAL 60 /* s */
+
+/* Minimum number of discharging samples in the power draw history
+ * before the typical runtime is estimated from them */
+#define RUNTIME_MIN_SAMPLES 10
+
 CC_PANEL_REGISTER (CcPowerPanel, cc_power_panel)
 
 #define POWER_PANEL_PRIVATE(o) \
@@ -61,6 +75,11 @@ struct _CcPowerPanelPrivate
   GtkWidget     *automatic_suspend_dialog;
   UpClient      *up_client;
   GPtrArray     *devices;
+  UpDevice      *composite;
+  GHashTable    *device_rows;
+  GHashTable    *dirty_rows;
+  gboolean       rebuild_rows;
+  guint          device_update_id;
   GDBusProxy    *screen_proxy;
   GDBusProxy    *kbd_proxy;
   gboolean       has_batteries;
@@ -78,6 +97,15 @@ struct _CcPowerPanelPrivate
   GtkWidget     *battery_section;
   GtkWidget     *battery_list;
 
+  GtkWidget     *history_expander;
+  GtkWidget     *charge_graph;
+  GtkWidget     *rate_graph;
+  GtkWidget     *runtime_label;
+  char          *history_path;
+  gdouble        history_energy_full;
+  GCancellable  *history_cancellable;
+  guint          history_refresh_id;
+
   GtkWidget     *device_heading;
   GtkWidget     *device_section;
   GtkWidget     *device_list;
@@ -134,15 +162,42 @@ cc_power_panel_dispose (GObject *object)
       g_object_unref (priv->cancellable);
       priv->cancellable = NULL;
     }
+  if (priv->history_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->history_cancellable);
+      g_clear_object (&priv->history_cancellable);
+    }
+  if (priv->history_refresh_id != 0)
+    {
+      g_source_remove (priv->history_refresh_id);
+      priv->history_refresh_id = 0;
+    }
+  g_clear_pointer (&priv->history_path, g_free);
   g_clear_pointer (&priv->automatic_suspend_dialog, gtk_widget_destroy);
   g_clear_object (&priv->builder);
   g_clear_object (&priv->screen_proxy);
   g_clear_object (&priv->kbd_proxy);
+  if (priv->device_update_id != 0)
+    {
+      g_source_remove (priv->device_update_id);
+      priv->device_update_id = 0;
+    }
   if (priv->devices)
     {
+      guint i;
+
+      for (i = 0; i < priv->devices->len; i++)
+        g_signal_handlers_disconnect_by_data (g_ptr_array_index (priv->devices, i), object);
       g_ptr_array_foreach (priv->devices, (GFunc) g_object_unref, NULL);
       g_clear_pointer (&priv->devices, g_ptr_array_unref);
     }
+  if (priv->composite)
+    {
+      g_signal_handlers_disconnect_by_data (priv->composite, object);
+      g_clear_object (&priv->composite);
+    }
+  g_clear_pointer (&priv->device_rows, g_hash_table_destroy);
+  g_clear_pointer (&priv->dirty_rows, g_hash_table_destroy);
   g_clear_object (&priv->up_client);
   g_clear_object (&priv->bt_rfkill);
   g_clear_object (&priv->bt_properties);
@@ -359,25 +414,20 @@ get_details_string (gdouble percentage, UpDeviceState state, guint64 time)
 }
 
 static void
-set_primary (CcPowerPanel *panel, UpDevice *device)
+update_primary_row (GtkWidget *row,
+                    UpDevice  *device)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
   gchar *details = NULL;
   gdouble percentage;
   guint64 time_empty, time_full, time;
   UpDeviceState state;
-  GtkWidget *box, *box2, *label;
-  GtkWidget *levelbar, *row;
   gchar *s;
-  gdouble energy_full, energy_rate;
 
   g_object_get (device,
                 "state", &state,
                 "percentage", &percentage,
                 "time-to-empty", &time_empty,
                 "time-to-full", &time_full,
-                "energy-full", &energy_full,
-                "energy-rate", &energy_rate,
                 NULL);
   if (state == UP_DEVICE_STATE_DISCHARGING)
     time = time_empty;
@@ -390,6 +440,22 @@ set_primary (CcPowerPanel *panel, UpDevice *device)
     percentage = 100.0;
 
   details = get_details_string (percentage, state, time);
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "details-label"), details);
+  g_free (details);
+
+  gtk_level_bar_set_value (g_object_get_data (G_OBJECT (row), "levelbar"), percentage / 100.0);
+
+  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "percentage-label"), s);
+  g_free (s);
+}
+
+static GtkWidget *
+set_primary (CcPowerPanel *panel, UpDevice *device)
+{
+  CcPowerPanelPrivate *priv = panel->priv;
+  GtkWidget *box, *box2, *label;
+  GtkWidget *levelbar, *row;
 
   row = no_prelight_row_new ();
   box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
@@ -401,63 +467,92 @@ set_primary (CcPowerPanel *panel, UpDevice *device)
   gtk_widget_set_margin_bottom (box, 6);
 
   levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
   gtk_widget_set_hexpand (levelbar, TRUE);
   gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
   gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
   gtk_box_pack_start (GTK_BOX (box), levelbar, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", levelbar);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 50);
   gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
 
-  label = gtk_label_new (details);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_START);
   gtk_box_pack_start (GTK_BOX (box2), label, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "details-label", label);
 
-  s = g_strdup_printf ("%d%%", (int)(percentage + 0.5));
-  label = gtk_label_new (s);
-  g_free (s);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "percentage-label", label);
 
   atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
                                ATK_RELATION_LABELLED_BY,
                                gtk_widget_get_accessible (label));
 
+  update_primary_row (row, device);
+
   gtk_container_add (GTK_CONTAINER (priv->battery_list), row);
   gtk_size_group_add_widget (priv->row_sizegroup, row);
   gtk_widget_show_all (row);
 
   g_object_set_data (G_OBJECT (row), "primary", GINT_TO_POINTER (TRUE));
-
-  g_free (details);
+  g_object_set_data (G_OBJECT (row), "update-func", (gpointer) update_primary_row);
 
   gtk_widget_set_visible (priv->battery_section, TRUE);
+
+  return row;
 }
 
 static void
+update_battery_row (GtkWidget *row,
+                    UpDevice  *device)
+{
+  GtkWidget *icon;
+  gdouble percentage;
+  gchar *icon_name;
+  gchar *s;
+
+  g_object_get (device,
+                "percentage", &percentage,
+                "icon-name", &icon_name,
+                NULL);
+
+  icon = g_object_get_data (G_OBJECT (row), "icon");
+  if (icon_name != NULL && *icon_name != '\0')
+    {
+      gtk_image_set_from_icon_name (GTK_IMAGE (icon), icon_name, GTK_ICON_SIZE_BUTTON);
+      gtk_widget_show (icon);
+    }
+  else
+    {
+      gtk_widget_hide (icon);
+    }
+  g_free (icon_name);
+
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "percentage-label"), s);
+  g_free (s);
+
+  gtk_level_bar_set_value (g_object_get_data (G_OBJECT (row), "levelbar"), percentage / 100.0);
+}
+
+static GtkWidget *
 add_battery (CcPowerPanel *panel, UpDevice *device)
 {
   CcPowerPanelPrivate *priv = panel->priv;
-  gdouble percentage;
   UpDeviceKind kind;
-  UpDeviceState state;
   GtkWidget *row;
   GtkWidget *box;
   GtkWidget *box2;
   GtkWidget *label;
   GtkWidget *levelbar;
   GtkWidget *widget;
-  gchar *s;
-  gchar *icon_name;
   const gchar *name;
 
   g_object_get (device,
                 "kind", &kind,
-                "state", &state,
-                "percentage", &percentage,
-                "icon-name", &icon_name,
                 NULL);
 
   if (g_object_get_data (G_OBJECT (device), "is-main-battery") != NULL)
@@ -480,51 +575,49 @@ add_battery (CcPowerPanel *panel, UpDevice *device)
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
   gtk_box_pack_start (GTK_BOX (box), box2, FALSE, TRUE, 0);
 
-#if 1
-  if (icon_name != NULL && *icon_name != '\0')
-    {
-      widget = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_BUTTON);
-      gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
-      gtk_widget_set_halign (widget, GTK_ALIGN_END);
-      gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-      gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
-    }
-#endif
+  widget = gtk_image_new ();
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_widget_set_halign (widget, GTK_ALIGN_END);
+  gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
+  gtk_widget_set_no_show_all (widget, TRUE);
+  gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "icon", widget);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
   gtk_widget_set_margin_start (box2, 20);
   gtk_widget_set_margin_end (box2, 20);
 
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  label = gtk_label_new (s);
-  g_free (s);
+  label = gtk_label_new (NULL);
   gtk_widget_set_halign (label, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (label), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), label, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->charge_sizegroup, label);
+  g_object_set_data (G_OBJECT (row), "percentage-label", label);
 
   levelbar = gtk_level_bar_new ();
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (levelbar), percentage / 100.0);
   gtk_widget_set_hexpand (levelbar, TRUE);
   gtk_widget_set_halign (levelbar, GTK_ALIGN_FILL);
   gtk_widget_set_valign (levelbar, GTK_ALIGN_CENTER);
   gtk_box_pack_start (GTK_BOX (box2), levelbar, TRUE, TRUE, 0);
   gtk_size_group_add_widget (priv->level_sizegroup, levelbar);
   gtk_box_pack_start (GTK_BOX (box), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", levelbar);
 
   atk_object_add_relationship (gtk_widget_get_accessible (levelbar),
                                ATK_RELATION_LABELLED_BY,
                                gtk_widget_get_accessible (label));
 
+  update_battery_row (row, device);
 
   g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
+  g_object_set_data (G_OBJECT (row), "update-func", (gpointer) update_battery_row);
   gtk_container_add (GTK_CONTAINER (priv->battery_list), row);
   gtk_size_group_add_widget (priv->row_sizegroup, row);
   gtk_widget_show_all (row);
 
-  g_free (icon_name);
-
   gtk_widget_set_visible (priv->battery_section, TRUE);
+
+  return row;
 }
 
 static const char *
@@ -565,87 +658,53 @@ kind_to_description (UpDeviceKind kind)
 }
 
 static void
-add_device (CcPowerPanel *panel, UpDevice *device)
+update_device_row (GtkWidget *row,
+                   UpDevice  *device)
 {
-  CcPowerPanelPrivate *priv = panel->priv;
   UpDeviceKind kind;
-  UpDeviceState state;
-  GtkWidget *row;
-  GtkWidget *hbox;
-  GtkWidget *box2;
-  GtkWidget *widget;
-  GString *status;
-  GString *description;
   gdouble percentage;
   gchar *name;
   gchar *s;
-  gboolean show_caution = FALSE;
-  gboolean is_present;
 
   name = NULL;
   g_object_get (device,
                 "kind", &kind,
                 "percentage", &percentage,
-                "state", &state,
                 "model", &name,
-                "is-present", &is_present,
                 NULL);
 
-  if (!is_present)
-    {
-      g_free (name);
-      return;
-    }
-
-  if (kind == UP_DEVICE_KIND_UPS)
-    show_caution = TRUE;
-
   if (name == NULL || *name == '\0')
-    description = g_string_new (_(kind_to_description (kind)));
+    gtk_label_set_markup (g_object_get_data (G_OBJECT (row), "description-label"),
+                          _(kind_to_description (kind)));
   else
-    description = g_string_new (name);
-
+    gtk_label_set_markup (g_object_get_data (G_OBJECT (row), "description-label"), name);
   g_free (name);
 
-  switch (state)
-    {
-      case UP_DEVICE_STATE_CHARGING:
-      case UP_DEVICE_STATE_PENDING_CHARGE:
-        /* TRANSLATORS: secondary battery */
-        status = g_string_new(C_("Battery power", "Charging"));
-        break;
-      case UP_DEVICE_STATE_DISCHARGING:
-      case UP_DEVICE_STATE_PENDING_DISCHARGE:
-        if (percentage < 10 && show_caution)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Caution"));
-          }
-        else if (percentage < 30)
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Low"));
-          }
-        else
-          {
-            /* TRANSLATORS: secondary battery */
-            status = g_string_new (C_("Battery power", "Good"));
-          }
-        break;
-      case UP_DEVICE_STATE_FULLY_CHARGED:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Fully charged"));
-        break;
-      case UP_DEVICE_STATE_EMPTY:
-        /* TRANSLATORS: primary battery */
-        status = g_string_new (C_("Battery power", "Empty"));
-        break;
-      default:
-        status = g_string_new (up_device_state_to_string (state));
-        break;
-    }
-  g_string_prepend (status, "<small>");
-  g_string_append (status, "</small>");
+  s = g_strdup_printf ("%d%%", (int)percentage);
+  gtk_label_set_text (g_object_get_data (G_OBJECT (row), "percentage-label"), s);
+  g_free (s);
+
+  gtk_level_bar_set_value (g_object_get_data (G_OBJECT (row), "levelbar"), percentage / 100.0f);
+}
+
+static GtkWidget *
+add_device (CcPowerPanel *panel, UpDevice *device)
+{
+  CcPowerPanelPrivate *priv = panel->priv;
+  UpDeviceKind kind;
+  GtkWidget *row;
+  GtkWidget *hbox;
+  GtkWidget *box2;
+  GtkWidget *widget;
+  gboolean is_present;
+
+  g_object_get (device,
+                "kind", &kind,
+                "is-present", &is_present,
+                NULL);
+
+  if (!is_present)
+    return NULL;
 
   /* create the new widget */
   row = no_prelight_row_new ();
@@ -653,49 +712,345 @@ add_device (CcPowerPanel *panel, UpDevice *device)
   gtk_container_add (GTK_CONTAINER (row), hbox);
   widget = gtk_label_new ("");
   gtk_widget_set_halign (widget, GTK_ALIGN_START);
-  gtk_label_set_markup (GTK_LABEL (widget), description->str);
   gtk_widget_set_margin_start (widget, 20);
   gtk_widget_set_margin_end (widget, 20);
   gtk_widget_set_margin_top (widget, 6);
   gtk_widget_set_margin_bottom (widget, 6);
   gtk_box_pack_start (GTK_BOX (hbox), widget, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->battery_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "description-label", widget);
 
   box2 = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 12);
   gtk_widget_set_margin_start (box2, 20);
   gtk_widget_set_margin_end (box2, 20);
-  s = g_strdup_printf ("%d%%", (int)percentage);
-  widget = gtk_label_new (s);
-  g_free (s);
+  widget = gtk_label_new (NULL);
   gtk_widget_set_halign (widget, GTK_ALIGN_END);
   gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
   gtk_box_pack_start (GTK_BOX (box2), widget, FALSE, TRUE, 0);
   gtk_size_group_add_widget (priv->charge_sizegroup, widget);
+  g_object_set_data (G_OBJECT (row), "percentage-label", widget);
 
   widget = gtk_level_bar_new ();
   gtk_widget_set_halign (widget, TRUE);
   gtk_widget_set_halign (widget, GTK_ALIGN_FILL);
   gtk_widget_set_valign (widget, GTK_ALIGN_CENTER);
-  gtk_level_bar_set_value (GTK_LEVEL_BAR (widget), percentage / 100.0f);
   gtk_box_pack_start (GTK_BOX (box2), widget, TRUE, TRUE, 0);
   gtk_size_group_add_widget (priv->level_sizegroup, widget);
   gtk_box_pack_start (GTK_BOX (hbox), box2, TRUE, TRUE, 0);
+  g_object_set_data (G_OBJECT (row), "levelbar", widget);
+
+  update_device_row (row, device);
   gtk_widget_show_all (row);
 
   gtk_container_add (GTK_CONTAINER (priv->device_list), row);
   gtk_size_group_add_widget (priv->row_sizegroup, row);
   g_object_set_data (G_OBJECT (row), "kind", GINT_TO_POINTER (kind));
-
-  g_string_free (description, TRUE);
-  g_string_free (status, TRUE);
+  g_object_set_data (G_OBJECT (row), "update-func", (gpointer) update_device_row);
 
   gtk_widget_set_visible (priv->device_section, TRUE);
+
+  return row;
+}
+
+static gint
+compare_points (gconstpointer a,
+                gconstpointer b)
+{
+  const CcBatteryGraphPoint *pa = a;
+  const CcBatteryGraphPoint *pb = b;
+
+  if (pa->x < pb->x)
+    return -1;
+  return pa->x > pb->x;
+}
+
+/* If @discharging is not %NULL, it is set to the samples taken while
+ * discharging, which are also part of the returned points */
+static GArray *
+get_history_finish (GObject       *source_object,
+                    GAsyncResult  *res,
+                    GArray       **discharging,
+                    GError       **error)
+{
+  GVariant *result;
+  GVariantIter *iter;
+  GArray *points;
+  guint32 time, state;
+  gdouble value;
+
+  result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, error);
+  if (result == NULL)
+    return NULL;
+
+  points = g_array_new (FALSE, FALSE, sizeof (CcBatteryGraphPoint));
+  if (discharging != NULL)
+    *discharging = g_array_new (FALSE, FALSE, sizeof (CcBatteryGraphPoint));
+  g_variant_get (result, "(a(udu))", &iter);
+  while (g_variant_iter_next (iter, "(udu)", &time, &value, &state))
+    {
+      CcBatteryGraphPoint point;
+
+      if (state == UP_DEVICE_STATE_UNKNOWN)
+        continue;
+
+      point.x = time;
+      point.y = value;
+      g_array_append_val (points, point);
+      if (discharging != NULL && state == UP_DEVICE_STATE_DISCHARGING)
+        g_array_append_val (*discharging, point);
+    }
+  g_variant_iter_free (iter);
+  g_variant_unref (result);
+
+  g_array_sort (points, compare_points);
+
+  return points;
 }
 
+/* The graphs show the whole timespan up to now, however much of it
+ * the history covers */
 static void
-up_client_changed (UpClient     *client,
-                   UpDevice     *device,
-                   CcPowerPanel *self)
+set_history_points (GtkWidget *graph,
+                    GArray    *points)
+{
+  gdouble now;
+
+  now = g_get_real_time () / (gdouble) G_USEC_PER_SEC;
+  cc_battery_graph_set_x_range (CC_BATTERY_GRAPH (graph), now - HISTORY_TIMESPAN, now);
+  cc_battery_graph_set_points (CC_BATTERY_GRAPH (graph), points);
+}
+
+static void
+got_charge_history_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GError *error = NULL;
+  GArray *points;
+  CcPowerPanel *self;
+
+  points = get_history_finish (source_object, res, NULL, &error);
+  if (points == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error getting charge history: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self = CC_POWER_PANEL (user_data);
+  set_history_points (self->priv->charge_graph, points);
+  g_array_unref (points);
+}
+
+/* The typical runtime is the full energy of the battery over its mean
+ * power draw while discharging */
+static void
+update_runtime_label (CcPowerPanel *self,
+                      GArray       *discharging)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+  gdouble total = 0.0;
+  guint n_samples = 0;
+  guint i;
+  gchar *time_string, *s;
+
+  for (i = 0; i < discharging->len; i++)
+    {
+      const CcBatteryGraphPoint *point;
+
+      point = &g_array_index (discharging, CcBatteryGraphPoint, i);
+      if (point->y <= 0.0)
+        continue;
+      total += point->y;
+      n_samples++;
+    }
+
+  if (n_samples < RUNTIME_MIN_SAMPLES || priv->history_energy_full <= 0.0)
+    {
+      gtk_widget_hide (priv->runtime_label);
+      return;
+    }
+
+  /* Wh over W */
+  time_string = get_timestring ((guint64) (priv->history_energy_full * 3600.0 * n_samples / total));
+  /* TRANSLATORS: %s is a duration, e.g. "5 hours 12 minutes" */
+  s = g_strdup_printf (_("Typical runtime on a full charge: %s"), time_string);
+  gtk_label_set_text (GTK_LABEL (priv->runtime_label), s);
+  gtk_widget_show (priv->runtime_label);
+  g_free (time_string);
+  g_free (s);
+}
+
+static void
+got_rate_history_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GError *error = NULL;
+  GArray *points;
+  GArray *discharging;
+  CcPowerPanel *self;
+
+  points = get_history_finish (source_object, res, &discharging, &error);
+  if (points == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error getting power draw history: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self = CC_POWER_PANEL (user_data);
+  set_history_points (self->priv->rate_graph, points);
+  update_runtime_label (self, discharging);
+  g_array_unref (points);
+  g_array_unref (discharging);
+}
+
+static void
+got_system_bus_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GError *error = NULL;
+  GDBusConnection *connection;
+  CcPowerPanel *self;
+  CcPowerPanelPrivate *priv;
+
+  connection = g_bus_get_finish (res, &error);
+  if (connection == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_printerr ("Error getting the system bus: %s\n", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  self = CC_POWER_PANEL (user_data);
+  priv = self->priv;
+
+  g_dbus_connection_call (connection,
+                          "org.freedesktop.UPower",
+                          priv->history_path,
+                          "org.freedesktop.UPower.Device",
+                          "GetHistory",
+                          g_variant_new ("(suu)", "charge", HISTORY_TIMESPAN, HISTORY_RESOLUTION),
+                          G_VARIANT_TYPE ("(a(udu))"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          priv->history_cancellable,
+                          got_charge_history_cb,
+                          self);
+  g_dbus_connection_call (connection,
+                          "org.freedesktop.UPower",
+                          priv->history_path,
+                          "org.freedesktop.UPower.Device",
+                          "GetHistory",
+                          g_variant_new ("(suu)", "rate", HISTORY_TIMESPAN, HISTORY_RESOLUTION),
+                          G_VARIANT_TYPE ("(a(udu))"),
+                          G_DBUS_CALL_FLAGS_NONE,
+                          -1,
+                          priv->history_cancellable,
+                          got_rate_history_cb,
+                          self);
+  g_object_unref (connection);
+}
+
+static gboolean history_refresh_timeout (gpointer user_data);
+
+/* libupower-glib only has blocking calls for the history, so it is
+ * fetched over D-Bus directly, and only while it is shown, in which
+ * case it is fetched again every HISTORY_REFRESH_INTERVAL */
+static void
+refresh_history (CcPowerPanel *self)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+
+  if (priv->history_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->history_cancellable);
+      g_clear_object (&priv->history_cancellable);
+    }
+  if (priv->history_refresh_id != 0)
+    {
+      g_source_remove (priv->history_refresh_id);
+      priv->history_refresh_id = 0;
+    }
+
+  if (priv->history_path == NULL ||
+      !gtk_expander_get_expanded (GTK_EXPANDER (priv->history_expander)))
+    return;
+
+  priv->history_cancellable = g_cancellable_new ();
+  g_bus_get (G_BUS_TYPE_SYSTEM, priv->history_cancellable, got_system_bus_cb, self);
+
+  priv->history_refresh_id = g_timeout_add_seconds (HISTORY_REFRESH_INTERVAL,
+                                                    history_refresh_timeout,
+                                                    self);
+}
+
+static gboolean
+history_refresh_timeout (gpointer user_data)
+{
+  CcPowerPanel *self = user_data;
+
+  self->priv->history_refresh_id = 0;
+  refresh_history (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+history_expanded_cb (GObject      *expander,
+                     GParamSpec   *pspec,
+                     CcPowerPanel *self)
+{
+  refresh_history (self);
+}
+
+static void
+set_history_device (CcPowerPanel *self,
+                    UpDevice     *device)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+  const gchar *path = NULL;
+
+  if (device != NULL)
+    {
+      path = up_device_get_object_path (device);
+      g_object_get (device, "energy-full", &priv->history_energy_full, NULL);
+    }
+
+  gtk_widget_set_visible (priv->history_expander, path != NULL);
+
+  if (g_strcmp0 (path, priv->history_path) == 0)
+    return;
+
+  g_free (priv->history_path);
+  priv->history_path = g_strdup (path);
+
+  cc_battery_graph_set_points (CC_BATTERY_GRAPH (priv->charge_graph), NULL);
+  cc_battery_graph_set_points (CC_BATTERY_GRAPH (priv->rate_graph), NULL);
+  gtk_widget_hide (priv->runtime_label);
+
+  refresh_history (self);
+}
+
+static void
+add_device_row (CcPowerPanel *self,
+                UpDevice     *device,
+                GtkWidget    *row)
+{
+  const char *object_path;
+
+  if (row == NULL)
+    return;
+
+  g_object_set_data_full (G_OBJECT (row), "device",
+                          g_object_ref (device), g_object_unref);
+
+  object_path = up_device_get_object_path (device);
+  if (object_path != NULL)
+    g_hash_table_insert (self->priv->device_rows, g_strdup (object_path), row);
+}
+
+static void
+rebuild_device_rows (CcPowerPanel *self)
 {
   CcPowerPanelPrivate *priv = self->priv;
   GList *children, *l;
@@ -704,8 +1059,13 @@ up_client_changed (UpClient     *client,
   guint n_batteries;
   gboolean on_ups;
   UpDevice *composite;
+  UpDevice *history_device = NULL;
   gchar *s;
 
+  priv->rebuild_rows = FALSE;
+  g_hash_table_remove_all (priv->dirty_rows);
+  g_hash_table_remove_all (priv->device_rows);
+
   children = gtk_container_get_children (GTK_CONTAINER (priv->battery_list));
   for (l = children; l != NULL; l = l->next)
     gtk_container_remove (GTK_CONTAINER (priv->battery_list), l->data);
@@ -721,6 +1081,7 @@ up_client_changed (UpClient     *client,
 #ifdef TEST_FAKE_DEVICES
   {
     static gboolean fake_devices_added = FALSE;
+    UpDevice *device;
 
     if (!fake_devices_added)
       {
@@ -768,7 +1129,7 @@ up_client_changed (UpClient     *client,
 
   on_ups = FALSE;
   n_batteries = 0;
-  composite = up_client_get_display_device (priv->up_client);
+  composite = priv->composite;
   g_object_get (composite, "kind", &kind, NULL);
   if (kind == UP_DEVICE_KIND_UPS)
     {
@@ -803,35 +1164,112 @@ up_client_changed (UpClient     *client,
   g_free (s);
 
   if (!on_ups && n_batteries > 1)
-    set_primary (self, composite);
+    add_device_row (self, composite, set_primary (self, composite));
 
   for (i = 0; priv->devices != NULL && i < priv->devices->len; i++)
     {
       UpDevice *device = (UpDevice*) g_ptr_array_index (priv->devices, i);
       g_object_get (device, "kind", &kind, NULL);
+
+      /* The history is shown for the UPS, or the main battery */
+      if (history_device == NULL &&
+          ((kind == UP_DEVICE_KIND_UPS && on_ups) ||
+           (kind == UP_DEVICE_KIND_BATTERY && !on_ups)))
+        history_device = device;
+
       if (kind == UP_DEVICE_KIND_LINE_POWER)
         {
           /* do nothing */
         }
       else if (kind == UP_DEVICE_KIND_UPS && on_ups)
         {
-          set_primary (self, device);
+          add_device_row (self, device, set_primary (self, device));
         }
       else if (kind == UP_DEVICE_KIND_BATTERY && !on_ups && n_batteries == 1)
         {
-          set_primary (self, device);
+          add_device_row (self, device, set_primary (self, device));
         }
       else if (kind == UP_DEVICE_KIND_BATTERY)
         {
-          add_battery (self, device);
+          add_device_row (self, device, add_battery (self, device));
         }
       else
         {
-          add_device (self, device);
+          add_device_row (self, device, add_device (self, device));
         }
     }
 
-  g_object_unref (composite);
+  set_history_device (self, history_device);
+}
+
+typedef void (*RowUpdateFunc) (GtkWidget *row,
+                               UpDevice  *device);
+
+static gboolean
+device_update_timeout (gpointer user_data)
+{
+  CcPowerPanel *self = user_data;
+  CcPowerPanelPrivate *priv = self->priv;
+  GHashTableIter iter;
+  gpointer object_path;
+
+  priv->device_update_id = 0;
+
+  if (priv->rebuild_rows)
+    {
+      rebuild_device_rows (self);
+      return G_SOURCE_REMOVE;
+    }
+
+  g_hash_table_iter_init (&iter, priv->dirty_rows);
+  while (g_hash_table_iter_next (&iter, &object_path, NULL))
+    {
+      RowUpdateFunc update_func;
+      GtkWidget *row;
+
+      row = g_hash_table_lookup (priv->device_rows, object_path);
+      if (row == NULL)
+        continue;
+
+      update_func = g_object_get_data (G_OBJECT (row), "update-func");
+      update_func (row, g_object_get_data (G_OBJECT (row), "device"));
+    }
+  g_hash_table_remove_all (priv->dirty_rows);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Devices send a notification for each property that changes, and
+ * some of them do so often, so the rows are updated in batches */
+static void
+queue_device_update (CcPowerPanel *self)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+
+  if (priv->device_update_id == 0)
+    priv->device_update_id = g_timeout_add (DEVICE_UPDATE_INTERVAL,
+                                            device_update_timeout,
+                                            self);
+}
+
+static void
+device_notify_cb (UpDevice     *device,
+                  GParamSpec   *pspec,
+                  CcPowerPanel *self)
+{
+  CcPowerPanelPrivate *priv = self->priv;
+  const char *object_path;
+
+  /* Those decide which rows are shown, and where */
+  if (g_str_equal (pspec->name, "kind") ||
+      g_str_equal (pspec->name, "is-present"))
+    priv->rebuild_rows = TRUE;
+
+  object_path = up_device_get_object_path (device);
+  if (object_path != NULL)
+    g_hash_table_add (priv->dirty_rows, g_strdup (object_path));
+
+  queue_device_update (self);
 }
 
 static void
@@ -851,13 +1289,15 @@ up_client_device_removed (UpClient     *client,
 
       if (g_strcmp0 (object_path, up_device_get_object_path (device)) == 0)
         {
+          g_signal_handlers_disconnect_by_func (device, device_notify_cb, self);
           g_object_unref (device);
           g_ptr_array_remove_index (priv->devices, i);
           break;
         }
     }
 
-  up_client_changed (self->priv->up_client, NULL, self);
+  priv->rebuild_rows = TRUE;
+  queue_device_update (self);
 }
 
 static void
@@ -869,8 +1309,9 @@ up_client_device_added (UpClient     *client,
 
   g_ptr_array_add (priv->devices, g_object_ref (device));
   g_signal_connect (G_OBJECT (device), "notify",
-                    G_CALLBACK (up_client_changed), self);
-  up_client_changed (priv->up_client, NULL, self);
+                    G_CALLBACK (device_notify_cb), self);
+  priv->rebuild_rows = TRUE;
+  queue_device_update (self);
 }
 
 static void
@@ -2351,7 +2792,7 @@ add_battery_section (CcPowerPanel *self)
   CcPowerPanelPrivate *priv = self->priv;
   GtkWidget *vbox;
   GtkWidget *widget, *box;
-  GtkWidget *frame;
+  GtkWidget *frame, *grid;
   gchar *s;
 
   vbox = WID (priv->builder, "vbox_power");
@@ -2396,7 +2837,45 @@ add_battery_section (CcPowerPanel *self)
   gtk_container_add (GTK_CONTAINER (frame), widget);
   gtk_box_pack_start (GTK_BOX (box), frame, FALSE, TRUE, 0);
 
+  priv->history_expander = widget = gtk_expander_new_with_mnemonic (_("Battery _History"));
+  gtk_widget_set_margin_top (widget, 12);
+  g_signal_connect (widget, "notify::expanded",
+                    G_CALLBACK (history_expanded_cb), self);
+  gtk_box_pack_start (GTK_BOX (box), widget, FALSE, TRUE, 0);
+
+  grid = gtk_grid_new ();
+  gtk_grid_set_row_spacing (GTK_GRID (grid), 6);
+  gtk_widget_set_margin_top (grid, 6);
+  gtk_container_add (GTK_CONTAINER (priv->history_expander), grid);
+
+  widget = gtk_label_new (_("Charge"));
+  gtk_widget_set_halign (widget, GTK_ALIGN_START);
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 0, 1, 1);
+
+  priv->charge_graph = widget = cc_battery_graph_new ("%.0f%%", 100.0);
+  gtk_widget_set_size_request (widget, -1, 100);
+  gtk_widget_set_hexpand (widget, TRUE);
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 1, 1, 1);
+
+  widget = gtk_label_new (_("Power Draw"));
+  gtk_widget_set_halign (widget, GTK_ALIGN_START);
+  gtk_style_context_add_class (gtk_widget_get_style_context (widget), GTK_STYLE_CLASS_DIM_LABEL);
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 2, 1, 1);
+
+  /* TRANSLATORS: the top of the power draw scale, in watts */
+  priv->rate_graph = widget = cc_battery_graph_new (_("%.1f W"), 0.0);
+  gtk_widget_set_size_request (widget, -1, 100);
+  gtk_widget_set_hexpand (widget, TRUE);
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 3, 1, 1);
+
+  priv->runtime_label = widget = gtk_label_new ("");
+  gtk_widget_set_halign (widget, GTK_ALIGN_START);
+  gtk_widget_set_no_show_all (widget, TRUE);
+  gtk_grid_attach (GTK_GRID (grid), widget, 0, 4, 1, 1);
+
   gtk_widget_show_all (box);
+  gtk_widget_hide (priv->history_expander);
 }
 
 static void
@@ -2544,13 +3023,20 @@ cc_power_panel_init (CcPowerPanel *self)
   g_signal_connect (priv->up_client, "device-added", G_CALLBACK (up_client_device_added), self);
   g_signal_connect (priv->up_client, "device-removed", G_CALLBACK (up_client_device_removed), self);
 
+  priv->device_rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->dirty_rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  priv->composite = up_client_get_display_device (priv->up_client);
+  g_signal_connect (G_OBJECT (priv->composite), "notify",
+                    G_CALLBACK (device_notify_cb), self);
+
   priv->devices = up_client_get_devices (priv->up_client);
   for (i = 0; priv->devices != NULL && i < priv->devices->len; i++) {
     UpDevice *device = g_ptr_array_index (priv->devices, i);
     g_signal_connect (G_OBJECT (device), "notify",
-                      G_CALLBACK (up_client_changed), self);
+                      G_CALLBACK (device_notify_cb), self);
   }
-  up_client_changed (priv->up_client, NULL, self);
+  rebuild_device_rows (self);
 
   widget = WID (priv->builder, "vbox_power");
   box = gtk_scrolled_window_new (NULL, NULL);
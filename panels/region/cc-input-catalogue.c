@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2010 Intel, Inc
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * Split out of cc-region-panel.c, which loaded the IBus engines, and
+ * cc-input-chooser.c, which loaded the locales.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#define GNOME_DESKTOP_USE_UNSTABLE_API
+#include <libgnome-desktop/gnome-languages.h>
+
+#include "cc-util.h"
+#include "cc-input-catalogue.h"
+
+#ifdef HAVE_IBUS
+#include <ibus.h>
+#endif
+
+/*
+ * Everything the region panel and its input chooser need to know about
+ * the available input sources, loaded once per process: the XKB layouts,
+ * the locales they are offered for, and the IBus engines indexed by the
+ * locale or language they are meant for.
+ */
+struct _CcInputCatalogue {
+        GObject parent_instance;
+
+        GnomeXkbInfo *xkb_info;
+        GPtrArray *locales;
+        guint locales_idle_id;
+
+        /* Engine id → IBusEngineDesc, replaced as a whole on reload */
+        GHashTable *ibus_engines;
+        /* "ll_CC.UTF-8" or language name → GPtrArray of engine ids */
+        GHashTable *engines_by_locale;
+        GHashTable *engines_by_language;
+        GPtrArray *other_engines;
+
+#ifdef HAVE_IBUS
+        IBusBus *ibus;
+        GCancellable *ibus_cancellable;
+#endif
+};
+
+G_DEFINE_TYPE (CcInputCatalogue, cc_input_catalogue, G_TYPE_OBJECT)
+
+enum {
+        IBUS_ENGINES_CHANGED,
+        LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+static void
+input_locale_free (gpointer data)
+{
+        CcInputLocale *locale = data;
+
+        g_free (locale->id);
+        g_free (locale->lang_code);
+        g_free (locale->country_code);
+        g_free (locale->name);
+        g_free (locale->unaccented_name);
+        g_free (locale->untranslated_name);
+        g_free (locale);
+}
+
+static void
+load_locales (CcInputCatalogue *catalogue)
+{
+        GHashTable *seen;
+        gchar **locale_ids;
+        gchar **l;
+
+        catalogue->locales = g_ptr_array_new_with_free_func (input_locale_free);
+        seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+        locale_ids = gnome_get_all_locales ();
+        for (l = locale_ids; *l; ++l) {
+                CcInputLocale *locale;
+                gchar *lang_code, *country_code;
+                gchar *simple_locale;
+                gchar *tmp;
+
+                if (!gnome_parse_locale (*l, &lang_code, &country_code, NULL, NULL))
+                        continue;
+
+                if (country_code != NULL)
+                        simple_locale = g_strdup_printf ("%s_%s.UTF-8", lang_code, country_code);
+                else
+                        simple_locale = g_strdup_printf ("%s.UTF-8", lang_code);
+
+                if (g_hash_table_contains (seen, simple_locale)) {
+                        g_free (simple_locale);
+                        g_free (country_code);
+                        g_free (lang_code);
+                        continue;
+                }
+
+                locale = g_new0 (CcInputLocale, 1);
+                locale->id = simple_locale; /* Take ownership */
+                locale->lang_code = lang_code;
+                locale->country_code = country_code;
+                locale->name = gnome_get_language_from_locale (simple_locale, NULL);
+                locale->unaccented_name = cc_util_normalize_casefold_and_unaccent (locale->name);
+                tmp = gnome_get_language_from_locale (simple_locale, "C");
+                locale->untranslated_name = cc_util_normalize_casefold_and_unaccent (tmp);
+                g_free (tmp);
+
+                g_ptr_array_add (catalogue->locales, locale);
+                g_hash_table_add (seen, locale->id);
+        }
+        g_strfreev (locale_ids);
+
+        g_hash_table_destroy (seen);
+}
+
+static gboolean
+preload_locales (gpointer user_data)
+{
+        CcInputCatalogue *catalogue = user_data;
+
+        catalogue->locales_idle_id = 0;
+
+        if (!catalogue->locales)
+                load_locales (catalogue);
+
+        return G_SOURCE_REMOVE;
+}
+
+#ifdef HAVE_IBUS
+static void
+add_engine_to_index (GHashTable  *index,
+                     gchar       *key,
+                     const gchar *engine_id)
+{
+        GPtrArray *ids;
+
+        ids = g_hash_table_lookup (index, key);
+        if (!ids) {
+                ids = g_ptr_array_new ();
+                g_hash_table_insert (index, key, ids);
+        } else {
+                g_free (key);
+        }
+
+        g_ptr_array_add (ids, (gpointer) engine_id);
+}
+
+static void
+index_engine (CcInputCatalogue *catalogue,
+              IBusEngineDesc   *engine)
+{
+        const gchar *engine_id;
+        gchar *lang_code = NULL;
+        gchar *country_code = NULL;
+        gchar *language;
+
+        engine_id = ibus_engine_desc_get_name (engine);
+
+        if (gnome_parse_locale (ibus_engine_desc_get_language (engine), &lang_code, &country_code, NULL, NULL) &&
+            lang_code != NULL &&
+            country_code != NULL) {
+                add_engine_to_index (catalogue->engines_by_locale,
+                                     g_strdup_printf ("%s_%s.UTF-8", lang_code, country_code),
+                                     engine_id);
+        } else if (lang_code != NULL &&
+                   (language = gnome_get_language_from_code (lang_code, NULL)) != NULL) {
+                /* Most IBus engines only specify the language */
+                add_engine_to_index (catalogue->engines_by_language, language, engine_id);
+        } else {
+                g_ptr_array_add (catalogue->other_engines, (gpointer) engine_id);
+        }
+
+        g_free (country_code);
+        g_free (lang_code);
+}
+
+static void
+fetch_ibus_engines_result (GObject          *object,
+                           GAsyncResult     *result,
+                           CcInputCatalogue *catalogue)
+{
+        GList *list, *l;
+        GError *error;
+
+        error = NULL;
+        list = ibus_bus_list_engines_async_finish (IBUS_BUS (object), result, &error);
+        if (!list && error) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Couldn't finish IBus request: %s", error->message);
+                g_error_free (error);
+                return;
+        }
+
+        g_clear_object (&catalogue->ibus_cancellable);
+
+        g_clear_pointer (&catalogue->ibus_engines, g_hash_table_unref);
+        g_clear_pointer (&catalogue->engines_by_locale, g_hash_table_unref);
+        g_clear_pointer (&catalogue->engines_by_language, g_hash_table_unref);
+        g_clear_pointer (&catalogue->other_engines, g_ptr_array_unref);
+
+        catalogue->ibus_engines = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+        catalogue->engines_by_locale = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                              g_free, (GDestroyNotify) g_ptr_array_unref);
+        catalogue->engines_by_language = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                                g_free, (GDestroyNotify) g_ptr_array_unref);
+        catalogue->other_engines = g_ptr_array_new ();
+
+        for (l = list; l; l = l->next) {
+                IBusEngineDesc *engine = l->data;
+                const gchar *engine_id = ibus_engine_desc_get_name (engine);
+
+                if (g_str_has_prefix (engine_id, "xkb:")) {
+                        g_object_unref (engine);
+                        continue;
+                }
+
+                g_hash_table_replace (catalogue->ibus_engines, (gpointer) engine_id, engine);
+                index_engine (catalogue, engine);
+        }
+        g_list_free (list);
+
+        g_signal_emit (catalogue, signals[IBUS_ENGINES_CHANGED], 0);
+}
+
+static void
+fetch_ibus_engines (CcInputCatalogue *catalogue)
+{
+        if (catalogue->ibus_cancellable)
+                g_cancellable_cancel (catalogue->ibus_cancellable);
+        g_clear_object (&catalogue->ibus_cancellable);
+
+        catalogue->ibus_cancellable = g_cancellable_new ();
+
+        ibus_bus_list_engines_async (catalogue->ibus,
+                                     -1,
+                                     catalogue->ibus_cancellable,
+                                     (GAsyncReadyCallback)fetch_ibus_engines_result,
+                                     catalogue);
+}
+#endif  /* HAVE_IBUS */
+
+static void
+cc_input_catalogue_finalize (GObject *object)
+{
+        CcInputCatalogue *catalogue = CC_INPUT_CATALOGUE (object);
+
+        if (catalogue->locales_idle_id)
+                g_source_remove (catalogue->locales_idle_id);
+
+        g_clear_object (&catalogue->xkb_info);
+        g_clear_pointer (&catalogue->locales, g_ptr_array_unref);
+        g_clear_pointer (&catalogue->ibus_engines, g_hash_table_unref);
+        g_clear_pointer (&catalogue->engines_by_locale, g_hash_table_unref);
+        g_clear_pointer (&catalogue->engines_by_language, g_hash_table_unref);
+        g_clear_pointer (&catalogue->other_engines, g_ptr_array_unref);
+#ifdef HAVE_IBUS
+        if (catalogue->ibus_cancellable)
+                g_cancellable_cancel (catalogue->ibus_cancellable);
+        g_clear_object (&catalogue->ibus_cancellable);
+        if (catalogue->ibus)
+                g_signal_handlers_disconnect_by_data (catalogue->ibus, catalogue);
+        g_clear_object (&catalogue->ibus);
+#endif
+
+        G_OBJECT_CLASS (cc_input_catalogue_parent_class)->finalize (object);
+}
+
+static void
+cc_input_catalogue_class_init (CcInputCatalogueClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+        object_class->finalize = cc_input_catalogue_finalize;
+
+        /**
+         * CcInputCatalogue::ibus-engines-changed:
+         *
+         * Emitted when the list of IBus engines was (re)loaded.
+         */
+        signals[IBUS_ENGINES_CHANGED] = g_signal_new ("ibus-engines-changed",
+                                                      CC_TYPE_INPUT_CATALOGUE,
+                                                      G_SIGNAL_RUN_LAST,
+                                                      0, NULL, NULL, NULL,
+                                                      G_TYPE_NONE, 0);
+}
+
+static void
+cc_input_catalogue_init (CcInputCatalogue *catalogue)
+{
+        catalogue->xkb_info = gnome_xkb_info_new ();
+
+        /* Have the locale names ready by the time a chooser opens */
+        catalogue->locales_idle_id = g_idle_add_full (G_PRIORITY_LOW, preload_locales, catalogue, NULL);
+        g_source_set_name_by_id (catalogue->locales_idle_id, "[gnome-control-center] preload_locales");
+
+#ifdef HAVE_IBUS
+        ibus_init ();
+        catalogue->ibus = ibus_bus_new_async ();
+        if (ibus_bus_is_connected (catalogue->ibus))
+                fetch_ibus_engines (catalogue);
+
+        /* IBus reloads its engines when it restarts */
+        g_signal_connect_swapped (catalogue->ibus, "connected",
+                                  G_CALLBACK (fetch_ibus_engines), catalogue);
+#endif
+}
+
+/**
+ * cc_input_catalogue_get_default:
+ *
+ * Returns: (transfer none): the catalogue shared by the whole process
+ */
+CcInputCatalogue *
+cc_input_catalogue_get_default (void)
+{
+        static CcInputCatalogue *catalogue = NULL;
+
+        if (!catalogue)
+                catalogue = g_object_new (CC_TYPE_INPUT_CATALOGUE, NULL);
+
+        return catalogue;
+}
+
+GnomeXkbInfo *
+cc_input_catalogue_get_xkb_info (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        return catalogue->xkb_info;
+}
+
+/**
+ * cc_input_catalogue_get_locales:
+ *
+ * Returns: (transfer none)(element-type CcInputLocale): all the locales,
+ * with their names, loaded on first use if they were not preloaded yet
+ */
+GPtrArray *
+cc_input_catalogue_get_locales (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        if (!catalogue->locales)
+                load_locales (catalogue);
+
+        return catalogue->locales;
+}
+
+/**
+ * cc_input_catalogue_get_ibus_engines:
+ *
+ * Returns: (transfer none)(nullable): engine ids mapped to their
+ * #IBusEngineDesc, or %NULL if they were not loaded yet. Take a reference
+ * to keep using it across #CcInputCatalogue::ibus-engines-changed.
+ */
+GHashTable *
+cc_input_catalogue_get_ibus_engines (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        return catalogue->ibus_engines;
+}
+
+/**
+ * cc_input_catalogue_get_engines_by_locale:
+ *
+ * Returns: (transfer none)(nullable): "ll_CC.UTF-8" locales mapped to the
+ * ids of the engines declaring both that language and country
+ */
+GHashTable *
+cc_input_catalogue_get_engines_by_locale (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        return catalogue->engines_by_locale;
+}
+
+/**
+ * cc_input_catalogue_get_engines_by_language:
+ *
+ * Returns: (transfer none)(nullable): language names, as returned by
+ * gnome_get_language_from_code(), mapped to the ids of the engines only
+ * declaring that language
+ */
+GHashTable *
+cc_input_catalogue_get_engines_by_language (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        return catalogue->engines_by_language;
+}
+
+/**
+ * cc_input_catalogue_get_other_engines:
+ *
+ * Returns: (transfer none)(nullable): the ids of the engines without a
+ * known language
+ */
+GPtrArray *
+cc_input_catalogue_get_other_engines (CcInputCatalogue *catalogue)
+{
+        g_return_val_if_fail (CC_IS_INPUT_CATALOGUE (catalogue), NULL);
+
+        return catalogue->other_engines;
+}
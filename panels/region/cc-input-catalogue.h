@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2010 Intel, Inc
+ * Copyright (C) 2013 Red Hat, Inc.
+ *
+ * Split out of cc-region-panel.c, which loaded the IBus engines, and
+ * cc-input-chooser.c, which loaded the locales.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CC_INPUT_CATALOGUE_H__
+#define __CC_INPUT_CATALOGUE_H__
+
+#include <glib-object.h>
+
+#define GNOME_DESKTOP_USE_UNSTABLE_API
+#include <libgnome-desktop/gnome-xkb-info.h>
+
+G_BEGIN_DECLS
+
+typedef struct {
+        gchar *id;
+        gchar *lang_code;
+        gchar *country_code;
+        gchar *name;
+        gchar *unaccented_name;
+        gchar *untranslated_name;
+} CcInputLocale;
+
+#define CC_TYPE_INPUT_CATALOGUE (cc_input_catalogue_get_type ())
+G_DECLARE_FINAL_TYPE (CcInputCatalogue, cc_input_catalogue, CC, INPUT_CATALOGUE, GObject)
+
+CcInputCatalogue *cc_input_catalogue_get_default              (void);
+
+GnomeXkbInfo     *cc_input_catalogue_get_xkb_info             (CcInputCatalogue *catalogue);
+GPtrArray        *cc_input_catalogue_get_locales              (CcInputCatalogue *catalogue);
+
+GHashTable       *cc_input_catalogue_get_ibus_engines         (CcInputCatalogue *catalogue);
+GHashTable       *cc_input_catalogue_get_engines_by_locale    (CcInputCatalogue *catalogue);
+GHashTable       *cc_input_catalogue_get_engines_by_language  (CcInputCatalogue *catalogue);
+GPtrArray        *cc_input_catalogue_get_other_engines        (CcInputCatalogue *catalogue);
+
+G_END_DECLS
+
+#endif /* __CC_INPUT_CATALOGUE_H__ */
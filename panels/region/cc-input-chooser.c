@@ -25,6 +25,7 @@
 #include "shell/list-box-helper.h"
 #include "cc-common-language.h"
 #include "cc-util.h"
+#include "cc-input-catalogue.h"
 #include "cc-input-chooser.h"
 
 #ifdef HAVE_IBUS
@@ -58,9 +59,10 @@ typedef struct {
   GtkWidget *scrolledwindow;
   GtkAdjustment *adjustment;
   GnomeXkbInfo *xkb_info;
-  GHashTable *ibus_engines;
 
   /* Owned */
+  CcInputCatalogue *catalogue;
+  GHashTable *ibus_engines;
   GtkListBoxRow *more_row;
   GtkWidget *no_results;
   GHashTable *locales;
@@ -68,6 +70,11 @@ typedef struct {
   gboolean showing_extra;
   guint filter_timeout_id;
   gchar **filter_words;
+  GPtrArray *search_docs;
+  GHashTable *token_index;
+  GHashTable *matched_docs;
+  GHashTable *match_scores;
+  GHashTable *locale_scores;
 
   gboolean is_login;
 } CcInputChooserPrivate;
@@ -87,6 +94,17 @@ typedef struct {
   GHashTable *engine_rows_by_id;
 } LocaleInfo;
 
+/* Characters splitting the searchable names into tokens */
+#define SEARCH_SEPARATORS " ()[],-/"
+
+/* Searchable names of a locale, or of one of its input source rows */
+typedef struct {
+  LocaleInfo *info;
+  GtkListBoxRow *row;
+  const gchar *names[3];
+  gchar **tokens;
+} SearchDoc;
+
 static void
 locale_info_free (gpointer data)
 {
@@ -420,6 +438,9 @@ show_locale_rows (GtkWidget *chooser)
     g_hash_table_destroy (initial);
 }
 
+static gint get_row_score (CcInputChooserPrivate *priv,
+                           GtkListBoxRow         *row);
+
 static gint
 list_sort (gconstpointer a,
            gconstpointer b,
@@ -448,6 +469,14 @@ list_sort (gconstpointer a,
   else if (ia->id[0] && !ib->id[0])
     return -1;
 
+  /* Most relevant locales first when searching */
+  if (ia != ib)
+    {
+      retval = get_row_score (priv, GTK_LIST_BOX_ROW (b)) - get_row_score (priv, GTK_LIST_BOX_ROW (a));
+      if (retval)
+        return retval;
+    }
+
   retval = g_strcmp0 (ia->name, ib->name);
   if (retval)
     return retval;
@@ -470,6 +499,10 @@ list_sort (gconstpointer a,
   if (g_object_get_data (G_OBJECT (b), "default"))
     return 1;
 
+  retval = get_row_score (priv, GTK_LIST_BOX_ROW (b)) - get_row_score (priv, GTK_LIST_BOX_ROW (a));
+  if (retval)
+    return retval;
+
   return g_strcmp0 (la, lb);
 }
 
@@ -486,22 +519,336 @@ match_all (gchar       **words,
   return TRUE;
 }
 
+static SearchDoc *
+search_doc_new (LocaleInfo    *info,
+                GtkListBoxRow *row)
+{
+  SearchDoc *doc;
+  GPtrArray *tokens;
+  guint i, n;
+
+  doc = g_new0 (SearchDoc, 1);
+  doc->info = info;
+  doc->row = row;
+
+  n = 0;
+  if (row)
+    {
+      doc->names[n++] = g_object_get_data (G_OBJECT (row), "unaccented-name");
+    }
+  else
+    {
+      doc->names[n++] = info->unaccented_name;
+      doc->names[n++] = info->untranslated_name;
+    }
+
+  tokens = g_ptr_array_new ();
+  for (i = 0; i < n; i++)
+    {
+      gchar **words, **w;
+
+      if (!doc->names[i])
+        continue;
+
+      words = g_strsplit_set (doc->names[i], SEARCH_SEPARATORS, 0);
+      for (w = words; *w; ++w)
+        {
+          if (**w)
+            g_ptr_array_add (tokens, *w);
+          else
+            g_free (*w);
+        }
+      g_free (words);
+    }
+  g_ptr_array_add (tokens, NULL);
+  doc->tokens = (gchar **) g_ptr_array_free (tokens, FALSE);
+
+  return doc;
+}
+
+static void
+search_doc_free (gpointer data)
+{
+  SearchDoc *doc = data;
+
+  g_strfreev (doc->tokens);
+  g_free (doc);
+}
+
+static void
+index_search_doc (CcInputChooserPrivate *priv,
+                  SearchDoc             *doc)
+{
+  gchar **t;
+
+  for (t = doc->tokens; *t; ++t)
+    {
+      GPtrArray *docs;
+
+      docs = g_hash_table_lookup (priv->token_index, *t);
+      if (!docs)
+        {
+          docs = g_ptr_array_new ();
+          g_hash_table_insert (priv->token_index, *t, docs);
+        }
+
+      /* The same token can appear twice in a document */
+      if (docs->len == 0 || g_ptr_array_index (docs, docs->len - 1) != doc)
+        g_ptr_array_add (docs, doc);
+    }
+}
+
+static void
+add_search_doc (CcInputChooserPrivate *priv,
+                LocaleInfo            *info,
+                GtkListBoxRow         *row)
+{
+  SearchDoc *doc;
+
+  doc = search_doc_new (info, row);
+  g_ptr_array_add (priv->search_docs, doc);
+  index_search_doc (priv, doc);
+}
+
+static void
+build_search_docs (GtkWidget *chooser)
+{
+  CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
+  GHashTableIter iter, rows_iter;
+  LocaleInfo *info;
+  GtkListBoxRow *row;
+
+  /* The index keys belong to the documents */
+  g_clear_pointer (&priv->token_index, g_hash_table_unref);
+  g_clear_pointer (&priv->search_docs, g_ptr_array_unref);
+  g_clear_pointer (&priv->matched_docs, g_hash_table_unref);
+
+  priv->search_docs = g_ptr_array_new_with_free_func (search_doc_free);
+  priv->token_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             NULL, (GDestroyNotify) g_ptr_array_unref);
+
+  g_hash_table_iter_init (&iter, priv->locales);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
+    {
+      /* Including the "Other" locale, whose rows all match its name */
+      add_search_doc (priv, info, NULL);
+
+      if (info->default_input_source_row)
+        add_search_doc (priv, info, info->default_input_source_row);
+
+      g_hash_table_iter_init (&rows_iter, info->layout_rows_by_id);
+      while (g_hash_table_iter_next (&rows_iter, NULL, (gpointer *) &row))
+        add_search_doc (priv, info, row);
+
+      g_hash_table_iter_init (&rows_iter, info->engine_rows_by_id);
+      while (g_hash_table_iter_next (&rows_iter, NULL, (gpointer *) &row))
+        add_search_doc (priv, info, row);
+    }
+}
+
+/* Whole word matches rank above word prefixes, and those above
+ * matches in the middle of a word */
+static gint
+search_doc_score (SearchDoc  *doc,
+                  gchar     **words)
+{
+  gboolean matched = FALSE;
+  gchar **w, **t;
+  gint score = 0;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (doc->names) && doc->names[i]; i++)
+    {
+      if (match_all (words, doc->names[i]))
+        {
+          matched = TRUE;
+          break;
+        }
+    }
+
+  if (!matched)
+    return 0;
+
+  for (w = words; *w; ++w)
+    {
+      gint word_score = 1;
+
+      for (t = doc->tokens; *t && word_score < 3; ++t)
+        {
+          if (g_str_equal (*t, *w))
+            word_score = 3;
+          else if (g_str_has_prefix (*t, *w))
+            word_score = 2;
+        }
+
+      score += word_score;
+    }
+
+  return score;
+}
+
 static gboolean
-match_source_in_table (gchar      **words,
-                       GHashTable  *table)
+words_refine (gchar **words,
+              gchar **previous_words)
+{
+  gchar **w, **p;
+
+  /* Every previous word must still be part of the matching word */
+  for (w = words, p = previous_words; *p; ++w, ++p)
+    if (*w == NULL || !strstr (*w, *p))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* A word without separators can only match inside a single token, so
+ * the documents it can match are found from the distinct tokens rather
+ * than from every document. Returns %NULL when any document might match */
+static GHashTable *
+lookup_candidates (CcInputChooserPrivate  *priv,
+                   gchar                 **words)
+{
+  GHashTable *candidates = NULL;
+  gchar **w;
+
+  for (w = words; *w; ++w)
+    {
+      GHashTable *word_docs;
+      GHashTableIter iter;
+      const gchar *token;
+      GPtrArray *docs;
+      SearchDoc *doc;
+      guint i;
+
+      if (strpbrk (*w, SEARCH_SEPARATORS))
+        continue;
+
+      word_docs = g_hash_table_new (NULL, NULL);
+
+      g_hash_table_iter_init (&iter, priv->token_index);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &token, (gpointer *) &docs))
+        {
+          if (!strstr (token, *w))
+            continue;
+
+          for (i = 0; i < docs->len; i++)
+            {
+              doc = g_ptr_array_index (docs, i);
+              if (!candidates || g_hash_table_contains (candidates, doc))
+                g_hash_table_add (word_docs, doc);
+            }
+        }
+
+      g_clear_pointer (&candidates, g_hash_table_unref);
+      candidates = word_docs;
+    }
+
+  return candidates;
+}
+
+static void
+update_matches (GtkWidget  *chooser,
+                gchar     **previous_words)
 {
+  CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
+  GHashTable *matched_docs, *candidates;
   GHashTableIter iter;
-  gpointer row;
-  const gchar *source_name;
+  SearchDoc *doc;
+  gpointer value;
+  guint i;
 
-  g_hash_table_iter_init (&iter, table);
-  while (g_hash_table_iter_next (&iter, NULL, &row))
+  g_clear_pointer (&priv->match_scores, g_hash_table_unref);
+  g_clear_pointer (&priv->locale_scores, g_hash_table_unref);
+
+  if (!priv->filter_words)
     {
-      source_name = g_object_get_data (G_OBJECT (row), "unaccented-name");
-      if (source_name && match_all (words, source_name))
-        return TRUE;
+      g_clear_pointer (&priv->matched_docs, g_hash_table_unref);
+      return;
+    }
+
+  if (!priv->search_docs)
+    build_search_docs (chooser);
+
+  matched_docs = g_hash_table_new (NULL, NULL);
+
+  /* When the query only got more specific, the new matches are a
+   * subset of the previous ones */
+  if (priv->matched_docs && previous_words && words_refine (priv->filter_words, previous_words))
+    {
+      g_hash_table_iter_init (&iter, priv->matched_docs);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &doc, NULL))
+        {
+          gint score = search_doc_score (doc, priv->filter_words);
+          if (score > 0)
+            g_hash_table_insert (matched_docs, doc, GINT_TO_POINTER (score));
+        }
+    }
+  else if ((candidates = lookup_candidates (priv, priv->filter_words)) != NULL)
+    {
+      g_hash_table_iter_init (&iter, candidates);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &doc, NULL))
+        {
+          gint score = search_doc_score (doc, priv->filter_words);
+          if (score > 0)
+            g_hash_table_insert (matched_docs, doc, GINT_TO_POINTER (score));
+        }
+      g_hash_table_unref (candidates);
+    }
+  else
+    {
+      for (i = 0; i < priv->search_docs->len; i++)
+        {
+          gint score;
+
+          doc = g_ptr_array_index (priv->search_docs, i);
+          score = search_doc_score (doc, priv->filter_words);
+          if (score > 0)
+            g_hash_table_insert (matched_docs, doc, GINT_TO_POINTER (score));
+        }
+    }
+
+  g_clear_pointer (&priv->matched_docs, g_hash_table_unref);
+  priv->matched_docs = matched_docs;
+
+  /* Scores by row for source rows and by locale for the locale names,
+   * and the best score of each locale for its heading row */
+  priv->match_scores = g_hash_table_new (NULL, NULL);
+  priv->locale_scores = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, priv->matched_docs);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &doc, &value))
+    {
+      gint score, best;
+
+      score = GPOINTER_TO_INT (value);
+      g_hash_table_insert (priv->match_scores,
+                           doc->row ? (gpointer) doc->row : (gpointer) doc->info,
+                           GINT_TO_POINTER (score));
+
+      best = GPOINTER_TO_INT (g_hash_table_lookup (priv->locale_scores, doc->info));
+      if (score > best)
+        g_hash_table_insert (priv->locale_scores, doc->info, GINT_TO_POINTER (score));
     }
-  return FALSE;
+}
+
+static gint
+get_row_score (CcInputChooserPrivate *priv,
+               GtkListBoxRow         *row)
+{
+  LocaleInfo *info;
+
+  if (!priv->match_scores)
+    return 0;
+
+  info = g_object_get_data (G_OBJECT (row), "locale-info");
+  if (!info)
+    return 0;
+
+  if (g_object_get_data (G_OBJECT (row), "name"))
+    return MAX (GPOINTER_TO_INT (g_hash_table_lookup (priv->match_scores, row)),
+                GPOINTER_TO_INT (g_hash_table_lookup (priv->match_scores, info)));
+
+  return GPOINTER_TO_INT (g_hash_table_lookup (priv->locale_scores, info));
 }
 
 static gboolean
@@ -512,7 +859,6 @@ list_filter (GtkListBoxRow *row,
   CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
   LocaleInfo *info;
   gboolean is_extra;
-  const gchar *source_name;
 
   if (row == priv->more_row)
     return !priv->showing_extra;
@@ -530,27 +876,7 @@ list_filter (GtkListBoxRow *row,
   if (row == info->back_row)
     return TRUE;
 
-  if (match_all (priv->filter_words, info->unaccented_name))
-    return TRUE;
-
-  if (match_all (priv->filter_words, info->untranslated_name))
-    return TRUE;
-
-  source_name = g_object_get_data (G_OBJECT (row), "unaccented-name");
-  if (source_name)
-    {
-      if (match_all (priv->filter_words, source_name))
-        return TRUE;
-    }
-  else
-    {
-      if (match_source_in_table (priv->filter_words, info->layout_rows_by_id))
-        return TRUE;
-      if (match_source_in_table (priv->filter_words, info->engine_rows_by_id))
-        return TRUE;
-    }
-
-  return FALSE;
+  return get_row_score (priv, row) > 0;
 }
 
 static gboolean
@@ -592,14 +918,18 @@ do_filter (GtkWidget *chooser)
   if (!priv->filter_words || !priv->filter_words[0])
     {
       g_clear_pointer (&priv->filter_words, g_strfreev);
+      update_matches (chooser, NULL);
       gtk_list_box_invalidate_filter (GTK_LIST_BOX (priv->list));
+      gtk_list_box_invalidate_sort (GTK_LIST_BOX (priv->list));
       gtk_list_box_set_placeholder (GTK_LIST_BOX (priv->list), NULL);
     }
   else
     {
       if (!previous_words || strvs_differ (priv->filter_words, previous_words))
         {
+          update_matches (chooser, previous_words);
           gtk_list_box_invalidate_filter (GTK_LIST_BOX (priv->list));
+          gtk_list_box_invalidate_sort (GTK_LIST_BOX (priv->list));
           gtk_list_box_set_placeholder (GTK_LIST_BOX (priv->list), priv->no_results);
         }
     }
@@ -787,70 +1117,65 @@ static void
 get_ibus_locale_infos (GtkWidget *chooser)
 {
   CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
+  GHashTable *engines_by_locale;
+  GHashTable *engines_by_language;
+  GPtrArray *other_engines;
   GHashTableIter iter;
   LocaleInfo *info;
-  const gchar *engine_id;
-  IBusEngineDesc *engine;
+  const gchar *key;
+  GPtrArray *ids;
+  guint i;
 
   if (!priv->ibus_engines || priv->is_login)
     return;
 
-  g_hash_table_iter_init (&iter, priv->ibus_engines);
-  while (g_hash_table_iter_next (&iter, (gpointer *) &engine_id, (gpointer *) &engine))
+  engines_by_locale = cc_input_catalogue_get_engines_by_locale (priv->catalogue);
+  engines_by_language = cc_input_catalogue_get_engines_by_language (priv->catalogue);
+  other_engines = cc_input_catalogue_get_other_engines (priv->catalogue);
+
+  g_hash_table_iter_init (&iter, engines_by_locale);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &ids))
     {
-      gchar *lang_code = NULL;
-      gchar *country_code = NULL;
-      const gchar *ibus_locale = ibus_engine_desc_get_language (engine);
+      const gchar *type, *id;
+      gboolean has_default;
 
-      if (gnome_parse_locale (ibus_locale, &lang_code, &country_code, NULL, NULL) &&
-          lang_code != NULL &&
-          country_code != NULL)
+      info = g_hash_table_lookup (priv->locales, key);
+      has_default = info &&
+                    gnome_get_input_source_from_locale (key, &type, &id) &&
+                    g_str_equal (type, INPUT_SOURCE_TYPE_IBUS);
+
+      for (i = 0; i < ids->len; i++)
         {
-          gchar *locale = g_strdup_printf ("%s_%s.UTF-8", lang_code, country_code);
+          const gchar *engine_id = g_ptr_array_index (ids, i);
 
-          info = g_hash_table_lookup (priv->locales, locale);
-          if (info)
-            {
-              const gchar *type, *id;
-
-              if (gnome_get_input_source_from_locale (locale, &type, &id) &&
-                  g_str_equal (type, INPUT_SOURCE_TYPE_IBUS) &&
-                  g_str_equal (id, engine_id))
-                {
-                  add_default_row (chooser, info, type, id);
-                }
-              else
-                {
-                  add_row (chooser, info, INPUT_SOURCE_TYPE_IBUS, engine_id);
-                }
-            }
+          if (!info)
+            add_row_other (chooser, INPUT_SOURCE_TYPE_IBUS, engine_id);
+          else if (has_default && g_str_equal (id, engine_id))
+            add_default_row (chooser, info, type, id);
           else
-            {
-              add_row_other (chooser, INPUT_SOURCE_TYPE_IBUS, engine_id);
-            }
-
-          g_free (locale);
+            add_row (chooser, info, INPUT_SOURCE_TYPE_IBUS, engine_id);
         }
-      else if (lang_code != NULL)
-        {
-          GHashTableIter iter;
-          GHashTable *locales_for_language;
-          gchar *language;
+    }
 
-          /* Most IBus engines only specify the language so we try to
-             add them to all locales for that language. */
+  /* Most IBus engines only specify the language so we try to
+     add them to all locales for that language. */
+  g_hash_table_iter_init (&iter, engines_by_language);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &ids))
+    {
+      GHashTable *locales_for_language;
 
-          language = gnome_get_language_from_code (lang_code, NULL);
-          if (language)
-            locales_for_language = g_hash_table_lookup (priv->locales_by_language, language);
-          else
-            locales_for_language = NULL;
-          g_free (language);
+      locales_for_language = g_hash_table_lookup (priv->locales_by_language, key);
+
+      for (i = 0; i < ids->len; i++)
+        {
+          const gchar *engine_id = g_ptr_array_index (ids, i);
 
           if (locales_for_language)
             {
-              g_hash_table_iter_init (&iter, locales_for_language);
-              while (g_hash_table_iter_next (&iter, (gpointer *) &info, NULL))
+              GHashTableIter locales_iter;
+
+              g_hash_table_iter_init (&locales_iter, locales_for_language);
+              while (g_hash_table_iter_next (&locales_iter, (gpointer *) &info, NULL))
                 if (!maybe_set_as_default (chooser, info, engine_id))
                   add_row (chooser, info, INPUT_SOURCE_TYPE_IBUS, engine_id);
             }
@@ -859,14 +1184,10 @@ get_ibus_locale_infos (GtkWidget *chooser)
               add_row_other (chooser, INPUT_SOURCE_TYPE_IBUS, engine_id);
             }
         }
-      else
-        {
-          add_row_other (chooser, INPUT_SOURCE_TYPE_IBUS, engine_id);
-        }
-
-      g_free (country_code);
-      g_free (lang_code);
     }
+
+  for (i = 0; i < other_engines->len; i++)
+    add_row_other (chooser, INPUT_SOURCE_TYPE_IBUS, g_ptr_array_index (other_engines, i));
 }
 #endif  /* HAVE_IBUS */
 
@@ -908,9 +1229,9 @@ get_locale_infos (GtkWidget *chooser)
   CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
   GHashTable *layouts_with_locale;
   LocaleInfo *info;
-  gchar **locale_ids;
-  gchar **locale;
+  GPtrArray *locales;
   GList *list, *l;
+  guint i;
 
   priv->locales = g_hash_table_new_full (g_str_hash, g_str_equal,
                                          NULL, locale_info_free);
@@ -919,43 +1240,23 @@ get_locale_infos (GtkWidget *chooser)
 
   layouts_with_locale = g_hash_table_new (g_str_hash, g_str_equal);
 
-  locale_ids = gnome_get_all_locales ();
-  for (locale = locale_ids; *locale; ++locale)
+  locales = cc_input_catalogue_get_locales (priv->catalogue);
+  for (i = 0; i < locales->len; i++)
     {
-      gchar *lang_code, *country_code;
-      gchar *simple_locale;
-      gchar *tmp;
+      CcInputLocale *locale = g_ptr_array_index (locales, i);
       const gchar *type = NULL;
       const gchar *id = NULL;
 
-      if (!gnome_parse_locale (*locale, &lang_code, &country_code, NULL, NULL))
-        continue;
-
-      if (country_code != NULL)
-	simple_locale = g_strdup_printf ("%s_%s.UTF-8", lang_code, country_code);
-      else
-	simple_locale = g_strdup_printf ("%s.UTF-8", lang_code);
-
-      if (g_hash_table_contains (priv->locales, simple_locale))
-        {
-          g_free (simple_locale);
-          g_free (country_code);
-          g_free (lang_code);
-          continue;
-        }
-
       info = g_new0 (LocaleInfo, 1);
-      info->id = simple_locale; /* Take ownership */
-      info->name = gnome_get_language_from_locale (simple_locale, NULL);
-      info->unaccented_name = cc_util_normalize_casefold_and_unaccent (info->name);
-      tmp = gnome_get_language_from_locale (simple_locale, "C");
-      info->untranslated_name = cc_util_normalize_casefold_and_unaccent (tmp);
-      g_free (tmp);
+      info->id = g_strdup (locale->id);
+      info->name = g_strdup (locale->name);
+      info->unaccented_name = g_strdup (locale->unaccented_name);
+      info->untranslated_name = g_strdup (locale->untranslated_name);
 
-      g_hash_table_replace (priv->locales, simple_locale, info);
-      add_locale_to_table (priv->locales_by_language, lang_code, info);
+      g_hash_table_replace (priv->locales, info->id, info);
+      add_locale_to_table (priv->locales_by_language, locale->lang_code, info);
 
-      if (gnome_get_input_source_from_locale (simple_locale, &type, &id) &&
+      if (gnome_get_input_source_from_locale (info->id, &type, &id) &&
           g_str_equal (type, INPUT_SOURCE_TYPE_XKB))
         {
           add_default_row (chooser, info, type, id);
@@ -968,23 +1269,19 @@ get_locale_infos (GtkWidget *chooser)
       info->engine_rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                        NULL, g_object_unref);
 
-      list = gnome_xkb_info_get_layouts_for_language (priv->xkb_info, lang_code);
+      list = gnome_xkb_info_get_layouts_for_language (priv->xkb_info, locale->lang_code);
       add_rows_to_table (chooser, info, list, INPUT_SOURCE_TYPE_XKB, id);
       add_ids_to_set (layouts_with_locale, list);
       g_list_free (list);
 
-      if (country_code != NULL)
+      if (locale->country_code != NULL)
         {
-          list = gnome_xkb_info_get_layouts_for_country (priv->xkb_info, country_code);
+          list = gnome_xkb_info_get_layouts_for_country (priv->xkb_info, locale->country_code);
           add_rows_to_table (chooser, info, list, INPUT_SOURCE_TYPE_XKB, id);
           add_ids_to_set (layouts_with_locale, list);
           g_list_free (list);
         }
-
-      g_free (lang_code);
-      g_free (country_code);
     }
-  g_strfreev (locale_ids);
 
   /* Add a "Other" locale to hold the remaining input sources */
   info = g_new0 (LocaleInfo, 1);
@@ -1018,12 +1315,44 @@ cc_input_chooser_private_free (gpointer data)
   g_object_unref (priv->no_results);
   g_hash_table_destroy (priv->locales);
   g_hash_table_destroy (priv->locales_by_language);
+  g_clear_pointer (&priv->ibus_engines, g_hash_table_unref);
+  g_object_unref (priv->catalogue);
   g_strfreev (priv->filter_words);
+  g_clear_pointer (&priv->token_index, g_hash_table_unref);
+  g_clear_pointer (&priv->search_docs, g_ptr_array_unref);
+  g_clear_pointer (&priv->matched_docs, g_hash_table_unref);
+  g_clear_pointer (&priv->match_scores, g_hash_table_unref);
+  g_clear_pointer (&priv->locale_scores, g_hash_table_unref);
   if (priv->filter_timeout_id)
     g_source_remove (priv->filter_timeout_id);
   g_free (priv);
 }
 
+static void
+ibus_engines_changed (GtkWidget *chooser)
+{
+  CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
+
+  /* Rows point to engine ids owned by the engines table, so the rows
+   * are all rebuilt before letting go of the previous table */
+  remove_all_children (GTK_CONTAINER (priv->list));
+  g_clear_pointer (&priv->locales, g_hash_table_destroy);
+  g_clear_pointer (&priv->locales_by_language, g_hash_table_destroy);
+
+  g_clear_pointer (&priv->ibus_engines, g_hash_table_unref);
+  priv->ibus_engines = cc_input_catalogue_get_ibus_engines (priv->catalogue);
+  if (priv->ibus_engines)
+    g_hash_table_ref (priv->ibus_engines);
+
+  get_locale_infos (chooser);
+#ifdef HAVE_IBUS
+  get_ibus_locale_infos (chooser);
+#endif  /* HAVE_IBUS */
+  build_search_docs (chooser);
+  update_matches (chooser, NULL);
+  show_locale_rows (chooser);
+}
+
 static gboolean
 reset_on_escape (GtkWidget   *widget,
                  GdkEventKey *event,
@@ -1036,10 +1365,9 @@ reset_on_escape (GtkWidget   *widget,
 }
 
 GtkWidget *
-cc_input_chooser_new (GtkWindow    *main_window,
-                      gboolean      is_login,
-                      GnomeXkbInfo *xkb_info,
-                      GHashTable   *ibus_engines)
+cc_input_chooser_new (GtkWindow        *main_window,
+                      gboolean          is_login,
+                      CcInputCatalogue *catalogue)
 {
   GtkBuilder *builder;
   GtkWidget *chooser;
@@ -1060,8 +1388,11 @@ cc_input_chooser_new (GtkWindow    *main_window,
   g_object_set_data_full (G_OBJECT (chooser), "private", priv, cc_input_chooser_private_free);
 
   priv->is_login = is_login;
-  priv->xkb_info = xkb_info;
-  priv->ibus_engines = ibus_engines;
+  priv->catalogue = g_object_ref (catalogue);
+  priv->xkb_info = cc_input_catalogue_get_xkb_info (catalogue);
+  priv->ibus_engines = cc_input_catalogue_get_ibus_engines (catalogue);
+  if (priv->ibus_engines)
+    g_hash_table_ref (priv->ibus_engines);
 
   priv->add_button = WID ("add-button");
   priv->filter_entry = WID ("filter-entry");
@@ -1081,6 +1412,8 @@ cc_input_chooser_new (GtkWindow    *main_window,
 
   g_signal_connect_swapped (priv->filter_entry, "search-changed", G_CALLBACK (filter_changed), chooser);
   g_signal_connect (priv->filter_entry, "key-release-event", G_CALLBACK (reset_on_escape), chooser);
+  g_signal_connect_object (catalogue, "ibus-engines-changed",
+                           G_CALLBACK (ibus_engines_changed), chooser, G_CONNECT_SWAPPED);
 
   if (priv->is_login)
     gtk_widget_show (WID ("login-label"));
@@ -1089,6 +1422,7 @@ cc_input_chooser_new (GtkWindow    *main_window,
 #ifdef HAVE_IBUS
   get_ibus_locale_infos (chooser);
 #endif  /* HAVE_IBUS */
+  build_search_docs (chooser);
   show_locale_rows (chooser);
 
   /* Try to come up with a sensible size */
@@ -1103,23 +1437,6 @@ cc_input_chooser_new (GtkWindow    *main_window,
   return chooser;
 }
 
-void
-cc_input_chooser_set_ibus_engines (GtkWidget  *chooser,
-                                   GHashTable *ibus_engines)
-{
-#ifdef HAVE_IBUS
-  CcInputChooserPrivate *priv = GET_PRIVATE (chooser);
-
-  /* This should only be called once when IBus shows up in case it
-     wasn't up yet when the user opened the input chooser dialog. */
-  g_return_if_fail (priv->ibus_engines == NULL);
-
-  priv->ibus_engines = ibus_engines;
-  get_ibus_locale_infos (chooser);
-  show_locale_rows (chooser);
-#endif  /* HAVE_IBUS */
-}
-
 gboolean
 cc_input_chooser_get_selected (GtkWidget  *chooser,
                                gchar     **type,
@@ -1156,5 +1473,6 @@ cc_input_chooser_reset (GtkWidget *chooser)
   gtk_entry_set_text (GTK_ENTRY (priv->filter_entry), "");
   gtk_widget_hide (priv->filter_entry);
   g_clear_pointer (&priv->filter_words, g_strfreev);
+  update_matches (chooser, NULL);
   show_locale_rows (chooser);
 }
@@ -20,18 +20,14 @@
 
 #include <gtk/gtk.h>
 
-#define GNOME_DESKTOP_USE_UNSTABLE_API
-#include <libgnome-desktop/gnome-xkb-info.h>
+#include "cc-input-catalogue.h"
 
 
 G_BEGIN_DECLS
 
-GtkWidget   *cc_input_chooser_new          (GtkWindow    *parent,
-                                            gboolean      is_login,
-                                            GnomeXkbInfo *xkb_info,
-                                            GHashTable   *ibus_engines);
-void         cc_input_chooser_set_ibus_engines (GtkWidget *chooser,
-                                                GHashTable *ibus_engines);
+GtkWidget   *cc_input_chooser_new          (GtkWindow        *parent,
+                                            gboolean          is_login,
+                                            CcInputCatalogue *catalogue);
 gboolean     cc_input_chooser_get_selected (GtkWidget    *chooser,
                                             gchar       **type,
                                             gchar       **id,
@@ -31,6 +31,7 @@
 #include "cc-region-resources.h"
 #include "cc-language-chooser.h"
 #include "cc-format-chooser.h"
+#include "cc-input-catalogue.h"
 #include "cc-input-chooser.h"
 #include "cc-input-options.h"
 
@@ -115,11 +116,10 @@ struct _CcRegionPanelPrivate {
         GtkWidget *show_layout;
 
         GSettings *input_settings;
+        CcInputCatalogue *catalogue;
         GnomeXkbInfo *xkb_info;
 #ifdef HAVE_IBUS
-        IBusBus *ibus;
         GHashTable *ibus_engines;
-        GCancellable *ibus_cancellable;
 #endif
 };
 
@@ -150,12 +150,9 @@ cc_region_panel_finalize (GObject *object)
         g_clear_object (&priv->locale_settings);
         g_clear_object (&priv->input_settings);
         g_clear_object (&priv->xkb_info);
+        g_clear_object (&priv->catalogue);
 #ifdef HAVE_IBUS
-        g_clear_object (&priv->ibus);
-        if (priv->ibus_cancellable)
-                g_cancellable_cancel (priv->ibus_cancellable);
-        g_clear_object (&priv->ibus_cancellable);
-        g_clear_pointer (&priv->ibus_engines, g_hash_table_destroy);
+        g_clear_pointer (&priv->ibus_engines, g_hash_table_unref);
 #endif
         g_free (priv->language);
         g_free (priv->region);
@@ -691,72 +688,16 @@ update_ibus_active_sources (CcRegionPanel *self)
 }
 
 static void
-update_input_chooser (CcRegionPanel *self)
+ibus_engines_changed (CcRegionPanel *self)
 {
         CcRegionPanelPrivate *priv = self->priv;
-        GtkWidget *chooser;
-
-        chooser = g_object_get_data (G_OBJECT (self), "input-chooser");
-        if (!chooser)
-                return;
-
-        cc_input_chooser_set_ibus_engines (chooser, priv->ibus_engines);
-}
-
-static void
-fetch_ibus_engines_result (GObject       *object,
-                           GAsyncResult  *result,
-                           CcRegionPanel *self)
-{
-        CcRegionPanelPrivate *priv;
-        GList *list, *l;
-        GError *error;
-
-        error = NULL;
-        list = ibus_bus_list_engines_async_finish (IBUS_BUS (object), result, &error);
-        if (!list && error) {
-                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-                        g_warning ("Couldn't finish IBus request: %s", error->message);
-                g_error_free (error);
-                return;
-        }
-
-        priv = self->priv;
-        g_clear_object (&priv->ibus_cancellable);
 
-        /* Maps engine ids to engine description objects */
-        priv->ibus_engines = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
-
-        for (l = list; l; l = l->next) {
-                IBusEngineDesc *engine = l->data;
-                const gchar *engine_id = ibus_engine_desc_get_name (engine);
-
-                if (g_str_has_prefix (engine_id, "xkb:"))
-                        g_object_unref (engine);
-                else
-                        g_hash_table_replace (priv->ibus_engines, (gpointer)engine_id, engine);
-        }
-        g_list_free (list);
+        g_clear_pointer (&priv->ibus_engines, g_hash_table_unref);
+        priv->ibus_engines = cc_input_catalogue_get_ibus_engines (priv->catalogue);
+        if (priv->ibus_engines)
+                g_hash_table_ref (priv->ibus_engines);
 
         update_ibus_active_sources (self);
-        update_input_chooser (self);
-}
-
-static void
-fetch_ibus_engines (CcRegionPanel *self)
-{
-        CcRegionPanelPrivate *priv = self->priv;
-
-        priv->ibus_cancellable = g_cancellable_new ();
-
-        ibus_bus_list_engines_async (priv->ibus,
-                                     -1,
-                                     priv->ibus_cancellable,
-                                     (GAsyncReadyCallback)fetch_ibus_engines_result,
-                                     self);
-
-  /* We've got everything we needed, don't want to be called again. */
-  g_signal_handlers_disconnect_by_func (priv->ibus, fetch_ibus_engines, self);
 }
 
 static void
@@ -1123,13 +1064,7 @@ show_input_chooser (CcRegionPanel *self)
                 toplevel = gtk_widget_get_toplevel (GTK_WIDGET (self));
                 chooser = cc_input_chooser_new (GTK_WINDOW (toplevel),
                                                 priv->login,
-                                                priv->xkb_info,
-#ifdef HAVE_IBUS
-                                                priv->ibus_engines
-#else
-                                                NULL
-#endif
-                                                );
+                                                priv->catalogue);
                 g_object_ref (chooser);
                 g_object_set_data_full (G_OBJECT (self), "input-chooser",
                                         chooser, g_object_unref);
@@ -1413,18 +1348,17 @@ setup_input_section (CcRegionPanel *self)
         priv->input_settings = g_settings_new (GNOME_DESKTOP_INPUT_SOURCES_DIR);
         g_settings_delay (priv->input_settings);
 
-        priv->xkb_info = gnome_xkb_info_new ();
+        /* Shared with every input chooser, and with later instances of
+         * the panel, so that the layouts and engines are only loaded once */
+        priv->catalogue = g_object_ref (cc_input_catalogue_get_default ());
+        priv->xkb_info = g_object_ref (cc_input_catalogue_get_xkb_info (priv->catalogue));
 
 #ifdef HAVE_IBUS
-        ibus_init ();
-        if (!priv->ibus) {
-                priv->ibus = ibus_bus_new_async ();
-                if (ibus_bus_is_connected (priv->ibus))
-                        fetch_ibus_engines (self);
-                else
-                        g_signal_connect_swapped (priv->ibus, "connected",
-                                                  G_CALLBACK (fetch_ibus_engines), self);
-        }
+        priv->ibus_engines = cc_input_catalogue_get_ibus_engines (priv->catalogue);
+        if (priv->ibus_engines)
+                g_hash_table_ref (priv->ibus_engines);
+        g_signal_connect_object (priv->catalogue, "ibus-engines-changed",
+                                 G_CALLBACK (ibus_engines_changed), self, G_CONNECT_SWAPPED);
         maybe_start_ibus ();
 #endif
 
@@ -39,9 +39,15 @@
 #define VERTICAL_BAR_WIDTH         6
 #define MIN_VERTICAL_BAR_HEIGHT    400
 
+/* How long the max peak marker stays put before falling, and how fast the
+ * bar and the marker fall, as a fraction of the whole bar per second */
+#define PEAK_HOLD_USEC             (1 * G_USEC_PER_SEC)
+#define PEAK_DECAY_PER_SEC         1.5
+
 typedef struct {
         int          peak_num;
         int          max_peak_num;
+        int          rms_num;
 
         GdkRectangle area;
         int          delta;
@@ -66,9 +72,12 @@ struct GvcLevelBarPrivate
         GtkAdjustment *rms_adjustment;
         GvcLevelScale  scale;
         gdouble        peak_fraction;
+        gdouble        target_peak_fraction;
         gdouble        rms_fraction;
         gdouble        max_peak;
-        guint          max_peak_id;
+        gint64         max_peak_time;
+        gint64         last_frame_time;
+        guint          tick_id;
         LevelBarLayout layout;
 };
 
@@ -95,13 +104,11 @@ G_DEFINE_TYPE (GvcLevelBar, gvc_level_bar, GTK_TYPE_WIDGET)
         }
 
 static gboolean
-layout_changed (LevelBarLayout *layout1,
-                LevelBarLayout *layout2)
+layout_style_changed (LevelBarLayout *layout1,
+                      LevelBarLayout *layout2)
 {
         check_rectangle (layout1->area, layout2->area);
         if (layout1->delta != layout2->delta) return TRUE;
-        if (layout1->peak_num != layout2->peak_num) return TRUE;
-        if (layout1->max_peak_num != layout2->max_peak_num) return TRUE;
         if (layout1->bg_r != layout2->bg_r
             || layout1->bg_g != layout2->bg_g
             || layout1->bg_b != layout2->bg_b)
@@ -118,6 +125,18 @@ layout_changed (LevelBarLayout *layout1,
         return FALSE;
 }
 
+static gboolean
+layout_changed (LevelBarLayout *layout1,
+                LevelBarLayout *layout2)
+{
+        if (layout_style_changed (layout1, layout2)) return TRUE;
+        if (layout1->peak_num != layout2->peak_num) return TRUE;
+        if (layout1->max_peak_num != layout2->max_peak_num) return TRUE;
+        if (layout1->rms_num != layout2->rms_num) return TRUE;
+
+        return FALSE;
+}
+
 static gdouble
 fraction_from_adjustment (GvcLevelBar   *bar,
                           GtkAdjustment *adjustment)
@@ -146,25 +165,29 @@ fraction_from_adjustment (GvcLevelBar   *bar,
         return fraction;
 }
 
-static gboolean
-reset_max_peak (GvcLevelBar *bar)
+static void
+bar_calc_levels (GvcLevelBar *bar)
 {
-        gdouble min;
+        int length;
 
-        min = gtk_adjustment_get_lower (bar->priv->peak_adjustment);
-        bar->priv->max_peak = min;
-        bar->priv->layout.max_peak_num = 0;
-        gtk_widget_queue_draw (GTK_WIDGET (bar));
-        bar->priv->max_peak_id = 0;
-        return FALSE;
+        /* This can happen if the level bar isn't realized */
+        if (bar->priv->layout.delta == 0)
+                return;
+
+        if (bar->priv->orientation == GTK_ORIENTATION_VERTICAL)
+                length = bar->priv->layout.area.height;
+        else
+                length = bar->priv->layout.area.width;
+
+        bar->priv->layout.peak_num = (int) (bar->priv->peak_fraction * length) / bar->priv->layout.delta;
+        bar->priv->layout.max_peak_num = (int) (bar->priv->max_peak * length) / bar->priv->layout.delta;
+        bar->priv->layout.rms_num = (int) (bar->priv->rms_fraction * length) / bar->priv->layout.delta;
 }
 
 static void
 bar_calc_layout (GvcLevelBar *bar)
 {
         GdkColor color;
-        int      peak_level;
-        int      max_peak_level;
         GtkAllocation allocation;
         GtkStyle *style;
 
@@ -187,9 +210,6 @@ bar_calc_layout (GvcLevelBar *bar)
         bar->priv->layout.fl_b = (float)color.blue / 65535.0;
 
         if (bar->priv->orientation == GTK_ORIENTATION_VERTICAL) {
-                peak_level = bar->priv->peak_fraction * bar->priv->layout.area.height;
-                max_peak_level = bar->priv->max_peak * bar->priv->layout.area.height;
-
                 bar->priv->layout.delta = bar->priv->layout.area.height / NUM_BOXES;
                 bar->priv->layout.area.x = 0;
                 bar->priv->layout.area.y = 0;
@@ -197,9 +217,6 @@ bar_calc_layout (GvcLevelBar *bar)
                 bar->priv->layout.box_width = bar->priv->layout.area.width;
                 bar->priv->layout.box_radius = bar->priv->layout.box_width / 2;
         } else {
-                peak_level = bar->priv->peak_fraction * bar->priv->layout.area.width;
-                max_peak_level = bar->priv->max_peak * bar->priv->layout.area.width;
-
                 bar->priv->layout.delta = bar->priv->layout.area.width / NUM_BOXES;
                 bar->priv->layout.area.x = 0;
                 bar->priv->layout.area.y = 0;
@@ -208,12 +225,145 @@ bar_calc_layout (GvcLevelBar *bar)
                 bar->priv->layout.box_radius = bar->priv->layout.box_height / 2;
         }
 
-        /* This can happen if the level bar isn't realized */
-        if (bar->priv->layout.delta == 0)
+        bar_calc_levels (bar);
+}
+
+static void
+queue_draw_boxes (GvcLevelBar *bar,
+                  int          first,
+                  int          last)
+{
+        GtkWidget     *widget = GTK_WIDGET (bar);
+        LevelBarLayout *layout = &bar->priv->layout;
+        GtkAllocation  allocation;
+        int            x, y, width, height;
+
+        first = MAX (first, 0);
+        last = MIN (last, NUM_BOXES - 1);
+        if (first > last)
+                return;
+
+        gtk_widget_get_allocation (widget, &allocation);
+
+        /* Pad by a pixel on each side for the border stroke */
+        if (bar->priv->orientation == GTK_ORIENTATION_VERTICAL) {
+                x = 0;
+                y = first * layout->delta - 1;
+                width = allocation.width;
+                height = (last - first) * layout->delta + layout->box_height + 2;
+        } else {
+                x = first * layout->delta - 1;
+                y = 0;
+                width = (last - first) * layout->delta + layout->box_width + 2;
+                height = allocation.height;
+
+                if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+                        x = allocation.width - x - width;
+        }
+
+        gtk_widget_queue_draw_area (widget, x, y, width, height);
+}
+
+static void
+queue_draw_level_change (GvcLevelBar *bar,
+                         int          old_num,
+                         int          new_num)
+{
+        /* Boxes are numbered from 1 in the layout, 0 meaning "none" */
+        if (old_num != new_num)
+                queue_draw_boxes (bar, MIN (old_num, new_num), MAX (old_num, new_num) - 1);
+}
+
+static void
+queue_draw_marker_change (GvcLevelBar *bar,
+                          int          old_num,
+                          int          new_num)
+{
+        if (old_num != new_num) {
+                queue_draw_boxes (bar, old_num - 1, old_num - 1);
+                queue_draw_boxes (bar, new_num - 1, new_num - 1);
+        }
+}
+
+/* Only damages the boxes that changed since the @old layout */
+static void
+queue_draw_layout_change (GvcLevelBar    *bar,
+                          LevelBarLayout *old)
+{
+        LevelBarLayout *layout = &bar->priv->layout;
+
+        if (!gtk_widget_is_drawable (GTK_WIDGET (bar)))
+                return;
+
+        if (layout_style_changed (layout, old)) {
+                gtk_widget_queue_draw (GTK_WIDGET (bar));
                 return;
+        }
+
+        queue_draw_level_change (bar, old->peak_num, layout->peak_num);
+        queue_draw_level_change (bar, old->rms_num, layout->rms_num);
+        queue_draw_marker_change (bar, old->max_peak_num, layout->max_peak_num);
+}
 
-        bar->priv->layout.peak_num = peak_level / bar->priv->layout.delta;
-        bar->priv->layout.max_peak_num = max_peak_level / bar->priv->layout.delta;
+static gboolean
+bar_is_animating (GvcLevelBar *bar)
+{
+        return bar->priv->peak_fraction > bar->priv->target_peak_fraction
+                || bar->priv->max_peak > bar->priv->peak_fraction;
+}
+
+static gboolean
+on_frame_tick (GtkWidget     *widget,
+               GdkFrameClock *frame_clock,
+               gpointer       user_data)
+{
+        GvcLevelBar   *bar = GVC_LEVEL_BAR (widget);
+        LevelBarLayout layout;
+        gint64         now;
+        gdouble        fall;
+
+        now = gdk_frame_clock_get_frame_time (frame_clock);
+        if (bar->priv->last_frame_time > 0)
+                fall = PEAK_DECAY_PER_SEC * (now - bar->priv->last_frame_time) / G_USEC_PER_SEC;
+        else
+                fall = 0.0;
+        bar->priv->last_frame_time = now;
+
+        if (bar->priv->peak_fraction > bar->priv->target_peak_fraction) {
+                bar->priv->peak_fraction = MAX (bar->priv->target_peak_fraction,
+                                                bar->priv->peak_fraction - fall);
+        }
+
+        if (bar->priv->max_peak > bar->priv->peak_fraction
+            && now - bar->priv->max_peak_time > PEAK_HOLD_USEC) {
+                bar->priv->max_peak = MAX (bar->priv->peak_fraction,
+                                           bar->priv->max_peak - fall);
+        }
+
+        layout = bar->priv->layout;
+        bar_calc_levels (bar);
+        queue_draw_layout_change (bar, &layout);
+
+        if (!bar_is_animating (bar)) {
+                bar->priv->tick_id = 0;
+                bar->priv->last_frame_time = 0;
+                return G_SOURCE_REMOVE;
+        }
+
+        return G_SOURCE_CONTINUE;
+}
+
+static void
+ensure_frame_tick (GvcLevelBar *bar)
+{
+        if (bar->priv->tick_id != 0 || !bar_is_animating (bar))
+                return;
+
+        bar->priv->last_frame_time = 0;
+        bar->priv->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (bar),
+                                                           on_frame_tick,
+                                                           NULL,
+                                                           NULL);
 }
 
 static void
@@ -225,30 +375,39 @@ update_peak_value (GvcLevelBar *bar)
         layout = bar->priv->layout;
 
         val = fraction_from_adjustment (bar, bar->priv->peak_adjustment);
-        bar->priv->peak_fraction = val;
+        bar->priv->target_peak_fraction = val;
 
-        if (val > bar->priv->max_peak) {
-                if (bar->priv->max_peak_id > 0) {
-                        g_source_remove (bar->priv->max_peak_id);
-                }
-                bar->priv->max_peak_id = g_timeout_add_seconds (1, (GSourceFunc)reset_max_peak, bar);
+        /* Rises are shown straight away, falls are animated from
+         * the frame clock */
+        if (val >= bar->priv->peak_fraction)
+                bar->priv->peak_fraction = val;
+
+        if (val >= bar->priv->max_peak) {
                 bar->priv->max_peak = val;
+                bar->priv->max_peak_time = g_get_monotonic_time ();
         }
 
         bar_calc_layout (bar);
 
-        if (layout_changed (&bar->priv->layout, &layout)) {
-                gtk_widget_queue_draw (GTK_WIDGET (bar));
-        }
+        if (layout_changed (&bar->priv->layout, &layout))
+                queue_draw_layout_change (bar, &layout);
+
+        ensure_frame_tick (bar);
 }
 
 static void
 update_rms_value (GvcLevelBar *bar)
 {
-        gdouble val;
+        gdouble        val;
+        LevelBarLayout layout;
+
+        layout = bar->priv->layout;
 
         val = fraction_from_adjustment (bar, bar->priv->rms_adjustment);
         bar->priv->rms_fraction = val;
+
+        bar_calc_levels (bar);
+        queue_draw_layout_change (bar, &layout);
 }
 
 GtkOrientation
@@ -319,7 +478,7 @@ gvc_level_bar_set_rms_adjustment (GvcLevelBar   *bar,
         g_return_if_fail (GTK_IS_ADJUSTMENT (adjustment));
 
         if (bar->priv->rms_adjustment != NULL) {
-                g_signal_handlers_disconnect_by_func (bar->priv->peak_adjustment,
+                g_signal_handlers_disconnect_by_func (bar->priv->rms_adjustment,
                                                       G_CALLBACK (on_rms_adjustment_value_changed),
                                                       bar);
                 g_object_unref (bar->priv->rms_adjustment);
@@ -328,9 +487,9 @@ gvc_level_bar_set_rms_adjustment (GvcLevelBar   *bar,
         bar->priv->rms_adjustment = g_object_ref_sink (adjustment);
 
 
-        g_signal_connect (bar->priv->peak_adjustment,
+        g_signal_connect (bar->priv->rms_adjustment,
                           "value-changed",
-                          G_CALLBACK (on_peak_adjustment_value_changed),
+                          G_CALLBACK (on_rms_adjustment_value_changed),
                           bar);
 
         update_rms_value (bar);
@@ -600,6 +759,13 @@ gvc_level_bar_draw (GtkWidget *widget,
                                 /* fill peak foreground */
                                 cairo_set_source_rgb (cr, bar->priv->layout.fl_r, bar->priv->layout.fl_g, bar->priv->layout.fl_b);
                                 cairo_fill_preserve (cr);
+                        } else if ((bar->priv->layout.rms_num - 1) >= i) {
+                                /* fill background */
+                                cairo_set_source_rgb (cr, bar->priv->layout.bg_r, bar->priv->layout.bg_g, bar->priv->layout.bg_b);
+                                cairo_fill_preserve (cr);
+                                /* fill rms foreground */
+                                cairo_set_source_rgba (cr, bar->priv->layout.fl_r, bar->priv->layout.fl_g, bar->priv->layout.fl_b, 0.8);
+                                cairo_fill_preserve (cr);
                         } else if ((bar->priv->layout.peak_num - 1) >= i) {
                                 /* fill background */
                                 cairo_set_source_rgb (cr, bar->priv->layout.bg_r, bar->priv->layout.bg_g, bar->priv->layout.bg_b);
@@ -641,6 +807,13 @@ gvc_level_bar_draw (GtkWidget *widget,
                                 /* fill peak foreground */
                                 cairo_set_source_rgb (cr, bar->priv->layout.fl_r, bar->priv->layout.fl_g, bar->priv->layout.fl_b);
                                 cairo_fill_preserve (cr);
+                        } else if ((bar->priv->layout.rms_num - 1) >= i) {
+                                /* fill background */
+                                cairo_set_source_rgb (cr, bar->priv->layout.bg_r, bar->priv->layout.bg_g, bar->priv->layout.bg_b);
+                                cairo_fill_preserve (cr);
+                                /* fill rms foreground */
+                                cairo_set_source_rgba (cr, bar->priv->layout.fl_r, bar->priv->layout.fl_g, bar->priv->layout.fl_b, 0.8);
+                                cairo_fill_preserve (cr);
                         } else if ((bar->priv->layout.peak_num - 1) >= i) {
                                 /* fill background */
                                 cairo_set_source_rgb (cr, bar->priv->layout.bg_r, bar->priv->layout.bg_g, bar->priv->layout.bg_b);
@@ -759,10 +932,6 @@ gvc_level_bar_finalize (GObject *object)
 
         bar = GVC_LEVEL_BAR (object);
 
-        if (bar->priv->max_peak_id > 0) {
-                g_source_remove (bar->priv->max_peak_id);
-        }
-
         g_return_if_fail (bar->priv != NULL);
 
         G_OBJECT_CLASS (gvc_level_bar_parent_class)->finalize (object);
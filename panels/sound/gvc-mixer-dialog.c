@@ -37,6 +37,7 @@
 #include "gvc-mixer-card.h"
 #include "gvc-mixer-sink.h"
 #include "gvc-mixer-source.h"
+#include "gvc-mixer-sink-input.h"
 #include "gvc-mixer-source-output.h"
 #include "gvc-mixer-dialog.h"
 #include "gvc-sound-theme-chooser.h"
@@ -51,7 +52,10 @@
 struct GvcMixerDialogPrivate
 {
         GvcMixerControl *mixer_control;
-        GHashTable      *bars; /* Application and event bars only */
+        GHashTable      *bars; /* stream id -> bar, for all the bars */
+        GHashTable      *app_meters; /* stream id -> AppMeter */
+        GHashTable      *meter_streams; /* key -> MeterStream, shared by the AppMeters */
+        gboolean         app_meters_enabled;
         GtkWidget       *notebook;
         GtkWidget       *output_bar;
         GtkWidget       *input_bar;
@@ -78,8 +82,30 @@ struct GvcMixerDialogPrivate
         GtkWidget       *test_dialog;
         GtkSizeGroup    *size_group;
 
+        /* UI device id -> GtkTreeIter, list store iters are persistent */
+        GHashTable      *output_rows;
+        GHashTable      *input_rows;
+        guint            active_output_id;
+        guint            active_input_id;
+
+        /* Active device changes and new streams come in bursts when a
+         * card profile changes, they are applied together from an idle,
+         * and only the last active device change of each is kept */
+        guint            pending_update_id;
+        GQueue           pending_streams; /* stream ids, in arrival order */
+        gboolean         output_update_pending;
+        guint            pending_output_id;
+        gboolean         input_update_pending;
+        guint            pending_input_id;
+
         gdouble          last_input_peak;
+        gdouble          last_input_rms;
         guint            num_apps;
+
+        /* Input level, accumulated from the monitor stream */
+        gfloat           pending_peak;
+        gdouble          pending_sum_sq;
+        gsize            pending_samples;
 };
 
 enum {
@@ -284,37 +310,106 @@ update_output_settings (GvcMixerDialog      *dialog,
         gtk_widget_set_sensitive (dialog->priv->output_balance_bar, gvc_channel_map_can_balance (map));
 }
 
-#define DECAY_STEP .15
+/* Rate of the server-side peak detection streams */
+#define PEAK_DETECT_RATE 25
+
+/* The input meter records real samples and does the peak and RMS
+ * detection itself; 8 kHz mono is plenty for a level meter, and one
+ * fragment per 20 ms is below the refresh rate of the display. */
+#define INPUT_METER_RATE 8000
+#define INPUT_METER_FRAGMENT_MSEC 20
 
+/* Level changes smaller than this are not worth a redraw */
+#define INPUT_METER_EPSILON 0.002
+
+/* GvcLevelBar animates the falls of the peak itself, so the raw
+ * value is passed on */
 static void
 update_input_peak (GvcMixerDialog *dialog,
                    gdouble         v)
 {
         GtkAdjustment *adj;
 
-        if (dialog->priv->last_input_peak >= DECAY_STEP) {
-                if (v < dialog->priv->last_input_peak - DECAY_STEP) {
-                        v = dialog->priv->last_input_peak - DECAY_STEP;
-                }
-        }
-
+        v = CLAMP (v, 0.0, 1.0);
+        if (fabs (v - dialog->priv->last_input_peak) < INPUT_METER_EPSILON && v > 0.0)
+                return;
         dialog->priv->last_input_peak = v;
 
         adj = gvc_level_bar_get_peak_adjustment (GVC_LEVEL_BAR (dialog->priv->input_level_bar));
-        if (v >= 0) {
-                gtk_adjustment_set_value (adj, v);
-        } else {
-                gtk_adjustment_set_value (adj, 0.0);
+        gtk_adjustment_set_value (adj, v);
+}
+
+static void
+update_input_rms (GvcMixerDialog *dialog,
+                  gdouble         v)
+{
+        GtkAdjustment *adj;
+
+        v = CLAMP (v, 0.0, 1.0);
+        if (fabs (v - dialog->priv->last_input_rms) < INPUT_METER_EPSILON && v > 0.0)
+                return;
+        dialog->priv->last_input_rms = v;
+
+        adj = gvc_level_bar_get_rms_adjustment (GVC_LEVEL_BAR (dialog->priv->input_level_bar));
+        gtk_adjustment_set_value (adj, v);
+}
+
+/* Computes the absolute peak and the sum of squares of a block of samples.
+ * The work is spread over four independent lanes so that the compiler can
+ * map the loop onto SIMD registers and the reductions don't serialise. */
+static void
+compute_peak_and_sum_sq (const float *samples,
+                         gsize        n_samples,
+                         gfloat      *peak,
+                         gdouble     *sum_sq)
+{
+        gfloat lane_peak[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        gfloat lane_sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        gfloat max;
+        gsize  i, j;
+
+        for (i = 0; i + 4 <= n_samples; i += 4) {
+                for (j = 0; j < 4; j++) {
+                        gfloat v = fabsf (samples[i + j]);
+
+                        lane_peak[j] = v > lane_peak[j] ? v : lane_peak[j];
+                        lane_sum[j] += v * v;
+                }
+        }
+        for (j = 0; i < n_samples; i++, j++) {
+                gfloat v = fabsf (samples[i]);
+
+                lane_peak[j] = v > lane_peak[j] ? v : lane_peak[j];
+                lane_sum[j] += v * v;
         }
+
+        max = MAX (MAX (lane_peak[0], lane_peak[1]), MAX (lane_peak[2], lane_peak[3]));
+        *peak = MAX (*peak, max);
+        *sum_sq += (gdouble) lane_sum[0] + lane_sum[1] + lane_sum[2] + lane_sum[3];
 }
 
 static void
-update_input_meter (GvcMixerDialog *dialog,
-                    uint32_t        source_index,
-                    uint32_t        sink_input_idx,
-                    double          v)
+reset_pending_input_level (GvcMixerDialog *dialog)
 {
-        update_input_peak (dialog, v);
+        dialog->priv->pending_peak = 0.0f;
+        dialog->priv->pending_sum_sq = 0.0;
+        dialog->priv->pending_samples = 0;
+}
+
+static void
+flush_input_level (GvcMixerDialog *dialog)
+{
+        gdouble         rms;
+
+        if (dialog->priv->pending_samples == 0)
+                return;
+
+        rms = sqrt (dialog->priv->pending_sum_sq / dialog->priv->pending_samples);
+
+        update_input_peak (dialog, dialog->priv->pending_peak);
+        update_input_rms (dialog, rms);
+
+        reset_pending_input_level (dialog);
 }
 
 static void
@@ -327,10 +422,9 @@ on_monitor_suspended_callback (pa_stream *s,
 
         if (pa_stream_is_suspended (s)) {
                 g_debug ("Stream suspended");
-                update_input_meter (dialog,
-                                    pa_stream_get_device_index (s),
-                                    PA_INVALID_INDEX,
-                                    -1);
+                reset_pending_input_level (dialog);
+                update_input_rms (dialog, 0.0);
+                update_input_peak (dialog, 0.0);
         }
 }
 
@@ -341,38 +435,31 @@ on_monitor_read_callback (pa_stream *s,
 {
         GvcMixerDialog *dialog;
         const void     *data;
-        double          v;
 
         dialog = userdata;
 
-        if (pa_stream_peek (s, &data, &length) < 0) {
-                g_warning ("Failed to read data from stream");
-                return;
-        }
-
-        if (!data) {
-                pa_stream_drop (s);
-                return;
-        }
-
-        assert (length > 0);
-        assert (length % sizeof (float) == 0);
+        while (pa_stream_readable_size (s) > 0) {
+                if (pa_stream_peek (s, &data, &length) < 0) {
+                        g_warning ("Failed to read data from stream");
+                        return;
+                }
 
-        v = ((const float *) data)[length / sizeof (float) -1];
+                if (length == 0)
+                        break;
 
-        pa_stream_drop (s);
+                /* data is NULL when there's a hole in the buffer */
+                if (data != NULL) {
+                        compute_peak_and_sum_sq (data,
+                                                 length / sizeof (float),
+                                                 &dialog->priv->pending_peak,
+                                                 &dialog->priv->pending_sum_sq);
+                        dialog->priv->pending_samples += length / sizeof (float);
+                }
 
-        if (v < 0) {
-                v = 0;
-        }
-        if (v > 1) {
-                v = 1;
+                pa_stream_drop (s);
         }
 
-        update_input_meter (dialog,
-                            pa_stream_get_device_index (s),
-                            pa_stream_get_monitor_stream (s),
-                            v);
+        flush_input_level (dialog);
 }
 
 static void
@@ -386,6 +473,7 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
         pa_context    *context;
         int            res;
         pa_proplist   *proplist;
+        pa_stream_flags_t flags;
         gboolean       has_monitor;
 
         if (stream == NULL) {
@@ -407,12 +495,14 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
 
         ss.channels = 1;
         ss.format = PA_SAMPLE_FLOAT32;
-        ss.rate = 25;
 
         memset (&attr, 0, sizeof (attr));
-        attr.fragsize = sizeof (float);
         attr.maxlength = (uint32_t) -1;
 
+        ss.rate = INPUT_METER_RATE;
+        attr.fragsize = pa_usec_to_bytes (INPUT_METER_FRAGMENT_MSEC * PA_USEC_PER_MSEC, &ss);
+        flags = PA_STREAM_DONT_MOVE | PA_STREAM_ADJUST_LATENCY;
+
         snprintf (t, sizeof (t), "%u", gvc_mixer_stream_get_index (stream));
 
         proplist = pa_proplist_new ();
@@ -427,12 +517,7 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
         pa_stream_set_read_callback (s, on_monitor_read_callback, dialog);
         pa_stream_set_suspended_callback (s, on_monitor_suspended_callback, dialog);
 
-        res = pa_stream_connect_record (s,
-                                        t,
-                                        &attr,
-                                        (pa_stream_flags_t) (PA_STREAM_DONT_MOVE
-                                                             |PA_STREAM_PEAK_DETECT
-                                                             |PA_STREAM_ADJUST_LATENCY));
+        res = pa_stream_connect_record (s, t, &attr, flags);
         if (res < 0) {
                 g_warning ("Failed to connect monitoring stream");
                 pa_stream_unref (s);
@@ -440,6 +525,8 @@ create_monitor_stream_for_source (GvcMixerDialog *dialog,
                 g_object_set_data (G_OBJECT (stream), "has-monitor", GINT_TO_POINTER (TRUE));
                 g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "pa_stream", s);
                 g_object_set_data (G_OBJECT (dialog->priv->input_level_bar), "stream", stream);
+
+                reset_pending_input_level (dialog);
         }
 }
 
@@ -675,18 +762,8 @@ static GtkWidget *
 lookup_bar_for_stream (GvcMixerDialog *dialog,
                        GvcMixerStream *stream)
 {
-        GtkWidget *bar;
-
-        bar = g_hash_table_lookup (dialog->priv->bars, GUINT_TO_POINTER (gvc_mixer_stream_get_id (stream)));
-        if (bar)
-                return bar;
-
-        if (g_object_get_data (G_OBJECT (dialog->priv->output_bar), "gvc-mixer-dialog-stream") == stream)
-                return dialog->priv->output_bar;
-        if (g_object_get_data (G_OBJECT (dialog->priv->input_bar), "gvc-mixer-dialog-stream") == stream)
-                return dialog->priv->input_bar;
-
-        return NULL;
+        return g_hash_table_lookup (dialog->priv->bars,
+                                    GUINT_TO_POINTER (gvc_mixer_stream_get_id (stream)));
 }
 
 static void
@@ -809,49 +886,414 @@ create_app_bar (GvcMixerDialog *dialog,
         return bar;
 }
 
-/* active_input_update
- * Handle input update change from the backend (control).
- * Trust the backend whole-heartedly to deliver the correct input. */
+/* Per-application level meters, shown when enabled on the
+ * Applications page.
+ * Playback streams are metered through a low-rate peak detect stream
+ * on the monitor of the sink they play to, restricted to that sink
+ * input. The server has no such restriction for recording streams, so
+ * they are metered on the source they record from. Meters on the same
+ * source share its peak detect stream. The streams are only connected
+ * while the Applications page is visible. */
+typedef struct {
+        GvcMixerDialog *dialog;
+        char           *key;
+        pa_stream      *pa_stream;
+        GList          *meters;
+} MeterStream;
+
+typedef struct {
+        GvcMixerDialog *dialog;
+        guint           index;
+        gboolean        is_source_output;
+        GtkWidget      *level_bar;
+        MeterStream    *stream;
+        pa_operation   *info_op;
+} AppMeter;
+
+/* GvcLevelBar animates the falls of the peak itself */
 static void
-active_input_update (GvcMixerDialog *dialog,
-                     GvcMixerUIDevice *active_input)
+app_meter_set_peak (AppMeter *meter,
+                    gdouble   v)
 {
-        /* First make sure the correct UI device is selected. */
-        GtkTreeModel   *model;
-        GtkTreeIter     iter;
-        GvcMixerStream *stream;
+        GtkAdjustment *adj;
 
-        g_debug ("active_input_update device id = %i",
-                 gvc_mixer_ui_device_get_id (active_input));
+        adj = gvc_level_bar_get_peak_adjustment (GVC_LEVEL_BAR (meter->level_bar));
+        gtk_adjustment_set_value (adj, CLAMP (v, 0.0, 1.0));
+}
 
-        model = gtk_tree_view_get_model (GTK_TREE_VIEW (dialog->priv->input_treeview));
+static void
+on_meter_stream_read_callback (pa_stream *s,
+                               size_t     length,
+                               void      *userdata)
+{
+        MeterStream *ms = userdata;
+        const void  *data;
+        gdouble      v;
+        GList       *l;
 
-        if (gtk_tree_model_get_iter_first (model, &iter) == FALSE) {
-                g_warning ("No devices in the tree, so cannot set the active output");
+        if (pa_stream_peek (s, &data, &length) < 0) {
+                g_warning ("Failed to read data from stream");
                 return;
         }
 
-        do {
-                gboolean         is_selected = FALSE;
-                gint             id;
+        if (length == 0)
+                return;
 
-                gtk_tree_model_get (model, &iter,
-                                    ID_COLUMN, &id,
-                                    -1);
+        if (data == NULL) {
+                pa_stream_drop (s);
+                return;
+        }
+
+        v = ((const float *) data)[length / sizeof (float) - 1];
+
+        pa_stream_drop (s);
+
+        for (l = ms->meters; l != NULL; l = l->next)
+                app_meter_set_peak (l->data, v);
+}
+
+/* Connects a peak detect stream to @device, or to the monitor of the
+ * sink @sink_input plays to when @device is %NULL */
+static MeterStream *
+meter_stream_new (GvcMixerDialog *dialog,
+                  const char     *key,
+                  const char     *device,
+                  guint           sink_input)
+{
+        MeterStream   *ms;
+        pa_context    *context;
+        pa_sample_spec ss;
+        pa_buffer_attr attr;
+        pa_proplist   *proplist;
+        pa_stream     *s;
+
+        context = gvc_mixer_control_get_pa_context (dialog->priv->mixer_control);
+
+        ss.channels = 1;
+        ss.format = PA_SAMPLE_FLOAT32;
+        ss.rate = PEAK_DETECT_RATE;
+
+        memset (&attr, 0, sizeof (attr));
+        attr.fragsize = sizeof (float);
+        attr.maxlength = (uint32_t) -1;
+
+        proplist = pa_proplist_new ();
+        pa_proplist_sets (proplist, PA_PROP_APPLICATION_ID, "org.gnome.VolumeControl");
+        s = pa_stream_new_with_proplist (context, _("Peak detect"), &ss, NULL, proplist);
+        pa_proplist_free (proplist);
+        if (s == NULL) {
+                g_warning ("Failed to create monitoring stream");
+                return NULL;
+        }
+
+        /* Without a device, the server picks the monitor of the sink
+         * the monitored sink input is playing to */
+        if (device == NULL)
+                pa_stream_set_monitor_stream (s, sink_input);
+
+        ms = g_new0 (MeterStream, 1);
+        ms->dialog = dialog;
+        ms->key = g_strdup (key);
+        pa_stream_set_read_callback (s, on_meter_stream_read_callback, ms);
+
+        if (pa_stream_connect_record (s,
+                                      device,
+                                      &attr,
+                                      (pa_stream_flags_t) (PA_STREAM_DONT_MOVE
+                                                           |PA_STREAM_PEAK_DETECT
+                                                           |PA_STREAM_ADJUST_LATENCY
+                                                           |PA_STREAM_DONT_INHIBIT_AUTO_SUSPEND)) < 0) {
+                g_warning ("Failed to connect monitoring stream");
+                pa_stream_set_read_callback (s, NULL, NULL);
+                pa_stream_unref (s);
+                g_free (ms->key);
+                g_free (ms);
+                return NULL;
+        }
+
+        ms->pa_stream = s;
+        g_hash_table_insert (dialog->priv->meter_streams, ms->key, ms);
+
+        return ms;
+}
+
+static void
+meter_stream_free (MeterStream *ms)
+{
+        g_hash_table_remove (ms->dialog->priv->meter_streams, ms->key);
+
+        pa_stream_set_read_callback (ms->pa_stream, NULL, NULL);
+        pa_stream_disconnect (ms->pa_stream);
+        pa_stream_unref (ms->pa_stream);
+        g_free (ms->key);
+        g_free (ms);
+}
+
+static void
+app_meter_attach (AppMeter   *meter,
+                  const char *device)
+{
+        MeterStream *ms;
+        char        *key;
+
+        if (device != NULL)
+                key = g_strdup_printf ("source-%s", device);
+        else
+                key = g_strdup_printf ("sink-input-%u", meter->index);
+
+        ms = g_hash_table_lookup (meter->dialog->priv->meter_streams, key);
+        if (ms == NULL)
+                ms = meter_stream_new (meter->dialog, key, device, meter->index);
+        g_free (key);
+
+        if (ms == NULL)
+                return;
+
+        ms->meters = g_list_prepend (ms->meters, meter);
+        meter->stream = ms;
+}
+
+static void
+app_meter_detach (AppMeter *meter)
+{
+        MeterStream *ms = meter->stream;
+
+        if (ms == NULL)
+                return;
+
+        meter->stream = NULL;
+        ms->meters = g_list_remove (ms->meters, meter);
+        if (ms->meters == NULL)
+                meter_stream_free (ms);
+}
+
+static void
+on_source_output_info (pa_context                  *c,
+                       const pa_source_output_info *i,
+                       int                          eol,
+                       void                        *userdata)
+{
+        AppMeter *meter = userdata;
+        char      device[16];
+
+        if (eol != 0) {
+                pa_operation_unref (meter->info_op);
+                meter->info_op = NULL;
+                return;
+        }
+
+        if (meter->stream == NULL) {
+                snprintf (device, sizeof (device), "%u", i->source);
+                app_meter_attach (meter, device);
+        }
+}
+
+static void
+app_meter_start (AppMeter *meter)
+{
+        pa_context *context;
+
+        if (meter->stream != NULL || meter->info_op != NULL)
+                return;
+
+        context = gvc_mixer_control_get_pa_context (meter->dialog->priv->mixer_control);
+        if (pa_context_get_server_protocol_version (context) < 13)
+                return;
+
+        if (meter->is_source_output) {
+                meter->info_op = pa_context_get_source_output_info (context,
+                                                                    meter->index,
+                                                                    on_source_output_info,
+                                                                    meter);
+        } else {
+                app_meter_attach (meter, NULL);
+        }
+}
+
+static void
+app_meter_stop (AppMeter *meter)
+{
+        if (meter->info_op != NULL) {
+                pa_operation_cancel (meter->info_op);
+                pa_operation_unref (meter->info_op);
+                meter->info_op = NULL;
+        }
 
-                is_selected = id == gvc_mixer_ui_device_get_id (active_input);
+        app_meter_detach (meter);
 
+        app_meter_set_peak (meter, 0.0);
+}
+
+static void
+app_meter_free (AppMeter *meter)
+{
+        app_meter_stop (meter);
+        gtk_widget_destroy (meter->level_bar);
+        g_object_unref (meter->level_bar);
+        g_free (meter);
+}
+
+static void
+add_app_meter (GvcMixerDialog *dialog,
+               GtkWidget      *bar,
+               GvcMixerStream *stream)
+{
+        AppMeter *meter;
+
+        if (!GVC_IS_MIXER_SINK_INPUT (stream) && !GVC_IS_MIXER_SOURCE_OUTPUT (stream))
+                return;
+
+        meter = g_new0 (AppMeter, 1);
+        meter->dialog = dialog;
+        meter->index = gvc_mixer_stream_get_index (stream);
+        meter->is_source_output = GVC_IS_MIXER_SOURCE_OUTPUT (stream);
+
+        /* Horizontal like the input level, next to the volume slider */
+        meter->level_bar = g_object_ref (gvc_level_bar_new ());
+        gvc_level_bar_set_scale (GVC_LEVEL_BAR (meter->level_bar),
+                                 GVC_LEVEL_SCALE_LINEAR);
+        gtk_widget_set_valign (meter->level_bar, GTK_ALIGN_CENTER);
+        gtk_box_pack_start (GTK_BOX (bar), meter->level_bar, FALSE, FALSE, 0);
+        gtk_widget_show (meter->level_bar);
+
+        g_hash_table_insert (dialog->priv->app_meters,
+                             GUINT_TO_POINTER (gvc_mixer_stream_get_id (stream)),
+                             meter);
+
+        if (gtk_widget_get_mapped (dialog->priv->applications_box))
+                app_meter_start (meter);
+}
+
+static void
+on_app_meters_toggled (GtkToggleButton *button,
+                       GvcMixerDialog  *dialog)
+{
+        GHashTableIter iter;
+        gpointer       key;
+        GtkWidget     *bar;
+
+        dialog->priv->app_meters_enabled = gtk_toggle_button_get_active (button);
+
+        if (!dialog->priv->app_meters_enabled) {
+                g_hash_table_remove_all (dialog->priv->app_meters);
+                return;
+        }
+
+        g_hash_table_iter_init (&iter, dialog->priv->bars);
+        while (g_hash_table_iter_next (&iter, &key, (gpointer *) &bar)) {
+                GvcMixerStream *stream;
+
+                if (bar == dialog->priv->output_bar ||
+                    bar == dialog->priv->input_bar ||
+                    bar == dialog->priv->effects_bar)
+                        continue;
+
+                stream = gvc_mixer_control_lookup_stream_id (dialog->priv->mixer_control,
+                                                             GPOINTER_TO_UINT (key));
+                if (stream != NULL)
+                        add_app_meter (dialog, bar, stream);
+        }
+}
+
+static void
+on_applications_box_map (GtkWidget      *widget,
+                         GvcMixerDialog *dialog)
+{
+        GHashTableIter iter;
+        AppMeter      *meter;
+
+        if (dialog->priv->app_meters == NULL)
+                return;
+
+        g_hash_table_iter_init (&iter, dialog->priv->app_meters);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &meter))
+                app_meter_start (meter);
+}
+
+static void
+on_applications_box_unmap (GtkWidget      *widget,
+                           GvcMixerDialog *dialog)
+{
+        GHashTableIter iter;
+        AppMeter      *meter;
+
+        if (dialog->priv->app_meters == NULL)
+                return;
+
+        g_hash_table_iter_init (&iter, dialog->priv->app_meters);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &meter))
+                app_meter_stop (meter);
+}
+
+static gboolean
+find_item_by_id (GHashTable  *rows,
+                 guint        id,
+                 GtkTreeIter *iter)
+{
+        GtkTreeIter *row;
+
+        row = g_hash_table_lookup (rows, GUINT_TO_POINTER (id));
+        if (row == NULL)
+                return FALSE;
+
+        *iter = *row;
+        return TRUE;
+}
+
+/* Moves the active mark from the previously active row to @id's,
+ * without walking the model */
+static void
+set_active_row (GvcMixerDialog *dialog,
+                GtkWidget      *treeview,
+                GHashTable     *rows,
+                guint          *active_id,
+                guint           id)
+{
+        GtkTreeModel *model;
+        GtkTreeIter   iter;
+
+        model = gtk_tree_view_get_model (GTK_TREE_VIEW (treeview));
+
+        if (*active_id != id && find_item_by_id (rows, *active_id, &iter)) {
                 gtk_list_store_set (GTK_LIST_STORE (model),
                                     &iter,
-                                    ACTIVE_COLUMN, is_selected,
+                                    ACTIVE_COLUMN, FALSE,
                                     -1);
+        }
 
-                if (is_selected) {
-                        GtkTreeSelection *selection;
-                        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (dialog->priv->input_treeview));
-                        gtk_tree_selection_select_iter (selection, &iter);
-                }
-        } while (gtk_tree_model_iter_next (model, &iter));
+        *active_id = id;
+
+        if (!find_item_by_id (rows, id, &iter)) {
+                g_warning ("No device with id %u in the tree, so cannot set it active", id);
+                return;
+        }
+
+        gtk_list_store_set (GTK_LIST_STORE (model),
+                            &iter,
+                            ACTIVE_COLUMN, TRUE,
+                            -1);
+        gtk_tree_selection_select_iter (gtk_tree_view_get_selection (GTK_TREE_VIEW (treeview)),
+                                        &iter);
+}
+
+/* active_input_update
+ * Handle input update change from the backend (control).
+ * Trust the backend whole-heartedly to deliver the correct input. */
+static void
+active_input_update (GvcMixerDialog *dialog,
+                     GvcMixerUIDevice *active_input)
+{
+        GvcMixerStream *stream;
+
+        g_debug ("active_input_update device id = %i",
+                 gvc_mixer_ui_device_get_id (active_input));
+
+        /* First make sure the correct UI device is selected. */
+        set_active_row (dialog,
+                        dialog->priv->input_treeview,
+                        dialog->priv->input_rows,
+                        &dialog->priv->active_input_id,
+                        gvc_mixer_ui_device_get_id (active_input));
 
         stream = gvc_mixer_control_get_stream_from_device (dialog->priv->mixer_control,
                                                            active_input);
@@ -873,48 +1315,22 @@ static void
 active_output_update (GvcMixerDialog   *dialog,
                       GvcMixerUIDevice *active_output)
 {
-        /* First make sure the correct UI device is selected. */
         GvcMixerStream *stream;
-        GtkTreeModel   *model;
-        GtkTreeIter     iter;
 
         g_debug ("active output update device id = %i",
                  gvc_mixer_ui_device_get_id (active_output));
 
-        model = gtk_tree_view_get_model (GTK_TREE_VIEW (dialog->priv->output_treeview));
-
-        if (gtk_tree_model_get_iter_first (model, &iter) == FALSE){
-                g_warning ("No devices in the tree, so cannot set the active output");
-                return;
+        if (dialog->priv->active_output_id == gvc_mixer_ui_device_get_id (active_output)) {
+                /* XXX: profile change on the same device? */
+                g_debug ("Unneccessary active output update");
         }
 
-        do {
-                gboolean         is_selected;
-                gint             id;
-
-                gtk_tree_model_get (model, &iter,
-                                    ID_COLUMN, &id,
-                                    ACTIVE_COLUMN, &is_selected,
-                                    -1);
-
-                if (is_selected && id == gvc_mixer_ui_device_get_id (active_output)) {
-                        /* XXX: profile change on the same device? */
-                        g_debug ("Unneccessary active output update");
-                }
-
-                is_selected = id == gvc_mixer_ui_device_get_id (active_output);
-
-                gtk_list_store_set (GTK_LIST_STORE (model),
-                                    &iter,
-                                    ACTIVE_COLUMN, is_selected,
-                                    -1);
-
-                if (is_selected) {
-                        GtkTreeSelection *selection;
-                        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (dialog->priv->output_treeview));
-                        gtk_tree_selection_select_iter (selection, &iter);
-                }
-        } while (gtk_tree_model_iter_next (model, &iter));
+        /* First make sure the correct UI device is selected. */
+        set_active_row (dialog,
+                        dialog->priv->output_treeview,
+                        dialog->priv->output_rows,
+                        &dialog->priv->active_output_id,
+                        gvc_mixer_ui_device_get_id (active_output));
 
         stream = gvc_mixer_control_get_stream_from_device (dialog->priv->mixer_control,
                                                            active_output);
@@ -958,14 +1374,14 @@ bar_set_stream (GvcMixerDialog *dialog,
         g_signal_handlers_disconnect_by_func (adj, on_adjustment_value_changed, dialog);
 
         g_object_set_data (G_OBJECT (bar), "gvc-mixer-dialog-stream", stream);
-        g_object_set_data (G_OBJECT (bar), "gvc-mixer-dialog-stream-id",
-                           GUINT_TO_POINTER (gvc_mixer_stream_get_id (stream)));
         g_object_set_data (G_OBJECT (adj), "gvc-mixer-dialog-stream", stream);
         g_object_set_data (G_OBJECT (adj), "gvc-mixer-dialog-bar", bar);
 
         if (stream != NULL) {
                 gboolean is_muted;
 
+                save_bar_for_stream (dialog, stream, bar);
+
                 is_muted = gvc_mixer_stream_get_is_muted (stream);
                 gvc_channel_bar_set_is_muted (GVC_CHANNEL_BAR (bar), is_muted);
 
@@ -992,7 +1408,6 @@ add_stream (GvcMixerDialog *dialog,
             GvcMixerStream *stream)
 {
         GtkWidget      *bar;
-        GvcMixerStream *old_stream;
 
         bar = NULL;
 
@@ -1009,6 +1424,8 @@ add_stream (GvcMixerDialog *dialog,
 
                 bar = create_app_bar (dialog, name,
                                       gvc_mixer_stream_get_icon_name (stream));
+                if (dialog->priv->app_meters_enabled)
+                        add_app_meter (dialog, bar, stream);
                 gtk_box_pack_start (GTK_BOX (dialog->priv->applications_box), bar, FALSE, FALSE, 12);
                 dialog->priv->num_apps++;
                 gtk_widget_hide (dialog->priv->no_apps_label);
@@ -1018,34 +1435,19 @@ add_stream (GvcMixerDialog *dialog,
         g_assert (bar != NULL);
 
         if (bar != NULL) {
-                old_stream = g_object_get_data (G_OBJECT (bar), "gvc-mixer-dialog-stream");
-                if (old_stream != NULL) {
-                        char *name;
-
-                        g_object_get (bar, "name", &name, NULL);
-                        g_debug ("Disconnecting old stream '%s' from bar '%s'",
-                                 gvc_mixer_stream_get_name (old_stream), name);
-                        g_free (name);
-
-                        g_signal_handlers_disconnect_by_func (old_stream, on_stream_is_muted_notify, dialog);
-                        g_signal_handlers_disconnect_by_func (old_stream, on_stream_volume_notify, dialog);
-                        g_hash_table_remove (dialog->priv->bars, GUINT_TO_POINTER (gvc_mixer_stream_get_id (old_stream)));
-                }
-                save_bar_for_stream (dialog, stream, bar);
                 bar_set_stream (dialog, bar, stream);
                 gtk_widget_show (bar);
         }
 }
 
 static void
-on_control_stream_added (GvcMixerControl *control,
-                         guint            id,
-                         GvcMixerDialog  *dialog)
+add_stream_id (GvcMixerDialog *dialog,
+               guint           id)
 {
         GvcMixerStream *stream;
         const char     *app_id;
 
-        stream = gvc_mixer_control_lookup_stream_id (control, id);
+        stream = gvc_mixer_control_lookup_stream_id (dialog->priv->mixer_control, id);
         if (stream == NULL)
                 return;
 
@@ -1069,34 +1471,6 @@ on_control_stream_added (GvcMixerControl *control,
         }
 }
 
-static gboolean
-find_item_by_id (GtkTreeModel *model,
-                   guint         id,
-                   guint         column,
-                   GtkTreeIter  *iter)
-{
-        gboolean found_item;
-
-        found_item = FALSE;
-
-        if (!gtk_tree_model_get_iter_first (model, iter)) {
-                return FALSE;
-        }
-
-        do {
-                guint t_id;
-
-                gtk_tree_model_get (model, iter,
-                                    column, &t_id, -1);
-
-                if (id == t_id) {
-                        found_item = TRUE;
-                }
-        } while (!found_item && gtk_tree_model_iter_next (model, iter));
-
-        return found_item;
-}
-
 static void
 add_input_ui_entry (GvcMixerDialog *dialog,
                     GvcMixerUIDevice *input)
@@ -1156,6 +1530,9 @@ add_input_ui_entry (GvcMixerDialog *dialog,
                             ICON_COLUMN, icon,
                             ID_COLUMN, gvc_mixer_ui_device_get_id (input),
                             -1);
+        g_hash_table_insert (dialog->priv->input_rows,
+                             GUINT_TO_POINTER (gvc_mixer_ui_device_get_id (input)),
+                             gtk_tree_iter_copy (&iter));
 
         if (icon != NULL)
                 g_object_unref (icon);
@@ -1223,6 +1600,9 @@ add_output_ui_entry (GvcMixerDialog   *dialog,
                             ICON_COLUMN, icon,
                             ID_COLUMN, gvc_mixer_ui_device_get_id (output),
                             -1);
+        g_hash_table_insert (dialog->priv->output_rows,
+                             GUINT_TO_POINTER (gvc_mixer_ui_device_get_id (output)),
+                             gtk_tree_iter_copy (&iter));
 
         if (icon != NULL)
                 g_object_unref (icon);
@@ -1230,19 +1610,60 @@ add_output_ui_entry (GvcMixerDialog   *dialog,
 }
 
 
+static gboolean
+apply_pending_updates (gpointer user_data)
+{
+        GvcMixerDialog   *dialog = user_data;
+        GvcMixerUIDevice *device;
+
+        dialog->priv->pending_update_id = 0;
+
+        while (!g_queue_is_empty (&dialog->priv->pending_streams))
+                add_stream_id (dialog, GPOINTER_TO_UINT (g_queue_pop_head (&dialog->priv->pending_streams)));
+
+        if (dialog->priv->output_update_pending) {
+                dialog->priv->output_update_pending = FALSE;
+                device = gvc_mixer_control_lookup_output_id (dialog->priv->mixer_control,
+                                                             dialog->priv->pending_output_id);
+                if (device != NULL)
+                        active_output_update (dialog, device);
+                else
+                        g_warning ("on_control_active_output_update - tried to fetch an output of id %u but got nothing",
+                                   dialog->priv->pending_output_id);
+        }
+
+        if (dialog->priv->input_update_pending) {
+                dialog->priv->input_update_pending = FALSE;
+                device = gvc_mixer_control_lookup_input_id (dialog->priv->mixer_control,
+                                                            dialog->priv->pending_input_id);
+                if (device != NULL)
+                        active_input_update (dialog, device);
+                else
+                        g_warning ("on_control_active_input_update - tried to fetch an input of id %u but got nothing",
+                                   dialog->priv->pending_input_id);
+        }
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+queue_pending_updates (GvcMixerDialog *dialog)
+{
+        if (dialog->priv->pending_update_id != 0)
+                return;
+
+        dialog->priv->pending_update_id = g_idle_add (apply_pending_updates, dialog);
+        g_source_set_name_by_id (dialog->priv->pending_update_id, "[gnome-control-center] apply_pending_updates");
+}
+
 static void
 on_control_active_input_update (GvcMixerControl *control,
                                 guint            id,
                                 GvcMixerDialog  *dialog)
 {
-        GvcMixerUIDevice* in = NULL;
-        in = gvc_mixer_control_lookup_input_id (control, id);
-
-        if (in == NULL) {
-                g_warning ("on_control_active_input_update - tried to fetch an input of id %u but got nothing", id);
-                return;
-        }
-        active_input_update (dialog, in);
+        dialog->priv->input_update_pending = TRUE;
+        dialog->priv->pending_input_id = id;
+        queue_pending_updates (dialog);
 }
 
 static void
@@ -1250,14 +1671,9 @@ on_control_active_output_update (GvcMixerControl *control,
                                  guint            id,
                                  GvcMixerDialog  *dialog)
 {
-        GvcMixerUIDevice* out = NULL;
-        out = gvc_mixer_control_lookup_output_id (control, id);
-
-        if (out == NULL) {
-                g_warning ("on_control_active_output_update - tried to fetch an output of id %u but got nothing", id);
-                return;
-        }
-        active_output_update (dialog, out);
+        dialog->priv->output_update_pending = TRUE;
+        dialog->priv->pending_output_id = id;
+        queue_pending_updates (dialog);
 }
 
 static void
@@ -1298,8 +1714,9 @@ on_control_input_removed (GvcMixerControl *control,
 
         /* remove from any models */
         model = gtk_tree_view_get_model (GTK_TREE_VIEW (dialog->priv->input_treeview));
-        found = find_item_by_id (GTK_TREE_MODEL (model), id, ID_COLUMN, &iter);
+        found = find_item_by_id (dialog->priv->input_rows, id, &iter);
         if (found) {
+                g_hash_table_remove (dialog->priv->input_rows, GUINT_TO_POINTER (id));
                 gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
         }
 }
@@ -1343,8 +1760,9 @@ on_control_output_removed (GvcMixerControl *control,
 
          /* remove from any models */
         model = gtk_tree_view_get_model (GTK_TREE_VIEW (dialog->priv->output_treeview));
-        found = find_item_by_id (GTK_TREE_MODEL (model), id, ID_COLUMN, &iter);
+        found = find_item_by_id (dialog->priv->output_rows, id, &iter);
         if (found) {
+                g_hash_table_remove (dialog->priv->output_rows, GUINT_TO_POINTER (id));
                 gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
         }
 }
@@ -1354,32 +1772,35 @@ remove_stream (GvcMixerDialog  *dialog,
                guint            id)
 {
         GtkWidget *bar;
-        guint output_id, input_id;
 
         bar = g_hash_table_lookup (dialog->priv->bars, GUINT_TO_POINTER (id));
-        if (bar != NULL) {
-                g_hash_table_remove (dialog->priv->bars, GUINT_TO_POINTER (id));
-                gtk_container_remove (GTK_CONTAINER (gtk_widget_get_parent (bar)),
-                                      bar);
-                dialog->priv->num_apps--;
-                if (dialog->priv->num_apps == 0) {
-                        gtk_widget_show (dialog->priv->no_apps_label);
-                }
+        if (bar == NULL)
                 return;
-        }
 
-	output_id = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (dialog->priv->output_bar), "gvc-mixer-dialog-stream-id"));
-	input_id = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (dialog->priv->input_bar), "gvc-mixer-dialog-stream-id"));
+        g_hash_table_remove (dialog->priv->bars, GUINT_TO_POINTER (id));
 
-	if (output_id == id)
-		bar = dialog->priv->output_bar;
-	else if (input_id == id)
-		bar = dialog->priv->input_bar;
-	else
-		return;
+        if (bar == dialog->priv->output_bar ||
+            bar == dialog->priv->input_bar ||
+            bar == dialog->priv->effects_bar) {
+                g_object_set_data (G_OBJECT (bar), "gvc-mixer-dialog-stream", NULL);
+                return;
+        }
 
-	g_object_set_data (G_OBJECT (bar), "gvc-mixer-dialog-stream-id", NULL);
-	g_object_set_data (G_OBJECT (bar), "gvc-mixer-dialog-stream", NULL);
+        g_hash_table_remove (dialog->priv->app_meters, GUINT_TO_POINTER (id));
+        gtk_container_remove (GTK_CONTAINER (gtk_widget_get_parent (bar)), bar);
+        dialog->priv->num_apps--;
+        if (dialog->priv->num_apps == 0)
+                gtk_widget_show (dialog->priv->no_apps_label);
+}
+
+static void
+on_control_stream_added (GvcMixerControl *control,
+                         guint            id,
+                         GvcMixerDialog  *dialog)
+{
+        if (g_queue_find (&dialog->priv->pending_streams, GUINT_TO_POINTER (id)) == NULL)
+                g_queue_push_tail (&dialog->priv->pending_streams, GUINT_TO_POINTER (id));
+        queue_pending_updates (dialog);
 }
 
 static void
@@ -1387,6 +1808,10 @@ on_control_stream_removed (GvcMixerControl *control,
                            guint            id,
                            GvcMixerDialog  *dialog)
 {
+        /* Streams that come and go within a burst are never shown */
+        if (g_queue_remove (&dialog->priv->pending_streams, GUINT_TO_POINTER (id)))
+                return;
+
         remove_stream (dialog, id);
 }
 
@@ -1608,6 +2033,7 @@ gvc_mixer_dialog_constructor (GType                  type,
         GtkWidget        *box;
         GtkWidget        *sbox;
         GtkWidget        *ebox;
+        GtkWidget        *button;
         GSList           *streams;
         GSList           *l;
         GvcMixerStream   *stream;
@@ -1786,6 +2212,15 @@ gvc_mixer_dialog_constructor (GType                  type,
         gtk_box_pack_start (GTK_BOX (self->priv->applications_box),
                             self->priv->no_apps_label,
                             TRUE, TRUE, 0);
+        button = gtk_check_button_new_with_mnemonic (_("Show application _levels"));
+        g_signal_connect (button, "toggled",
+                          G_CALLBACK (on_app_meters_toggled), self);
+        gtk_box_pack_end (GTK_BOX (self->priv->applications_box),
+                          button, FALSE, FALSE, 0);
+        g_signal_connect (self->priv->applications_box, "map",
+                          G_CALLBACK (on_applications_box_map), self);
+        g_signal_connect (self->priv->applications_box, "unmap",
+                          G_CALLBACK (on_applications_box_unmap), self);
 
         g_signal_connect (self->priv->mixer_control,
                           "output-added",
@@ -1830,6 +2265,13 @@ gvc_mixer_dialog_dispose (GObject *object)
 {
         GvcMixerDialog *dialog = GVC_MIXER_DIALOG (object);
 
+        /* The meters need the PulseAudio context to disconnect */
+        if (dialog->priv->app_meters != NULL) {
+                g_hash_table_destroy (dialog->priv->app_meters);
+                dialog->priv->app_meters = NULL;
+        }
+        g_clear_pointer (&dialog->priv->meter_streams, g_hash_table_destroy);
+
         if (dialog->priv->mixer_control != NULL) {
 
                 g_signal_handlers_disconnect_by_func (dialog->priv->mixer_control,
@@ -1866,6 +2308,12 @@ gvc_mixer_dialog_dispose (GObject *object)
                 dialog->priv->bars = NULL;
         }
 
+        if (dialog->priv->pending_update_id != 0) {
+                g_source_remove (dialog->priv->pending_update_id);
+                dialog->priv->pending_update_id = 0;
+        }
+        g_queue_clear (&dialog->priv->pending_streams);
+
         if (dialog->priv->test_dialog != NULL) {
                 gtk_dialog_response (GTK_DIALOG (dialog->priv->test_dialog),
                                      GTK_RESPONSE_OK);
@@ -1904,6 +2352,11 @@ gvc_mixer_dialog_init (GvcMixerDialog *dialog)
                                         GTK_ORIENTATION_VERTICAL);
         dialog->priv = GVC_MIXER_DIALOG_GET_PRIVATE (dialog);
         dialog->priv->bars = g_hash_table_new (NULL, NULL);
+        g_queue_init (&dialog->priv->pending_streams);
+        dialog->priv->output_rows = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) gtk_tree_iter_free);
+        dialog->priv->input_rows = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) gtk_tree_iter_free);
+        dialog->priv->app_meters = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) app_meter_free);
+        dialog->priv->meter_streams = g_hash_table_new (g_str_hash, g_str_equal);
         dialog->priv->size_group = gtk_size_group_new (GTK_SIZE_GROUP_HORIZONTAL);
 }
 
@@ -1918,6 +2371,9 @@ gvc_mixer_dialog_finalize (GObject *object)
         mixer_dialog = GVC_MIXER_DIALOG (object);
 
         g_return_if_fail (mixer_dialog->priv != NULL);
+
+        g_hash_table_destroy (mixer_dialog->priv->output_rows);
+        g_hash_table_destroy (mixer_dialog->priv->input_rows);
         G_OBJECT_CLASS (gvc_mixer_dialog_parent_class)->finalize (object);
 }
 
@@ -28,6 +28,7 @@
 
 #include <glib.h>
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
 #include <gtk/gtk.h>
 #include <canberra-gtk.h>
 #include <libxml/tree.h>
@@ -47,10 +48,38 @@ struct GvcSoundThemeChooserPrivate
         GSettings *sound_settings;
         char *current_theme;
         char *current_parent;
+        char *current_alert;
+
+        /* Loaded from a thread, see load_catalogue_thread() */
+        GCancellable *cancellable;
+        GHashTable   *theme_parents;
+        gboolean      parent_pending;
+
+        /* Alert sounds uploaded to the sample cache, most recently
+         * used first, see touch_preview() */
+        GQueue        preview_lru;
+        guint         precache_id;
 };
 
+typedef struct {
+        char *id;
+        char *name;
+} AlertSound;
+
+typedef struct {
+        GPtrArray  *alerts;
+        GHashTable *theme_parents;
+} SoundCatalogue;
+
+typedef struct {
+        char     *id;
+        guint     slot;
+        gboolean  cached;
+} Preview;
+
 static void     gvc_sound_theme_chooser_class_init (GvcSoundThemeChooserClass *klass);
 static void     gvc_sound_theme_chooser_init       (GvcSoundThemeChooser      *sound_theme_chooser);
+static void     gvc_sound_theme_chooser_dispose    (GObject            *object);
 static void     gvc_sound_theme_chooser_finalize   (GObject            *object);
 
 G_DEFINE_TYPE (GvcSoundThemeChooser, gvc_sound_theme_chooser, GTK_TYPE_BOX)
@@ -68,6 +97,9 @@ G_DEFINE_TYPE (GvcSoundThemeChooser, gvc_sound_theme_chooser, GTK_TYPE_BOX)
 #define NO_SOUNDS_THEME_NAME    "__no_sounds"
 #define DEFAULT_THEME           "freedesktop"
 
+#define CATALOGUE_CACHE_FORMAT  "(stta(ss)a{sms})"
+#define PREVIEW_CACHE_SIZE      8
+
 enum {
         THEME_DISPLAY_COL,
         THEME_IDENTIFIER_COL,
@@ -157,9 +189,24 @@ xml_get_and_trim_names (xmlNodePtr node)
 }
 
 static void
-populate_model_from_node (GvcSoundThemeChooser *chooser,
-                          GtkTreeModel         *model,
-                          xmlNodePtr            node)
+alert_sound_free (AlertSound *alert)
+{
+        g_free (alert->id);
+        g_free (alert->name);
+        g_free (alert);
+}
+
+static void
+sound_catalogue_free (SoundCatalogue *catalogue)
+{
+        g_ptr_array_unref (catalogue->alerts);
+        g_hash_table_unref (catalogue->theme_parents);
+        g_free (catalogue);
+}
+
+static void
+alerts_from_node (GPtrArray  *alerts,
+                  xmlNodePtr  node)
 {
         xmlNodePtr child;
         xmlChar   *filename;
@@ -180,13 +227,12 @@ populate_model_from_node (GvcSoundThemeChooser *chooser,
         }
 
         if (filename != NULL && name != NULL) {
-                gtk_list_store_insert_with_values (GTK_LIST_STORE (model),
-                                                   NULL,
-                                                   G_MAXINT,
-                                                   ALERT_IDENTIFIER_COL, filename,
-                                                   ALERT_DISPLAY_COL, name,
-                                                   ALERT_SOUND_TYPE_COL, _("Built-in"),
-                                                   -1);
+                AlertSound *alert;
+
+                alert = g_new0 (AlertSound, 1);
+                alert->id = g_strdup ((char *) filename);
+                alert->name = g_strdup ((char *) name);
+                g_ptr_array_add (alerts, alert);
         }
 
         xmlFree (filename);
@@ -194,9 +240,8 @@ populate_model_from_node (GvcSoundThemeChooser *chooser,
 }
 
 static void
-populate_model_from_file (GvcSoundThemeChooser *chooser,
-                          GtkTreeModel         *model,
-                          const char           *filename)
+alerts_from_file (GPtrArray  *alerts,
+                  const char *filename)
 {
         xmlDocPtr  doc;
         xmlNodePtr root;
@@ -223,23 +268,24 @@ populate_model_from_file (GvcSoundThemeChooser *chooser,
                         continue;
                 }
 
-                populate_model_from_node (chooser, model, child);
+                alerts_from_node (alerts, child);
         }
 
         xmlFreeDoc (doc);
 }
 
-static void
-populate_model_from_dir (GvcSoundThemeChooser *chooser,
-                         GtkTreeModel         *model,
-                         const char           *dirname)
+static GPtrArray *
+alerts_from_dir (const char *dirname)
 {
+        GPtrArray  *alerts;
         GDir       *d;
         const char *name;
 
+        alerts = g_ptr_array_new_with_free_func ((GDestroyNotify) alert_sound_free);
+
         d = g_dir_open (dirname, 0, NULL);
         if (d == NULL) {
-                return;
+                return alerts;
         }
 
         while ((name = g_dir_read_name (d)) != NULL) {
@@ -250,9 +296,173 @@ populate_model_from_dir (GvcSoundThemeChooser *chooser,
                 }
 
                 path = g_build_filename (dirname, name, NULL);
-                populate_model_from_file (chooser, model, path);
+                alerts_from_file (alerts, path);
                 g_free (path);
         }
+
+        g_dir_close (d);
+
+        return alerts;
+}
+
+/* The newest mtime of the directory and the sound lists in it,
+ * so that both added and edited files invalidate the cache */
+static guint64
+get_alerts_stamp (const char *dirname)
+{
+        GStatBuf    buf;
+        GDir       *d;
+        const char *name;
+        guint64     stamp;
+
+        if (g_stat (dirname, &buf) != 0)
+                return 0;
+        stamp = buf.st_mtime;
+
+        d = g_dir_open (dirname, 0, NULL);
+        if (d == NULL)
+                return stamp;
+
+        while ((name = g_dir_read_name (d)) != NULL) {
+                char *path;
+
+                if (! g_str_has_suffix (name, ".xml"))
+                        continue;
+
+                path = g_build_filename (dirname, name, NULL);
+                if (g_stat (path, &buf) == 0)
+                        stamp = MAX (stamp, (guint64) buf.st_mtime);
+                g_free (path);
+        }
+
+        g_dir_close (d);
+
+        return stamp;
+}
+
+static char *
+get_catalogue_cache_path (void)
+{
+        return g_build_filename (g_get_user_cache_dir (), "gnome-control-center", "sound-catalogue", NULL);
+}
+
+/* The names in the sound lists are translated, so the cached alerts
+ * are only valid for the languages they were loaded for */
+static char *
+get_alerts_cache_languages (void)
+{
+        return g_strjoinv (":", (char **) g_get_language_names ());
+}
+
+/* Fills in the parts of @catalogue that are still up to date in the
+ * cache, a zero stamp never matches */
+static void
+load_catalogue_cache (SoundCatalogue *catalogue,
+                      guint64         alerts_stamp,
+                      guint64         themes_stamp)
+{
+        GVariant     *variant;
+        GVariantIter *alerts_iter;
+        GVariantIter *themes_iter;
+        char         *path;
+        char         *contents;
+        gsize         length;
+        const char   *languages;
+        char         *current_languages;
+        guint64       cached_alerts_stamp;
+        guint64       cached_themes_stamp;
+        const char   *id;
+        const char   *name;
+        char         *parent;
+
+        path = get_catalogue_cache_path ();
+        if (!g_file_get_contents (path, &contents, &length, NULL)) {
+                g_free (path);
+                return;
+        }
+        g_free (path);
+
+        variant = g_variant_new_from_data (G_VARIANT_TYPE (CATALOGUE_CACHE_FORMAT),
+                                           contents, length, FALSE,
+                                           g_free, contents);
+        g_variant_ref_sink (variant);
+
+        g_variant_get (variant, "(&stta(ss)a{sms})",
+                       &languages, &cached_alerts_stamp, &cached_themes_stamp,
+                       &alerts_iter, &themes_iter);
+
+        current_languages = get_alerts_cache_languages ();
+        if (alerts_stamp != 0 &&
+            cached_alerts_stamp == alerts_stamp &&
+            g_strcmp0 (languages, current_languages) == 0) {
+                catalogue->alerts = g_ptr_array_new_with_free_func ((GDestroyNotify) alert_sound_free);
+                while (g_variant_iter_next (alerts_iter, "(&s&s)", &id, &name)) {
+                        AlertSound *alert;
+
+                        alert = g_new0 (AlertSound, 1);
+                        alert->id = g_strdup (id);
+                        alert->name = g_strdup (name);
+                        g_ptr_array_add (catalogue->alerts, alert);
+                }
+        }
+        g_free (current_languages);
+
+        if (themes_stamp != 0 && cached_themes_stamp == themes_stamp) {
+                catalogue->theme_parents = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+                while (g_variant_iter_next (themes_iter, "{&sms}", &name, &parent))
+                        g_hash_table_insert (catalogue->theme_parents, g_strdup (name), parent);
+        }
+
+        g_variant_iter_free (alerts_iter);
+        g_variant_iter_free (themes_iter);
+        g_variant_unref (variant);
+}
+
+static void
+save_catalogue_cache (SoundCatalogue *catalogue,
+                      guint64         alerts_stamp,
+                      guint64         themes_stamp)
+{
+        GVariantBuilder alerts_builder;
+        GVariantBuilder themes_builder;
+        GVariant       *variant;
+        GHashTableIter  iter;
+        gpointer        name;
+        gpointer        parent;
+        char           *languages;
+        char           *path;
+        char           *dir;
+        guint           i;
+
+        g_variant_builder_init (&alerts_builder, G_VARIANT_TYPE ("a(ss)"));
+        for (i = 0; i < catalogue->alerts->len; i++) {
+                AlertSound *alert = g_ptr_array_index (catalogue->alerts, i);
+
+                g_variant_builder_add (&alerts_builder, "(ss)", alert->id, alert->name);
+        }
+
+        g_variant_builder_init (&themes_builder, G_VARIANT_TYPE ("a{sms}"));
+        g_hash_table_iter_init (&iter, catalogue->theme_parents);
+        while (g_hash_table_iter_next (&iter, &name, &parent))
+                g_variant_builder_add (&themes_builder, "{sms}", name, parent);
+
+        languages = get_alerts_cache_languages ();
+        variant = g_variant_ref_sink (g_variant_new (CATALOGUE_CACHE_FORMAT,
+                                                     languages, alerts_stamp, themes_stamp,
+                                                     &alerts_builder, &themes_builder));
+        g_free (languages);
+
+        path = get_catalogue_cache_path ();
+        dir = g_path_get_dirname (path);
+        g_mkdir_with_parents (dir, 0755);
+        g_file_set_contents (path,
+                             g_variant_get_data (variant),
+                             g_variant_get_size (variant),
+                             NULL);
+        g_free (dir);
+        g_free (path);
+
+        g_variant_unref (variant);
 }
 
 static gboolean
@@ -290,6 +500,11 @@ update_alert_model (GvcSoundThemeChooser  *chooser,
         GtkTreeModel *model;
         GtkTreeIter   iter;
 
+        if (id != chooser->priv->current_alert) {
+                g_free (chooser->priv->current_alert);
+                chooser->priv->current_alert = g_strdup (id);
+        }
+
         model = gtk_tree_view_get_model (GTK_TREE_VIEW (chooser->priv->treeview));
         g_assert (gtk_tree_model_get_iter_first (model, &iter));
         do {
@@ -388,6 +603,163 @@ load_theme_name (const char *name,
         return FALSE;
 }
 
+static void
+add_themes_from_dir (GHashTable *themes,
+                     const char *data_dir)
+{
+        GDir       *d;
+        const char *name;
+        char       *dirname;
+
+        dirname = g_build_filename (data_dir, "sounds", NULL);
+        d = g_dir_open (dirname, 0, NULL);
+        if (d == NULL) {
+                g_free (dirname);
+                return;
+        }
+
+        while ((name = g_dir_read_name (d)) != NULL) {
+                char *path;
+                char *parent;
+
+                /* Earlier data dirs take precedence, as in load_theme_name() */
+                if (g_hash_table_contains (themes, name))
+                        continue;
+
+                path = g_build_filename (dirname, name, "index.theme", NULL);
+                parent = NULL;
+                if (load_theme_file (path, &parent))
+                        g_hash_table_insert (themes, g_strdup (name), parent);
+                g_free (path);
+        }
+
+        g_dir_close (d);
+        g_free (dirname);
+}
+
+static GHashTable *
+load_theme_parents (void)
+{
+        GHashTable         *themes;
+        const char * const *data_dirs;
+        guint               i;
+
+        themes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+        add_themes_from_dir (themes, g_get_user_data_dir ());
+        data_dirs = g_get_system_data_dirs ();
+        for (i = 0; data_dirs[i] != NULL; i++)
+                add_themes_from_dir (themes, data_dirs[i]);
+
+        return themes;
+}
+
+/* The newest mtime of the sounds directory, of the theme directories
+ * in it and of their index files */
+static guint64
+get_themes_dir_stamp (const char *data_dir)
+{
+        GStatBuf    buf;
+        GDir       *d;
+        const char *name;
+        char       *dirname;
+        guint64     stamp;
+
+        dirname = g_build_filename (data_dir, "sounds", NULL);
+        if (g_stat (dirname, &buf) != 0) {
+                g_free (dirname);
+                return 0;
+        }
+        stamp = buf.st_mtime;
+
+        d = g_dir_open (dirname, 0, NULL);
+        if (d == NULL) {
+                g_free (dirname);
+                return stamp;
+        }
+
+        while ((name = g_dir_read_name (d)) != NULL) {
+                char *path;
+
+                path = g_build_filename (dirname, name, NULL);
+                if (g_stat (path, &buf) == 0)
+                        stamp = MAX (stamp, (guint64) buf.st_mtime);
+                g_free (path);
+
+                path = g_build_filename (dirname, name, "index.theme", NULL);
+                if (g_stat (path, &buf) == 0)
+                        stamp = MAX (stamp, (guint64) buf.st_mtime);
+                g_free (path);
+        }
+
+        g_dir_close (d);
+        g_free (dirname);
+
+        return stamp;
+}
+
+static guint64
+get_themes_stamp (void)
+{
+        const char * const *data_dirs;
+        guint64             stamp;
+        guint               i;
+
+        stamp = get_themes_dir_stamp (g_get_user_data_dir ());
+        data_dirs = g_get_system_data_dirs ();
+        for (i = 0; data_dirs[i] != NULL; i++)
+                stamp = MAX (stamp, get_themes_dir_stamp (data_dirs[i]));
+
+        return stamp;
+}
+
+static gboolean
+lookup_theme_parent (GvcSoundThemeChooser *chooser,
+                     const char           *name,
+                     char                **parent)
+{
+        gpointer value;
+
+        if (chooser->priv->theme_parents == NULL)
+                return load_theme_name (name, parent);
+
+        if (!g_hash_table_lookup_extended (chooser->priv->theme_parents, name, NULL, &value))
+                return FALSE;
+
+        *parent = g_strdup (value);
+        return TRUE;
+}
+
+/* Works out the parent of the current theme, falling back to the
+ * default theme if the current one can't be found. Returns %TRUE
+ * if the current theme was replaced. */
+static gboolean
+resolve_theme_parent (GvcSoundThemeChooser *chooser)
+{
+        chooser->priv->parent_pending = FALSE;
+
+        g_clear_pointer (&chooser->priv->current_parent, g_free);
+        if (lookup_theme_parent (chooser,
+                                 chooser->priv->current_theme,
+                                 &chooser->priv->current_parent) == FALSE) {
+                g_free (chooser->priv->current_theme);
+                chooser->priv->current_theme = g_strdup (DEFAULT_THEME);
+                lookup_theme_parent (chooser,
+                                     DEFAULT_THEME,
+                                     &chooser->priv->current_parent);
+                return TRUE;
+        }
+
+        return FALSE;
+}
+
+static void
+ensure_theme_parent (GvcSoundThemeChooser *chooser)
+{
+        if (chooser->priv->parent_pending)
+                resolve_theme_parent (chooser);
+}
+
 static void
 update_alert (GvcSoundThemeChooser *chooser,
               const char           *alert_id)
@@ -397,6 +769,8 @@ update_alert (GvcSoundThemeChooser *chooser,
         gboolean      add_custom;
         gboolean      remove_custom;
 
+        ensure_theme_parent (chooser);
+
         is_custom = strcmp (chooser->priv->current_theme, CUSTOM_THEME_NAME) == 0;
         is_default = strcmp (alert_id, DEFAULT_ALERT_ID) == 0;
 
@@ -440,12 +814,130 @@ update_alert (GvcSoundThemeChooser *chooser,
         update_alert_model (chooser, alert_id);
 }
 
+/* Previews are uploaded to the sample cache under one of a fixed set
+ * of event ids, so the cache never holds more than PREVIEW_CACHE_SIZE
+ * of our samples: uploading to a slot replaces what was in it */
+static char *
+get_preview_event_id (guint slot)
+{
+        return g_strdup_printf ("gnome-control-center-preview-%u", slot);
+}
+
+static void
+preview_free (Preview *preview)
+{
+        g_free (preview->id);
+        g_free (preview);
+}
+
+/* Moves @id to the front of the preview LRU, giving it the slot of
+ * the least recently used preview if it wasn't in it yet */
+static Preview *
+touch_preview (GvcSoundThemeChooser *chooser,
+               const char           *id)
+{
+        GQueue  *lru = &chooser->priv->preview_lru;
+        Preview *preview;
+        GList   *l;
+
+        for (l = lru->head; l != NULL; l = l->next) {
+                preview = l->data;
+                if (strcmp (preview->id, id) == 0) {
+                        g_queue_unlink (lru, l);
+                        g_queue_push_head_link (lru, l);
+                        return preview;
+                }
+        }
+
+        if (g_queue_get_length (lru) < PREVIEW_CACHE_SIZE) {
+                preview = g_new0 (Preview, 1);
+                preview->slot = g_queue_get_length (lru);
+        } else {
+                preview = g_queue_pop_tail (lru);
+                g_free (preview->id);
+        }
+        preview->id = g_strdup (id);
+        preview->cached = FALSE;
+        g_queue_push_head (lru, preview);
+
+        return preview;
+}
+
+static void
+cache_preview (GvcSoundThemeChooser *chooser,
+               Preview              *preview)
+{
+        ca_context *context;
+        char       *event_id;
+        int         res;
+
+        context = ca_gtk_context_get_for_screen (gtk_widget_get_screen (GTK_WIDGET (chooser)));
+        event_id = get_preview_event_id (preview->slot);
+        res = ca_context_cache (context,
+                                CA_PROP_EVENT_ID, event_id,
+                                CA_PROP_MEDIA_FILENAME, preview->id,
+                                CA_PROP_CANBERRA_CACHE_CONTROL, "permanent",
+                                NULL);
+        if (res != CA_SUCCESS)
+                g_debug ("Failed to cache '%s': %s", preview->id, ca_strerror (res));
+        g_free (event_id);
+
+        preview->cached = (res == CA_SUCCESS);
+}
+
+/* Uploads one preview per iteration so as not to block the UI for
+ * long, libcanberra contexts must only be used from the main thread */
+static gboolean
+precache_previews_idle (gpointer user_data)
+{
+        GvcSoundThemeChooser *chooser = user_data;
+        GList                *l;
+
+        for (l = chooser->priv->preview_lru.head; l != NULL; l = l->next) {
+                Preview *preview = l->data;
+
+                if (preview->cached)
+                        continue;
+
+                /* Give up if the sound server can't take them */
+                cache_preview (chooser, preview);
+                if (!preview->cached)
+                        break;
+                return G_SOURCE_CONTINUE;
+        }
+
+        chooser->priv->precache_id = 0;
+        return G_SOURCE_REMOVE;
+}
+
+/* Decodes and uploads the first alerts to the sample cache in the
+ * background, so that previewing them starts straight away */
+static void
+precache_previews (GvcSoundThemeChooser *chooser,
+                   GPtrArray            *alerts)
+{
+        guint i;
+
+        for (i = MIN (alerts->len, PREVIEW_CACHE_SIZE); i > 0; i--) {
+                AlertSound *alert = g_ptr_array_index (alerts, i - 1);
+
+                touch_preview (chooser, alert->id);
+        }
+
+        if (chooser->priv->precache_id == 0) {
+                chooser->priv->precache_id = g_idle_add (precache_previews_idle, chooser);
+                g_source_set_name_by_id (chooser->priv->precache_id, "[gnome-control-center] precache_previews_idle");
+        }
+}
+
 static void
 play_preview_for_id (GvcSoundThemeChooser *chooser,
                      const char           *id)
 {
         g_return_if_fail (id != NULL);
 
+        ensure_theme_parent (chooser);
+
         /* special case: for the default item on custom themes
          * play the alert for the parent theme */
         if (strcmp (id, DEFAULT_ALERT_ID) == 0) {
@@ -474,17 +966,28 @@ play_preview_for_id (GvcSoundThemeChooser *chooser,
                                                 NULL);
                 }
         } else {
+                Preview *preview;
+                char    *event_id;
+
+                /* A slot that was just handed over still holds the
+                 * previous sample, so upload before playing it */
+                preview = touch_preview (chooser, id);
+                if (!preview->cached)
+                        cache_preview (chooser, preview);
+
+                event_id = get_preview_event_id (preview->slot);
                 ca_gtk_play_for_widget (GTK_WIDGET (chooser), 0,
                                         CA_PROP_APPLICATION_NAME, _("Sound Preferences"),
+                                        CA_PROP_EVENT_ID, event_id,
                                         CA_PROP_MEDIA_FILENAME, id,
                                         CA_PROP_EVENT_DESCRIPTION, _("Testing event sound"),
-                                        CA_PROP_CANBERRA_CACHE_CONTROL, "never",
+                                        CA_PROP_CANBERRA_CACHE_CONTROL, preview->cached ? "permanent" : "never",
                                         CA_PROP_APPLICATION_ID, "org.gnome.VolumeControl",
 #ifdef CA_PROP_CANBERRA_ENABLE
                                         CA_PROP_CANBERRA_ENABLE, "1",
 #endif
                                         NULL);
-
+                g_free (event_id);
         }
 }
 
@@ -555,8 +1058,7 @@ create_alert_treeview (GvcSoundThemeChooser *chooser)
                                            ALERT_SOUND_TYPE_COL, _("From theme"),
                                            -1);
 
-        populate_model_from_dir (chooser, GTK_TREE_MODEL (store), SOUND_SET_DIR);
-
+        /* The rest of the alerts are added by on_catalogue_loaded() */
         gtk_tree_view_set_model (GTK_TREE_VIEW (treeview),
                                  GTK_TREE_MODEL (store));
 
@@ -640,13 +1142,13 @@ update_theme (GvcSoundThemeChooser *chooser)
         }
 
         if (g_strcmp0 (last_theme, chooser->priv->current_theme) != 0) {
-                g_clear_pointer (&chooser->priv->current_parent, g_free);
-                if (load_theme_name (chooser->priv->current_theme,
-                                     &chooser->priv->current_parent) == FALSE) {
-                        g_free (chooser->priv->current_theme);
-                        chooser->priv->current_theme = g_strdup (DEFAULT_THEME);
-                        load_theme_name (DEFAULT_THEME,
-                                         &chooser->priv->current_parent);
+                /* Until the theme list is loaded, only look up the
+                 * parent theme when it's actually needed */
+                if (chooser->priv->theme_parents != NULL) {
+                        resolve_theme_parent (chooser);
+                } else {
+                        g_clear_pointer (&chooser->priv->current_parent, g_free);
+                        chooser->priv->parent_pending = TRUE;
                 }
         }
         g_free (last_theme);
@@ -656,6 +1158,90 @@ update_theme (GvcSoundThemeChooser *chooser)
         update_alerts_from_theme_name (chooser, chooser->priv->current_theme);
 }
 
+static void
+load_catalogue_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+        SoundCatalogue *catalogue;
+        guint64         alerts_stamp;
+        guint64         themes_stamp;
+        gboolean        changed = FALSE;
+
+        catalogue = g_new0 (SoundCatalogue, 1);
+
+        alerts_stamp = get_alerts_stamp (SOUND_SET_DIR);
+        themes_stamp = get_themes_stamp ();
+        load_catalogue_cache (catalogue, alerts_stamp, themes_stamp);
+
+        if (catalogue->alerts == NULL) {
+                catalogue->alerts = alerts_from_dir (SOUND_SET_DIR);
+                changed = TRUE;
+        }
+        if (catalogue->theme_parents == NULL) {
+                catalogue->theme_parents = load_theme_parents ();
+                changed = TRUE;
+        }
+
+        if (changed)
+                save_catalogue_cache (catalogue, alerts_stamp, themes_stamp);
+
+        g_task_return_pointer (task, catalogue, (GDestroyNotify) sound_catalogue_free);
+}
+
+static void setup_list_size_constraint (GtkWidget *widget,
+                                        GtkWidget *to_size);
+
+static void
+on_catalogue_loaded (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+        GvcSoundThemeChooser *chooser;
+        SoundCatalogue       *catalogue;
+        GtkTreeModel         *model;
+        GError               *error = NULL;
+        guint                 i;
+
+        catalogue = g_task_propagate_pointer (G_TASK (res), &error);
+        if (catalogue == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Failed to load the alert sounds: %s", error->message);
+                g_error_free (error);
+                return;
+        }
+
+        chooser = GVC_SOUND_THEME_CHOOSER (source_object);
+
+        model = gtk_tree_view_get_model (GTK_TREE_VIEW (chooser->priv->treeview));
+        for (i = 0; i < catalogue->alerts->len; i++) {
+                AlertSound *alert = g_ptr_array_index (catalogue->alerts, i);
+
+                gtk_list_store_insert_with_values (GTK_LIST_STORE (model),
+                                                   NULL,
+                                                   G_MAXINT,
+                                                   ALERT_IDENTIFIER_COL, alert->id,
+                                                   ALERT_DISPLAY_COL, alert->name,
+                                                   ALERT_SOUND_TYPE_COL, _("Built-in"),
+                                                   -1);
+        }
+        setup_list_size_constraint (gtk_widget_get_parent (chooser->priv->treeview),
+                                    chooser->priv->treeview);
+
+        chooser->priv->theme_parents = g_hash_table_ref (catalogue->theme_parents);
+        if (chooser->priv->parent_pending && resolve_theme_parent (chooser)) {
+                update_alerts_from_theme_name (chooser, chooser->priv->current_theme);
+        } else if (chooser->priv->current_alert != NULL) {
+                /* Now that the custom alert has a row, select it */
+                update_alert_model (chooser, chooser->priv->current_alert);
+        }
+
+        precache_previews (chooser, catalogue->alerts);
+
+        sound_catalogue_free (catalogue);
+}
+
 static GObject *
 gvc_sound_theme_chooser_constructor (GType                  type,
                                      guint                  n_construct_properties,
@@ -679,6 +1265,7 @@ gvc_sound_theme_chooser_class_init (GvcSoundThemeChooserClass *klass)
         GObjectClass   *object_class = G_OBJECT_CLASS (klass);
 
         object_class->constructor = gvc_sound_theme_chooser_constructor;
+        object_class->dispose = gvc_sound_theme_chooser_dispose;
         object_class->finalize = gvc_sound_theme_chooser_finalize;
 
         g_type_class_add_private (klass, sizeof (GvcSoundThemeChooserPrivate));
@@ -728,6 +1315,7 @@ gvc_sound_theme_chooser_init (GvcSoundThemeChooser *chooser)
         GtkWidget   *box;
         GtkWidget   *label;
         GtkWidget   *scrolled_window;
+        GTask       *task;
         char        *str;
 
         gtk_orientable_set_orientation (GTK_ORIENTABLE (chooser),
@@ -767,6 +1355,31 @@ gvc_sound_theme_chooser_init (GvcSoundThemeChooser *chooser)
                           G_CALLBACK (on_sound_settings_changed), chooser);
         g_signal_connect (chooser->priv->settings, "changed::" AUDIO_BELL_KEY,
                           G_CALLBACK (on_audible_bell_changed), chooser);
+
+        g_queue_init (&chooser->priv->preview_lru);
+        chooser->priv->cancellable = g_cancellable_new ();
+        task = g_task_new (chooser, chooser->priv->cancellable, on_catalogue_loaded, NULL);
+        g_task_set_source_tag (task, gvc_sound_theme_chooser_init);
+        g_task_run_in_thread (task, load_catalogue_thread);
+        g_object_unref (task);
+}
+
+static void
+gvc_sound_theme_chooser_dispose (GObject *object)
+{
+        GvcSoundThemeChooser *chooser = GVC_SOUND_THEME_CHOOSER (object);
+
+        if (chooser->priv->cancellable != NULL) {
+                g_cancellable_cancel (chooser->priv->cancellable);
+                g_clear_object (&chooser->priv->cancellable);
+        }
+
+        if (chooser->priv->precache_id != 0) {
+                g_source_remove (chooser->priv->precache_id);
+                chooser->priv->precache_id = 0;
+        }
+
+        G_OBJECT_CLASS (gvc_sound_theme_chooser_parent_class)->dispose (object);
 }
 
 static void
@@ -782,6 +1395,12 @@ gvc_sound_theme_chooser_finalize (GObject *object)
         if (sound_theme_chooser->priv != NULL) {
                 g_object_unref (sound_theme_chooser->priv->settings);
                 g_object_unref (sound_theme_chooser->priv->sound_settings);
+                g_clear_pointer (&sound_theme_chooser->priv->theme_parents, g_hash_table_unref);
+                g_queue_foreach (&sound_theme_chooser->priv->preview_lru, (GFunc) preview_free, NULL);
+                g_queue_clear (&sound_theme_chooser->priv->preview_lru);
+                g_free (sound_theme_chooser->priv->current_theme);
+                g_free (sound_theme_chooser->priv->current_parent);
+                g_free (sound_theme_chooser->priv->current_alert);
         }
 
         G_OBJECT_CLASS (gvc_sound_theme_chooser_parent_class)->finalize (object);